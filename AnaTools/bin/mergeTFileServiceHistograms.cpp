@@ -1,16 +1,22 @@
 #include <TFile.h>
 #include <TROOT.h>
 #include <TKey.h>
+#include <TClass.h>
 #include <TH1.h>
 #include <TH2.h>
 #include <TH3.h>
 #include <TDirectory.h>
 #include <TList.h>
 #include <TMath.h>
+#include <RVersion.h>
 #include <boost/tokenizer.hpp>
 #include <boost/program_options.hpp>
 #include <string>
 #include <vector>
+#include <map>
+#include <set>
+#include <atomic>
+#include <thread>
 #include <iostream>
 #include <algorithm>
 #include <cassert>
@@ -21,11 +27,35 @@ using namespace boost::program_options;
 using namespace boost;
 using namespace std;
 
-void make(TDirectory & out, TObject * o);
-void fill(TDirectory & out, TObject * o, double);
+////////////////////////////////////////////////////////////////////////////////
+// The histograms being merged, keyed by their path in the file, e.g.,
+// "MyChannelPlotter/Muon Plots/muonPt". The directories and histograms are
+// kept in the order in which they are first seen, parents before children, so
+// that the output has the same layout as the inputs. The histograms belong to
+// no directory until the output is written.
+////////////////////////////////////////////////////////////////////////////////
+struct HistogramSet {
+  vector<string> directories;
+  map<string, string> directoryTitles;
+  vector<string> histograms;
+  map<string, TH1 *> histogramsByPath;
+
+  ~HistogramSet() {
+    for(auto &h : histogramsByPath)
+      delete h.second;
+  }
+};
+
+bool sameBinning(const TH1 * const, const TH1 * const);
+void addHistogram(TH1 * const, TH1 * const, const double);
+void add(HistogramSet &, const string &, TH1 * const, const double);
+void addDirectory(HistogramSet &, TDirectory &, const string &, const double);
+bool addFile(HistogramSet &, const string &, const double);
+void merge(HistogramSet &, HistogramSet &);
+void write(HistogramSet &, TFile &);
 double normCDF (const double);
-void generateUpperLimitCutFlow (TDirectoryFile &, TH1D * const, const double);
-void upperLimitCutFlow (TDirectoryFile &, const double);
+void generateUpperLimitCutFlow (HistogramSet &, const string &, TH1D * const, const double);
+void upperLimitCutFlow (HistogramSet &, const double);
 
 static const char * const kHelpOpt = "help";
 static const char * const kHelpCommandOpt = "help,h";
@@ -35,6 +65,8 @@ static const char * const kInputFilesOpt = "input-files";
 static const char * const kInputFilesCommandOpt = "input-files,i";
 static const char * const kWeightsOpt = "weights";
 static const char * const kWeightsCommandOpt = "weights,w";
+static const char * const kJobsOpt = "jobs";
+static const char * const kJobsCommandOpt = "jobs,j";
 
 vector<double> weights;
 
@@ -49,6 +81,7 @@ int main(int argc, char * argv[]) {
     (kHelpCommandOpt, "produce help message")
     (kOutputFileCommandOpt, value<string>()->default_value("out.root"), "output root file")
     (kWeightsCommandOpt, value<string>(), "list of weights (comma separates).\ndefault: weights are assumed to be 1")
+    (kJobsCommandOpt, value<unsigned>()->default_value(1), "number of threads reading the input files")
     (kInputFilesCommandOpt, value<vector<string> >()->multitoken(), "input root files");
 
   positional_options_description p;
@@ -112,233 +145,198 @@ int main(int argc, char * argv[]) {
     exit(-1);
   }
 
+  unsigned nJobs = max(min(vm[kJobsOpt].as<unsigned>(), (unsigned) fileNames.size()), 1u);
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,6,0)
+  if(nJobs > 1)
+    ROOT::EnableThreadSafety();
+#else
+  nJobs = 1;
+#endif
+
   gROOT->SetBatch();
 
+  // the histograms are owned by the HistogramSets, not by whichever file or
+  // directory happens to be current
+  TH1::AddDirectory(kFALSE);
+
   TFile out(outputFile.c_str(), "RECREATE");
   if(!out.IsOpen()) {
     cerr << "can't open output file: " << outputFile <<endl;
     return -1;
   }
 
-  for(size_t i = 0; i < fileNames.size(); ++i) {
-    string fileName = fileNames[i];
-    TFile file(fileName.c_str(), "read");
-    if(!file.IsOpen()) {
-      cerr << "can't open input file: " << fileName <<endl;
-      return -1;
-    }
-
-    TIter next(file.GetListOfKeys());
-    TKey *key;
-    while ((key = dynamic_cast<TKey*>(next()))) {
-      string className(key->GetClassName());
-      string name(key->GetName());
-      TObject * obj = file.Get(name.c_str());
-      if(obj == 0) {
-        cerr <<"error: key " << name << " not found in file " << fileName << endl;
-        return -1;
-      }
-      make(out, obj);
-    }
-    file.Close();
+  //////////////////////////////////////////////////////////////////////////////
+  // Each thread adds a contiguous range of the input files, with their weights,
+  // to its own set of partial sums.
+  //////////////////////////////////////////////////////////////////////////////
+  vector<HistogramSet> partialSums(nJobs);
+  atomic<bool> failed(false);
+  vector<thread> threads;
+  for(unsigned job = 0; job < nJobs; ++job) {
+    threads.emplace_back([&, job] {
+      size_t first = job * fileNames.size() / nJobs,
+             last = (job + 1) * fileNames.size() / nJobs;
+      for(size_t i = first; i < last && !failed; ++i)
+        if(!addFile(partialSums[job], fileNames[i], weights[i]))
+          failed = true;
+    });
   }
-  for(size_t i = 0; i < fileNames.size(); ++i) {
-    string fileName = fileNames[i];
-    TFile file(fileName.c_str(), "read");
-    if(!file.IsOpen()) {
-      cerr << "can't open input file: " << fileName <<endl;
-      return -1;
-    }
-
-    TIter next(file.GetListOfKeys());
-    TKey *key;
-    while ((key = dynamic_cast<TKey*>(next()))) {
-      string className(key->GetClassName());
-      string name(key->GetName());
-      TObject * obj = file.Get(name.c_str());
-      if(obj == 0) {
-        cerr <<"error: key " << name << " not found in file " << fileName << endl;
-        return -1;
-      }
-      fill(out, obj, weights[i]);
-    }
-    file.Close();
+  for(auto &t : threads)
+    t.join();
+  if(failed)
+    return -1;
+  //////////////////////////////////////////////////////////////////////////////
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Then the partial sums are added pairwise, in parallel, until only the
+  // first one is left.
+  //////////////////////////////////////////////////////////////////////////////
+  for(unsigned step = 1; step < nJobs; step *= 2) {
+    threads.clear();
+    for(unsigned job = 0; job + step < nJobs; job += 2 * step)
+      threads.emplace_back([&, job, step] { merge(partialSums[job], partialSums[job + step]); });
+    for(auto &t : threads)
+      t.join();
   }
+  //////////////////////////////////////////////////////////////////////////////
 
-  out.Write();
-  out.Close();
-
-  TFile fout (outputFile.c_str(), "UPDATE");
-  upperLimitCutFlow (fout, weights[0]);
-  fout.Write();
-  fout.Close();
+  upperLimitCutFlow(partialSums[0], weights[0]);
+  write(partialSums[0], out);
 
   return 0;
 }
 
-void make(TDirectory & out, TObject * o) {
-  TDirectory * dir = dynamic_cast<TDirectory*>(o);
-  bool exists = out.Get (o->GetName ());
-  TH1F * th1f;
-  TH1D * th1d;
-  TH2F * th2f;
-  TH2D * th2d;
-  TH3F * th3f;
-  TH3D * th3d;
-  out.cd();
-  if (!dir && exists)
-    return;
-  if(dir != 0) {
-    TDirectory * outDir;
-    if (!exists)
-      outDir = out.mkdir(dir->GetName(), dir->GetTitle());
-    else
-      outDir = (TDirectory *) out.Get(dir->GetName());
-    TIter next(dir->GetListOfKeys());
-    TKey *key;
-    while( (key = dynamic_cast<TKey*>(next())) ) {
-      string className(key->GetClassName());
-      string name(key->GetName());
-      TObject * obj = dir->Get(name.c_str());
-      if(obj == 0) {
-        cerr <<"error: key " << name << " not found in directory " << dir->GetName() << endl;
-        exit(-1);
-      }
-      make(*outDir, obj);
-    }
-  } else if((th1f = dynamic_cast<TH1F*>(o)) != 0) {
-    TH1F *h = (TH1F*) th1f->Clone();
-    h->Reset();
-    h->Sumw2();
-    h->SetDirectory(&out);
-  } else if((th1d = dynamic_cast<TH1D*>(o)) != 0) {
-    TH1D *h = (TH1D*) th1d->Clone();
-    h->Reset();
-    h->Sumw2();
-    h->SetDirectory(&out);
-  } else if((th2f = dynamic_cast<TH2F*>(o)) != 0) {
-    TH2F *h = (TH2F*) th2f->Clone();
-    h->Reset();
-    h->Sumw2();
-    h->SetDirectory(&out);
-  } else if((th2d = dynamic_cast<TH2D*>(o)) != 0) {
-    TH2D *h = (TH2D*) th2d->Clone();
-    h->Reset();
-    h->Sumw2();
-    h->SetDirectory(&out);
-  } else if((th3f = dynamic_cast<TH3F*>(o)) != 0) {
-    TH3F *h = (TH3F*) th3f->Clone();
-    h->Reset();
-    h->Sumw2();
-    h->SetDirectory(&out);
-  } else if((th3d = dynamic_cast<TH3D*>(o)) != 0) {
-    TH3D *h = (TH3D*) th3d->Clone();
-    h->Reset();
-    h->Sumw2();
-    h->SetDirectory(&out);
+bool sameBinning(const TH1 * const a, const TH1 * const b) {
+  if(a->GetDimension() != b->GetDimension())
+    return false;
+  const TAxis * const axesA[3] = {a->GetXaxis(), a->GetYaxis(), a->GetZaxis()},
+              * const axesB[3] = {b->GetXaxis(), b->GetYaxis(), b->GetZaxis()};
+  for(int i = 0; i < a->GetDimension(); ++i) {
+    const TAxis * const x = axesA[i], * const y = axesB[i];
+    if(x->GetNbins() != y->GetNbins() || x->GetXmin() != y->GetXmin() || x->GetXmax() != y->GetXmax())
+      return false;
+    if(x->GetXbins()->GetSize() != y->GetXbins()->GetSize())
+      return false;
+    for(int bin = 0; bin < x->GetXbins()->GetSize(); ++bin)
+      if(x->GetXbins()->At(bin) != y->GetXbins()->At(bin))
+        return false;
+    if(x->GetLabels() || y->GetLabels())
+      for(int bin = 1; bin <= x->GetNbins(); ++bin)
+        if(string(x->GetBinLabel(bin)) != string(y->GetBinLabel(bin)))
+          return false;
   }
+  return true;
 }
 
-void fill(TDirectory & out, TObject * o, double w) {
-  TDirectory * dir;
-  TH1F * th1f;
-  TH1D * th1d;
-  TH2F * th2f;
-  TH2D * th2d;
-  TH3F * th3f;
-  TH3D * th3d;
-  if((dir  = dynamic_cast<TDirectory*>(o)) != 0) {
-    const char * name = dir->GetName();
-    TDirectory * outDir = dynamic_cast<TDirectory*>(out.Get(name));
-    if(outDir == 0) {
-      cerr << "can't find directory " << name << " in output file" << endl;
-      exit(-1);
-    }
-    TIter next(dir->GetListOfKeys());
-    TKey *key;
-    while( (key = dynamic_cast<TKey*>(next())) ) {
-      string className(key->GetClassName());
-      string name(key->GetName());
-      TObject * obj = dir->Get(name.c_str());
-      if(obj == 0) {
-        cerr <<"error: key " << name << " not found in directory " << dir->GetName() << endl;
+// Adds w times h to sum. The number of entries is not weighted, as when
+// merging histograms which have been scaled. Histograms with different
+// binning, e.g., labels in a different order, fall back to TH1::Merge.
+void addHistogram(TH1 * const sum, TH1 * const h, const double w) {
+  if(sameBinning(sum, h)) {
+    double entries = sum->GetEntries() + h->GetEntries();
+    sum->Add(h, w);
+    sum->SetEntries(entries);
+  } else {
+    if(w != 1.0)
+      h->Scale(w);
+    TList list;
+    list.Add(h);
+    sum->Merge(&list);
+  }
+}
+
+void add(HistogramSet &histogramSet, const string &path, TH1 * const h, const double w) {
+  map<string, TH1 *>::iterator sum = histogramSet.histogramsByPath.find(path);
+  if(sum == histogramSet.histogramsByPath.end()) {
+    TH1 * const newSum = (TH1 *) h->Clone();
+    newSum->SetDirectory(0);
+    newSum->Reset();
+    newSum->Sumw2();
+    histogramSet.histograms.push_back(path);
+    sum = histogramSet.histogramsByPath.insert(make_pair(path, newSum)).first;
+  }
+  addHistogram(sum->second, h, w);
+}
+
+void addDirectory(HistogramSet &histogramSet, TDirectory &dir, const string &path, const double w) {
+  set<string> names;
+  TIter next(dir.GetListOfKeys());
+  TKey *key;
+  while( (key = dynamic_cast<TKey*>(next())) ) {
+    string name(key->GetName());
+    if(!names.insert(name).second) // older cycles of the same object
+      continue;
+    TClass * const cl = TClass::GetClass(key->GetClassName());
+    if(!cl)
+      continue;
+    const string subPath = (path.empty() ? name : path + "/" + name);
+    if(cl->InheritsFrom(TDirectory::Class())) {
+      TDirectory * const subDir = dynamic_cast<TDirectory*>(dir.Get(name.c_str()));
+      if(subDir == 0) {
+        cerr <<"error: key " << name << " not found in directory " << dir.GetName() << endl;
         exit(-1);
       }
-      fill(*outDir, obj, w);
-    }
-  } else if((th1f = dynamic_cast<TH1F*>(o)) != 0) {
-    const char * name = th1f->GetName();
-    TH1F * outTh1f = dynamic_cast<TH1F*>(out.Get(name));
-    if(outTh1f == 0) {
-      cerr <<"error: histogram TH1F" << name << " not found in directory " << out.GetName() << endl;
-      exit(-1);
-    }
-    th1f->Scale(w);
-
-    TList *list = new TList();
-    list->Add(th1f);
-    outTh1f->Merge(list);
-  } else if((th1d = dynamic_cast<TH1D*>(o)) != 0) {
-    const char * name = th1d->GetName();
-    TH1D * outTh1d = dynamic_cast<TH1D*>(out.Get(name));
-    if(outTh1d == 0) {
-      cerr <<"error: histogram TH1D" << name << " not found in directory " << out.GetName() << endl;
-      exit(-1);
-    }
-    th1d->Scale(w);
-
-    TList *list = new TList();
-    list->Add(th1d);
-    outTh1d->Merge(list);
-  } else if((th2f = dynamic_cast<TH2F*>(o)) != 0) {
-    const char * name = th2f->GetName();
-    TH2F * outTh2f = dynamic_cast<TH2F*>(out.Get(name));
-    if(outTh2f == 0) {
-      cerr <<"error: histogram TH2F" << name << " not found in directory " << out.GetName() << endl;
-      exit(-1);
-    }
-    th2f->Scale(w);
-
-    TList *list = new TList();
-    list->Add(th2f);
-    outTh2f->Merge(list);
-  } else if((th2d = dynamic_cast<TH2D*>(o)) != 0) {
-    const char * name = th2d->GetName();
-    TH2D * outTh2d = dynamic_cast<TH2D*>(out.Get(name));
-    if(outTh2d == 0) {
-      cerr <<"error: histogram TH2D" << name << " not found in directory " << out.GetName() << endl;
-      exit(-1);
-    }
-    th2d->Scale(w);
-
-    TList *list = new TList();
-    list->Add(th2d);
-    outTh2d->Merge(list);
-  } else if((th3f = dynamic_cast<TH3F*>(o)) != 0) {
-    const char * name = th3f->GetName();
-    TH3F * outTh3f = dynamic_cast<TH3F*>(out.Get(name));
-    if(outTh3f == 0) {
-      cerr <<"error: histogram TH3F" << name << " not found in directory " << out.GetName() << endl;
-      exit(-1);
+      if(!histogramSet.directoryTitles.count(subPath)) {
+        histogramSet.directories.push_back(subPath);
+        histogramSet.directoryTitles[subPath] = subDir->GetTitle();
+      }
+      addDirectory(histogramSet, *subDir, subPath, w);
+    } else if(cl->InheritsFrom(TH1::Class())) {
+      TH1 * const h = dynamic_cast<TH1*>(key->ReadObj());
+      if(h == 0) {
+        cerr <<"error: key " << name << " not found in directory " << dir.GetName() << endl;
+        exit(-1);
+      }
+      h->SetDirectory(0);
+      add(histogramSet, subPath, h, w);
+      delete h;
     }
-    th3f->Scale(w);
-
-    TList *list = new TList();
-    list->Add(th3f);
-    outTh3f->Merge(list);
-  } else if((th3d = dynamic_cast<TH3D*>(o)) != 0) {
-    const char * name = th3d->GetName();
-    TH3D * outTh3d = dynamic_cast<TH3D*>(out.Get(name));
-    if(outTh3d == 0) {
-      cerr <<"error: histogram TH3D" << name << " not found in directory " << out.GetName() << endl;
-      exit(-1);
+  }
+}
+
+bool addFile(HistogramSet &histogramSet, const string &fileName, const double w) {
+  TFile file(fileName.c_str(), "read");
+  if(!file.IsOpen()) {
+    cerr << "can't open input file: " << fileName <<endl;
+    return false;
+  }
+  addDirectory(histogramSet, file, "", w);
+  file.Close();
+  return true;
+}
+
+// Adds the histograms in b to those in a.
+void merge(HistogramSet &a, HistogramSet &b) {
+  for(const auto &path : b.directories) {
+    if(!a.directoryTitles.count(path)) {
+      a.directories.push_back(path);
+      a.directoryTitles[path] = b.directoryTitles.at(path);
     }
-    th3d->Scale(w);
+  }
+  for(const auto &path : b.histograms)
+    add(a, path, b.histogramsByPath.at(path), 1.0);
+}
 
-    TList *list = new TList();
-    list->Add(th3d);
-    outTh3d->Merge(list);
+void write(HistogramSet &histogramSet, TFile &out) {
+  map<string, TDirectory *> directories;
+  directories[""] = &out;
+  for(const auto &path : histogramSet.directories) {
+    size_t slash = path.rfind('/');
+    TDirectory * const parent = directories.at(slash == string::npos ? "" : path.substr(0, slash));
+    const string name = (slash == string::npos ? path : path.substr(slash + 1));
+    directories[path] = parent->mkdir(name.c_str(), histogramSet.directoryTitles.at(path).c_str());
   }
+  for(const auto &path : histogramSet.histograms) {
+    size_t slash = path.rfind('/');
+    histogramSet.histogramsByPath.at(path)->SetDirectory(directories.at(slash == string::npos ? "" : path.substr(0, slash)));
+  }
+
+  out.Write();
+
+  // the HistogramSet deletes the histograms, not the file
+  for(const auto &path : histogramSet.histograms)
+    histogramSet.histogramsByPath.at(path)->SetDirectory(0);
+  out.Close();
 }
 
 double
@@ -348,18 +346,19 @@ normCDF (const double x)
 }
 
 void
-generateUpperLimitCutFlow (TDirectoryFile &dirFile, TH1D * const cutFlow, const double w)
+generateUpperLimitCutFlow (HistogramSet &histogramSet, const string &dir, TH1D * const cutFlow, const double w)
 {
   vector<double> sigmas = {1.0, 2.0, 3.0};
-  cutFlow->SetDirectory (0);
   for (const auto &sigma : sigmas)
     {
       double cl = 1.0 - 2.0 * normCDF (-sigma);
       stringstream ss;
       ss << ((int) (cl * 100.0));
 
-      TH1D * const upperLimitCutFlowHist = (TH1D *) cutFlow->Clone (("cutFlow_" + ss.str () + "CL").c_str ());
-      upperLimitCutFlowHist->SetDirectory (&dirFile);
+      const string name = "cutFlow_" + ss.str () + "CL",
+                   path = (dir.empty () ? name : dir + "/" + name);
+      TH1D * const upperLimitCutFlowHist = (TH1D *) cutFlow->Clone (name.c_str ());
+      upperLimitCutFlowHist->SetDirectory (0);
       for (int i = 0; i <= cutFlow->GetXaxis ()->GetNbins () + 1; i++)
         {
           // The calculation of upper and lower limits is taken from the PDG Statistics chapter.
@@ -371,19 +370,33 @@ generateUpperLimitCutFlow (TDirectoryFile &dirFile, TH1D * const cutFlow, const
           upperLimit = 0.5 * TMath::ChisquareQuantile (cl, 2 * (content + 1));
           upperLimitCutFlowHist->SetBinContent (i, upperLimit * w);
         }
+
+      // any upper-limit cut flows in the inputs are replaced, not added up
+      map<string, TH1 *>::iterator existing = histogramSet.histogramsByPath.find (path);
+      if (existing != histogramSet.histogramsByPath.end ())
+        {
+          delete existing->second;
+          existing->second = upperLimitCutFlowHist;
+        }
+      else
+        {
+          histogramSet.histograms.push_back (path);
+          histogramSet.histogramsByPath[path] = upperLimitCutFlowHist;
+        }
     }
 }
 
 void
-upperLimitCutFlow (TDirectoryFile &dirFile, const double w)
+upperLimitCutFlow (HistogramSet &histogramSet, const double w)
 {
-  TIter next (dirFile.GetListOfKeys ());
-  TKey *key;
-  while ((key = (TKey *) next ()))
+  const vector<string> histograms = histogramSet.histograms;
+  for (const auto &path : histograms)
     {
-      if (string (key->GetClassName ()) == "TDirectoryFile")
-        upperLimitCutFlow (*((TDirectoryFile *) dirFile.Get (key->GetName ())), w);
-      if (string (key->GetClassName ()) == "TH1D" && string (key->GetName ()) == "cutFlow")
-        generateUpperLimitCutFlow (dirFile, (TH1D *) dirFile.Get (key->GetName ()), w);
+      TH1 * const h = histogramSet.histogramsByPath.at (path);
+      size_t slash = path.rfind ('/');
+      const string dir = (slash == string::npos ? "" : path.substr (0, slash)),
+                   name = (slash == string::npos ? path : path.substr (slash + 1));
+      if (string (h->ClassName ()) == "TH1D" && name == "cutFlow")
+        generateUpperLimitCutFlow (histogramSet, dir, (TH1D *) h, w);
     }
 }
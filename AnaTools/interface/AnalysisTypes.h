@@ -30,13 +30,16 @@
 #include "OSUT3Analysis/Collections/interface/Uservariable.h"
 #include "OSUT3Analysis/Collections/interface/PileUpInfo.h"
 
+#include "OSUT3Analysis/AnaTools/interface/HistogramFillBuffer.h"
+#include "OSUT3Analysis/AnaTools/interface/ObjectFlags.h"
+#include "OSUT3Analysis/AnaTools/interface/ValueLookupCache.h"
+#include "OSUT3Analysis/AnaTools/interface/VariableIndex.h"
+
 
 class ValueLookupTree;
 
 typedef boost::variant<double, string> Leaf;
 
-typedef vector<map<string, vector<pair<bool, bool> > > > FlagMap;
-
 struct Cut
 {
   ValueLookupTree  *valueLookupTree;
@@ -53,10 +56,23 @@ struct Cut
 
 typedef vector<Cut> Cuts;
 
+// The cuts, triggers, and filters of a CutCalculator channel, which are the
+// same for every event.
+struct CutCalculatorMetadata
+{
+  Cuts            cuts;
+  vector<string>  triggers;
+  vector<string>  triggersToVeto;
+  vector<string>  triggerFilters;
+  vector<string>  triggersInMenu;
+  vector<string>  metFilters;
+  bool            reorderCuts = false;   // whether the cuts can be rejected by prefilters out of order
+};
+
 struct CutCalculatorPayload
 {
-  FlagMap         cumulativeObjectFlags;
-  FlagMap         individualObjectFlags;
+  ObjectFlags     cumulativeObjectFlags;
+  ObjectFlags     individualObjectFlags;
   bool            cutDecision;         // whether event passes current cut (independant from other cuts)
   bool            cutsDecision;        // whether event passes all cuts, without trigger
   bool            eventDecision;       // whether event passes all cuts and the trigger
@@ -64,19 +80,15 @@ struct CutCalculatorPayload
   bool            triggerDecision;
   bool            triggerFilterDecision;
   bool            metFilterDecision;
-  Cuts            cuts;
   vector<bool>    cumulativeEventFlags;
   vector<bool>    individualEventFlags;
+  vector<bool>    evaluatedCuts;       // whether each cut was evaluated, which is false for those skipped by a lazy CutCalculator
   vector<bool>    triggerFlags;
   vector<bool>    vetoTriggerFlags;
   vector<bool>    triggerFilterFlags;
   vector<bool>    triggerInMenuFlags;
   vector<bool>    metFilterFlags;
-  vector<string>  triggers;
-  vector<string>  triggersToVeto;
-  vector<string>  triggerFilters;
-  vector<string>  triggersInMenu;
-  vector<string>  metFilters;
+  const CutCalculatorMetadata *metadata = NULL;  // owned by the CutCalculator; not persistent
 };
 
 struct HistoDef {
@@ -98,6 +110,7 @@ struct HistoDef {
   vector<ValueLookupTree *> valueLookupTrees;
   int dimensions;
   bool weight;
+  vector<HistogramFillBuffer> histograms; // one for each weight variation, filled by the Plotter
 };
 
 struct BranchDef {
@@ -129,6 +142,12 @@ struct ScaleFactor
   vector<string> inputPlots;
   vector<double> inputLumis;
   string outputVariable;
+
+  // slots of the nominal, up, and down output variables in the
+  // EventVariableProducerPayload
+  unsigned outputSlot;
+  unsigned outputSlotUp;
+  unsigned outputSlotDown;
 };
 
 struct Node
@@ -164,6 +183,15 @@ struct Collections
   edm::Handle<vector<osu::PileUpInfo> >     pileupinfos;
   vector<edm::Handle<osu::Uservariable> >   uservariables;
   vector<edm::Handle<osu::Eventvariable> >  eventvariables;
+  vector<edm::Handle<vector<string> > >     eventvariableNames;   // for each run, for payloads read from a file
+  vector<edm::Handle<map<string, double> > > legacyEventvariables;   // from files written before EventVariableProducerPayload
+
+  // merged view of uservariables and eventvariables, rebuilt for each event
+  anatools::VariableIndex                   variables;
+
+  // values computed by the ValueLookupTree objects using these collections,
+  // invalidated for each event
+  ValueLookupCache                          cache;
 
   edm::Handle<TYPE(triggers)>                 triggers;
   edm::Handle<vector<TYPE(trigobjs)> >        trigobjs;
@@ -0,0 +1,200 @@
+#ifndef BINNED_LOOKUP
+#define BINNED_LOOKUP
+
+#include <algorithm>
+#include <vector>
+
+#include "TAxis.h"
+#include "TGraphAsymmErrors.h"
+#include "TH1.h"
+
+using namespace std;
+
+/*
+The BinnedLookup classes hold a copy of the binning, contents, and errors of a
+ROOT histogram, taken once when they are constructed, so that scale factors and
+weights can be looked up for every object without touching ROOT. They are only
+read after construction, so a single instance can be shared between threads.
+
+Bins are numbered as in ROOT: 1 to nBins () for the regular bins, 0 for the
+underflow, and nBins () + 1 for the overflow. findBin () gives the same bin as
+TAxis::FindBin (), using the same arithmetic for axes with fixed bin widths and
+a binary search over the bin edges otherwise. clampBin () gives the nearest
+regular bin instead, for weights which should be taken from the first or last
+bin when the argument is outside the range of the histogram.
+
+BinnedGraph does the same for a TGraphAsymmErrors, with each point covering the
+open interval (x - exlow, x + exhigh). findPoint () gives the point whose
+interval contains x, or the last point if there is none.
+*/
+
+class BinnedAxis
+{
+  public:
+    BinnedAxis ();
+    BinnedAxis (const TAxis &);
+
+    int nBins () const;
+    double lowEdge (const int) const;
+    double upEdge (const int) const;
+    double center (const int) const;
+
+    int findBin (const double) const;
+    int clampBin (const double) const;
+
+  private:
+    int nBins_;
+    double xMin_;
+    double xMax_;
+    bool fixedWidth_;
+    vector<double> edges_;
+};
+
+class BinnedLookup1D
+{
+  public:
+    BinnedLookup1D ();
+    BinnedLookup1D (const TH1 &);
+
+    bool empty () const;
+    const BinnedAxis &axis () const;
+
+    double content (const int) const;
+    double error (const int) const;
+
+    // content of the bin containing x, the equivalent of
+    // h->GetBinContent (h->FindBin (x))
+    double at (const double) const;
+
+  private:
+    BinnedAxis axis_;
+    vector<double> contents_;
+    vector<double> errors_;
+};
+
+class BinnedLookup2D
+{
+  public:
+    BinnedLookup2D ();
+    BinnedLookup2D (const TH1 &);
+
+    bool empty () const;
+    const BinnedAxis &xAxis () const;
+    const BinnedAxis &yAxis () const;
+
+    // global bin number, as given by TH1::GetBin ()
+    int bin (const int, const int) const;
+    int findBin (const double, const double) const;
+
+    double content (const int) const;
+    double error (const int) const;
+
+  private:
+    BinnedAxis xAxis_;
+    BinnedAxis yAxis_;
+    vector<double> contents_;
+    vector<double> errors_;
+};
+
+class BinnedGraph
+{
+  public:
+    BinnedGraph ();
+    BinnedGraph (const TGraphAsymmErrors &);
+
+    bool empty () const;
+    unsigned findPoint (const double) const;
+
+    double content (const unsigned) const;
+    double errorHigh (const unsigned) const;
+
+  private:
+    vector<double> low_;
+    vector<double> high_;
+    vector<double> contents_;
+    vector<double> errorsHigh_;
+
+    // true if the intervals are sorted and do not overlap, so that findPoint ()
+    // can use a binary search
+    bool ordered_;
+};
+
+inline int
+BinnedAxis::nBins () const
+{
+  return nBins_;
+}
+
+inline int
+BinnedAxis::findBin (const double x) const
+{
+  if (x < xMin_)
+    return 0;
+  if (!(x < xMax_))
+    return nBins_ + 1;
+  if (fixedWidth_)
+    return 1 + int (nBins_ * (x - xMin_) / (xMax_ - xMin_));
+  return upper_bound (edges_.begin (), edges_.end (), x) - edges_.begin ();
+}
+
+inline int
+BinnedAxis::clampBin (const double x) const
+{
+  return max (min (findBin (x), nBins_), 1);
+}
+
+inline double
+BinnedLookup1D::content (const int bin) const
+{
+  return contents_.at (bin);
+}
+
+inline double
+BinnedLookup1D::error (const int bin) const
+{
+  return errors_.at (bin);
+}
+
+inline double
+BinnedLookup1D::at (const double x) const
+{
+  return contents_.at (axis_.findBin (x));
+}
+
+inline int
+BinnedLookup2D::bin (const int binX, const int binY) const
+{
+  return binX + (xAxis_.nBins () + 2) * binY;
+}
+
+inline int
+BinnedLookup2D::findBin (const double x, const double y) const
+{
+  return bin (xAxis_.findBin (x), yAxis_.findBin (y));
+}
+
+inline double
+BinnedLookup2D::content (const int bin) const
+{
+  return contents_.at (bin);
+}
+
+inline double
+BinnedLookup2D::error (const int bin) const
+{
+  return errors_.at (bin);
+}
+
+inline double
+BinnedGraph::content (const unsigned point) const
+{
+  return contents_.at (point);
+}
+
+inline double
+BinnedGraph::errorHigh (const unsigned point) const
+{
+  return errorsHigh_.at (point);
+}
+
+#endif
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <vector>
@@ -5,6 +6,15 @@ using namespace std;
 class BtagSFWeight {
  public:
   bool filter(int t, int minTags);
-  double weight(vector<double> jets, int useMinTags);
+  double weight(const vector<double> &jets, int useMinTags);
   double sflookup(double jetCSV, double pt, double flavor, double jetEta);
+
+  // Probability of exactly k of the jets being tagged, for k = 0 to the
+  // number of jets, given the tagging probability of each jet. Computed in
+  // O(N^2), so callers needing several weights, e.g., >=1 and >=2 tags, or the
+  // up and down variations of the scale factors, should compute it once for
+  // each set of probabilities and use atLeast() and exactly() on the result.
+  vector<double> tagCountDistribution(const vector<double> &jets) const;
+  double atLeast(const vector<double> &distribution, int minTags) const;
+  double exactly(const vector<double> &distribution, int nTags) const;
 };
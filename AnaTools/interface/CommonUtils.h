@@ -7,6 +7,7 @@
 #ifndef COMMON_UTILS
 #define COMMON_UTILS
 
+#include <cstddef>
 #include <iostream>
 #include <map>
 #include <unordered_set>
@@ -26,6 +27,7 @@
 #include "OSUT3Analysis/AnaTools/interface/TypeWithDict.h"
 
 #include "OSUT3Analysis/AnaTools/interface/AnalysisTypes.h"
+#include "OSUT3Analysis/AnaTools/interface/TriggerObjectIndex.h"
 
 struct Tokens
 {
@@ -60,6 +62,8 @@ struct Tokens
 
   vector<edm::EDGetTokenT<osu::Uservariable> > uservariables;
   vector<edm::EDGetTokenT<osu::Eventvariable> > eventvariables;
+  vector<edm::EDGetTokenT<vector<string> > > eventvariableNames;
+  vector<edm::EDGetTokenT<map<string, double> > > legacyEventvariables;
 };
 
 namespace anatools
@@ -212,6 +216,51 @@ namespace anatools
 
   template <class T> double getMember (const T &obj, const string &member);
 
+  ////////////////////////////////////////////////////////////////////////////////
+  // A member of a type, data or function, which is resolved through the
+  // dictionary only once. The resolved chain of steps, including any
+  // intermediate members for nested members like
+  // innerTrack.hitPattern_.numberOfValidPixelHits, can then be read from any
+  // object of that type with no string comparisons and no heap allocations.
+  // If bind() fails, getMember() should be used instead.
+  ////////////////////////////////////////////////////////////////////////////////
+  class MemberAccessor
+  {
+    public:
+      MemberAccessor ();
+
+      bool bind (const string &type, const string &member);
+      bool isResolved () const;
+      bool isBound () const;
+      bool isDirect () const;   // bound to a data member, without calling any function
+      double value (void *obj);
+
+    private:
+      enum StepType { OFFSET, DEREFERENCE, NONNULL, INVOKE };
+      enum ValueType { FLOAT, DOUBLE, LONG_DOUBLE, CHAR, INT, UNSIGNED, UNSIGNED_SHORT, UNSIGNED_LONG, BOOL, SIGNED_CHAR, UNSIGNED_CHAR };
+
+      struct Step
+      {
+        StepType                        type;
+        long                            offset;
+        void                            (*function) (void *, int, void **, void *);
+        anatools::TypeWithDict          returnType;
+        bool                            destruct;
+        vector<max_align_t>             buffer;
+      };
+
+      bool resolve (const anatools::TypeWithDict &, const string &, anatools::TypeWithDict &);
+
+      string        type_;
+      string        member_;
+      bool          resolved_;
+      bool          bound_;
+      bool          direct_;
+      ValueType     valueType_;
+      vector<Step>  steps_;
+  };
+  ////////////////////////////////////////////////////////////////////////////////
+
 #ifdef ROOT6
   anatools::ObjectWithDict * getMember (const anatools::TypeWithDict &tDerived, const anatools::TypeWithDict &t, const anatools::ObjectWithDict &o, const string &member, string &memberType, map<pair<string, string>, pair<string, void (*) (void *, int, void **, void *)> > *);
   anatools::ObjectWithDict * invoke (const string &returnType, const anatools::ObjectWithDict &o, const anatools::FunctionWithDict &f);
@@ -291,28 +340,12 @@ anatools::isMatchedToTriggerObject (const edm::Event &event, const edm::TriggerR
 {
   if (collection == "")
     return false;
-  for (auto trigObj : trigObjs)
+  const TriggerObjectIndex &index = TriggerObjectIndex::get (event, triggers, trigObjs);
+  for (const auto &i : index.inCollection (collection))
     {
-#if CMSSW_VERSION_CODE >= CMSSW_VERSION(9,2,0)
-      trigObj.unpackNamesAndLabels(event, triggers);
-#else
-      trigObj.unpackPathNames(event.triggerNames(triggers));
-#endif
-      if (trigObj.collection () != collection)
+      if (filter != "" && !index.hasFilter (i, filter))
         continue;
-      if (filter != "")
-        {
-          bool flag = false;
-          for (const auto &filterLabel : trigObj.filterLabels ())
-            if (filterLabel == filter)
-              {
-                flag = true;
-                break;
-              }
-          if (!flag)
-            continue;
-        }
-      if (deltaR (obj, trigObj) > dR)
+      if (deltaR (obj, index.at (i)) > dR)
         continue;
 
       return true;
@@ -325,31 +358,14 @@ anatools::getMatchedTriggerObject (const edm::Event &event, const edm::TriggerRe
 {
   if (collection == "")
     return NULL;
+  const TriggerObjectIndex &index = TriggerObjectIndex::get (event, triggers, trigObjs);
   double minDR = -1.0;
-  int i = -1, iMinDR = -1;
-  for (auto trigObj : trigObjs)
+  int iMinDR = -1;
+  for (const auto &i : index.inCollection (collection))
     {
-      i++;
-#if CMSSW_VERSION_CODE >= CMSSW_VERSION(9,2,0)
-      trigObj.unpackNamesAndLabels(event, triggers);
-#else
-      trigObj.unpackPathNames(event.triggerNames(triggers));
-#endif
-      if (trigObj.collection () != collection)
+      if (filter != "" && !index.hasFilter (i, filter))
         continue;
-      if (filter != "")
-        {
-          bool flag = false;
-          for (const auto &filterLabel : trigObj.filterLabels ())
-            if (filterLabel == filter)
-              {
-                flag = true;
-                break;
-              }
-          if (!flag)
-            continue;
-        }
-      double currentDR = deltaR (obj, trigObj);
+      double currentDR = deltaR (obj, index.at (i));
       if (currentDR > dR)
         continue;
 
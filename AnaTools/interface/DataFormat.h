@@ -107,9 +107,9 @@ struct UserVariable
 typedef map<string, vector<UserVariable> > VariableProducerPayload;
 
 // EventVariableProducerPayload type:
-//   string - user-defined name of variable
-//   double - value of variable for the event
-typedef map<string, double > EventVariableProducerPayload;
+//   the value of each variable of one producer for the event, indexed as in
+//   the EventVariableSchema of the producer
+#include "OSUT3Analysis/AnaTools/interface/EventVariableProducerPayload.h"
 
 // define some macros with meaningful names for the ANSI color codes
 // https://en.wikipedia.org/wiki/ANSI_escape_code#Colors
@@ -1,16 +1,31 @@
 #ifndef EVENT_VARIABLE_PRODUCER
 #define EVENT_VARIABLE_PRODUCER
 
-#include "FWCore/Framework/interface/EDFilter.h"
+#include <atomic>
+
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/Run.h"
+#include "FWCore/Framework/interface/stream/EDFilter.h"
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
 
 #include "OSUT3Analysis/AnaTools/interface/AnalysisTypes.h"
 #include "OSUT3Analysis/AnaTools/interface/CommonUtils.h"
 
 
-class EventVariableProducer : public edm::EDFilter
+// The schema of a producer for the run, which is set by each of its streams
+// and written when the run ends.
+struct EventVariableProducerRunCache
+{
+  mutable atomic<EventVariableSchema *> schema;
+
+  EventVariableProducerRunCache () :
+    schema (NULL)
+  {
+  }
+};
+
+class EventVariableProducer : public edm::stream::EDFilter<edm::RunCache<EventVariableProducerRunCache>, edm::EndRunProducer>
   {
     public:
       EventVariableProducer (const edm::ParameterSet &);
@@ -18,7 +33,13 @@ class EventVariableProducer : public edm::EDFilter
 
       // Methods
 
-      bool filter (edm::Event &, const edm::EventSetup &);
+      static shared_ptr<EventVariableProducerRunCache> globalBeginRun (const edm::Run &, const edm::EventSetup &, const GlobalCache *);
+      static void globalEndRun (const edm::Run &, const edm::EventSetup &, const RunContext *);
+      static void globalEndRunProduce (edm::Run &, const edm::EventSetup &, const RunContext *);
+
+      // Subclasses overriding beginRun () must call this one as well.
+      void beginRun (const edm::Run &, const edm::EventSetup &) override;
+      bool filter (edm::Event &, const edm::EventSetup &) override;
 
     protected:
 
@@ -28,8 +49,20 @@ class EventVariableProducer : public edm::EDFilter
       unordered_set<string> objectsToGet_;
       unique_ptr<EventVariableProducerPayload> eventvariables;
 
+      // Methods
+
+      // Returns the index of the named variable in the payload, which should
+      // be declared in the constructor and set with eventvariables->set () for
+      // each event.
+      unsigned declareVariable (const string &) const;
+
     private:
 
+      // Variables
+
+      EventVariableSchema *schema_;   // shared by all the streams of this producer
+      unsigned filterDecision_;
+
       // Methods
 
       virtual void AddVariables(const edm::Event &, const edm::EventSetup &) = 0;
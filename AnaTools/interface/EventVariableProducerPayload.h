@@ -0,0 +1,325 @@
+#ifndef EVENT_VARIABLE_PRODUCER_PAYLOAD
+#define EVENT_VARIABLE_PRODUCER_PAYLOAD
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+/*
+Every event variable in the job is given a dense integer slot by the
+EventVariableRegistry the first time its name is declared, and readers like
+the ValueLookupTree resolve each name to a slot once, so no strings are built
+or compared for each event.
+
+Each producer numbers its own variables in the order in which it declares
+them, in an EventVariableSchema shared by all of its streams. Producers
+declare their variables once, in their constructors, and set them by index for
+each event. Access by name is kept for producers which only know the names of
+some of their variables while processing an event, and declares any name not
+seen before. Such names are numbered in the order in which they are first set,
+so a producer which sets them in an order that varies from event to event
+should declare them in its constructor instead, to keep the numbering the same
+in every job.
+
+An EventVariableProducerPayload holds the values of only the variables of the
+producer which made it, for one event, indexed as in its schema. The names in
+the schema are written once for each run, as a vector<string> with the same
+label as the payloads, and the payloads themselves hold no strings. A payload
+made in this job points to the schema of its producer, while one read from a
+file, which is created with the default constructor, does not, and is
+interpreted through the names written for its run. Files written before the
+payload replaced map<string, double> are merged by name.
+
+All three classes are defined entirely in this header, since the Collections
+package, which cannot link against AnaTools, also uses the payload.
+*/
+
+class EventVariableRegistry
+{
+  public:
+    static EventVariableRegistry &instance ();
+
+    unsigned slot (const string &);           // declares the name if it is new
+    int find (const string &) const;          // returns -1 if not declared
+
+  private:
+    EventVariableRegistry ();
+
+    mutable mutex                    mutex_;
+    unordered_map<string, unsigned>  slots_;
+    vector<string>                   names_;
+};
+
+class EventVariableSchema
+{
+  public:
+    // The schema of the producer with the given module label, shared by all
+    // of its streams for the whole job.
+    static EventVariableSchema *forProducer (const string &);
+
+    unsigned declare (const string &);        // declares the name in the registry as well
+    int find (const string &) const;          // returns -1 if not declared
+    vector<string> names () const;
+    unsigned size () const;
+
+  private:
+    EventVariableSchema ();
+
+    mutable mutex                    mutex_;
+    unordered_map<string, unsigned>  indices_;
+    vector<string>                   names_;
+};
+
+class EventVariableProducerPayload
+{
+  public:
+    EventVariableProducerPayload ();
+    EventVariableProducerPayload (EventVariableSchema *);   // the schema of the producer making it
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Methods for accessing a variable by its index. get () returns
+    // INVALID_VALUE for a variable which has not been set.
+    ////////////////////////////////////////////////////////////////////////////
+    void set (const unsigned, const double);
+    bool isSet (const unsigned) const;
+    double get (const unsigned) const;
+    unsigned size () const;
+    ////////////////////////////////////////////////////////////////////////////
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Methods for accessing a variable by its name, as with the
+    // map<string, double> which this class replaces, which need the schema of
+    // the producer. at () throws std::out_of_range for a variable which has
+    // not been set.
+    ////////////////////////////////////////////////////////////////////////////
+    double &operator[] (const string &);
+    double at (const string &) const;
+    unsigned count (const string &) const;
+    ////////////////////////////////////////////////////////////////////////////
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Methods for copying the variables set in the argument which are not
+    // already set in this payload, from a payload with the given index in
+    // this payload for each of its variables, or from a map of names to the
+    // slots of the registry.
+    ////////////////////////////////////////////////////////////////////////////
+    void merge (const EventVariableProducerPayload &, const vector<unsigned> &);
+    void merge (const map<string, double> &);
+    ////////////////////////////////////////////////////////////////////////////
+
+    // The schema of the producer, or NULL if the payload was read from a file.
+    EventVariableSchema *schema () const;
+
+    // Unsets every variable, keeping the storage for reuse.
+    void clear ();
+
+  private:
+    vector<double>        values_;
+    vector<bool>          isSet_;
+    EventVariableSchema  *schema_;   // transient
+
+    void resize (const unsigned);
+};
+
+inline EventVariableRegistry &
+EventVariableRegistry::instance ()
+{
+  static EventVariableRegistry registry;
+  return registry;
+}
+
+inline
+EventVariableRegistry::EventVariableRegistry ()
+{
+}
+
+inline unsigned
+EventVariableRegistry::slot (const string &name)
+{
+  lock_guard<mutex> lock (mutex_);
+  auto slot = slots_.find (name);
+  if (slot != slots_.end ())
+    return slot->second;
+  names_.push_back (name);
+  return (slots_[name] = names_.size () - 1);
+}
+
+inline int
+EventVariableRegistry::find (const string &name) const
+{
+  lock_guard<mutex> lock (mutex_);
+  auto slot = slots_.find (name);
+  return (slot != slots_.end () ? (int) slot->second : -1);
+}
+
+inline EventVariableSchema *
+EventVariableSchema::forProducer (const string &label)
+{
+  static mutex schemasMutex;
+  static map<string, unique_ptr<EventVariableSchema> > schemas;
+
+  lock_guard<mutex> lock (schemasMutex);
+  auto &schema = schemas[label];
+  if (!schema)
+    schema = unique_ptr<EventVariableSchema> (new EventVariableSchema ());
+  return schema.get ();
+}
+
+inline
+EventVariableSchema::EventVariableSchema ()
+{
+}
+
+inline unsigned
+EventVariableSchema::declare (const string &name)
+{
+  lock_guard<mutex> lock (mutex_);
+  auto index = indices_.find (name);
+  if (index != indices_.end ())
+    return index->second;
+  EventVariableRegistry::instance ().slot (name);
+  names_.push_back (name);
+  return (indices_[name] = names_.size () - 1);
+}
+
+inline int
+EventVariableSchema::find (const string &name) const
+{
+  lock_guard<mutex> lock (mutex_);
+  auto index = indices_.find (name);
+  return (index != indices_.end () ? (int) index->second : -1);
+}
+
+inline vector<string>
+EventVariableSchema::names () const
+{
+  lock_guard<mutex> lock (mutex_);
+  return names_;
+}
+
+inline unsigned
+EventVariableSchema::size () const
+{
+  lock_guard<mutex> lock (mutex_);
+  return names_.size ();
+}
+
+inline
+EventVariableProducerPayload::EventVariableProducerPayload () :
+  schema_  (NULL)
+{
+}
+
+inline
+EventVariableProducerPayload::EventVariableProducerPayload (EventVariableSchema *schema) :
+  values_  (schema->size (), 0.0),
+  isSet_   (schema->size (), false),
+  schema_  (schema)
+{
+}
+
+inline void
+EventVariableProducerPayload::resize (const unsigned size)
+{
+  if (size > values_.size ())
+    {
+      values_.resize (size, 0.0);
+      isSet_.resize (size, false);
+    }
+}
+
+inline void
+EventVariableProducerPayload::set (const unsigned index, const double value)
+{
+  resize (index + 1);
+  values_[index] = value;
+  isSet_[index] = true;
+}
+
+inline bool
+EventVariableProducerPayload::isSet (const unsigned index) const
+{
+  return (index < isSet_.size () && isSet_[index]);
+}
+
+inline double
+EventVariableProducerPayload::get (const unsigned index) const
+{
+  return (isSet (index) ? values_[index] : numeric_limits<int>::min ());
+}
+
+inline unsigned
+EventVariableProducerPayload::size () const
+{
+  return values_.size ();
+}
+
+inline double &
+EventVariableProducerPayload::operator[] (const string &name)
+{
+  if (!schema_)
+    throw logic_error ("event variable \"" + name + "\" cannot be set in a payload read from a file");
+  unsigned index = schema_->declare (name);
+  resize (index + 1);
+  isSet_[index] = true;
+  return values_[index];
+}
+
+inline double
+EventVariableProducerPayload::at (const string &name) const
+{
+  int index = (schema_ ? schema_->find (name) : -1);
+  if (index < 0 || !isSet (index))
+    throw out_of_range ("event variable \"" + name + "\" is not set");
+  return values_[index];
+}
+
+inline unsigned
+EventVariableProducerPayload::count (const string &name) const
+{
+  int index = (schema_ ? schema_->find (name) : -1);
+  return (index >= 0 && isSet (index));
+}
+
+inline void
+EventVariableProducerPayload::merge (const EventVariableProducerPayload &payload, const vector<unsigned> &indices)
+{
+  for (unsigned index = 0; index < payload.values_.size (); index++)
+    {
+      if (payload.isSet_[index] && !isSet (indices.at (index)))
+        set (indices.at (index), payload.values_[index]);
+    }
+}
+
+inline void
+EventVariableProducerPayload::merge (const map<string, double> &payload)
+{
+  for (const auto &variable : payload)
+    {
+      unsigned slot = EventVariableRegistry::instance ().slot (variable.first);
+      if (!isSet (slot))
+        set (slot, variable.second);
+    }
+}
+
+inline EventVariableSchema *
+EventVariableProducerPayload::schema () const
+{
+  return schema_;
+}
+
+inline void
+EventVariableProducerPayload::clear ()
+{
+  fill (isSet_.begin (), isSet_.end (), false);
+}
+
+#endif
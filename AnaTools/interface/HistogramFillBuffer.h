@@ -0,0 +1,89 @@
+#ifndef HISTOGRAM_FILL_BUFFER
+#define HISTOGRAM_FILL_BUFFER
+
+#include <vector>
+
+#include "TH1.h"
+
+using namespace std;
+
+/*
+A HistogramFillBuffer holds a pointer to a booked 1D, 2D, or 3D histogram and
+collects the fills for it, each as a global bin number, the values, and a
+weight, until flush () adds them to the histogram all at once. This happens
+automatically when the buffer is full, and the owner must call flush () once
+more before the histogram is written. Since the copies of a histogram made for
+different weights all have the same binning, the bin is found once with
+findBin () and the same fill can be added to each of them.
+
+flush () gives the same bin contents, errors, number of entries, and
+statistics as calling TH1::Fill () for each fill in turn, assuming the default
+of fills outside the range of the histogram not counting towards the
+statistics. The statistics are read and written once per flush instead of
+being updated by every fill.
+*/
+
+class HistogramFillBuffer
+{
+  public:
+    HistogramFillBuffer ();
+    HistogramFillBuffer (TH1 * const, const unsigned = 64);
+
+    TH1 *histogram () const;
+
+    // global bin number, as given by TH1::FindFixBin ()
+    int findBin (const double) const;
+    int findBin (const double, const double) const;
+    int findBin (const double, const double, const double) const;
+
+    void fill (const int, const double, const double, const double = 0.0, const double = 0.0);
+    void flush ();
+
+  private:
+    struct Fill
+    {
+      int     bin;
+      double  weight;
+      double  x;
+      double  y;
+      double  z;
+    };
+
+    TH1 *histogram_;
+    unsigned capacity_;
+    vector<Fill> fills_;
+};
+
+inline TH1 *
+HistogramFillBuffer::histogram () const
+{
+  return histogram_;
+}
+
+inline int
+HistogramFillBuffer::findBin (const double x) const
+{
+  return histogram_->GetXaxis ()->FindFixBin (x);
+}
+
+inline int
+HistogramFillBuffer::findBin (const double x, const double y) const
+{
+  return histogram_->GetBin (histogram_->GetXaxis ()->FindFixBin (x), histogram_->GetYaxis ()->FindFixBin (y));
+}
+
+inline int
+HistogramFillBuffer::findBin (const double x, const double y, const double z) const
+{
+  return histogram_->GetBin (histogram_->GetXaxis ()->FindFixBin (x), histogram_->GetYaxis ()->FindFixBin (y), histogram_->GetZaxis ()->FindFixBin (z));
+}
+
+inline void
+HistogramFillBuffer::fill (const int bin, const double weight, const double x, const double y, const double z)
+{
+  fills_.push_back ({bin, weight, x, y, z});
+  if (fills_.size () >= capacity_)
+    flush ();
+}
+
+#endif
@@ -0,0 +1,152 @@
+#ifndef OBJECT_FLAGS
+#define OBJECT_FLAGS
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/*
+An ObjectFlags object holds two flags for every object in every collection on
+which the CutCalculator sets flags, for every cut: whether the object passes
+the cut, and whether the flag is valid, e.g., the flags for non-unique
+combinations in composite collections like muon-muons are not valid.
+
+Collections are identified by integers which the CutCalculator assigns after
+unpacking the cuts, and collectionID() converts the name of a collection into
+this integer. Each set of flags is packed into a bitset, with one word holding
+the flags for 64 objects, so that the flags for a whole collection can be
+combined or counted a word at a time. Bits beyond the last object of a
+collection are always zero.
+*/
+
+class ObjectFlags
+{
+  public:
+    typedef unsigned long long Word;
+    static const unsigned BITS_PER_WORD = 64;
+
+    ObjectFlags ();
+
+    // Sets the number of cuts, and the name and number of objects of each
+    // collection, and clears all the flags.
+    void reset (const unsigned, const vector<string> &, const vector<unsigned> &);
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Methods describing the layout of the flags.
+    ////////////////////////////////////////////////////////////////////////////
+    bool empty () const;
+    unsigned nCuts () const;
+    unsigned nCollections () const;
+    int collectionID (const string &) const;    // returns -1 if not found
+    const string &collectionName (const unsigned) const;
+    unsigned size (const unsigned) const;       // number of objects in a collection
+    unsigned nWords (const unsigned) const;     // number of words per bitset for a collection
+    ////////////////////////////////////////////////////////////////////////////
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Methods for accessing the flags of a single object, given the cut, the
+    // collection, and the index of the object.
+    ////////////////////////////////////////////////////////////////////////////
+    bool passes (const unsigned, const unsigned, const unsigned) const;
+    bool valid (const unsigned, const unsigned, const unsigned) const;
+    void set (const unsigned, const unsigned, const unsigned, const bool, const bool);
+    void setPasses (const unsigned, const unsigned, const unsigned, const bool);
+    ////////////////////////////////////////////////////////////////////////////
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Methods for accessing the bitsets of a whole collection, given the cut
+    // and the collection, and for counting the objects which are both valid
+    // and passing.
+    ////////////////////////////////////////////////////////////////////////////
+    Word *passesWords (const unsigned, const unsigned);
+    const Word *passesWords (const unsigned, const unsigned) const;
+    Word *validWords (const unsigned, const unsigned);
+    const Word *validWords (const unsigned, const unsigned) const;
+    unsigned count (const unsigned, const unsigned) const;
+    ////////////////////////////////////////////////////////////////////////////
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Helper methods for reading and writing single bits in a bitset.
+    ////////////////////////////////////////////////////////////////////////////
+    static bool getBit (const Word * const, const unsigned);
+    static void setBit (Word * const, const unsigned, const bool);
+    static unsigned nWordsFor (const unsigned);
+    ////////////////////////////////////////////////////////////////////////////
+
+  private:
+    unsigned word (const unsigned, const unsigned) const;
+
+    unsigned          nCuts_;
+    unsigned          wordsPerCut_;
+    vector<string>    collections_;
+    vector<unsigned>  sizes_;
+    vector<unsigned>  offsets_;
+    vector<Word>      passes_;
+    vector<Word>      valid_;
+};
+
+inline unsigned
+ObjectFlags::word (const unsigned cut, const unsigned collection) const
+{
+  return cut * wordsPerCut_ + offsets_.at (collection);
+}
+
+inline bool
+ObjectFlags::getBit (const Word * const words, const unsigned i)
+{
+  return (words[i / BITS_PER_WORD] >> (i % BITS_PER_WORD)) & 1;
+}
+
+inline void
+ObjectFlags::setBit (Word * const words, const unsigned i, const bool value)
+{
+  if (value)
+    words[i / BITS_PER_WORD] |= (Word (1) << (i % BITS_PER_WORD));
+  else
+    words[i / BITS_PER_WORD] &= ~(Word (1) << (i % BITS_PER_WORD));
+}
+
+inline unsigned
+ObjectFlags::nWordsFor (const unsigned nBits)
+{
+  return (nBits + BITS_PER_WORD - 1) / BITS_PER_WORD;
+}
+
+inline bool
+ObjectFlags::passes (const unsigned cut, const unsigned collection, const unsigned object) const
+{
+  return getBit (&passes_.at (word (cut, collection)), object);
+}
+
+inline bool
+ObjectFlags::valid (const unsigned cut, const unsigned collection, const unsigned object) const
+{
+  return getBit (&valid_.at (word (cut, collection)), object);
+}
+
+inline ObjectFlags::Word *
+ObjectFlags::passesWords (const unsigned cut, const unsigned collection)
+{
+  return passes_.data () + word (cut, collection);
+}
+
+inline const ObjectFlags::Word *
+ObjectFlags::passesWords (const unsigned cut, const unsigned collection) const
+{
+  return passes_.data () + word (cut, collection);
+}
+
+inline ObjectFlags::Word *
+ObjectFlags::validWords (const unsigned cut, const unsigned collection)
+{
+  return valid_.data () + word (cut, collection);
+}
+
+inline const ObjectFlags::Word *
+ObjectFlags::validWords (const unsigned cut, const unsigned collection) const
+{
+  return valid_.data () + word (cut, collection);
+}
+
+#endif
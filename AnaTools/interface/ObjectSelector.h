@@ -5,9 +5,9 @@
 
 #include "DataFormats/Common/interface/Handle.h"
 
-#include "FWCore/Framework/interface/EDFilter.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/stream/EDFilter.h"
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
 
 #include "OSUT3Analysis/AnaTools/interface/CommonUtils.h"
@@ -15,13 +15,13 @@
 #define EXIT_CODE 2
 
 template<class T, class TO>
-class ObjectSelector : public edm::EDFilter
+class ObjectSelector : public edm::stream::EDFilter<>
 {
   public:
     ObjectSelector (const edm::ParameterSet &);
     ~ObjectSelector ();
 
-    bool filter (edm::Event &, const edm::EventSetup &);
+    bool filter (edm::Event &, const edm::EventSetup &) override;
 
   private:
     ////////////////////////////////////////////////////////////////////////////
@@ -110,6 +110,19 @@ template<class T, class TO> bool
     }
   //////////////////////////////////////////////////////////////////////////////
 
+  //////////////////////////////////////////////////////////////////////////////
+  // Find the integer identifying the collection to filter in the cut
+  // decisions, and quit if no flags were set for it.
+  //////////////////////////////////////////////////////////////////////////////
+  int collectionID = -1;
+  if (cutDecisions.isValid () && !cutDecisions->cumulativeObjectFlags.empty ()
+   && (collectionID = cutDecisions->cumulativeObjectFlags.collectionID (collectionToFilter_)) < 0)
+    {
+      clog << "ERROR: no flags have been set for " << collectionToFilter_ << "." << endl;
+      exit (EXIT_CODE);
+    }
+  //////////////////////////////////////////////////////////////////////////////
+
   //////////////////////////////////////////////////////////////////////////////
   // Fill the payload with the objects from the collection which pass all cuts.
   // If the collection could not be retrieved, the payload remains empty. If the
@@ -125,13 +138,11 @@ template<class T, class TO> bool
           unsigned iObject = object - collection->begin ();
           bool passes = true;
 
-          if (cutDecisions.isValid ())
+          if (cutDecisions.isValid () && !cutDecisions->cumulativeObjectFlags.empty ())
             {
-              for (int iCut = cutDecisions->cumulativeObjectFlags.size () - 1; iCut >= 0; iCut--)
-                {
-                  passes = (cutDecisions->cumulativeObjectFlags.at (iCut).at (collectionToFilter_).at (iObject).second ? cutDecisions->cumulativeObjectFlags.at (iCut).at (collectionToFilter_).at (iObject).first : false);
-                  break;
-                }
+              const ObjectFlags &flags = cutDecisions->cumulativeObjectFlags;
+              unsigned iCut = flags.nCuts () - 1;
+              passes = (flags.valid (iCut, collectionID, iObject) ? flags.passes (iCut, collectionID, iObject) : false);
             }
           if (passes)
             {
@@ -11,6 +11,8 @@
 #include "TH1D.h"
 #include "TFile.h"
 
+#include "OSUT3Analysis/AnaTools/interface/BinnedLookup.h"
+
 using namespace std;
 
 class PUWeight
@@ -18,12 +20,11 @@ class PUWeight
     public:
       PUWeight () {};
       PUWeight (const string &, const string &, const string &);
-      ~PUWeight ();
-      double operator[] (const unsigned &pu) { return puWeight_->GetBinContent (puWeight_->FindBin (pu)); };
-      double at (const unsigned &pu) { return (*this)[pu]; };
+      double operator[] (const unsigned &pu) const { return puWeight_.at (pu); };
+      double at (const unsigned &pu) const { return (*this)[pu]; };
 
     private:
-      TH1D *puWeight_;
+      BinnedLookup1D puWeight_;
   };
 
 #endif
@@ -16,6 +16,8 @@
 #include "TGraphAsymmErrors.h"
 #include "TFile.h"
 
+#include "OSUT3Analysis/AnaTools/interface/BinnedLookup.h"
+
 using namespace std;
 
 
@@ -37,11 +39,10 @@ class MuonSFWeight
     public:
       MuonSFWeight () {};
       MuonSFWeight (const string &, const string &);
-      ~MuonSFWeight ();
-      double at (const double &, const double &, const int &shiftUpDown = 0);
+      double at (const double &, const double &, const int &shiftUpDown = 0) const;
 
     private:
-      TH2 *muonSFWeight_;
+      BinnedLookup2D muonSFWeight_;
   };
 
 
@@ -51,14 +52,14 @@ class ElectronSFWeight
     public:
       ElectronSFWeight () {};
       ElectronSFWeight (const string &, const string &, const string &sfFile = "", const string &dataOverMC = "");
-      ~ElectronSFWeight ();
-      double at (const double &, const double &, const int &shiftUpDown = 0);
+      double at (const double &, const double &, const int &shiftUpDown = 0) const;
 
     private:
       string cmsswRelease_;
       string id_;
 
-      TH2F *electronSFWeight_;
+      BinnedLookup2D electronSFWeight_;
+      bool ptOnXAxis_;
   };
 
 
@@ -67,11 +68,10 @@ class TriggerMetSFWeight
   {
     public:
       TriggerMetSFWeight (const string &sfFile, const string &dataOverMC);
-      ~TriggerMetSFWeight ();
-      double at (const double &Met, const int &shiftUpDown = 0);
+      double at (const double &Met, const int &shiftUpDown = 0) const;
 
     private:
-      TH1F *triggerMetSFWeight_;
+      BinnedLookup1D triggerMetSFWeight_;
   };
 
 class TrackNMissOutSFWeight
@@ -79,11 +79,10 @@ class TrackNMissOutSFWeight
   {
     public:
       TrackNMissOutSFWeight (const string &sfFile, const string &dataOverMC);
-      ~TrackNMissOutSFWeight ();
-      double at (const double &NMissOut, const int &shiftUpDown = 0);
+      double at (const double &NMissOut, const int &shiftUpDown = 0) const;
 
     private:
-      TH1F *trackNMissOutSFWeight_;
+      BinnedLookup1D trackNMissOutSFWeight_;
   };
 
 class EcaloVarySFWeight
@@ -91,11 +90,10 @@ class EcaloVarySFWeight
 {
  public:
   EcaloVarySFWeight (const string &sfFile, const string &dataOverMC);
-  ~EcaloVarySFWeight ();
-  double at (const double &EcaloVary, const int &shiftUpDown = 0);
+  double at (const double &EcaloVary, const int &shiftUpDown = 0) const;
 
  private:
-  TH1F *EcaloVarySFWeight_;
+  BinnedLookup1D EcaloVarySFWeight_;
 };
 
 
@@ -105,11 +103,10 @@ class IsrVarySFWeight
   {
     public:
       IsrVarySFWeight (const string &sfFile, const string &dataOverMC);
-      ~IsrVarySFWeight ();
-      double at (const double &ptSusy, const int &shiftUpDown = 0);
+      double at (const double &ptSusy, const int &shiftUpDown = 0) const;
 
     private:
-      TH1F *isrVarySFWeight_;
+      BinnedLookup1D isrVarySFWeight_;
   };
 
 class MuonCutWeight
@@ -117,11 +114,10 @@ class MuonCutWeight
   {
     public:
       MuonCutWeight (const string &sfFile, const string &dataOverMC);
-      ~MuonCutWeight ();
-      double at (const double &pt);
+      double at (const double &pt) const;
 
     private:
-      TH1F *muonCutWeight_;
+      BinnedLookup1D muonCutWeight_;
   };
 
 
@@ -130,11 +126,10 @@ class ElectronCutWeight
   {
     public:
       ElectronCutWeight (const string &sfFile, const string &dataOverMC);
-      ~ElectronCutWeight ();
-      double at (const double &d0);
+      double at (const double &d0) const;
 
     private:
-      TH1F *electronCutWeight_;
+      BinnedLookup1D electronCutWeight_;
   };
 
 
@@ -143,11 +138,10 @@ class RecoElectronWeight
   {
     public:
       RecoElectronWeight (const string &sfFile, const string &dataOverMC);
-      ~RecoElectronWeight ();
-      double at (const double &d0);
+      double at (const double &d0) const;
 
     private:
-      TH1F *recoElectronWeight_;
+      BinnedLookup1D recoElectronWeight_;
   };
 
 
@@ -156,11 +150,10 @@ class RecoMuonWeight
   {
     public:
       RecoMuonWeight (const string &sfFile, const string &dataOverMC);
-      ~RecoMuonWeight ();
-      double at (const double &d0);
+      double at (const double &d0) const;
 
     private:
-      TH1F *recoMuonWeight_;
+      BinnedLookup1D recoMuonWeight_;
   };
 
 
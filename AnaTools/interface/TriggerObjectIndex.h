@@ -0,0 +1,70 @@
+#ifndef TRIGGER_OBJECT_INDEX
+#define TRIGGER_OBJECT_INDEX
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "FWCore/Framework/interface/Event.h"
+#include "DataFormats/Common/interface/TriggerResults.h"
+
+#include "OSUT3Analysis/AnaTools/interface/DataFormat.h"
+
+#if IS_VALID(trigobjs)
+
+using namespace std;
+
+/*
+A TriggerObjectIndex holds a copy of every trigger object in an event with its
+path names and filter labels unpacked, along with the indices of the objects in
+each collection and of the objects passing each filter. Looking up trigger
+objects by collection and filter is then a hash lookup, instead of copying and
+unpacking every trigger object for every query.
+
+There is one index per thread, returned by get(), which rebuilds it the first
+time it is called for a new event or for a different collection of trigger
+objects. The indices refer to positions in the original collection, so
+pointers to the original objects can still be returned to the caller.
+*/
+
+namespace anatools
+{
+  class TriggerObjectIndex
+    {
+      public:
+        static const TriggerObjectIndex &get (const edm::Event &, const edm::TriggerResults &, const vector<pat::TriggerObjectStandAlone> &);
+
+        // the unpacked copy of the i-th trigger object
+        const pat::TriggerObjectStandAlone &at (const unsigned) const;
+
+        // indices, in increasing order, of the objects in a collection, or
+        // with a filter label
+        const vector<unsigned> &inCollection (const string &) const;
+        const vector<unsigned> &withFilter (const string &) const;
+
+        bool hasFilter (const unsigned, const string &) const;
+
+      private:
+        TriggerObjectIndex ();
+
+        void build (const edm::Event &, const edm::TriggerResults &, const vector<pat::TriggerObjectStandAlone> &);
+
+        edm::EventID eventID_;
+        const vector<pat::TriggerObjectStandAlone> *trigObjs_;
+
+        vector<pat::TriggerObjectStandAlone> unpacked_;
+        unordered_map<string, vector<unsigned> > byCollection_;
+        unordered_map<string, vector<unsigned> > byFilter_;
+        vector<unsigned> none_;
+    };
+}
+
+inline const pat::TriggerObjectStandAlone &
+anatools::TriggerObjectIndex::at (const unsigned i) const
+{
+  return unpacked_.at (i);
+}
+
+#endif
+
+#endif
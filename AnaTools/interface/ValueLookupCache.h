@@ -0,0 +1,176 @@
+#ifndef VALUE_LOOKUP_CACHE
+#define VALUE_LOOKUP_CACHE
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/*
+A ValueLookupCache object holds values which have already been computed by any
+ValueLookupTree in the current event, so that the trees of a module which
+evaluate the same members or the same expressions, e.g., the cuts of all the
+channels of a CutCalculator, or the histograms of a Plotter, only compute them
+once.
+
+Values are stored in dense columns, one for each collection and each integer
+identifying what was computed, indexed by the local index of the object in its
+collection. Collections are given an integer the first time a tree reads from
+them. For members, e.g., "osu::Muon.pt", the integer is assigned the first time
+the member is read. For subexpressions, e.g., "abs(eta)" for muons, it is
+assigned when a tree is compiled. Each cache counts the number of times each
+subexpression appears in the trees using it, as they are first given their
+collections, and only stores those which appear more than once. Members which are read directly from the object, without
+calling any function, are cheaper to read again than to look up, so they are
+never stored.
+
+The integers are shared by the whole process, but each Collections object has
+its own cache, so there is one per module and per stream and it is only ever
+used by one thread at a time. Values are therefore not shared between modules. Each stored value is stamped with the event it
+was computed in, so beginEvent(), which is called by
+anatools::getRequiredCollections(), invalidates all of them without touching
+the columns, which keep their size from one event to the next.
+*/
+
+class ValueLookupCache
+{
+  public:
+    // The number of hits and misses of a cache, or summed over several.
+    struct Counters
+    {
+      unsigned long  memberHits = 0;
+      unsigned long  memberMisses = 0;
+      unsigned long  subexpressionHits = 0;
+      unsigned long  subexpressionMisses = 0;
+
+      Counters &operator+= (const Counters &);
+    };
+
+    // A subexpression which has been registered by at least one tree.
+    struct Subexpression
+    {
+      unsigned  key;
+    };
+
+    ValueLookupCache ();
+
+    // Invalidates all the cached values.
+    void beginEvent ();
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Methods for assigning integers to collections, members, and
+    // subexpressions. The returned subexpression remains valid until the end
+    // of the job.
+    ////////////////////////////////////////////////////////////////////////////
+    static unsigned getCollectionKey (const string &);
+    static unsigned getMemberKey (const string &);
+    static const Subexpression *registerSubexpression (const string &);
+    ////////////////////////////////////////////////////////////////////////////
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Methods for counting the trees using this cache in which a subexpression
+    // appears, and for checking whether it appears in more than one.
+    ////////////////////////////////////////////////////////////////////////////
+    void addSubexpressionUse (const Subexpression * const);
+    bool isShared (const Subexpression * const) const;
+    ////////////////////////////////////////////////////////////////////////////
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Methods for retrieving and storing the values for the object with the
+    // given local index in the given collection. The get methods return false
+    // if the value has not been stored in the current event.
+    ////////////////////////////////////////////////////////////////////////////
+    bool getMember (const unsigned, const unsigned, const unsigned, double &);
+    void setMember (const unsigned, const unsigned, const unsigned, const double);
+    bool getSubexpression (const unsigned, const Subexpression * const, const unsigned, double &);
+    void setSubexpression (const unsigned, const Subexpression * const, const unsigned, const double);
+    ////////////////////////////////////////////////////////////////////////////
+
+    // Returns the number of hits and misses of this cache so far.
+    const Counters &counters () const;
+
+    // Returns the given number of hits and misses as a printable string.
+    static string summary (const Counters &);
+
+  private:
+    struct Column
+    {
+      vector<double>    values;
+      vector<unsigned>  events;   // value of event_ when each value was stored
+    };
+    typedef vector<vector<Column> > Table;   // indexed by collection, then key
+
+    bool get (const Table &, const unsigned, const unsigned, const unsigned, double &) const;
+    void set (Table &, const unsigned, const unsigned, const unsigned, const double);
+
+    unsigned          event_;
+    Table             members_;
+    Table             subexpressions_;
+    vector<unsigned>  subexpressionUses_;   // indexed by key
+
+    Counters          counters_;
+};
+
+inline bool
+ValueLookupCache::get (const Table &table, const unsigned collection, const unsigned key, const unsigned index, double &value) const
+{
+  if (collection >= table.size () || key >= table[collection].size ())
+    return false;
+  const Column &column = table[collection][key];
+  if (index >= column.events.size () || column.events[index] != event_)
+    return false;
+  value = column.values[index];
+  return true;
+}
+
+inline void
+ValueLookupCache::addSubexpressionUse (const Subexpression * const subexpression)
+{
+  if (subexpression->key >= subexpressionUses_.size ())
+    subexpressionUses_.resize (subexpression->key + 1, 0);
+  subexpressionUses_[subexpression->key]++;
+}
+
+inline bool
+ValueLookupCache::isShared (const Subexpression * const subexpression) const
+{
+  return (subexpression->key < subexpressionUses_.size () && subexpressionUses_[subexpression->key] > 1);
+}
+
+inline bool
+ValueLookupCache::getMember (const unsigned collection, const unsigned key, const unsigned index, double &value)
+{
+  if (get (members_, collection, key, index, value))
+    {
+      counters_.memberHits++;
+      return true;
+    }
+  counters_.memberMisses++;
+  return false;
+}
+
+inline void
+ValueLookupCache::setMember (const unsigned collection, const unsigned key, const unsigned index, const double value)
+{
+  set (members_, collection, key, index, value);
+}
+
+inline bool
+ValueLookupCache::getSubexpression (const unsigned collection, const Subexpression * const subexpression, const unsigned index, double &value)
+{
+  if (get (subexpressions_, collection, subexpression->key, index, value))
+    {
+      counters_.subexpressionHits++;
+      return true;
+    }
+  counters_.subexpressionMisses++;
+  return false;
+}
+
+inline void
+ValueLookupCache::setSubexpression (const unsigned collection, const Subexpression * const subexpression, const unsigned index, const double value)
+{
+  set (subexpressions_, collection, subexpression->key, index, value);
+}
+
+#endif
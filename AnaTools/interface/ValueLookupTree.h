@@ -7,6 +7,8 @@
 #include <unordered_set>
 
 #include "OSUT3Analysis/AnaTools/interface/AnalysisTypes.h"
+#include "OSUT3Analysis/AnaTools/interface/CommonUtils.h"
+#include "OSUT3Analysis/AnaTools/interface/ValueLookupCache.h"
 
 /*
 A ValueLookupTree object contains all the information needed to
@@ -82,9 +84,82 @@ This will be converted to the following, by the prunedCommas() and prunedParenth
           /   \
        muon   muon
 
+After pruning, the tree is compiled by the compile() function into a flat
+program of instructions in postfix order. For "abs(eta) < 2.5" this is:
+
+   LOOKUP eta, ABS, CONSTANT 2.5, LT
+
+Numbers are parsed once, operators are stored as opcodes, and each member
+access is stored as an index into a table of (collection, variable) slots. The
+evaluate() function then runs this program on a stack of doubles instead of
+walking the tree. Any expression that cannot be compiled, e.g., one that would
+produce an evaluation error, falls back to the recursive evaluate_() function.
+
+If the program only reads members of a single input collection, e.g., muons for
+"pt > 25 && abs(eta) < 2.1", evaluate() runs it once over the whole collection
+instead of once per object. Each member is gathered into a column of doubles
+and each operator is applied to entire columns at a time.
+
+Member values, and the values of subexpressions of single-collection programs,
+are shared with every other tree using the same Collections through its
+ValueLookupCache, keyed by the collection and the local index of the object.
+Members read directly from the object, without a function call, are not
+cached, since reading them again is cheaper. Each such
+subexpression is bracketed by a CACHE_LOAD instruction, which skips ahead to
+the matching CACHE_STORE if the value was already computed in this event by
+any tree, and the CACHE_STORE instruction, which saves it, e.g.:
+
+   CACHE_LOAD, LOOKUP eta, ABS, CACHE_STORE
+
+Each slot, like each (collection, variable) pair looked up by evaluate_(), is
+bound the first time it is read to an anatools::MemberAccessor, which resolves
+the member through the dictionary once. Subsequent reads follow the cached
+chain of offsets and function calls directly.
+
 */
 
-typedef unordered_multimap<string, DressedObject> ObjMap;
+enum Opcode
+{
+  OP_CONSTANT, OP_LOOKUP,
+  OP_OR, OP_AND, OP_EQ, OP_NE, OP_LT, OP_LE, OP_GT, OP_GE,
+  OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_MOD, OP_POS, OP_NEG, OP_NOT,
+  OP_ATAN2, OP_LDEXP, OP_POW, OP_HYPOT, OP_FMOD, OP_REMAINDER, OP_COPYSIGN, OP_NEXTAFTER, OP_FDIM, OP_FMAX, OP_FMIN,
+  OP_COS, OP_SIN, OP_TAN, OP_ACOS, OP_ASIN, OP_ATAN, OP_COSH, OP_SINH, OP_TANH, OP_ACOSH, OP_ASINH, OP_ATANH,
+  OP_EXP, OP_LOG, OP_LOG10, OP_EXP2, OP_EXPM1, OP_ILOGB, OP_LOG1P, OP_LOG2, OP_LOGB,
+  OP_SQRT, OP_CBRT, OP_ERF, OP_ERFC, OP_TGAMMA, OP_LGAMMA,
+  OP_CEIL, OP_FLOOR, OP_TRUNC, OP_ROUND, OP_RINT, OP_NEARBYINT, OP_FABS,
+  OP_DPHI, OP_NORMALIZED_PHI,
+  OP_DELTA_PHI, OP_COMPOSITE_PHI, OP_DELTA_R, OP_INV_MASS, OP_TRANS_MASS, OP_PT, OP_COS_ALPHA, OP_NUMBER, OP_MEMBER,
+  OP_CACHE_LOAD, OP_CACHE_STORE
+};
+
+// A member of a collection which is looked up when the program is run.
+struct MemberSlot
+{
+  string                     collection;
+  string                     variable;
+  bool                       iterateObj;
+  anatools::MemberAccessor   accessor;
+  unsigned                   cacheCollection;
+  unsigned                   cacheKey;
+  int                        component;   // first input collection with this name, or -1
+  int                        variableSlot;    // slot of an event variable or ID of a user variable, or -1
+};
+
+// A single step of a compiled program. The instruction pops nOperands values
+// from the stack, looks up each of the member slots in order, and pushes its
+// result onto the stack. CACHE_LOAD and CACHE_STORE instructions instead refer
+// to a shared subexpression, and CACHE_LOAD jumps to the instruction at target
+// if its value is found.
+struct Instruction
+{
+  Opcode                                    opcode;
+  unsigned                                  nOperands;
+  double                                    constant;
+  vector<unsigned>                          slots;
+  const ValueLookupCache::Subexpression     *subexpression;
+  unsigned                                  target;
+};
 
 class ValueLookupTree
 {
@@ -147,7 +222,7 @@ class ValueLookupTree
     // evaluating it.
     ////////////////////////////////////////////////////////////////////////////
     Node *insert_ (const string &, Node * const) const;
-    Leaf evaluate_ (const Node * const, const ObjMap &);
+    Leaf evaluate_ (const Node * const);
     ////////////////////////////////////////////////////////////////////////////
 
     // Mainly for debugging:
@@ -155,7 +230,24 @@ class ValueLookupTree
     string printValue(Node* node) const;
 
     // Returns the result of an operator acting on its operands.
-    Leaf evaluateOperator (const string &op, const vector<Leaf> &operands, const ObjMap &objs);
+    Leaf evaluateOperator (const string &op, const vector<Leaf> &operands);
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Methods for compiling the pruned tree into a flat program and for
+    // running that program for a given set of objects.
+    ////////////////////////////////////////////////////////////////////////////
+    void compile ();
+    bool compile_ (const Node * const);
+    bool compileCollectionOperator (const Node * const, Instruction &);
+    bool getOpcode (const string &, const unsigned, Opcode &) const;
+    bool isCollectionLeaf (const Node * const) const;
+    bool hasLookup (const Node * const) const;
+    string canonicalForm (const Node * const) const;
+    unsigned addMemberSlot (const string &, const string &, const bool);
+    double execute ();
+    double applyInstruction (const Instruction &, const double * const, const double * const, const unsigned) const;
+    void evaluateColumns ();
+    ////////////////////////////////////////////////////////////////////////////
 
     ////////////////////////////////////////////////////////////////////////////
     // Methods for retrieving and deleting an object from a collection.
@@ -191,9 +283,17 @@ class ValueLookupTree
     bool vetoMatch (const string &, const string &, const size_t, const vector<string> &) const;
     ////////////////////////////////////////////////////////////////////////////
 
-    // To avoid double counting. For a given set of objects, returns true only
-    // if they are all unique and in a specific order.
-    bool isUniqueCase (const ObjMap &, const unordered_set<string> &) const;
+    // To avoid double counting. For the current combination of objects,
+    // returns true only if they are all unique and in a specific order.
+    bool isUniqueCase () const;
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Methods for resolving the input collections into components, once the
+    // input collections have been sorted.
+    ////////////////////////////////////////////////////////////////////////////
+    void setComponents ();
+    int firstComponent (const string &) const;
+    ////////////////////////////////////////////////////////////////////////////
 
     ////////////////////////////////////////////////////////////////////////////
     // Methods for inserting different types of operators into the tree.
@@ -207,7 +307,9 @@ class ValueLookupTree
     ////////////////////////////////////////////////////////////////////////////
     // Methods for retrieving values from objects.
     ////////////////////////////////////////////////////////////////////////////
-    double valueLookup (const string &collection, const ObjMap &objs, const string &variable, const bool iterateObj = true);
+    double valueLookup (const string &collection, const string &variable, const bool iterateObj = true);
+    double valueLookup (MemberSlot &slot, const bool iterateObj);
+    double memberValue (MemberSlot &slot, void *obj, const unsigned index);
     ////////////////////////////////////////////////////////////////////////////
 
     Node            *root_;
@@ -215,8 +317,6 @@ class ValueLookupTree
     bool            evaluationError_;
 
     Collections                                    *handles_;
-    unordered_map<string, ObjMap::const_iterator>  objIterators_;  // defined for each collection
-    unordered_map<string, bool>                    shouldIterate_; // defined for each collection
     vector<Leaf>                                   values_;
     vector<unsigned>                               collectionSizes_; // vector index corresponds to collection index
     vector<unsigned>                               nCombinations_;   // vector index corresponds to collection index
@@ -224,13 +324,47 @@ class ValueLookupTree
     // nCombinations[i] specifies the number of combinations that can be formed from objects
     // in collections i to N, where N is the number of collections
 
-    vector<void *> uservariablesToDelete_;
-    vector<void *> eventvariablesToDelete_;
+    ////////////////////////////////////////////////////////////////////////////
+    // The combination of objects being evaluated, with one component for each
+    // input collection. Since the input collections are sorted, components
+    // from the same collection are adjacent, and each is identified by the
+    // index of the first of them. The objects in each collection are gathered
+    // once per event, and these vectors keep their size from one combination
+    // to the next, so nothing is allocated for each combination.
+    ////////////////////////////////////////////////////////////////////////////
+    vector<unsigned>         firstComponents_;    // first component from the same collection as each component
+    vector<vector<void *> >  collectionObjects_;  // all the objects in the collection of each first component
+    vector<unsigned>         localIndices_;       // local index of the object in each component
+    vector<void *>           componentObjects_;   // object in each component
+    vector<int>              currentComponents_;  // for each first component, the component last looked up, or -1
+    ////////////////////////////////////////////////////////////////////////////
 
     const int                                      verbose_ = 0;  // verbosity levels:  0, 1, ...
     // Typically you want to use verbosity of 1 when running over a single event.
 
     map<pair<string, string>, pair<string, void (*) (void *, int, void **, void *)> > functionLookupTable_;
+    map<pair<string, string>, MemberSlot> lookupSlots_;
+
+    ////////////////////////////////////////////////////////////////////////////
+    // The compiled program and the scratch space used to run it.
+    ////////////////////////////////////////////////////////////////////////////
+    bool                 compiled_;
+    vector<Instruction>  program_;
+    vector<MemberSlot>   memberSlots_;
+    vector<double>       stack_;
+    vector<double>       slotValues_;
+
+    bool                                    cacheSubexpressions_;
+    unsigned                                cacheCollection_;
+    bool                                    collectionsResolved_;   // whether the user variables and subexpressions have been resolved for handles_
+    vector<pair<unsigned, string> >         subexpressionsToRegister_;
+
+    bool                     columnar_;
+    vector<void *>           objects_;
+    vector<vector<double> >  columns_;
+    vector<vector<double> >  slotColumns_;
+    vector<double>           resultColumn_;
+    ////////////////////////////////////////////////////////////////////////////
 
 };
 
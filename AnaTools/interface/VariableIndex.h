@@ -0,0 +1,91 @@
+#ifndef VARIABLE_INDEX
+#define VARIABLE_INDEX
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "DataFormats/Common/interface/Handle.h"
+
+#include "OSUT3Analysis/Collections/interface/Eventvariable.h"
+#include "OSUT3Analysis/Collections/interface/Uservariable.h"
+
+using namespace std;
+
+/*
+A VariableIndex merges the payloads of all of the variable producers in an
+event into a single read-only view, which every ValueLookupTree using the same
+Collections reads from, instead of each tree copying the payloads into a new
+map of its own.
+
+It is rebuilt by anatools::getRequiredCollections() for each event. The event
+variables of all the producers are merged into one payload indexed by the
+slots of the registry, with the first producer to set a variable taking
+precedence, as before. The slot of each variable of a producer is found once,
+from its schema for payloads made in this job, or from the names written for
+the run for payloads read from a file, which are only found again when those
+names change. For each producer without a payload, a map<string, double>
+written before the payload replaced it is used instead. User
+variables are given an integer ID by userVariable() the first time a tree
+looks one up, and for each event the index finds the values of only the user
+variables which have been looked up, once for all of the trees. Each user
+variable is resolved to an ID when the trees using it are given their
+collections, and to the producer setting it the first time it is found, so
+for each event only the payload of that producer is searched for it.
+*/
+
+namespace anatools
+{
+  class VariableIndex
+    {
+      public:
+        VariableIndex ();
+
+        void build (const vector<edm::Handle<osu::Uservariable> > &, const vector<edm::Handle<osu::Eventvariable> > &, const vector<edm::Handle<vector<string> > > &, const vector<edm::Handle<map<string, double> > > &);
+
+        // value of the event variable in the given slot, or INVALID_VALUE if
+        // no producer set it in this event
+        double eventVariable (const unsigned) const;
+
+        // ID of the named user variable, which is found in the current event
+        // and in each event after it
+        unsigned userVariable (const string &);
+
+        // value of the user variable with the given ID, or INVALID_VALUE if
+        // its producer did not set it in this event; variables with a value
+        // for each combination of objects throw a cms::Exception when found
+        double userVariable (const unsigned) const;
+
+      private:
+        void findUserVariable (const unsigned);
+
+        const vector<edm::Handle<osu::Uservariable> > *uservariables_;
+
+        EventVariableProducerPayload eventvariables_;
+
+        // for each producer, the names of its variables, and the slot in the
+        // registry of each of them
+        vector<vector<string> > producerNames_;
+        vector<vector<unsigned> > producerSlots_;
+
+        unordered_map<string, unsigned> userVariableIDs_;
+        vector<string> userVariableNames_;
+        vector<double> userVariableValues_;
+        vector<int> userVariableProducers_;   // index of the producer setting each, or -1 until found
+    };
+}
+
+inline double
+anatools::VariableIndex::eventVariable (const unsigned slot) const
+{
+  return eventvariables_.get (slot);
+}
+
+inline double
+anatools::VariableIndex::userVariable (const unsigned id) const
+{
+  return userVariableValues_.at (id);
+}
+
+#endif
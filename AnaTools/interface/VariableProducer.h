@@ -2,15 +2,15 @@
 
 #define VARIABLE_PRODUCER
 
-#include "FWCore/Framework/interface/EDFilter.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/stream/EDFilter.h"
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
 
 #include "OSUT3Analysis/AnaTools/interface/AnalysisTypes.h"
 #include "OSUT3Analysis/AnaTools/interface/CommonUtils.h"
 
-class VariableProducer : public edm::EDFilter
+class VariableProducer : public edm::stream::EDFilter<>
   {
     public:
       VariableProducer (const edm::ParameterSet &);
@@ -18,7 +18,7 @@ class VariableProducer : public edm::EDFilter
 
       // Methods
 
-      bool filter (edm::Event &, const edm::EventSetup &);
+      bool filter (edm::Event &, const edm::EventSetup &) override;
 
     protected:
 
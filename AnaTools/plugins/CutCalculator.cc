@@ -1,51 +1,69 @@
 #include <algorithm>
+#include <chrono>
+#include <iomanip>
 #include <iostream>
+#include <mutex>
 #include <set>
+#include <sstream>
 #include <unordered_map>
 
 #include "FWCore/Common/interface/TriggerNames.h"
 
 #include "OSUT3Analysis/AnaTools/interface/CommonUtils.h"
+#include "OSUT3Analysis/AnaTools/interface/ValueLookupCache.h"
 #include "OSUT3Analysis/AnaTools/interface/ValueLookupTree.h"
 #include "OSUT3Analysis/AnaTools/plugins/CutCalculator.h"
 
 #define EXIT_CODE 1
 
-CutCalculator::CutCalculator (const edm::ParameterSet &cfg) :
+CutCalculator::CutCalculator (const edm::ParameterSet &cfg, const CutCalculatorCosts *) :
   collections_    (cfg.getParameter<edm::ParameterSet>  ("collections")),
-  cuts_           (cfg.getParameter<edm::ParameterSet>  ("cuts")),
-  triggersInMenu_ (true),
   firstEvent_     (true)
 {
-
   //////////////////////////////////////////////////////////////////////////////
-  // Try to unpack the cuts ParameterSet and quit if there is a problem.
+  // Unpack the cuts of each channel, quitting if there is a problem. A single
+  // channel given by the "cuts" PSet puts its payload into the event as
+  // "cutDecisions", as before, and takes the lazy evaluation options from the
+  // module.
   //////////////////////////////////////////////////////////////////////////////
-  if (!unpackCuts ())
+  if (cfg.exists ("channels"))
     {
-      clog << "ERROR: failed to interpret cuts PSet. Quitting..." << endl;
-      exit (EXIT_CODE);
+      for (const auto &channel : cfg.getParameter<edm::VParameterSet> ("channels"))
+        channels_.emplace_back (channel.getParameter<edm::ParameterSet> ("cuts"),
+                                channel.getParameter<string> ("name"),
+                                (channel.exists ("lazy") && channel.getParameter<bool> ("lazy")),
+                                (channel.exists ("reorderCuts") && channel.getParameter<bool> ("reorderCuts")),
+                                (channel.exists ("profileEvents") ? channel.getParameter<unsigned> ("profileEvents") : 1000),
+                                &handles_);
     }
+  else
+    channels_.emplace_back (cfg.getParameter<edm::ParameterSet> ("cuts"),
+                            "cutDecisions",
+                            (cfg.exists ("lazy") && cfg.getParameter<bool> ("lazy")),
+                            (cfg.exists ("reorderCuts") && cfg.getParameter<bool> ("reorderCuts")),
+                            (cfg.exists ("profileEvents") ? cfg.getParameter<unsigned> ("profileEvents") : 1000),
+                            &handles_);
   //////////////////////////////////////////////////////////////////////////////
 
-  triggerNamesPSetID_.reset ();
-  triggerIndices_.clear ();
+  for (const auto &channel : channels_)
+    {
+      objectsToGet_.insert (channel.objectsToGet ().begin (), channel.objectsToGet ().end ());
+      produces<CutCalculatorPayload> (channel.label ());
+    }
 
   anatools::getAllTokens (collections_, consumesCollector (), tokens_);
-
-  produces<CutCalculatorPayload> ("cutDecisions");
 }
 
 CutCalculator::~CutCalculator ()
 {
+  for (auto &tree : valueLookupTrees_)
+    delete tree.second;
+}
 
-   for (auto &cut : unpackedCuts_)
-     {
-       if (cut.valueLookupTree)
-         delete cut.valueLookupTree;
-       if (cut.arbitrationTree)
-         delete cut.arbitrationTree;
-     }
+unique_ptr<CutCalculatorCosts>
+CutCalculator::initializeGlobalCache (const edm::ParameterSet &)
+{
+  return unique_ptr<CutCalculatorCosts> (new CutCalculatorCosts);
 }
 
 void
@@ -57,7 +75,7 @@ CutCalculator::produce (edm::Event &event, const edm::EventSetup &setup)
   // and parse the cut strings in the unpacked cuts into ValueLookupTree
   // objects.
   //////////////////////////////////////////////////////////////////////////////
-  if (!initializeValueLookupForest (unpackedCuts_, &handles_))
+  if (!initializeValueLookupForest ())
     {
       clog << "ERROR: failed to parse all cut strings. Quitting..." << endl;
       exit (EXIT_CODE);
@@ -65,19 +83,129 @@ CutCalculator::produce (edm::Event &event, const edm::EventSetup &setup)
   //////////////////////////////////////////////////////////////////////////////
 
   //////////////////////////////////////////////////////////////////////////////
-  // Create the payload for this EDProducer and initialize some of its members.
+  // Time each distinct tree used by a channel being profiled once, before any
+  // of the cuts are evaluated, so that a tree shared by several cuts is
+  // charged in full to each of them rather than only to the first one to use
+  // it.
+  //////////////////////////////////////////////////////////////////////////////
+  treeTimes_.clear ();
+  for (auto &channel : channels_)
+    {
+      if (!channel.profiling ())
+        continue;
+      for (const auto &cut : channel.cuts ())
+        {
+          if (treeTimes_.count (cut.valueLookupTree))
+            continue;
+          auto start = chrono::steady_clock::now ();
+          cut.valueLookupTree->evaluate ();
+          treeTimes_[cut.valueLookupTree] = chrono::duration<double> (chrono::steady_clock::now () - start).count ();
+        }
+    }
+  //////////////////////////////////////////////////////////////////////////////
+
+  for (auto &channel : channels_)
+    event.put (channel.produce (event, treeTimes_), channel.label ());
+
+  firstEvent_ = false;
+}
+
+void
+CutCalculator::endStream ()
+{
+  //////////////////////////////////////////////////////////////////////////////
+  // Add the costs measured in this stream, and the hits and misses of its
+  // cache, to the totals over all of the streams. Every stream has the same
+  // channels in the same order.
+  //////////////////////////////////////////////////////////////////////////////
+  lock_guard<mutex> lock (globalCache ()->merging);
+  globalCache ()->cacheCounters += handles_.cache.counters ();
+  vector<CutCalculatorCosts::Channel> &costs = globalCache ()->channels;
+  costs.resize (channels_.size ());
+  for (unsigned i = 0; i != channels_.size (); i++)
+    channels_.at (i).addCosts (costs.at (i));
+  //////////////////////////////////////////////////////////////////////////////
+}
+
+void
+CutCalculator::globalEndJob (const CutCalculatorCosts *costs)
+{
+  for (const auto &channel : costs->channels)
+    {
+      string table = Channel::costTable (channel);
+      if (table != "")
+        edm::LogInfo ("CutCalculator") << table;
+    }
+  edm::LogInfo ("CutCalculator") << ValueLookupCache::summary (costs->cacheCounters);
+}
+
+CutCalculator::Channel::Channel (const edm::ParameterSet &cuts, const string &label, const bool lazy, const bool reorderCuts, const unsigned profileEvents, const Collections * const handles) :
+  cuts_                  (cuts),
+  label_                 (label),
+  lazy_                  (lazy),
+  reorderCuts_           (lazy && reorderCuts),
+  profileEvents_         (profileEvents),
+  triggersInMenu_        (true),
+  handles_               (handles),
+  nEvents_               (0),
+  nPrefilterRejections_  (0)
+{
+  //////////////////////////////////////////////////////////////////////////////
+  // Try to unpack the cuts ParameterSet and quit if there is a problem.
+  //////////////////////////////////////////////////////////////////////////////
+  if (!unpackCuts ())
+    {
+      clog << "ERROR: failed to interpret cuts PSet. Quitting..." << endl;
+      exit (EXIT_CODE);
+    }
+  //////////////////////////////////////////////////////////////////////////////
+
+  setFlagCollections ();
+  metadata_.reorderCuts = reorderCuts_;
+
+  cutTimes_.assign (metadata_.cuts.size (), 0.0);
+  cutRejections_.assign (metadata_.cuts.size (), 0);
+
+  triggerNamesPSetID_.reset ();
+  triggerIndices_.clear ();
+}
+
+const string &
+CutCalculator::Channel::label () const
+{
+  return label_;
+}
+
+Cuts &
+CutCalculator::Channel::cuts ()
+{
+  return metadata_.cuts;
+}
+
+const unordered_set<string> &
+CutCalculator::Channel::objectsToGet () const
+{
+  return objectsToGet_;
+}
+
+bool
+CutCalculator::Channel::profiling () const
+{
+  return (reorderCuts_ && nEvents_ < profileEvents_);
+}
+
+unique_ptr<CutCalculatorPayload>
+CutCalculator::Channel::produce (const edm::Event &event, const unordered_map<const ValueLookupTree *, double> &treeTimes)
+{
+  //////////////////////////////////////////////////////////////////////////////
+  // Create the payload for this channel and initialize some of its members.
   //////////////////////////////////////////////////////////////////////////////
   pl_ = unique_ptr<CutCalculatorPayload> (new CutCalculatorPayload);
   pl_->isValid = true;
-  pl_->cuts = unpackedCuts_;
-  pl_->triggers = unpackedTriggers_;
-  pl_->triggersToVeto = unpackedTriggersToVeto_;
-  pl_->triggerFilters = unpackedTriggerFilters_;
-  pl_->triggersInMenu = unpackedTriggersInMenu_;
-  pl_->metFilters = unpackedMETFilters_;
+  pl_->metadata = &metadata_;
   //////////////////////////////////////////////////////////////////////////////
 
-  // getListOfObjects
+  // updateFlagCollections
   // for each cut:
   //   setInputCollectionFlags
   //   arbitrateInputCollectionFlags
@@ -85,29 +213,74 @@ CutCalculator::produce (edm::Event &event, const edm::EventSetup &setup)
   //   propagateFromCompositeCollections
   //   setOtherCollectionsFlags
 
-  vector<string> listOfObjects = getListOfObjects(pl_->cuts);
+  // Get the number of objects in each collection and allocate the flags.
+  pl_->isValid = updateFlagCollections ();
+
+  // Decide whether the event passes the triggers specified by the user and
+  // store the decision in the payload. These do not depend on the cuts, and
+  // in lazy mode no cuts are evaluated if the event fails them.
+  evaluateTriggers (event);
+  evaluateTriggerFilters (event);
+  evaluateMETFilters (event);
 
   // Loop over cuts to set flags for each object indicating whether it passed
-  // the cut.
-  for (unsigned currentCutIndex = 0; pl_->isValid && currentCutIndex != pl_->cuts.size (); currentCutIndex++)
+  // the cut, then decide whether the event passes the cut by counting the
+  // number of objects passing it. In lazy mode, the cuts after the first one
+  // which the event fails are skipped, and their flags are left false.
+  //
+  // When reordering the cuts, every cut is evaluated while profiling, and
+  // afterward the prefilters are checked before any of the cuts.
+  bool profiling = this->profiling ();
+  if (reorderCuts_ && nEvents_ == profileEvents_)
+    orderPrefilters ();
+  nEvents_++;
+
+  pl_->cutsDecision = true;
+  bool canPass = profiling || !lazy_ || (pl_->triggerDecision && pl_->triggerFilterDecision && pl_->metFilterDecision);
+  if (canPass && !profiling && !prefilters_.empty () && !passesPrefilters ())
+    {
+      nPrefilterRejections_++;
+      canPass = false;
+    }
+  for (unsigned currentCutIndex = 0; pl_->isValid && currentCutIndex != metadata_.cuts.size (); currentCutIndex++)
     {
-      Cut currentCut = pl_->cuts.at (currentCutIndex);
+      const Cut &currentCut = metadata_.cuts.at (currentCutIndex);
+
+      pl_->evaluatedCuts.push_back (canPass);
+      if (!canPass)
+        {
+          pl_->cumulativeEventFlags.push_back (false);
+          pl_->individualEventFlags.push_back (false);
+          pl_->cutsDecision = false;
+          continue;
+        }
 
       // Sets the flags for the current cut only for the objects which are
-      // being cut on.
+      // being cut on. When profiling, the tree has already been evaluated and
+      // timed by the CutCalculator.
+      if (profiling)
+        cutTimes_.at (currentCutIndex) += treeTimes.at (currentCut.valueLookupTree);
       pl_->isValid = setInputCollectionFlags (currentCut, currentCutIndex);
 
       // If the cut has an arbitration parameter, adjust flags accordingly
-      pl_->isValid = arbitrateInputCollectionFlags (currentCut, currentCutIndex);
+      pl_->isValid = pl_->isValid && arbitrateInputCollectionFlags (currentCut, currentCutIndex);
 
       // Copy flags to any composite collections containing the inputCollection, e.g. muons -> muon-jets
-      pl_->isValid = propagateFromSingleCollections (currentCut, currentCutIndex, listOfObjects);
+      pl_->isValid = pl_->isValid && propagateFromSingleCollections (currentCut, currentCutIndex);
 
       // Copy flags to any component collections contained in the inputCollection, e.g. muon-jets -> muons, jets, muon-muons, etc.
-      pl_->isValid = propagateFromCompositeCollections (currentCut, currentCutIndex, listOfObjects);
+      pl_->isValid = pl_->isValid && propagateFromCompositeCollections (currentCut, currentCutIndex);
 
       // Set flags for all collections unrelated to the cut equal to true
-      pl_->isValid = setOtherCollectionsFlags (currentCut, currentCutIndex, listOfObjects);
+      pl_->isValid = pl_->isValid && setOtherCollectionsFlags (currentCut, currentCutIndex);
+
+      // Decide whether the event passes the current cut, which only depends
+      // on the flags of this cut and the previous one.
+      pl_->isValid = pl_->isValid && setEventFlags (currentCut, currentCutIndex);
+      if (profiling && pl_->isValid && !pl_->individualEventFlags.back ())
+        cutRejections_.at (currentCutIndex)++;
+
+      canPass = canPass && (profiling || !lazy_ || pl_->cutsDecision);
     }
 
   //////////////////////////////////////////////////////////////////////////////
@@ -120,73 +293,52 @@ CutCalculator::produce (edm::Event &event, const edm::EventSetup &setup)
     }
   //////////////////////////////////////////////////////////////////////////////
 
-  // Decide whether the event passes the triggers specified by the user and
-  // store the decision in the payload.
-  evaluateTriggers (event);
-  evaluateTriggerFilters (event);
-  evaluateMETFilters (event);
-
-  // Decide whether the event passes each cut
-  // by counting the number of objects passing the cut
-  // also AND together cut and trigger decision
-  setEventFlags ();
+  // Store the logical AND of the trigger decision and the global cut decision
+  // as the global event decision in the payload.
+  pl_->eventDecision = (pl_->triggerDecision && pl_->triggerFilterDecision && pl_->metFilterDecision && pl_->cutsDecision);
 
-  event.put (std::move (pl_), "cutDecisions");
-  pl_.reset ();
-  firstEvent_ = false;
+  return std::move (pl_);
 }
 
 bool
-CutCalculator::setInputCollectionFlags (const Cut &currentCut, unsigned currentCutIndex) const
+CutCalculator::Channel::setInputCollectionFlags (const Cut &currentCut, unsigned currentCutIndex) const
 {
-  ////////////////////////////////////////////////////////////////////////////////
-  // Prepare the flag maps for the new cut by increasing the size of the vector
-  // and adding the input label as a key to the map.
-  ////////////////////////////////////////////////////////////////////////////////
-
-  if (currentCutIndex >= pl_->individualObjectFlags.size ()){
-    pl_->individualObjectFlags.resize (currentCutIndex + 1);
-  }
-  pl_->individualObjectFlags.at (currentCutIndex)[currentCut.inputLabel];
-
-  if (currentCutIndex >= pl_->cumulativeObjectFlags.size ()){
-    pl_->cumulativeObjectFlags.resize (currentCutIndex + 1);
-  }
-  pl_->cumulativeObjectFlags.at (currentCutIndex)[currentCut.inputLabel];
-
   ////////////////////////////////////////////////////////////////////////////////
   // extract decision from valueLookupTree and store in corresponding flag
   ////////////////////////////////////////////////////////////////////////////////
 
-  for (auto cutDecision = currentCut.valueLookupTree->evaluate ().begin (); cutDecision != currentCut.valueLookupTree->evaluate ().end (); cutDecision++)
+  unsigned inputCollection = inputCollectionIDs_.at (currentCutIndex);
+  const vector<Leaf> &cutDecisions = currentCut.valueLookupTree->evaluate ();
+  if (cutDecisions.size () != pl_->individualObjectFlags.size (inputCollection))
+    {
+      clog << "ERROR: got " << cutDecisions.size () << " values for " << pl_->individualObjectFlags.size (inputCollection) << " objects in " << currentCut.inputLabel << "." << endl;
+      return false;
+    }
+
+  ObjectFlags::Word *passes = pl_->individualObjectFlags.passesWords (currentCutIndex, inputCollection),
+                    *valid = pl_->individualObjectFlags.validWords (currentCutIndex, inputCollection);
+  for (unsigned index = 0; index != cutDecisions.size (); index++)
     {
-      double value = boost::get<double> (*cutDecision);
+      double value = boost::get<double> (cutDecisions.at (index));
       pair<bool, bool> flag = make_pair (value, !IS_INVALID(value));
 
       // invert flags if this cut is a veto
       if (currentCut.isVeto)
         flag.first = !flag.first;
 
-      pl_->individualObjectFlags.at (currentCutIndex).at (currentCut.inputLabel).push_back (flag);
-      pl_->cumulativeObjectFlags.at (currentCutIndex).at (currentCut.inputLabel).push_back (flag);
-
+      ObjectFlags::setBit (passes, index, flag.first);
+      ObjectFlags::setBit (valid, index, flag.second);
     }
 
-  //!!!
-  for (unsigned index = 0; index != pl_->cumulativeObjectFlags.at(currentCutIndex).at(currentCut.inputLabel).size(); index++) {
-
-    // AND together cumulative flags from previous cuts with the one for the current cut
-    for (unsigned cutIndex = 0; cutIndex != currentCutIndex; cutIndex++){
-      pl_->cumulativeObjectFlags.at (currentCutIndex).at (currentCut.inputLabel).at (index).first = pl_->cumulativeObjectFlags.at (currentCutIndex).at (currentCut.inputLabel).at (index).first && pl_->cumulativeObjectFlags.at (cutIndex).at (currentCut.inputLabel).at (index).first;
-    }
+  // AND together cumulative flags from previous cuts with the one for the current cut
+  setCumulativeFlags (currentCutIndex, inputCollection);
 
-  }
   return true;
 }
 
 
 bool
-CutCalculator::arbitrateInputCollectionFlags (const Cut &currentCut, unsigned currentCutIndex) const
+CutCalculator::Channel::arbitrateInputCollectionFlags (const Cut &currentCut, unsigned currentCutIndex) const
 {
   ////////////////////////////////////////////////////////////////////////////////
   // If the user has given an expression for the arbitration, use it to pick
@@ -197,6 +349,7 @@ CutCalculator::arbitrateInputCollectionFlags (const Cut &currentCut, unsigned cu
   ////////////////////////////////////////////////////////////////////////////////
   if (currentCut.arbitration != "")
     {
+      unsigned inputCollection = inputCollectionIDs_.at (currentCutIndex);
       vector<pair<unsigned, double> > indicesToArbitrate, otherIndices;
       indicesToArbitrate.clear ();
       otherIndices.clear ();
@@ -206,8 +359,8 @@ CutCalculator::arbitrateInputCollectionFlags (const Cut &currentCut, unsigned cu
           double value = boost::get<double> (*arbitrationValue);
           pair<bool, bool> flag = make_pair (value, !IS_INVALID(value));
 
-          if (pl_->cumulativeObjectFlags.at (currentCutIndex).at (currentCut.inputLabel).at (object).first
-           && pl_->cumulativeObjectFlags.at (currentCutIndex).at (currentCut.inputLabel).at (object).second
+          if (pl_->cumulativeObjectFlags.passes (currentCutIndex, inputCollection, object)
+           && pl_->cumulativeObjectFlags.valid (currentCutIndex, inputCollection, object)
            && flag.second)
             indicesToArbitrate.emplace_back (object, value);
           else
@@ -221,14 +374,14 @@ CutCalculator::arbitrateInputCollectionFlags (const Cut &currentCut, unsigned cu
       bool isChosen = (indicesToArbitrate.empty () ? false : true);
       for (const auto &index : indicesToArbitrate)
         {
-          pl_->individualObjectFlags.at (currentCutIndex).at (currentCut.inputLabel).at (index.first).first = isChosen;
-          pl_->cumulativeObjectFlags.at (currentCutIndex).at (currentCut.inputLabel).at (index.first).first = isChosen;
+          pl_->individualObjectFlags.setPasses (currentCutIndex, inputCollection, index.first, isChosen);
+          pl_->cumulativeObjectFlags.setPasses (currentCutIndex, inputCollection, index.first, isChosen);
           isChosen = false;
         }
       for (const auto &index : otherIndices)
         {
-          pl_->individualObjectFlags.at (currentCutIndex).at (currentCut.inputLabel).at (index.first).first = isChosen;
-          pl_->cumulativeObjectFlags.at (currentCutIndex).at (currentCut.inputLabel).at (index.first).first = isChosen;
+          pl_->individualObjectFlags.setPasses (currentCutIndex, inputCollection, index.first, isChosen);
+          pl_->cumulativeObjectFlags.setPasses (currentCutIndex, inputCollection, index.first, isChosen);
         }
     }
   ////////////////////////////////////////////////////////////////////////////////
@@ -237,73 +390,57 @@ CutCalculator::arbitrateInputCollectionFlags (const Cut &currentCut, unsigned cu
 }
 
 bool
-CutCalculator::propagateFromSingleCollections (const Cut &currentCut, unsigned currentCutIndex, const vector<string> &listOfObjects) const
+CutCalculator::Channel::propagateFromSingleCollections (const Cut &currentCut, unsigned currentCutIndex) const
 {
   ////////////////////////////////////////////////////////////////////////////////
   // Propagates flags for single object input collections to all related composite collections.
-  // Initialize flags for all relevant composite collections to true.
-  // Then, for every object in the input collection failing the current cut,
-  // propagate the flag to every instance of that object in composite collections
+  // A composite object passes if it is a unique combination and every instance
+  // of the input collection in it passes the current cut.
   ////////////////////////////////////////////////////////////////////////////////
 
   // ignore composite input collections, as those are handled by propagateFromCompositeCollections function
-  vector<string> singleObjects = anatools::getSingleObjects (currentCut.inputLabel);
-  if (singleObjects.size() > 1){
+  unsigned inputCollection = inputCollectionIDs_.at (currentCutIndex);
+  if (flagCollections_.at (inputCollection).components.size () > 1){
     return true;
   }
+  const ObjectFlags::Word *inputFlags = pl_->individualObjectFlags.passesWords (currentCutIndex, inputCollection);
 
   // loop over all the other collections containing these items
-  for (auto &inputType : listOfObjects)
+  for (unsigned collection = 0; collection != flagCollections_.size (); collection++)
     {
       // don't reset flags for the input collection for this cut
-      if (inputType == currentCut.inputLabel){
+      if (collection == inputCollection){
         continue;
       }
       // skip irrelevant collections
-      vector<string> components = anatools::getSingleObjects (inputType);
-      if (find(components.begin(), components.end(), currentCut.inputLabel) == components.end())
+      const FlagCollection &flagCollection = flagCollections_.at (collection);
+      vector<unsigned> positions = flagCollection.positionsOf (currentCut.inputLabel);
+      if (positions.empty ())
         continue;
 
-      // determine total size of collection, since it's composed of multiple single objects
-      int totalSize = 1;
-      for (const auto &component : components){
-        totalSize *= currentCut.valueLookupTree->getCollectionSize (component);
-      }
-
-      // by default all composite objects pass
-      pl_->individualObjectFlags.at (currentCutIndex)[inputType] = vector<pair<bool, bool> > (totalSize, make_pair (true, true));
+      // only unique combinations are valid, and by default they pass
+      ObjectFlags::Word *passes = pl_->individualObjectFlags.passesWords (currentCutIndex, collection),
+                        *valid = pl_->individualObjectFlags.validWords (currentCutIndex, collection);
+      copy (flagCollection.unique.begin (), flagCollection.unique.end (), passes);
+      copy (flagCollection.unique.begin (), flagCollection.unique.end (), valid);
 
-      // mark non-unique combinations as invalid
-      for (unsigned index = 0; index != pl_->individualObjectFlags.at(currentCutIndex).at(inputType).size(); index++) {
-        if (isUniqueCase(currentCut, index, inputType))
-          continue;
-        pl_->individualObjectFlags.at(currentCutIndex).at(inputType).at(index) = make_pair (false, false);
-      }
-
-      // loop over objects in input collection for current cut
-      for (unsigned index = 0; index != pl_->individualObjectFlags.at(currentCutIndex).at(currentCut.inputLabel).size(); index++) {
-        bool flag = pl_->individualObjectFlags.at(currentCutIndex).at(currentCut.inputLabel).at(index).first;
-
-        // nothing to be done for good objects
-        if (flag){
-          continue;
-        }
-
-        // get the list of global indices for the composite collection containing the object in question
-        set<unsigned> globalIndices = currentCut.valueLookupTree->getGlobalIndices (index, currentCut.inputLabel, inputType);
-        for (const auto &globalIndex : globalIndices){
-          // set flags to false for any composite object containing the bad individual object
-          pl_->individualObjectFlags.at(currentCutIndex).at(inputType).at(globalIndex).first = false;
+      // set flags to false for any composite object containing a bad individual object
+      for (unsigned index = 0; index != flagCollection.size; index++)
+        {
+          if (!ObjectFlags::getBit (passes, index))
+            continue;
+          for (const auto &position : positions)
+            {
+              if (!ObjectFlags::getBit (inputFlags, flagCollection.localIndex (index, position)))
+                {
+                  ObjectFlags::setBit (passes, index, false);
+                  break;
+                }
+            }
         }
-      }
-      pl_->cumulativeObjectFlags.at (currentCutIndex)[inputType] = pl_->individualObjectFlags.at(currentCutIndex).at(inputType);
 
       // for each object, AND together cumulative flags from previous cuts with the one for the current cut
-      for (unsigned index = 0; index != pl_->cumulativeObjectFlags.at(currentCutIndex).at(inputType).size(); index++) {
-        for (unsigned cutIndex = 0; cutIndex != currentCutIndex; cutIndex++){
-          pl_->cumulativeObjectFlags.at (currentCutIndex).at (inputType).at (index).first = pl_->cumulativeObjectFlags.at (currentCutIndex).at (inputType).at (index).first && pl_->cumulativeObjectFlags.at (cutIndex).at (inputType).at (index).first;
-        }
-      }
+      setCumulativeFlags (currentCutIndex, collection);
     }
 
   ////////////////////////////////////////////////////////////////////////////////
@@ -311,184 +448,109 @@ CutCalculator::propagateFromSingleCollections (const Cut &currentCut, unsigned c
 }
 
 bool
-CutCalculator::propagateFromCompositeCollections (const Cut &currentCut, unsigned currentCutIndex, const vector<string> &listOfObjects) const
+CutCalculator::Channel::propagateFromCompositeCollections (const Cut &currentCut, unsigned currentCutIndex) const
 {
   ////////////////////////////////////////////////////////////////////////////////
   // Propagates flags for input collections with multiple inputs to all other related collections.
-  // Proceeds in 3 steps:
-  // 1. Initialize all flags to false
-  // 2. Find all single objects which are considered "good"
+  // Proceeds in 2 steps:
+  // 1. Find all single objects which are considered "good"
   // - non-veto case: "good" => part of any object PASSING current cut criteria
   // - veto case: "good" for individual flag => NOT part of any object FAILING current cut criteria
   // - veto case: "good" for cumulative flag => NOT part of any object FAILING current cut criteria but passing all previous cuts
-  // 3. For every object in the list generated in the previous step and
-  //    propagate the 'true' flag to every instance of that object in found elsewhere
+  // 2. Any unique (potentially composite) object elsewhere containing a good
+  //    single object passes, and all others fail
   ////////////////////////////////////////////////////////////////////////////////
 
   // ignore single object input collections, as those are handled by propagateFromSingleCollections function
-  vector<string> singleObjects = anatools::getSingleObjects (currentCut.inputLabel);
-  if (singleObjects.size() <= 1){
+  unsigned inputCollection = inputCollectionIDs_.at (currentCutIndex);
+  const FlagCollection &input = flagCollections_.at (inputCollection);
+  if (input.components.size () <= 1){
     return true;
   }
   // filter out duplicate collections, e.g. muon-muons has 1 unique collection (i.e. muons)
   vector<string> uniqueSingleObjects;
-  for (const auto &singleObject : singleObjects){
+  for (const auto &singleObject : input.components){
     if (find(uniqueSingleObjects.begin(), uniqueSingleObjects.end(), singleObject) == uniqueSingleObjects.end())
       uniqueSingleObjects.push_back(singleObject);
   }
 
+  const ObjectFlags::Word *inputFlags = pl_->individualObjectFlags.passesWords (currentCutIndex, inputCollection),
+                          *previousFlags = (currentCutIndex > 0 ? pl_->cumulativeObjectFlags.passesWords (currentCutIndex - 1, inputCollection) : NULL);
+
   // loop over all the individual collections in the input collection
   for (const auto &singleObject : uniqueSingleObjects){
 
-    // generate list of bad object indices in the individual object collection
-
-    vector<bool> individualFlags;
-    vector<bool> cumulativeFlags;
-
-    // non-veto case
-    if (!currentCut.isVeto){
-      for (unsigned index = 0; index != currentCut.valueLookupTree->getCollectionSize (singleObject); index++){
-        // initialize flags to false, reset them to true once we find a good composite object containing them
-        individualFlags.push_back(false);
-        cumulativeFlags.push_back(false);
-
-        // get the list of global indices for the composite collection containing the object in question
-        set<unsigned> globalIndices = currentCut.valueLookupTree->getGlobalIndices (index, singleObject, currentCut.inputLabel);
-        for (const auto &globalIndex : globalIndices){
-          // if we find a "true" flag for any composite object, set the individual object flag to true
-          if (pl_->individualObjectFlags.at(currentCutIndex).at(currentCut.inputLabel).at(globalIndex).first){
-            individualFlags.at(index) = true;
-            if (currentCutIndex > 0){
-              if(pl_->cumulativeObjectFlags.at(currentCutIndex-1).at(currentCut.inputLabel).at(globalIndex).first){
-                cumulativeFlags.at(index) = true;
-                break;
-              }
-            }
-            else{
-              cumulativeFlags.at(index) = true;
-              break;
-            }
-          }
-        }
-      }
-    }
-    // veto case
-    else {
-      for (unsigned index = 0; index != currentCut.valueLookupTree->getCollectionSize (singleObject); index++){
-        // initialize flags to true, reset them to false once we find a bad composite object containing them
-        individualFlags.push_back(true);
-        cumulativeFlags.push_back(true);
-
-        // get the list of global indices for the composite collection containing the object in question
-        set<unsigned> globalIndices = currentCut.valueLookupTree->getGlobalIndices (index, singleObject, currentCut.inputLabel);
-        for (const auto &globalIndex : globalIndices){
-          // if we find a "false" flag for any composite object, set the individual object flag to false
-          if (!pl_->individualObjectFlags.at(currentCutIndex).at(currentCut.inputLabel).at(globalIndex).first){
-            individualFlags.at(index) = false;
-
-            // for calculating the cumulative flags, only consider composite objects passing all previous cuts
-            if (currentCutIndex > 0){
-              if(pl_->cumulativeObjectFlags.at(currentCutIndex-1).at(currentCut.inputLabel).at(globalIndex).first){
-                cumulativeFlags.at(index) = false;
-                break;
-              }
-            }
-            else{
-              cumulativeFlags.at(index) = false;
-              break;
-            }
-          }
-        }
+    // generate list of good object indices in the individual object collection
+
+    vector<unsigned> inputPositions = input.positionsOf (singleObject);
+    unsigned singleObjectSize = input.componentSizes.at (inputPositions.at (0));
+
+    // non-veto case: initialize flags to false, reset them to true once we find a good composite object containing them
+    // veto case: initialize flags to true, reset them to false once we find a bad composite object containing them
+    vector<bool> individualFlags (singleObjectSize, currentCut.isVeto);
+    vector<bool> cumulativeFlags (singleObjectSize, currentCut.isVeto);
+
+    for (unsigned globalIndex = 0; globalIndex != input.size; globalIndex++){
+      // for calculating the cumulative flags, only consider composite objects passing all previous cuts
+      bool flag = ObjectFlags::getBit (inputFlags, globalIndex),
+           passesPrevious = (!previousFlags || ObjectFlags::getBit (previousFlags, globalIndex));
+
+      // nothing to be done for good (veto case) or bad (non-veto case) composite objects
+      if (flag == currentCut.isVeto)
+        continue;
+
+      for (const auto &position : inputPositions){
+        unsigned index = input.localIndex (globalIndex, position);
+        individualFlags.at (index) = flag;
+        if (passesPrevious)
+          cumulativeFlags.at (index) = flag;
       }
     }
 
     // loop over all the other collections containing these items
-    for (auto &inputType : listOfObjects){
+    for (unsigned collection = 0; collection != flagCollections_.size (); collection++){
       // don't reset flags for the input collection for this cut
-      if (inputType == currentCut.inputLabel){
+      if (collection == inputCollection){
         continue;
       }
       // skip irrelevant collections
-      vector<string> components = anatools::getSingleObjects (inputType);
-      if (find(components.begin(), components.end(), singleObject) == components.end())
+      const FlagCollection &flagCollection = flagCollections_.at (collection);
+      vector<unsigned> positions = flagCollection.positionsOf (singleObject);
+      if (positions.empty ())
         continue;
 
-
-      // determine total size of collection, since it's potentially composed of multiple single objects
-      int totalSize = 1;
-      for (const auto &component : components){
-        totalSize *= currentCut.valueLookupTree->getCollectionSize (component);
-      }
-
       //////////////////////////////////////////////////////////////////////////////////////////
       // set individual and cumulative flags seperately (since for vetoes they're not identical)
       //////////////////////////////////////////////////////////////////////////////////////////
 
-      ///////////////////////
-      // set individual flags
-      ///////////////////////
+      ObjectFlags::Word *individualPasses = pl_->individualObjectFlags.passesWords (currentCutIndex, collection),
+                        *cumulativePasses = pl_->cumulativeObjectFlags.passesWords (currentCutIndex, collection);
 
-      // dy default all objects fail
-      pl_->individualObjectFlags.at (currentCutIndex)[inputType] = vector<pair<bool, bool> > (totalSize, make_pair (false, true));
+      // by default all objects fail, and only unique combinations are valid
+      fill (individualPasses, individualPasses + flagCollection.unique.size (), 0);
+      fill (cumulativePasses, cumulativePasses + flagCollection.unique.size (), 0);
+      copy (flagCollection.unique.begin (), flagCollection.unique.end (), pl_->individualObjectFlags.validWords (currentCutIndex, collection));
+      copy (flagCollection.unique.begin (), flagCollection.unique.end (), pl_->cumulativeObjectFlags.validWords (currentCutIndex, collection));
 
-      // loop over flags for objects in the current inputType collection
-      for (unsigned index = 0; index != individualFlags.size(); index++) {
-
-        // nothing to be done for bad objects
-        if (!individualFlags.at(index)){
+      // set flags to true for any unique (potentially composite) object containing a good individual object
+      for (unsigned index = 0; index != flagCollection.size; index++) {
+        if (!ObjectFlags::getBit (flagCollection.unique.data (), index))
           continue;
+        bool individualFlag = false, cumulativeFlag = false;
+        for (const auto &position : positions){
+          unsigned localIndex = flagCollection.localIndex (index, position);
+          individualFlag = individualFlag || individualFlags.at (localIndex);
+          cumulativeFlag = cumulativeFlag || cumulativeFlags.at (localIndex);
         }
-
-        // get the list of global indices containing the object in question
-        set<unsigned> globalIndices = currentCut.valueLookupTree->getGlobalIndices (index, singleObject, inputType);
-        for (const auto &globalIndex : globalIndices){
-          // set flags to true for any (potentially composite) object containing the good individual object
-          pl_->individualObjectFlags.at(currentCutIndex).at(inputType).at(globalIndex).first = true;
-        }
-
-        // mark non-unique combinations as invalid
-        for (unsigned index = 0; index != pl_->individualObjectFlags.at(currentCutIndex).at(inputType).size(); index++) {
-          if (isUniqueCase(currentCut, index, inputType))
-            continue;
-          pl_->individualObjectFlags.at(currentCutIndex).at(inputType).at(index) = make_pair (false, false);
-        }
+        ObjectFlags::setBit (individualPasses, index, individualFlag);
+        ObjectFlags::setBit (cumulativePasses, index, cumulativeFlag);
       }
 
-      ///////////////////////
-      // set cumulative flags
-      ///////////////////////
-
-      // dy default all objects fail
-      pl_->cumulativeObjectFlags.at (currentCutIndex)[inputType] = vector<pair<bool, bool> > (totalSize, make_pair (false, true));
-
-      // loop over flags for objects in the current inputType collection
-      for (unsigned index = 0; index != cumulativeFlags.size(); index++) {
-
-        // nothing to be done for good objects
-        if (!cumulativeFlags.at(index)){
-          continue;
-        }
-
-        // get the list of global indices containing the object in question
-        set<unsigned> globalIndices = currentCut.valueLookupTree->getGlobalIndices (index, singleObject, inputType);
-        for (const auto &globalIndex : globalIndices){
-          // set flags to true for any (potentially composite) object containing the good cumulative object
-          pl_->cumulativeObjectFlags.at(currentCutIndex).at(inputType).at(globalIndex).first = true;
-        }
-
-        // mark non-unique combinations as invalid
-        for (unsigned index = 0; index != pl_->cumulativeObjectFlags.at(currentCutIndex).at(inputType).size(); index++) {
-          if (isUniqueCase(currentCut, index, inputType))
-            continue;
-          pl_->cumulativeObjectFlags.at(currentCutIndex).at(inputType).at(index) = make_pair (false, false);
-        }
-
-        // for each object, AND together cumulative flags from previous cuts with the one for the current cut
-        for (unsigned index = 0; index != pl_->cumulativeObjectFlags.at(currentCutIndex).at(inputType).size(); index++) {
-          for (unsigned cutIndex = 0; cutIndex != currentCutIndex; cutIndex++){
-            pl_->cumulativeObjectFlags.at (currentCutIndex).at (inputType).at (index).first = pl_->cumulativeObjectFlags.at (currentCutIndex).at (inputType).at (index).first && pl_->cumulativeObjectFlags.at (cutIndex).at (inputType).at (index).first;
-          }
-        }
+      // for each object, AND together cumulative flags from previous cuts with the one for the current cut
+      if (currentCutIndex > 0){
+        const ObjectFlags::Word *previousPasses = pl_->cumulativeObjectFlags.passesWords (currentCutIndex - 1, collection);
+        for (unsigned word = 0; word != flagCollection.unique.size (); word++)
+          cumulativePasses[word] &= previousPasses[word];
       }
     }
   }
@@ -496,81 +558,90 @@ CutCalculator::propagateFromCompositeCollections (const Cut &currentCut, unsigne
 }
 
 bool
-CutCalculator::setOtherCollectionsFlags (const Cut &currentCut, unsigned currentCutIndex, const vector<string> &listOfObjects) const
+CutCalculator::Channel::setOtherCollectionsFlags (const Cut &currentCut, unsigned currentCutIndex) const
 {
   ////////////////////////////////////////////////////////////////////////////////
   // Sets flags for all irrelevant collections to true
   ////////////////////////////////////////////////////////////////////////////////
 
-   for (auto &inputType : listOfObjects)
-     {
-       // skip if flags for this object already exist
-       if (pl_->individualObjectFlags.at (currentCutIndex).find(inputType) != pl_->individualObjectFlags.at (currentCutIndex).end())
-         continue;
-
-       // determine total size of collection, since it may be composed of multiple single objects
-       vector<string> singleObjects = anatools::getSingleObjects (inputType);
-       int totalSize = 1;
-       for (auto singleObject = singleObjects.begin (); singleObject != singleObjects.end (); singleObject++){
-         totalSize *= currentCut.valueLookupTree->getCollectionSize (*singleObject);
-       }
-
-       // since these collections don't pertain to the current cut, they all pass by default
-       pl_->individualObjectFlags.at (currentCutIndex)[inputType] = vector<pair<bool, bool> > (totalSize, make_pair (true, true));
-
-       // mark non-unique combinations as invalid
-       for (unsigned index = 0; index != pl_->individualObjectFlags.at(currentCutIndex).at(inputType).size(); index++) {
-         if (isUniqueCase(currentCut, index, inputType))
-           continue;
-         pl_->individualObjectFlags.at(currentCutIndex).at(inputType).at(index) = make_pair (false, false);
-       }
-
-       pl_->cumulativeObjectFlags.at (currentCutIndex)[inputType] = pl_->individualObjectFlags.at(currentCutIndex).at(inputType);
-
-       // for each object, AND together cumulative flags from previous cuts with the one for the current cut
-       for (unsigned index = 0; index != pl_->cumulativeObjectFlags.at(currentCutIndex).at(inputType).size(); index++) {
-         for (unsigned cutIndex = 0; cutIndex != currentCutIndex; cutIndex++){
-           pl_->cumulativeObjectFlags.at (currentCutIndex).at (inputType).at (index).first = pl_->cumulativeObjectFlags.at (currentCutIndex).at (inputType).at (index).first && pl_->cumulativeObjectFlags.at (cutIndex).at (inputType).at (index).first;
-         }
-       }
-     }
+  unsigned inputCollection = inputCollectionIDs_.at (currentCutIndex);
+  for (unsigned collection = 0; collection != flagCollections_.size (); collection++)
+    {
+      // skip if flags for this object were already set by the functions above
+      if (sharesComponents (collection, inputCollection))
+        continue;
+
+      // since these collections don't pertain to the current cut, all unique combinations pass by default
+      const FlagCollection &flagCollection = flagCollections_.at (collection);
+      copy (flagCollection.unique.begin (), flagCollection.unique.end (), pl_->individualObjectFlags.passesWords (currentCutIndex, collection));
+      copy (flagCollection.unique.begin (), flagCollection.unique.end (), pl_->individualObjectFlags.validWords (currentCutIndex, collection));
+
+      // for each object, AND together cumulative flags from previous cuts with the one for the current cut
+      setCumulativeFlags (currentCutIndex, collection);
+    }
   return true;
 }
 
+void
+CutCalculator::Channel::setCumulativeFlags (unsigned currentCutIndex, unsigned collection) const
+{
+  ////////////////////////////////////////////////////////////////////////////////
+  // Sets the cumulative flags for a collection to the individual flags for the
+  // current cut, ANDed with the cumulative flags for the previous cut. Since
+  // those already include every cut before it, this is the same as ANDing
+  // the flags for all previous cuts.
+  ////////////////////////////////////////////////////////////////////////////////
+  unsigned nWords = pl_->individualObjectFlags.nWords (collection);
+  const ObjectFlags::Word *individualPasses = pl_->individualObjectFlags.passesWords (currentCutIndex, collection),
+                          *individualValid = pl_->individualObjectFlags.validWords (currentCutIndex, collection);
+  ObjectFlags::Word *cumulativePasses = pl_->cumulativeObjectFlags.passesWords (currentCutIndex, collection),
+                    *cumulativeValid = pl_->cumulativeObjectFlags.validWords (currentCutIndex, collection);
+
+  copy (individualPasses, individualPasses + nWords, cumulativePasses);
+  copy (individualValid, individualValid + nWords, cumulativeValid);
+  if (currentCutIndex > 0)
+    {
+      const ObjectFlags::Word *previousPasses = pl_->cumulativeObjectFlags.passesWords (currentCutIndex - 1, collection);
+      for (unsigned word = 0; word != nWords; word++)
+        cumulativePasses[word] &= previousPasses[word];
+    }
+  ////////////////////////////////////////////////////////////////////////////////
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 bool
-CutCalculator::unpackCuts ()
+CutCalculator::Channel::unpackCuts ()
 {
   //////////////////////////////////////////////////////////////////////////////
   // If triggers are given, retrieve them.
   //////////////////////////////////////////////////////////////////////////////
   if (cuts_.exists ("triggers"))
     {
-      unpackedTriggers_ = cuts_.getParameter<vector<string> > ("triggers");
+      metadata_.triggers = cuts_.getParameter<vector<string> > ("triggers");
       objectsToGet_.insert ("triggers");
     }
   else
     clog << "WARNING: no triggers have been specified." << endl;
   if (cuts_.exists ("triggersToVeto"))
     {
-      unpackedTriggersToVeto_ = cuts_.getParameter<vector<string> > ("triggersToVeto");
+      metadata_.triggersToVeto = cuts_.getParameter<vector<string> > ("triggersToVeto");
       objectsToGet_.insert ("triggers");
     }
   if (cuts_.exists ("triggerFilters"))
     {
-      unpackedTriggerFilters_ = cuts_.getParameter<vector<string> > ("triggerFilters");
+      metadata_.triggerFilters = cuts_.getParameter<vector<string> > ("triggerFilters");
       objectsToGet_.insert ("triggers");
       objectsToGet_.insert ("trigobjs");
     }
   if (cuts_.exists ("triggersInMenu"))
     {
-      unpackedTriggersInMenu_ = cuts_.getParameter<vector<string> > ("triggersInMenu");
+      metadata_.triggersInMenu = cuts_.getParameter<vector<string> > ("triggersInMenu");
       objectsToGet_.insert ("triggers");
     }
   if (cuts_.exists ("metFilters"))
     {
-      unpackedMETFilters_ = cuts_.getParameter<vector<string> > ("metFilters");
+      metadata_.metFilters = cuts_.getParameter<vector<string> > ("metFilters");
       objectsToGet_.insert ("metFilters");
     }
   //////////////////////////////////////////////////////////////////////////////
@@ -657,14 +728,14 @@ CutCalculator::unpackCuts ()
       // initialize the valueLookupTree pointers to be NULL.
       tempCut.valueLookupTree = NULL;
       tempCut.arbitrationTree = NULL;
-      unpackedCuts_.push_back (tempCut);
+      metadata_.cuts.push_back (tempCut);
     }
 
   return true;
 }
 
 bool
-CutCalculator::evaluateComparison (int testValue, const string &comparison, int cutValue) const
+CutCalculator::Channel::evaluateComparison (int testValue, const string &comparison, int cutValue) const
 {
   //////////////////////////////////////////////////////////////////////////////
   // Return the result of the comparison of two values, returning false if the
@@ -690,7 +761,7 @@ CutCalculator::evaluateComparison (int testValue, const string &comparison, int
 }
 
 vector<string>
-CutCalculator::splitString (const string &inputString) const
+CutCalculator::Channel::splitString (const string &inputString) const
 {
   //////////////////////////////////////////////////////////////////////////////
   // Split the input string into words separated by whitespace, with each word
@@ -705,7 +776,7 @@ CutCalculator::splitString (const string &inputString) const
 }
 
 bool
-CutCalculator::evaluateTriggers (const edm::Event &event)
+CutCalculator::Channel::evaluateTriggers (const edm::Event &event)
 {
   //////////////////////////////////////////////////////////////////////////////
   // Initialize the flags for each trigger which is required to pass, each
@@ -713,15 +784,15 @@ CutCalculator::evaluateTriggers (const edm::Event &event)
   // required to exist in the HLT menu, as well as the event-wide flags for
   // each of these.
   //////////////////////////////////////////////////////////////////////////////
-  bool triggerDecision = pl_->triggers.empty (), vetoTriggerDecision = true;
-  pl_->triggerFlags.resize (pl_->triggers.size (), false);
-  pl_->vetoTriggerFlags.resize (pl_->triggersToVeto.size (), true);
-  pl_->triggerInMenuFlags.resize (pl_->triggersInMenu.size (), false);
+  bool triggerDecision = metadata_.triggers.empty (), vetoTriggerDecision = true;
+  pl_->triggerFlags.resize (metadata_.triggers.size (), false);
+  pl_->vetoTriggerFlags.resize (metadata_.triggersToVeto.size (), true);
+  pl_->triggerInMenuFlags.resize (metadata_.triggersInMenu.size (), false);
   //////////////////////////////////////////////////////////////////////////////
 
-  if (handles_.triggers.isValid ())
+  if (handles_->triggers.isValid ())
     {
-      const edm::TriggerNames &triggerNames = event.triggerNames (*handles_.triggers);
+      const edm::TriggerNames &triggerNames = event.triggerNames (*handles_->triggers);
       if (triggerNamesPSetID_ != triggerNames.parameterSetID ())
         {
           triggerIndices_.clear ();
@@ -733,19 +804,19 @@ CutCalculator::evaluateTriggers (const edm::Event &event)
           for (unsigned i = 0; i < triggerNames.size (); i++)
             {
               string name = triggerNames.triggerName (i);
-              bool pass = handles_.triggers->accept (i);
+              bool pass = handles_->triggers->accept (i);
 
               //////////////////////////////////////////////////////////////////////////
               // If the current trigger matches one of the triggers to veto, record its
               // decision. If any of these triggers is true, set the event-wide flag to
               // false;
               //////////////////////////////////////////////////////////////////////////
-              for (unsigned triggerIndex = 0; triggerIndex != pl_->triggersToVeto.size (); triggerIndex++)
+              for (unsigned triggerIndex = 0; triggerIndex != metadata_.triggersToVeto.size (); triggerIndex++)
                 {
-                  if (name.find (pl_->triggersToVeto.at (triggerIndex)) == 0)
+                  if (name.find (metadata_.triggersToVeto.at (triggerIndex)) == 0)
                     {
-                      triggerIndices_[pl_->triggersToVeto.at (triggerIndex)];
-                      triggerIndices_.at (pl_->triggersToVeto.at (triggerIndex)).insert (i);
+                      triggerIndices_[metadata_.triggersToVeto.at (triggerIndex)];
+                      triggerIndices_.at (metadata_.triggersToVeto.at (triggerIndex)).insert (i);
                       vetoTriggerDecision = vetoTriggerDecision && !pass;
                       pl_->vetoTriggerFlags.at (triggerIndex) = pass;
                     }
@@ -757,12 +828,12 @@ CutCalculator::evaluateTriggers (const edm::Event &event)
               // decision. If any of these triggers is true, set the event-wide flag to
               // true.
               //////////////////////////////////////////////////////////////////////////
-              for (unsigned triggerIndex = 0; triggerIndex != pl_->triggers.size (); triggerIndex++)
+              for (unsigned triggerIndex = 0; triggerIndex != metadata_.triggers.size (); triggerIndex++)
                 {
-                  if (name.find (pl_->triggers.at (triggerIndex)) == 0)
+                  if (name.find (metadata_.triggers.at (triggerIndex)) == 0)
                     {
-                      triggerIndices_[pl_->triggers.at (triggerIndex)];
-                      triggerIndices_.at (pl_->triggers.at (triggerIndex)).insert (i);
+                      triggerIndices_[metadata_.triggers.at (triggerIndex)];
+                      triggerIndices_.at (metadata_.triggers.at (triggerIndex)).insert (i);
                       triggerDecision = triggerDecision || pass;
                       pl_->triggerFlags.at (triggerIndex) = pass;
                     }
@@ -774,9 +845,9 @@ CutCalculator::evaluateTriggers (const edm::Event &event)
               // required to exist in the HLT menu, set the corresponding flag to
               // true.
               //////////////////////////////////////////////////////////////////////////
-              for (unsigned triggerIndex = 0; triggerIndex != pl_->triggersInMenu.size (); triggerIndex++)
+              for (unsigned triggerIndex = 0; triggerIndex != metadata_.triggersInMenu.size (); triggerIndex++)
                 {
-                  if (name == pl_->triggersInMenu.at (triggerIndex))
+                  if (name == metadata_.triggersInMenu.at (triggerIndex))
                     pl_->triggerInMenuFlags.at (triggerIndex) = true;
                 }
               //////////////////////////////////////////////////////////////////////////
@@ -784,24 +855,24 @@ CutCalculator::evaluateTriggers (const edm::Event &event)
         }
       else
         {
-          for (unsigned triggerIndex = 0; triggerIndex != pl_->triggersToVeto.size (); triggerIndex++)
+          for (unsigned triggerIndex = 0; triggerIndex != metadata_.triggersToVeto.size (); triggerIndex++)
             {
-              if (!triggerIndices_.count (pl_->triggersToVeto.at (triggerIndex)))
+              if (!triggerIndices_.count (metadata_.triggersToVeto.at (triggerIndex)))
                 continue;
-              for (const auto &i : triggerIndices_.at (pl_->triggersToVeto.at (triggerIndex)))
+              for (const auto &i : triggerIndices_.at (metadata_.triggersToVeto.at (triggerIndex)))
                 {
-                  bool pass = handles_.triggers->accept (i);
+                  bool pass = handles_->triggers->accept (i);
                   vetoTriggerDecision = vetoTriggerDecision && !pass;
                   pl_->vetoTriggerFlags.at (triggerIndex) = pass;
                 }
             }
-          for (unsigned triggerIndex = 0; triggerIndex != pl_->triggers.size (); triggerIndex++)
+          for (unsigned triggerIndex = 0; triggerIndex != metadata_.triggers.size (); triggerIndex++)
             {
-              if (!triggerIndices_.count (pl_->triggers.at (triggerIndex)))
+              if (!triggerIndices_.count (metadata_.triggers.at (triggerIndex)))
                 continue;
-              for (const auto &i : triggerIndices_.at (pl_->triggers.at (triggerIndex)))
+              for (const auto &i : triggerIndices_.at (metadata_.triggers.at (triggerIndex)))
                 {
-                  bool pass = handles_.triggers->accept (i);
+                  bool pass = handles_->triggers->accept (i);
                   triggerDecision = triggerDecision || pass;
                   pl_->triggerFlags.at (triggerIndex) = pass;
                 }
@@ -823,31 +894,20 @@ CutCalculator::evaluateTriggers (const edm::Event &event)
 }
 
 bool
-CutCalculator::evaluateTriggerFilters (const edm::Event &event) const
+CutCalculator::Channel::evaluateTriggerFilters (const edm::Event &event) const
 {
-  bool triggerFilterDecision = pl_->triggerFilters.empty ();
-  pl_->triggerFilterFlags.resize (pl_->triggerFilters.size (), false);
+  bool triggerFilterDecision = metadata_.triggerFilters.empty ();
+  pl_->triggerFilterFlags.resize (metadata_.triggerFilters.size (), false);
 
-  if (handles_.triggers.isValid () && handles_.trigobjs.isValid ())
+  if (handles_->triggers.isValid () && handles_->trigobjs.isValid ())
     {
 #if DATA_FORMAT_FROM_MINIAOD
-      const edm::TriggerNames &triggerNames = event.triggerNames (*handles_.triggers);
+      const anatools::TriggerObjectIndex &index = anatools::TriggerObjectIndex::get (event, *handles_->triggers, *handles_->trigobjs);
 #endif
-      for (unsigned i = 0; i < pl_->triggerFilters.size (); i++)
+      for (unsigned i = 0; i < metadata_.triggerFilters.size (); i++)
         {
 #if DATA_FORMAT_FROM_MINIAOD
-          for (auto trigobj : *handles_.trigobjs)
-            {
-              trigobj.unpackPathNames (triggerNames);
-              for (const auto &filter : trigobj.filterLabels ())
-                {
-                  pl_->triggerFilterFlags.at (i) = (pl_->triggerFilters.at (i) == filter);
-                  if (pl_->triggerFilterFlags.at (i))
-                    break;
-                }
-              if (pl_->triggerFilterFlags.at (i))
-                break;
-            }
+          pl_->triggerFilterFlags.at (i) = !index.withFilter (metadata_.triggerFilters.at (i)).empty ();
 #endif
           triggerFilterDecision = triggerFilterDecision || pl_->triggerFilterFlags.at (i);
         }
@@ -857,7 +917,7 @@ CutCalculator::evaluateTriggerFilters (const edm::Event &event) const
 }
 
 bool
-CutCalculator::evaluateMETFilters (const edm::Event &event)
+CutCalculator::Channel::evaluateMETFilters (const edm::Event &event)
 {
   // The MET filter decisions are stored in an edm::TriggerResults object (for
   // some reason). As such, this code is just a copypasta of the code in
@@ -865,11 +925,11 @@ CutCalculator::evaluateMETFilters (const edm::Event &event)
   // that the MET filter decision is the AND of several booleans, instead of
   // the OR as in the case of the trigger decision.
   bool metFilterDecision = true;
-  pl_->metFilterFlags.resize (pl_->metFilters.size (), false);
+  pl_->metFilterFlags.resize (metadata_.metFilters.size (), false);
 
-  if (handles_.metFilters.isValid ())
+  if (handles_->metFilters.isValid ())
     {
-      const edm::TriggerNames &metFilterNames = event.triggerNames (*handles_.metFilters);
+      const edm::TriggerNames &metFilterNames = event.triggerNames (*handles_->metFilters);
       if (metFilterNamesPSetID_ != metFilterNames.parameterSetID ())
         {
           metFilterIndices_.clear ();
@@ -880,14 +940,14 @@ CutCalculator::evaluateMETFilters (const edm::Event &event)
           for (unsigned i = 0; i < metFilterNames.size (); i++)
             {
               string name = metFilterNames.triggerName (i);
-              bool pass = handles_.metFilters->accept (i);
+              bool pass = handles_->metFilters->accept (i);
 
-              for (unsigned metFilterIndex = 0; metFilterIndex != pl_->metFilters.size (); metFilterIndex++)
+              for (unsigned metFilterIndex = 0; metFilterIndex != metadata_.metFilters.size (); metFilterIndex++)
                 {
-                  if (name.find (pl_->metFilters.at (metFilterIndex)) == 0)
+                  if (name.find (metadata_.metFilters.at (metFilterIndex)) == 0)
                     {
-                      metFilterIndices_[pl_->metFilters.at (metFilterIndex)];
-                      metFilterIndices_.at (pl_->metFilters.at (metFilterIndex)).insert (i);
+                      metFilterIndices_[metadata_.metFilters.at (metFilterIndex)];
+                      metFilterIndices_.at (metadata_.metFilters.at (metFilterIndex)).insert (i);
                       metFilterDecision = metFilterDecision && pass;
                       pl_->metFilterFlags.at (metFilterIndex) = pass;
                     }
@@ -896,13 +956,13 @@ CutCalculator::evaluateMETFilters (const edm::Event &event)
         }
       else
         {
-          for (unsigned metFilterIndex = 0; metFilterIndex != pl_->metFilters.size (); metFilterIndex++)
+          for (unsigned metFilterIndex = 0; metFilterIndex != metadata_.metFilters.size (); metFilterIndex++)
             {
-              if (!metFilterIndices_.count (pl_->metFilters.at (metFilterIndex)))
+              if (!metFilterIndices_.count (metadata_.metFilters.at (metFilterIndex)))
                 continue;
-              for (const auto &i : metFilterIndices_.at (pl_->metFilters.at (metFilterIndex)))
+              for (const auto &i : metFilterIndices_.at (metadata_.metFilters.at (metFilterIndex)))
                 {
-                  bool pass = handles_.metFilters->accept (i);
+                  bool pass = handles_->metFilters->accept (i);
                   metFilterDecision = metFilterDecision && pass;
                   pl_->metFilterFlags.at (metFilterIndex) = pass;
                 }
@@ -914,120 +974,232 @@ CutCalculator::evaluateMETFilters (const edm::Event &event)
 }
 
 bool
-CutCalculator::setEventFlags () const
+CutCalculator::Channel::setEventFlags (const Cut &currentCut, unsigned currentCutIndex) const
 {
-  pl_->cutsDecision = true;
+  unsigned inputCollection = inputCollectionIDs_.at (currentCutIndex);
+  int numberPassingPrev = 0;
 
-  // Loop over the cuts, storing the event-wide decision for each in the
-  // payload.
-  for (unsigned currentCutIndex = 0; currentCutIndex != pl_->cuts.size (); currentCutIndex++)
-    {
-      Cut currentCut = pl_->cuts.at (currentCutIndex);
-      int numberPassing = 0;
-      int numberPassingPrev = 0;
-      int numberPassingIndividual = 0;
+  //////////////////////////////////////////////////////////////////////////////
+  // Count the number of objects passing the current cut and all previous
+  // cuts in the collection on which this cut acts.
+  //////////////////////////////////////////////////////////////////////////////
+  int numberPassing = pl_->cumulativeObjectFlags.count (currentCutIndex, inputCollection);
+  //////////////////////////////////////////////////////////////////////////////
 
-      //////////////////////////////////////////////////////////////////////////
-      // Count the number of objects passing the current cut and all previous
-      // cuts in the collection on which this cut acts.
-      //////////////////////////////////////////////////////////////////////////
-      for (const auto &flag : pl_->cumulativeObjectFlags.at (currentCutIndex).at (currentCut.inputLabel))
-        {
-          if (flag.second && flag.first)
-            numberPassing++;
-        }
-      //////////////////////////////////////////////////////////////////////////
+  //////////////////////////////////////////////////////////////////////////////
+  // Count the number of objects passing the current cut independently.
+  //////////////////////////////////////////////////////////////////////////////
+  int numberPassingIndividual = pl_->individualObjectFlags.count (currentCutIndex, inputCollection);
+  //////////////////////////////////////////////////////////////////////////////
 
-      //////////////////////////////////////////////////////////////////////////
-      // Count the number of objects passing the current cut independently.
-      //////////////////////////////////////////////////////////////////////////
-      for (const auto &flag : pl_->individualObjectFlags.at (currentCutIndex).at (currentCut.inputLabel))
+  //////////////////////////////////////////////////////////////////////////////
+  // Decide if the event passes this cut. If the cut is a veto, we have to
+  // test the number of objects which failed this cut but which passed all
+  // previous cuts. Remember, the object flags are inverted in the case of a
+  // veto.
+  //////////////////////////////////////////////////////////////////////////////
+  bool cutDecision;
+  bool cutDecisionIndividual;
+  if (!currentCut.isVeto)
+    {
+      cutDecision = evaluateComparison (numberPassing, currentCut.eventComparativeOperator, currentCut.numberRequired);
+      cutDecisionIndividual = evaluateComparison (numberPassingIndividual, currentCut.eventComparativeOperator, currentCut.numberRequired);
+    }
+  else
+    {
+      int numberTotalObjects = pl_->cumulativeObjectFlags.size (inputCollection);
+      if (currentCutIndex > 0)
+        numberPassingPrev = pl_->cumulativeObjectFlags.count (currentCutIndex - 1, inputCollection);
+      else
         {
-          if (flag.second && flag.first)
-            numberPassingIndividual++;
+          numberPassingPrev = numberTotalObjects;
         }
-      //////////////////////////////////////////////////////////////////////////
+      int numberFailIndividual = numberTotalObjects - numberPassingIndividual;
+      int numberFailCumulative = numberPassingPrev - numberPassing;
+      //          cout << "numberFailIndividual: " <<  numberFailIndividual << endl;
+      //          cout << "numberFailCumulative: " << numberFailCumulative << endl;
+      cutDecision = evaluateComparison (numberFailCumulative, currentCut.eventComparativeOperator, currentCut.numberRequired);
+      cutDecisionIndividual = evaluateComparison (numberFailIndividual, currentCut.eventComparativeOperator, currentCut.numberRequired);
+    }
 
-      //////////////////////////////////////////////////////////////////////////
-      // Decide if the event passes this cut. If the cut is a veto, we have to
-      // test the number of objects which failed this cut but which passed all
-      // previous cuts. Remember, the object flags are inverted in the case of a
-      // veto.
-      //////////////////////////////////////////////////////////////////////////
-      bool cutDecision;
-      bool cutDecisionIndividual;
-      if (!currentCut.isVeto)
+  // cout << "cutDecision: " << cutDecision << endl;
+  // cout << "cutDecisionIndividual: " << cutDecisionIndividual << endl;
+  //////////////////////////////////////////////////////////////////////////////
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Store the decision for this cut in the payload and update the global
+  // cut decision flag.
+  //////////////////////////////////////////////////////////////////////////////
+  pl_->cumulativeEventFlags.push_back (cutDecision);
+  pl_->cutsDecision = pl_->cutsDecision && cutDecision;
+  pl_->individualEventFlags.push_back (cutDecisionIndividual);
+  //////////////////////////////////////////////////////////////////////////////
+
+  return true;
+}
+
+bool
+CutCalculator::Channel::isPrefilter (const Cut &cut) const
+{
+  //////////////////////////////////////////////////////////////////////////////
+  // The cumulative flags for a cut are never set for more objects than the
+  // individual flags, so if a cut requires more than some number of objects,
+  // the event fails it cumulatively whenever it fails it on its own. This is
+  // not true for vetoes or for the other comparisons.
+  //////////////////////////////////////////////////////////////////////////////
+  return (!cut.isVeto && (cut.eventComparativeOperator == ">=" || cut.eventComparativeOperator == ">"));
+  //////////////////////////////////////////////////////////////////////////////
+}
+
+void
+CutCalculator::Channel::orderPrefilters ()
+{
+  //////////////////////////////////////////////////////////////////////////////
+  // Choose the cuts which can be checked on their own and which rejected at
+  // least one event while profiling, and order them by the average time spent
+  // per rejected event, so that cheap cuts which reject many events come
+  // first.
+  //////////////////////////////////////////////////////////////////////////////
+  prefilters_.clear ();
+  for (unsigned cut = 0; cut != metadata_.cuts.size (); cut++)
+    if (isPrefilter (metadata_.cuts.at (cut)) && cutRejections_.at (cut) > 0)
+      prefilters_.push_back (cut);
+  sort (prefilters_.begin (), prefilters_.end (), [&](unsigned a, unsigned b) -> bool {
+    return (cutTimes_.at (a) / cutRejections_.at (a) < cutTimes_.at (b) / cutRejections_.at (b));
+  });
+  //////////////////////////////////////////////////////////////////////////////
+}
+
+bool
+CutCalculator::Channel::passesPrefilters () const
+{
+  //////////////////////////////////////////////////////////////////////////////
+  // Count the objects passing each prefilter on its own, in the same way as
+  // for the individual flags, and return false as soon as the event fails
+  // one of them.
+  //////////////////////////////////////////////////////////////////////////////
+  for (const auto &cutIndex : prefilters_)
+    {
+      const Cut &cut = metadata_.cuts.at (cutIndex);
+      int numberPassing = 0;
+      for (const auto &cutDecision : cut.valueLookupTree->evaluate ())
         {
-        cutDecision = evaluateComparison (numberPassing, currentCut.eventComparativeOperator, currentCut.numberRequired);
-        cutDecisionIndividual = evaluateComparison (numberPassingIndividual, currentCut.eventComparativeOperator, currentCut.numberRequired);
+          double value = boost::get<double> (cutDecision);
+          numberPassing += (value && !IS_INVALID(value));
         }
-      else
+      if (!evaluateComparison (numberPassing, cut.eventComparativeOperator, cut.numberRequired))
+        return false;
+    }
+  return true;
+  //////////////////////////////////////////////////////////////////////////////
+}
+
+void
+CutCalculator::Channel::addCosts (CutCalculatorCosts::Channel &costs) const
+{
+  if (!reorderCuts_)
+    return;
+
+  if (costs.cutNames.empty ())
+    {
+      costs.label = label_;
+      for (const auto &cut : metadata_.cuts)
         {
-          int numberTotalObjects = pl_->cumulativeObjectFlags.at (currentCutIndex).at (currentCut.inputLabel).size();
-          if (currentCutIndex > 0)
-            {
-              for (const auto &flag : pl_->cumulativeObjectFlags.at (currentCutIndex - 1).at (currentCut.inputLabel))
-                (flag.second && flag.first) && numberPassingPrev++;
-            }
-          else
-            {
-              numberPassingPrev = numberTotalObjects;
-            }
-          int numberFailIndividual = numberTotalObjects - numberPassingIndividual;
-          int numberFailCumulative = numberPassingPrev - numberPassing;
-          //          cout << "numberFailIndividual: " <<  numberFailIndividual << endl;
-          //          cout << "numberFailCumulative: " << numberFailCumulative << endl;
-          cutDecision = evaluateComparison (numberFailCumulative, currentCut.eventComparativeOperator, currentCut.numberRequired);
-          cutDecisionIndividual = evaluateComparison (numberFailIndividual, currentCut.eventComparativeOperator, currentCut.numberRequired);
+          costs.cutNames.push_back (cut.name);
+          costs.prefilterable.push_back (isPrefilter (cut));
         }
+      costs.cutTimes.assign (metadata_.cuts.size (), 0.0);
+      costs.cutRejections.assign (metadata_.cuts.size (), 0);
+    }
 
-      // cout << "cutDecision: " << cutDecision << endl;
-      // cout << "cutDecisionIndividual: " << cutDecisionIndividual << endl;
-      //////////////////////////////////////////////////////////////////////////
-
-      //////////////////////////////////////////////////////////////////////////
-      // Store the decision for this cut in the payload and update the global
-      // cut decision flag.
-      //////////////////////////////////////////////////////////////////////////
-      pl_->cumulativeEventFlags.push_back (cutDecision);
-      pl_->cutsDecision = pl_->cutsDecision && cutDecision;
-      pl_->individualEventFlags.push_back (cutDecisionIndividual);
-      //////////////////////////////////////////////////////////////////////////
+  unsigned long long nProfiled = min<unsigned long long> (nEvents_, profileEvents_);
+  costs.nEvents += nEvents_;
+  costs.nProfiled += nProfiled;
+  costs.nPrefilterRejections += nPrefilterRejections_;
+  for (unsigned cut = 0; cut != metadata_.cuts.size (); cut++)
+    {
+      costs.cutTimes.at (cut) += cutTimes_.at (cut);
+      costs.cutRejections.at (cut) += cutRejections_.at (cut);
     }
+}
 
-  // Store the logical AND of the trigger decision and the global cut decision
-  // as the global event decision in the payload and return it.
-  return (pl_->eventDecision = (pl_->triggerDecision && pl_->triggerFilterDecision && pl_->metFilterDecision && pl_->cutsDecision));
+string
+CutCalculator::Channel::costTable (const CutCalculatorCosts::Channel &costs)
+{
+  //////////////////////////////////////////////////////////////////////////////
+  // For each cut, print the average time to evaluate it, the fraction of the
+  // profiled events failing it on its own, and its position among the
+  // prefilters which would be chosen from the costs summed over all streams,
+  // if any.
+  //////////////////////////////////////////////////////////////////////////////
+  if (!costs.nProfiled)
+    return "";
+
+  vector<unsigned> prefilters;
+  for (unsigned cut = 0; cut != costs.cutNames.size (); cut++)
+    if (costs.prefilterable.at (cut) && costs.cutRejections.at (cut) > 0)
+      prefilters.push_back (cut);
+  sort (prefilters.begin (), prefilters.end (), [&](unsigned a, unsigned b) -> bool {
+    return (costs.cutTimes.at (a) / costs.cutRejections.at (a) < costs.cutTimes.at (b) / costs.cutRejections.at (b));
+  });
+
+  stringstream ss;
+  ss << "cut costs for channel " << costs.label << " measured over " << costs.nProfiled << " events:" << endl;
+  ss << setw (8) << "order" << setw (16) << "time [us]" << setw (16) << "rejection" << "  cut" << endl;
+  for (unsigned cut = 0; cut != costs.cutNames.size (); cut++)
+    {
+      auto prefilter = find (prefilters.begin (), prefilters.end (), cut);
+      ss << setw (8) << (prefilter != prefilters.end () ? to_string (prefilter - prefilters.begin ()) : "-")
+         << setw (16) << fixed << setprecision (3) << 1.0e6 * costs.cutTimes.at (cut) / costs.nProfiled
+         << setw (16) << fixed << setprecision (4) << costs.cutRejections.at (cut) / (double) costs.nProfiled
+         << "  " << costs.cutNames.at (cut) << endl;
+    }
+  ss << costs.nPrefilterRejections << " of " << (costs.nEvents - costs.nProfiled) << " events after profiling were rejected by the prefilters.";
+  return ss.str ();
+  //////////////////////////////////////////////////////////////////////////////
 }
 
 bool
-CutCalculator::initializeValueLookupForest (Cuts &cuts, Collections * const handles)
+CutCalculator::initializeValueLookupForest ()
 {
   //////////////////////////////////////////////////////////////////////////////
-  // For each cut, parse its cut string into a new ValueLookupTree object which
-  // is stored in the cut structure.
+  // For each cut of each channel, find the ValueLookupTree for its cut string,
+  // parsing it into a new one if no other cut has the same string and input
+  // collections, and likewise for the arbitration. Then give every distinct
+  // tree the collections for this event, which also clears the values from
+  // the previous event.
   //////////////////////////////////////////////////////////////////////////////
-  for (auto &cut : cuts)
+  if (firstEvent_)
     {
-      if (firstEvent_)
-        {
-          cut.valueLookupTree = new ValueLookupTree (cut);
-          if (cut.arbitration != "")
-            cut.arbitrationTree = new ValueLookupTree (cut.arbitration != "random" ? cut.arbitration : "0.0", cut.inputCollections);
-          if (!cut.valueLookupTree->isValid ())
-            return false;
-        }
-      cut.valueLookupTree->setCollections (handles);
-      if (cut.arbitration != "")
-        cut.arbitrationTree->setCollections (handles);
+      for (auto &channel : channels_)
+        for (auto &cut : channel.cuts ())
+          {
+            cut.valueLookupTree = getValueLookupTree (cut.cutString, cut.inputCollections, &cut);
+            if (cut.arbitration != "")
+              cut.arbitrationTree = getValueLookupTree (cut.arbitration != "random" ? cut.arbitration : "0.0", cut.inputCollections, NULL);
+            if (!cut.valueLookupTree->isValid ())
+              return false;
+          }
     }
+  for (auto &tree : valueLookupTrees_)
+    tree.second->setCollections (&handles_);
   return true;
   //////////////////////////////////////////////////////////////////////////////
 }
 
+ValueLookupTree *
+CutCalculator::getValueLookupTree (const string &expression, const vector<string> &inputCollections, const Cut * const cut)
+{
+  string key = anatools::concatenateInputCollection (inputCollections) + (cut ? " cut " : " arbitration ") + expression;
+  auto tree = valueLookupTrees_.find (key);
+  if (tree == valueLookupTrees_.end ())
+    tree = valueLookupTrees_.emplace (key, (cut ? new ValueLookupTree (*cut) : new ValueLookupTree (expression, inputCollections))).first;
+  return tree->second;
+}
+
 
 vector<string>
-CutCalculator::getListOfObjects (const Cuts &cuts)
+CutCalculator::Channel::getListOfObjects (const Cuts &cuts)
 {
   //////////////////////////////////////////////////////////////////////////////
   // Create unique list of objects for which flags should be set
@@ -1049,11 +1221,121 @@ CutCalculator::getListOfObjects (const Cuts &cuts)
 
 }
 
+void
+CutCalculator::Channel::setFlagCollections ()
+{
+  //////////////////////////////////////////////////////////////////////////////
+  // Assign an integer to each collection on which flags are set, and store
+  // the components of each, which do not change from event to event.
+  //////////////////////////////////////////////////////////////////////////////
+  flagCollectionNames_ = getListOfObjects (metadata_.cuts);
+  for (const auto &name : flagCollectionNames_)
+    {
+      FlagCollection flagCollection;
+      flagCollection.name = name;
+      flagCollection.components = anatools::getSingleObjects (name);
+      flagCollection.hasDuplicates = (set<string> (flagCollection.components.begin (), flagCollection.components.end ()).size () != flagCollection.components.size ());
+      flagCollection.size = 0;
+      flagCollections_.push_back (flagCollection);
+    }
+  flagCollectionSizes_.resize (flagCollections_.size ());
+
+  for (const auto &cut : metadata_.cuts)
+    inputCollectionIDs_.push_back (find (flagCollectionNames_.begin (), flagCollectionNames_.end (), cut.inputLabel) - flagCollectionNames_.begin ());
+  //////////////////////////////////////////////////////////////////////////////
+}
+
+bool
+CutCalculator::Channel::updateFlagCollections ()
+{
+  //////////////////////////////////////////////////////////////////////////////
+  // Get the number of objects in each collection for this event, and find
+  // which combinations of objects in composite collections are unique. Then
+  // allocate the flags for every cut and every collection.
+  //////////////////////////////////////////////////////////////////////////////
+  if (metadata_.cuts.empty ())
+    return true;
+  const ValueLookupTree * const tree = metadata_.cuts.at (0).valueLookupTree;
+  for (unsigned collection = 0; collection != flagCollections_.size (); collection++)
+    {
+      FlagCollection &flagCollection = flagCollections_.at (collection);
+      unsigned nComponents = flagCollection.components.size ();
+      flagCollection.componentSizes.resize (nComponents);
+      flagCollection.strides.resize (nComponents);
+      flagCollection.size = 1;
+      for (int component = nComponents - 1; component >= 0; component--)
+        {
+          flagCollection.componentSizes.at (component) = tree->getCollectionSize (flagCollection.components.at (component));
+          flagCollection.strides.at (component) = flagCollection.size;
+          flagCollection.size *= flagCollection.componentSizes.at (component);
+        }
+
+      flagCollection.unique.assign (ObjectFlags::nWordsFor (flagCollection.size), 0);
+      for (unsigned index = 0; index != flagCollection.size; index++)
+        ObjectFlags::setBit (flagCollection.unique.data (), index, isUniqueCase (flagCollection, index));
+
+      flagCollectionSizes_.at (collection) = flagCollection.size;
+    }
+
+  pl_->individualObjectFlags.reset (metadata_.cuts.size (), flagCollectionNames_, flagCollectionSizes_);
+  pl_->cumulativeObjectFlags.reset (metadata_.cuts.size (), flagCollectionNames_, flagCollectionSizes_);
+  //////////////////////////////////////////////////////////////////////////////
+
+  return true;
+}
+
 bool
-  CutCalculator::isUniqueCase (const Cut &currentCut, unsigned globalIndex, string inputType) const
+CutCalculator::Channel::sharesComponents (unsigned collection, unsigned otherCollection) const
+{
+  //////////////////////////////////////////////////////////////////////////////
+  // Returns whether two collections are the same, or whether any single object
+  // collection is a component of both, e.g., muons and muon-jets.
+  //////////////////////////////////////////////////////////////////////////////
+  if (collection == otherCollection)
+    return true;
+  for (const auto &component : flagCollections_.at (collection).components)
+    {
+      if (VEC_CONTAINS (flagCollections_.at (otherCollection).components, component))
+        return true;
+    }
+  return false;
+  //////////////////////////////////////////////////////////////////////////////
+}
+
+vector<unsigned>
+CutCalculator::FlagCollection::positionsOf (const string &component) const
+{
+  //////////////////////////////////////////////////////////////////////////////
+  // Returns the positions at which a single object collection appears in this
+  // collection, e.g., {0, 1} for muons in muon-muons.
+  //////////////////////////////////////////////////////////////////////////////
+  vector<unsigned> positions;
+  for (unsigned position = 0; position != components.size (); position++)
+    {
+      if (components.at (position) == component)
+        positions.push_back (position);
+    }
+  return positions;
+  //////////////////////////////////////////////////////////////////////////////
+}
+
+unsigned
+CutCalculator::FlagCollection::localIndex (unsigned globalIndex, unsigned position) const
+{
+  //////////////////////////////////////////////////////////////////////////////
+  // Returns the index within the component at the given position of the
+  // object used in a combination, in the same way as
+  // ValueLookupTree::getGlobalIndices().
+  //////////////////////////////////////////////////////////////////////////////
+  return ((globalIndex / strides.at (position)) % componentSizes.at (position));
+  //////////////////////////////////////////////////////////////////////////////
+}
+
+bool
+CutCalculator::Channel::isUniqueCase (const FlagCollection &collection, unsigned globalIndex) const
 {
   ////////////////////////////////////////////////////////////////////////////////
-  // Determine whether the composite object in index 'globalIndex' in the collection 'inputType'
+  // Determine whether the composite object in index 'globalIndex' in the given collection
   // corresponds to a unique case
   // Unique cases have ascending local indices for any objects in the same collection
 
@@ -1083,37 +1365,32 @@ bool
 
   ////////////////////////////////////////////////////////////////////////////////
 
-  vector<string> singleObjects = anatools::getSingleObjects (inputType);
-  // always unique for single object collections
-  if (singleObjects.size() <= 1){
+  // always unique if no collection is used more than once, including single object collections
+  if (!collection.hasDuplicates){
     return true;
   }
 
   vector<string> uniqueSingleObjects;
-  for (const auto &singleObject : singleObjects){
+  for (const auto &singleObject : collection.components){
     if (find(uniqueSingleObjects.begin(), uniqueSingleObjects.end(), singleObject) == uniqueSingleObjects.end())
       uniqueSingleObjects.push_back(singleObject);
   }
-  // always unique if no collection is used more than once
-  if (singleObjects.size() == uniqueSingleObjects.size()){
-    return true;
-  }
 
   // for each single input object, store the type and the local index of the object used
   vector<pair<string,unsigned> > objectIndexMap;
 
   int nCombinations = 1;
-  for (unsigned collectionIndex = 0; collectionIndex != singleObjects.size(); collectionIndex++){
+  for (unsigned collectionIndex = 0; collectionIndex != collection.components.size(); collectionIndex++){
     unsigned localIndex;
-    int collectionSize = currentCut.valueLookupTree->getCollectionSize (singleObjects.at(collectionIndex));
-    if (collectionIndex + 1 != singleObjects.size ()){
-      nCombinations *= currentCut.valueLookupTree->getCollectionSize (singleObjects.at(collectionIndex));
-      localIndex = ((globalIndex / nCombinations) % currentCut.valueLookupTree->getCollectionSize (singleObjects.at(collectionIndex)));
+    int collectionSize = collection.componentSizes.at(collectionIndex);
+    if (collectionIndex + 1 != collection.components.size ()){
+      nCombinations *= collectionSize;
+      localIndex = ((globalIndex / nCombinations) % collectionSize);
     }
     else{
       localIndex = (globalIndex % collectionSize);
     }
-    objectIndexMap.emplace_back(singleObjects.at(collectionIndex),localIndex);
+    objectIndexMap.emplace_back(collection.components.at(collectionIndex),localIndex);
   }
 
   bool pass = true;
@@ -1132,6 +1409,5 @@ bool
   return pass;
 }
 
-
 #include "FWCore/Framework/interface/MakerMacros.h"
 DEFINE_FWK_MODULE(CutCalculator);
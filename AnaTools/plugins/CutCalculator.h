@@ -1,84 +1,245 @@
 #ifndef CUT_CALCULATOR
 #define CUT_CALCULATOR
 
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <unordered_set>
 
-#include "FWCore/Framework/interface/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
 
 #include "OSUT3Analysis/AnaTools/interface/AnalysisTypes.h"
 
+// The cost and rejection of the cuts of each channel which reorders its cuts,
+// and the hits and misses of the ValueLookupCache, summed over the streams as
+// each one ends, for the tables printed once at the end of the job.
+struct CutCalculatorCosts
+{
+  struct Channel
+  {
+    string                      label;
+    vector<string>              cutNames;
+    vector<bool>                prefilterable;   // whether each cut can be checked on its own
+    unsigned long long          nEvents = 0;
+    unsigned long long          nProfiled = 0;
+    unsigned long long          nPrefilterRejections = 0;
+    vector<double>              cutTimes;
+    vector<unsigned long long>  cutRejections;
+  };
+
+  mutable vector<Channel> channels;
+  mutable ValueLookupCache::Counters cacheCounters;
+  mutable mutex merging;
+};
+
 // Declaration of the CutCalculator EDProducer which produces various flags
 // indicating whether the event and each object passed the user-defined cuts.
-class CutCalculator : public edm::EDProducer
+// There is one instance per stream, each with its own ValueLookupTree objects.
+//
+// A single instance can calculate the flags for several channels which use
+// the same collections, given as a VPSet named "channels" instead of the usual
+// PSet named "cuts", and puts one payload into the event for each, with the
+// name of the channel as the product instance name. Cuts with the same input
+// collections and cut string share a ValueLookupTree, so each distinct cut is
+// only evaluated once per event, no matter how many channels use it.
+//
+// A channel can also be given the optional parameter "lazy", in which case
+// its cuts are no longer evaluated once the event has failed the triggers or
+// one of the cuts. This is meant for skims, where only the event decision is
+// used; the flags for the cuts which are skipped are left false, and are
+// marked as such in the payload.
+//
+// A lazy channel given "reorderCuts" as well times the evaluation of each of
+// its cuts, and counts how often the event fails it, over the first
+// "profileEvents" events (1000 by default). After that, the cuts which the
+// event cannot pass cumulatively if it fails them on their own, i.e., cuts
+// which are not vetoes and require more than some number of objects, are
+// checked on their own first, in order of increasing cost per rejected event.
+// If the event fails any of them, none of the cuts are marked as evaluated, so
+// it is not known which cut it fails first, and the CutFlowPlotter of the
+// channel must combine all of the cuts into a single bin.
+// Otherwise the cuts are evaluated in the configured order as usual, reusing
+// the values already calculated, so the event decision is always the same as
+// without reordering. Each distinct tree is timed once per event, and its
+// time is charged to every cut using it. Each stream orders its prefilters
+// from its own profile, and the costs measured by all of them are printed
+// together at the end of the job.
+class CutCalculator : public edm::stream::EDProducer<edm::GlobalCache<CutCalculatorCosts> >
 {
   public:
-    CutCalculator (const edm::ParameterSet &);
+    CutCalculator (const edm::ParameterSet &, const CutCalculatorCosts *);
     ~CutCalculator ();
 
-    void produce (edm::Event &, const edm::EventSetup &);
+    static unique_ptr<CutCalculatorCosts> initializeGlobalCache (const edm::ParameterSet &);
+    void produce (edm::Event &, const edm::EventSetup &) override;
+    void endStream () override;
+    static void globalEndJob (const CutCalculatorCosts *);
 
   private:
     ////////////////////////////////////////////////////////////////////////////
-    // Private methods used in calculating the cut decisions.
+    // A collection on which flags are set, e.g., muons or muon-muons. The
+    // position of a FlagCollection in flagCollections_ is the integer which
+    // identifies the collection in the ObjectFlags of the payload.
+    ////////////////////////////////////////////////////////////////////////////
+    struct FlagCollection
+    {
+      string            name;
+      vector<string>    components;      // e.g., {"muons", "muons"} for muon-muons
+      bool              hasDuplicates;   // whether any component appears more than once
+
+      // Updated for each event.
+      unsigned                   size;
+      vector<unsigned>           componentSizes;
+      vector<unsigned>           strides;
+      vector<ObjectFlags::Word>  unique;  // whether each combination is unique
+
+      vector<unsigned> positionsOf (const string &) const;
+      unsigned localIndex (unsigned, unsigned) const;
+    };
     ////////////////////////////////////////////////////////////////////////////
 
-    bool setInputCollectionFlags (const Cut &, unsigned) const;
-    bool arbitrateInputCollectionFlags (const Cut &, unsigned) const;
-    bool propagateToCompositeCollections (const Cut &, unsigned) const;
-    bool setOtherCollectionsFlags (const Cut &, unsigned, const vector<string> &) const;
-    bool propagateFromSingleCollections (const Cut &, unsigned, const vector<string> &) const;
-    bool propagateFromCompositeCollections (const Cut &, unsigned, const vector<string> &) const;
-    bool unpackCuts ();
-    bool evaluateComparison (int, const string &, int) const;
-    vector<string> splitString (const string &) const;
-    bool evaluateTriggers (const edm::Event &);
-    bool evaluateTriggerFilters (const edm::Event &) const;
-    bool evaluateMETFilters (const edm::Event &);
-    bool setEventFlags () const;
-    vector<string> getListOfObjects (const Cuts &);
-    bool isUniqueCase (const Cut &, unsigned, string) const;
-
+    ////////////////////////////////////////////////////////////////////////////
+    // The cuts, triggers, and filters of a single channel, and everything
+    // needed to calculate its payload from the ValueLookupTree objects, which
+    // belong to the CutCalculator.
+    ////////////////////////////////////////////////////////////////////////////
+    class Channel
+    {
+      public:
+        Channel (const edm::ParameterSet &, const string &, const bool, const bool, const unsigned, const Collections * const);
+
+        const string &label () const;
+        Cuts &cuts ();
+        const unordered_set<string> &objectsToGet () const;
+
+        // Whether the cuts are being profiled in the current event, in which
+        // case every cut is evaluated.
+        bool profiling () const;
+
+        // Calculates the payload for the current event, after the trees of
+        // all the cuts have been given the collections for the event, given
+        // the time to evaluate each tree when profiling.
+        unique_ptr<CutCalculatorPayload> produce (const edm::Event &, const unordered_map<const ValueLookupTree *, double> &);
+
+        // Adds the cost and rejection of each cut measured while profiling to
+        // the totals over all streams, unless the cuts are not reordered.
+        void addCosts (CutCalculatorCosts::Channel &) const;
+
+        // Table of the cost and rejection of each cut summed over all
+        // streams.
+        static string costTable (const CutCalculatorCosts::Channel &);
+
+      private:
+        ////////////////////////////////////////////////////////////////////////
+        // Private methods used in calculating the cut decisions.
+        ////////////////////////////////////////////////////////////////////////
+
+        bool setInputCollectionFlags (const Cut &, unsigned) const;
+        bool arbitrateInputCollectionFlags (const Cut &, unsigned) const;
+        bool propagateToCompositeCollections (const Cut &, unsigned) const;
+        bool setOtherCollectionsFlags (const Cut &, unsigned) const;
+        bool propagateFromSingleCollections (const Cut &, unsigned) const;
+        bool propagateFromCompositeCollections (const Cut &, unsigned) const;
+        bool unpackCuts ();
+        bool evaluateComparison (int, const string &, int) const;
+        vector<string> splitString (const string &) const;
+        bool evaluateTriggers (const edm::Event &);
+        bool evaluateTriggerFilters (const edm::Event &) const;
+        bool evaluateMETFilters (const edm::Event &);
+        bool setEventFlags (const Cut &, unsigned) const;
+        vector<string> getListOfObjects (const Cuts &);
+        void setFlagCollections ();
+        bool updateFlagCollections ();
+        void setCumulativeFlags (unsigned, unsigned) const;
+        bool sharesComponents (unsigned, unsigned) const;
+        bool isUniqueCase (const FlagCollection &, unsigned) const;
+        bool isPrefilter (const Cut &) const;
+        void orderPrefilters ();
+        bool passesPrefilters () const;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Private variables initialized by the constructor.
+        ////////////////////////////////////////////////////////////////////////
+        edm::ParameterSet  cuts_;
+        string             label_;
+        bool               lazy_;
+        bool               reorderCuts_;
+        unsigned           profileEvents_;
+        bool               triggersInMenu_;
+        const Collections  *handles_;
+        ////////////////////////////////////////////////////////////////////////
+
+        ////////////////////////////////////////////////////////////////////////
+        // Private variables set after unpacking the cuts ParameterSet.
+        ////////////////////////////////////////////////////////////////////////
+        unordered_set<string>  objectsToGet_;
+        CutCalculatorMetadata  metadata_;   // shared by the payloads of every event
+        ////////////////////////////////////////////////////////////////////////
+
+        ////////////////////////////////////////////////////////////////////////
+        // Private variables describing the collections on which flags are
+        // set, with the index in flagCollections_ of the input collection of
+        // each cut.
+        ////////////////////////////////////////////////////////////////////////
+        vector<FlagCollection>  flagCollections_;
+        vector<string>          flagCollectionNames_;
+        vector<unsigned>        flagCollectionSizes_;
+        vector<unsigned>        inputCollectionIDs_;
+        ////////////////////////////////////////////////////////////////////////
+
+        edm::ParameterSetID triggerNamesPSetID_;
+        unordered_map<string, unordered_set<unsigned> > triggerIndices_;
+
+        edm::ParameterSetID metFilterNamesPSetID_;
+        unordered_map<string, unordered_set<unsigned> > metFilterIndices_;
+
+        ////////////////////////////////////////////////////////////////////////
+        // Private variables used in reordering the cuts: the time spent
+        // evaluating each cut and the number of events failing it on its own
+        // while profiling, and the indices of the cuts checked first.
+        ////////////////////////////////////////////////////////////////////////
+        unsigned long long          nEvents_;
+        vector<double>              cutTimes_;
+        vector<unsigned long long>  cutRejections_;
+        vector<unsigned>            prefilters_;
+        unsigned long long          nPrefilterRejections_;
+        ////////////////////////////////////////////////////////////////////////
+
+        // Payload for the current event.
+        unique_ptr<CutCalculatorPayload>  pl_;
+    };
     ////////////////////////////////////////////////////////////////////////////
 
     ////////////////////////////////////////////////////////////////////////////
     // Private variables initialized by the constructor.
     ////////////////////////////////////////////////////////////////////////////
     edm::ParameterSet  collections_;
-    edm::ParameterSet  cuts_;
-    bool               triggersInMenu_;
     bool               firstEvent_;
+    vector<Channel>    channels_;
     ////////////////////////////////////////////////////////////////////////////
 
-    ////////////////////////////////////////////////////////////////////////////
-    // Private variables set after unpacking the cuts ParameterSet.
-    ////////////////////////////////////////////////////////////////////////////
+    // Union of the collections needed by all of the channels.
     unordered_set<string>  objectsToGet_;
-    Cuts                   unpackedCuts_;
-    vector<string>         unpackedTriggersToVeto_;
-    vector<string>         unpackedTriggers_;
-    vector<string>         unpackedTriggerFilters_;
-    vector<string>         unpackedTriggersInMenu_;
-    vector<string>         unpackedMETFilters_;
-    ////////////////////////////////////////////////////////////////////////////
-
-    edm::ParameterSetID triggerNamesPSetID_;
-    unordered_map<string, unordered_set<unsigned> > triggerIndices_;
-
-    edm::ParameterSetID metFilterNamesPSetID_;
-    unordered_map<string, unordered_set<unsigned> > metFilterIndices_;
 
     // Object collections which can be gotten from the event.
     Collections handles_;
     Tokens tokens_;
 
-    // Payload for this EDProducer.
-    unique_ptr<CutCalculatorPayload>  pl_;
+    // The distinct ValueLookupTree objects used by the cuts of all the
+    // channels, keyed by the input collections and the expression.
+    unordered_map<string, ValueLookupTree *>  valueLookupTrees_;
+
+    // The time to evaluate each tree used by a channel being profiled in the
+    // current event.
+    unordered_map<const ValueLookupTree *, double>  treeTimes_;
 
-    // Function for initializing the ValueLookupTree objects, one for each cut.
-    bool initializeValueLookupForest (Cuts &, Collections * const);
+    // Function for initializing the ValueLookupTree objects, one for each
+    // distinct cut string and arbitration.
+    bool initializeValueLookupForest ();
+    ValueLookupTree *getValueLookupTree (const string &, const vector<string> &, const Cut * const);
 };
 
 #endif
@@ -1,6 +1,8 @@
 #include <iomanip>
 #include <iostream>
 
+#include "FWCore/Utilities/interface/Exception.h"
+
 #include "OSUT3Analysis/AnaTools/interface/CommonUtils.h"
 #include "OSUT3Analysis/AnaTools/plugins/CutFlowPlotter.h"
 
@@ -13,16 +15,24 @@ CutFlowPlotter::CutFlowPlotter (const edm::ParameterSet &cfg) :
   cutDecisions_ (cfg.getParameter<edm::InputTag> ("cutDecisions")),
   module_type_  (cfg.getParameter<std::string>("@module_type")),
   module_label_ (cfg.getParameter<std::string>("@module_label")),
+  combineCuts_ (cfg.exists ("combineCuts") && cfg.getParameter<bool> ("combineCuts")),
+  cumulativeOnly_ (combineCuts_ || (cfg.exists ("cumulativeOnly") && cfg.getParameter<bool> ("cumulativeOnly"))),
   firstEvent_ (true)
 {
+  usesResource (TFileService::kSharedResource);
+
   //////////////////////////////////////////////////////////////////////////////
   // Create a directory for this channel and book the cut flow histograms
-  // within.
+  // within. The individual decisions of a lazy channel are incomplete, so its
+  // plotter has no selection histogram. A channel which reorders its cuts may
+  // reject an event without knowing which cut it fails first, so its cut flow
+  // only has a single bin for all of the cuts.
   //////////////////////////////////////////////////////////////////////////////
   TH1::SetDefaultSumw2 ();
   oneDHists_["eventCounter"]  =  fs_->make<TH1D>  ("eventCounter",  ";;events",          1,  0.0,  1.0);
   oneDHists_["cutFlow"]       =  fs_->make<TH1D>  ("cutFlow",       ";;passing events",  1,  0.0,  1.0);
-  oneDHists_["selection"]     =  fs_->make<TH1D>  ("selection",     ";;passing events",  1,  0.0,  1.0);
+  if (!cumulativeOnly_)
+    oneDHists_["selection"]   =  fs_->make<TH1D>  ("selection",     ";;passing events",  1,  0.0,  1.0);
   //  oneDHists_["minusOne"]      =  fs_->make<TH1D>  ("minusOne",      ";;passing events",  1,  0.0,  1.0);
   //////////////////////////////////////////////////////////////////////////////
 
@@ -38,7 +48,7 @@ CutFlowPlotter::~CutFlowPlotter ()
   // module_label_ = channel + module_type_  (module_type_ = "CutFlowPlotter")
 
   TH1D* cutFlow_   = oneDHists_["cutFlow"];
-  TH1D* selection_ = oneDHists_["selection"];
+  TH1D* selection_ = (cumulativeOnly_ ? NULL : oneDHists_.at ("selection"));
   //  TH1D* minusOne_  = oneDHists_["minusOne"];
 
   // Print all the cutflow information stored in histograms when this class is destroyed.
@@ -66,13 +76,13 @@ CutFlowPlotter::~CutFlowPlotter ()
   totalEvents = cutFlow_->GetBinContent (1);
   for (int i = 1; i <= cutFlow_->GetNbinsX(); i++) {
     double cutFlow   =   cutFlow_->GetBinContent (i);
-    double selection = selection_->GetBinContent (i);
+    double selection = (selection_ ? selection_->GetBinContent (i) : 0.0);
     //    double minusOne  =  minusOne_->GetBinContent (i);
     //    minusOne *= 1.0; // Dummy statement to avoid compilation error for unused variable.
     TString name = cutFlow_->GetXaxis()->GetBinLabel(i);
     clog << setw (longestCutName) << left << name << right << setw (10) << setprecision(1) << cutFlow
          << setw (15) << setprecision(3) << 100.0 * (cutFlow   / (double) totalEvents) << "%"
-         << setw (15) << setprecision(3) << 100.0 * (selection / (double) totalEvents) << "%"
+         << setw (15) << setprecision(3) << 100.0 * (selection / (double) totalEvents) << (selection_ ? "%" : " (not computed)")
       //         << setw (15) << setprecision(3) << 100.0 * (minusOne  / (double) totalEvents) << "%"
          << endl;
 
@@ -143,11 +153,14 @@ CutFlowPlotter::initializeCutFlow ()
   //////////////////////////////////////////////////////////////////////////////
   unsigned bin = 1;
   oneDHists_.at ("cutFlow")->GetXaxis    ()->SetBinLabel  (bin,  "total");
-  oneDHists_.at ("selection")->GetXaxis  ()->SetBinLabel  (bin,  "total");
+  if (!cumulativeOnly_)
+    oneDHists_.at ("selection")->GetXaxis  ()->SetBinLabel  (bin,  "total");
   //  oneDHists_.at ("minusOne")->GetXaxis   ()->SetBinLabel  (bin,  "total");
   bin++;
-  if (!cutDecisions.isValid ())
+  if (!cutDecisions.isValid () || !cutDecisions->metadata)
     return false;
+  if (cutDecisions->metadata->reorderCuts && !combineCuts_)
+    throw cms::Exception ("Configuration") << "The cut decisions " << cutDecisions_.encode () << " are from a channel which reorders its cuts, so " << module_label_ << " must set combineCuts.";
   //////////////////////////////////////////////////////////////////////////////
 
   //////////////////////////////////////////////////////////////////////////////
@@ -155,12 +168,13 @@ CutFlowPlotter::initializeCutFlow ()
   // If triggers have been specified, add a special bin for the trigger
   // decision.
   //////////////////////////////////////////////////////////////////////////////
-  unsigned nCuts = cutDecisions->cuts.size ();
-  !cutDecisions->triggers.empty () && nCuts++;
-  !cutDecisions->triggerFilters.empty () && nCuts++;
-  !cutDecisions->metFilters.empty () && nCuts++;
+  unsigned nCuts = (combineCuts_ ? !cutDecisions->metadata->cuts.empty () : cutDecisions->metadata->cuts.size ());
+  !cutDecisions->metadata->triggers.empty () && nCuts++;
+  !cutDecisions->metadata->triggerFilters.empty () && nCuts++;
+  !cutDecisions->metadata->metFilters.empty () && nCuts++;
   oneDHists_.at ("cutFlow")->SetBins    (nCuts + 1,  0.0,  nCuts + 1);
-  oneDHists_.at ("selection")->SetBins  (nCuts + 1,  0.0,  nCuts + 1);
+  if (!cumulativeOnly_)
+    oneDHists_.at ("selection")->SetBins  (nCuts + 1,  0.0,  nCuts + 1);
   //  oneDHists_.at ("minusOne")->SetBins   (nCuts + 1,  0.0,  nCuts + 1);
   //////////////////////////////////////////////////////////////////////////////
 
@@ -168,31 +182,37 @@ CutFlowPlotter::initializeCutFlow ()
   // Set the bin labels for the rest of the bins according to the name of the
   // cut. The special bin for the trigger decision is simply labeled "trigger".
   //////////////////////////////////////////////////////////////////////////////
-  if (!cutDecisions->triggers.empty ())
+  if (!cutDecisions->metadata->triggers.empty ())
     {
       oneDHists_.at ("cutFlow")->GetXaxis    ()->SetBinLabel  (bin,  "trigger");
-      oneDHists_.at ("selection")->GetXaxis  ()->SetBinLabel  (bin,  "trigger");
+      if (!cumulativeOnly_)
+        oneDHists_.at ("selection")->GetXaxis  ()->SetBinLabel  (bin,  "trigger");
       //      oneDHists_.at ("minusOne")->GetXaxis   ()->SetBinLabel  (bin,  "trigger");
       bin++;
     }
-  if (!cutDecisions->triggerFilters.empty ())
+  if (!cutDecisions->metadata->triggerFilters.empty ())
     {
       oneDHists_.at ("cutFlow")->GetXaxis    ()->SetBinLabel  (bin,  "trigger filter");
-      oneDHists_.at ("selection")->GetXaxis  ()->SetBinLabel  (bin,  "trigger filter");
+      if (!cumulativeOnly_)
+        oneDHists_.at ("selection")->GetXaxis  ()->SetBinLabel  (bin,  "trigger filter");
       //      oneDHists_.at ("minusOne")->GetXaxis   ()->SetBinLabel  (bin,  "trigger filter");
       bin++;
     }
-  if (!cutDecisions->metFilters.empty ())
+  if (!cutDecisions->metadata->metFilters.empty ())
     {
       oneDHists_.at ("cutFlow")->GetXaxis    ()->SetBinLabel  (bin,  "MET filter");
-      oneDHists_.at ("selection")->GetXaxis  ()->SetBinLabel  (bin,  "MET filter");
+      if (!cumulativeOnly_)
+        oneDHists_.at ("selection")->GetXaxis  ()->SetBinLabel  (bin,  "MET filter");
       //      oneDHists_.at ("minusOne")->GetXaxis   ()->SetBinLabel  (bin,  "trigger filter");
       bin++;
     }
-  for (vector<Cut>::const_iterator cut = cutDecisions->cuts.begin (); cut != cutDecisions->cuts.end (); cut++, bin++)
+  if (combineCuts_ && !cutDecisions->metadata->cuts.empty ())
+    oneDHists_.at ("cutFlow")->GetXaxis    ()->SetBinLabel  (bin,  "all cuts");
+  for (vector<Cut>::const_iterator cut = cutDecisions->metadata->cuts.begin (); !combineCuts_ && cut != cutDecisions->metadata->cuts.end (); cut++, bin++)
     {
       oneDHists_.at ("cutFlow")->GetXaxis    ()->SetBinLabel  (bin,  cut->name.c_str  ());
-      oneDHists_.at ("selection")->GetXaxis  ()->SetBinLabel  (bin,  cut->name.c_str  ());
+      if (!cumulativeOnly_)
+        oneDHists_.at ("selection")->GetXaxis  ()->SetBinLabel  (bin,  cut->name.c_str  ());
       //      oneDHists_.at ("minusOne")->GetXaxis   ()->SetBinLabel  (bin,  cut->name.c_str  ());
     }
   //////////////////////////////////////////////////////////////////////////////
@@ -203,10 +223,10 @@ CutFlowPlotter::initializeCutFlow ()
   // This is needed because the CutCalculatorPayload object is not available in the
   // destructor, when the terminal output is produced.
   //////////////////////////////////////////////////////////////////////////////
-  triggers_ = cutDecisions->triggers;
-  triggersToVeto_ = cutDecisions->triggersToVeto;
-  triggerFilters_ = cutDecisions->triggerFilters;
-  metFilters_ = cutDecisions->metFilters;
+  triggers_ = cutDecisions->metadata->triggers;
+  triggersToVeto_ = cutDecisions->metadata->triggersToVeto;
+  triggerFilters_ = cutDecisions->metadata->triggerFilters;
+  metFilters_ = cutDecisions->metadata->metFilters;
   //////////////////////////////////////////////////////////////////////////////
 
   // Return true if the initialization was successful.
@@ -225,7 +245,8 @@ CutFlowPlotter::fillCutFlow (double w)
   bool passes = true;
   oneDHists_.at ("eventCounter")->Fill  (bin,  w);
   oneDHists_.at ("cutFlow")->Fill       (bin,  w);
-  oneDHists_.at ("selection")->Fill     (bin,  w);
+  if (!cumulativeOnly_)
+    oneDHists_.at ("selection")->Fill     (bin,  w);
   bin++;
   if (!cutDecisions.isValid ())
     return false;
@@ -235,43 +256,54 @@ CutFlowPlotter::fillCutFlow (double w)
   // Fill the rest of the bins according to the flags in the cut decisions
   // object.
   //////////////////////////////////////////////////////////////////////////////
-  if (!cutDecisions->triggers.empty ())
+  if (!triggers_.empty ())
     {
       passes = passes && cutDecisions->triggerDecision;
-      if (cutDecisions->triggerDecision)
+      if (!cumulativeOnly_ && cutDecisions->triggerDecision)
         oneDHists_.at ("selection")->Fill  (bin,  w);
       if (passes)
         oneDHists_.at ("cutFlow")->Fill    (bin,  w);
       bin++;
     }
-  if (!cutDecisions->triggerFilters.empty ())
+  if (!triggerFilters_.empty ())
     {
       passes = passes && cutDecisions->triggerFilterDecision;
-      if (cutDecisions->triggerFilterDecision)
+      if (!cumulativeOnly_ && cutDecisions->triggerFilterDecision)
         oneDHists_.at ("selection")->Fill  (bin,  w);
       if (passes)
         oneDHists_.at ("cutFlow")->Fill    (bin,  w);
       bin++;
     }
-  if (!cutDecisions->metFilters.empty ())
+  if (!metFilters_.empty ())
     {
       passes = passes && cutDecisions->metFilterDecision;
-      if (cutDecisions->metFilterDecision)
+      if (!cumulativeOnly_ && cutDecisions->metFilterDecision)
         oneDHists_.at ("selection")->Fill  (bin,  w);
       if (passes)
         oneDHists_.at ("cutFlow")->Fill    (bin,  w);
       bin++;
     }
   double firstBin = bin;  // save the index of the first bin corresponding to an actual cut
-  for (vector<bool>::const_iterator flag = cutDecisions->cumulativeEventFlags.begin (); flag != cutDecisions->cumulativeEventFlags.end (); flag++, bin++)
+  if (combineCuts_ && !cutDecisions->cumulativeEventFlags.empty ())
+    {
+      passes = passes && cutDecisions->cumulativeEventFlags.back ();
+      if (passes)
+        oneDHists_.at ("cutFlow")->Fill (bin, w);
+    }
+  for (vector<bool>::const_iterator flag = cutDecisions->cumulativeEventFlags.begin (); !combineCuts_ && flag != cutDecisions->cumulativeEventFlags.end (); flag++, bin++)
     {
       passes = passes && (*flag);
       if (passes)
         oneDHists_.at ("cutFlow")->Fill (bin, w);
     }
   bin = firstBin;  // reset to the first bin with an actual cut
-  for (vector<bool>::const_iterator flag = cutDecisions->individualEventFlags.begin (); flag != cutDecisions->individualEventFlags.end (); flag++, bin++)
+  // A lazy CutCalculator does not evaluate the cuts after the first one the
+  // event fails, so nothing is known about whether the event passes them
+  // individually, and its channel must not fill the selection histogram.
+  for (vector<bool>::const_iterator flag = cutDecisions->individualEventFlags.begin (); !cumulativeOnly_ && flag != cutDecisions->individualEventFlags.end (); flag++, bin++)
     {
+      if (!cutDecisions->evaluatedCuts.at (flag - cutDecisions->individualEventFlags.begin ()))
+        throw cms::Exception ("Configuration") << "The cut decisions " << cutDecisions_.encode () << " are from a lazy channel, so " << module_label_ << " must set cumulativeOnly.";
       if (*flag)
         oneDHists_.at ("selection")->Fill (bin, w);
     }
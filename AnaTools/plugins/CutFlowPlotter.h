@@ -3,9 +3,9 @@
 
 #include "CommonTools/UtilAlgos/interface/TFileService.h"
 
-#include "FWCore/Framework/interface/EDAnalyzer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/one/EDAnalyzer.h"
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
 #include "FWCore/ServiceRegistry/interface/Service.h"
 
@@ -13,13 +13,13 @@
 
 #include "OSUT3Analysis/AnaTools/interface/AnalysisTypes.h"
 
-class CutFlowPlotter : public edm::EDAnalyzer
+class CutFlowPlotter : public edm::one::EDAnalyzer<edm::one::SharedResources>
 {
   public:
     CutFlowPlotter (const edm::ParameterSet &);
     ~CutFlowPlotter ();
 
-    void analyze (const edm::Event &, const edm::EventSetup &);
+    void analyze (const edm::Event &, const edm::EventSetup &) override;
 
   private:
     bool initializeCutFlow ();
@@ -32,6 +32,8 @@ class CutFlowPlotter : public edm::EDAnalyzer
     edm::InputTag      cutDecisions_;
     string             module_type_;
     string             module_label_;
+    bool               combineCuts_;      // a single bin in the cut flow for all the cuts, for channels reordering their cuts
+    bool               cumulativeOnly_;   // only the event counter and cumulative cut flow, for lazy channels
     bool               firstEvent_;
     vector<string>     triggers_;
     vector<string>     triggersToVeto_;
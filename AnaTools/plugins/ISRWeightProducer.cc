@@ -9,7 +9,11 @@ ISRWeightProducer::ISRWeightProducer (const edm::ParameterSet &cfg) :
   requireLastNotFirstCopy_ (cfg.getParameter<bool>            ("requireLastNotFirstCopy")),
   weightFile_              (cfg.getParameter<string>          ("weightFile")),
   weightHist_              (cfg.getParameter<vector<string> > ("weightHist")),
-  weights_                 ({})
+  weights_                 ({}),
+  isrPt_                   (declareVariable ("isrPt")),
+  isrWeight_               (declareVariable ("isrWeight")),
+  isrWeightUp_             (declareVariable ("isrWeightUp")),
+  isrWeightDown_           (declareVariable ("isrWeightDown"))
 {
   mcparticlesToken_ = consumes<vector<TYPE(hardInteractionMcparticles)> > (collections_.getParameter<edm::InputTag> ("hardInteractionMcparticles"));
 }
@@ -25,19 +29,19 @@ ISRWeightProducer::AddVariables (const edm::Event &event, const edm::EventSetup
 
 #ifndef STOPPPED_PTLS
   if(event.isRealData() || weightFile_.empty () || weightHist_.empty ()) {
-    (*eventvariables)["isrPt"] = -1;
-    (*eventvariables)["isrWeight"] = 1;
-    (*eventvariables)["isrWeightUp"] = 1;
-    (*eventvariables)["isrWeightDown"] = 1;
+    eventvariables->set (isrPt_, -1);
+    eventvariables->set (isrWeight_, 1);
+    eventvariables->set (isrWeightUp_, 1);
+    eventvariables->set (isrWeightDown_, 1);
     return;
   }
 
   edm::Handle<vector<TYPE(hardInteractionMcparticles)> > mcparticles;
   if (!event.getByToken(mcparticlesToken_, mcparticles)) {
-    (*eventvariables)["isrPt"] = -1;
-    (*eventvariables)["isrWeight"] = 1;
-    (*eventvariables)["isrWeightUp"] = 1;
-    (*eventvariables)["isrWeightDown"] = 1;
+    eventvariables->set (isrPt_, -1);
+    eventvariables->set (isrWeight_, 1);
+    eventvariables->set (isrWeightUp_, 1);
+    eventvariables->set (isrWeightDown_, 1);
     return;
   }
 
@@ -107,16 +111,16 @@ ISRWeightProducer::AddVariables (const edm::Event &event, const edm::EventSetup
     isrWeightDown *= max(content - error, 0.0); // max just in case error > content
   }
 
-  (*eventvariables)["isrPt"] = pt;
-  (*eventvariables)["isrWeight"] = isrWeight;
-  (*eventvariables)["isrWeightUp"] = isrWeightUp;
-  (*eventvariables)["isrWeightDown"] = isrWeightDown;
+  eventvariables->set (isrPt_, pt);
+  eventvariables->set (isrWeight_, isrWeight);
+  eventvariables->set (isrWeightUp_, isrWeightUp);
+  eventvariables->set (isrWeightDown_, isrWeightDown);
 
 #else // if STOPPPED_PTLS
-  (*eventvariables)["isrPt"] = -1;
-  (*eventvariables)["isrWeight"] = 1;
-  (*eventvariables)["isrWeightUp"] = 1;
-  (*eventvariables)["isrWeightDown"] = 1;
+  eventvariables->set (isrPt_, -1);
+  eventvariables->set (isrWeight_, 1);
+  eventvariables->set (isrWeightUp_, 1);
+  eventvariables->set (isrWeightDown_, 1);
 #endif
 }
 
@@ -28,6 +28,11 @@ private:
 
   vector<TH1D *> weights_;
 
+  unsigned isrPt_;
+  unsigned isrWeight_;
+  unsigned isrWeightUp_;
+  unsigned isrWeightDown_;
+
   bool isOriginalParticle (const TYPE(hardInteractionMcparticles) &, const int) const;
   void AddVariables(const edm::Event &, const edm::EventSetup &);
 };
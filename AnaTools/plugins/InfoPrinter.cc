@@ -202,17 +202,17 @@ InfoPrinter::printMETFilterDecision ()
 bool
 InfoPrinter::printCumulativeEventFlags ()
 {
-  if (!cutDecisions.isValid ())
+  if (!cutDecisions.isValid () || !cutDecisions->metadata)
     return false;
 
   ss_ << endl;
-  !maxCutWidth_ && (maxCutWidth_ = getMaxWidth (cutDecisions->cuts));
+  !maxCutWidth_ && (maxCutWidth_ = getMaxWidth (cutDecisions->metadata->cuts));
   ss_ << "--------------------------------------------------------------------------------" << endl;
   ss_ << A_BRIGHT_MAGENTA << "cumulative event flags" << A_RESET << endl;
   ss_ << "--------------------------------------------------------------------------------" << endl;
   for (auto flag = cutDecisions->cumulativeEventFlags.begin (); flag != cutDecisions->cumulativeEventFlags.end (); flag++)
     {
-      ss_ << A_BRIGHT_BLUE << setw (maxCutWidth_) << left << cutDecisions->cuts.at (flag - cutDecisions->cumulativeEventFlags.begin ()).name << A_RESET;
+      ss_ << A_BRIGHT_BLUE << setw (maxCutWidth_) << left << cutDecisions->metadata->cuts.at (flag - cutDecisions->cumulativeEventFlags.begin ()).name << A_RESET;
       if (*flag)
         ss_ << A_BRIGHT_GREEN << "true" << A_RESET << endl;
       else
@@ -224,17 +224,17 @@ InfoPrinter::printCumulativeEventFlags ()
 bool
 InfoPrinter::printIndividualEventFlags ()
 {
-  if (!cutDecisions.isValid ())
+  if (!cutDecisions.isValid () || !cutDecisions->metadata)
     return false;
 
   ss_ << endl;
-  !maxCutWidth_ && (maxCutWidth_ = getMaxWidth (cutDecisions->cuts));
+  !maxCutWidth_ && (maxCutWidth_ = getMaxWidth (cutDecisions->metadata->cuts));
   ss_ << "--------------------------------------------------------------------------------" << endl;
   ss_ << A_BRIGHT_MAGENTA << "individual event flags" << A_RESET << endl;
   ss_ << "--------------------------------------------------------------------------------" << endl;
   for (auto flag = cutDecisions->individualEventFlags.begin (); flag != cutDecisions->individualEventFlags.end (); flag++)
     {
-      ss_ << A_BRIGHT_BLUE << setw (maxCutWidth_) << left << cutDecisions->cuts.at (flag - cutDecisions->individualEventFlags.begin ()).name << A_RESET;
+      ss_ << A_BRIGHT_BLUE << setw (maxCutWidth_) << left << cutDecisions->metadata->cuts.at (flag - cutDecisions->individualEventFlags.begin ()).name << A_RESET;
       if (*flag)
         ss_ << A_BRIGHT_GREEN << "true" << A_RESET << endl;
       else
@@ -246,34 +246,36 @@ InfoPrinter::printIndividualEventFlags ()
 bool
 InfoPrinter::printCumulativeObjectFlags ()
 {
-  if (!cutDecisions.isValid ())
+  if (!cutDecisions.isValid () || !cutDecisions->metadata)
     return false;
 
   ss_ << endl;
-  if (cutDecisions->cumulativeObjectFlags.empty ())
+  const ObjectFlags &flags = cutDecisions->cumulativeObjectFlags;
+  if (flags.empty ())
     return true;
   vector<string> collections;
-  for (const auto &collection : cutDecisions->cumulativeObjectFlags.at (0))
-    collections.push_back (collection.first);
+  for (unsigned collection = 0; collection != flags.nCollections (); collection++)
+    collections.push_back (flags.collectionName (collection));
   sort (collections.begin (), collections.end ());
-  !maxCutWidth_ && (maxCutWidth_ = getMaxWidth (cutDecisions->cuts));
+  !maxCutWidth_ && (maxCutWidth_ = getMaxWidth (cutDecisions->metadata->cuts));
   for (auto collection = collections.begin (); collection != collections.end (); collection++)
     {
       if (collection != collections.begin ())
         ss_ << endl;
+      unsigned collectionID = flags.collectionID (*collection);
       ss_ << "--------------------------------------------------------------------------------" << endl;
       ss_ << A_BRIGHT_MAGENTA << "cumulative object flags for " << *collection << A_RESET << endl;
       ss_ << "--------------------------------------------------------------------------------" << endl;
-      for (auto cut = cutDecisions->cumulativeObjectFlags.begin (); cut != cutDecisions->cumulativeObjectFlags.end (); cut++)
+      for (unsigned cut = 0; cut != flags.nCuts (); cut++)
         {
-          ss_ << A_BRIGHT_BLUE << setw (maxCutWidth_) << left << cutDecisions->cuts.at (cut - cutDecisions->cumulativeObjectFlags.begin ()).name << A_RESET;
-          for (auto flag = cut->at (*collection).begin (); flag != cut->at (*collection).end (); flag++)
+          ss_ << A_BRIGHT_BLUE << setw (maxCutWidth_) << left << cutDecisions->metadata->cuts.at (cut).name << A_RESET;
+          for (unsigned object = 0; object != flags.size (collectionID); object++)
             {
-              if (flag != cut->at (*collection).begin ())
+              if (object)
                 ss_ << ", ";
-              if (flag->second)
+              if (flags.valid (cut, collectionID, object))
                 {
-                  if (flag->first)
+                  if (flags.passes (cut, collectionID, object))
                     ss_ << A_BRIGHT_GREEN << "1" << A_RESET;
                   else
                     ss_ << A_BRIGHT_RED << "0" << A_RESET;
@@ -292,34 +294,36 @@ InfoPrinter::printCumulativeObjectFlags ()
 bool
 InfoPrinter::printIndividualObjectFlags ()
 {
-  if (!cutDecisions.isValid ())
+  if (!cutDecisions.isValid () || !cutDecisions->metadata)
     return false;
 
   ss_ << endl;
-  if (cutDecisions->individualObjectFlags.empty ())
+  const ObjectFlags &flags = cutDecisions->individualObjectFlags;
+  if (flags.empty ())
     return true;
   vector<string> collections;
-  for (const auto &collection : cutDecisions->individualObjectFlags.at (0))
-    collections.push_back (collection.first);
+  for (unsigned collection = 0; collection != flags.nCollections (); collection++)
+    collections.push_back (flags.collectionName (collection));
   sort (collections.begin (), collections.end ());
-  !maxCutWidth_ && (maxCutWidth_ = getMaxWidth (cutDecisions->cuts));
+  !maxCutWidth_ && (maxCutWidth_ = getMaxWidth (cutDecisions->metadata->cuts));
   for (auto collection = collections.begin (); collection != collections.end (); collection++)
     {
       if (collection != collections.begin ())
         ss_ << endl;
+      unsigned collectionID = flags.collectionID (*collection);
       ss_ << "--------------------------------------------------------------------------------" << endl;
       ss_ << A_BRIGHT_MAGENTA << "individual object flags for " << *collection << A_RESET << endl;
       ss_ << "--------------------------------------------------------------------------------" << endl;
-      for (auto cut = cutDecisions->individualObjectFlags.begin (); cut != cutDecisions->individualObjectFlags.end (); cut++)
+      for (unsigned cut = 0; cut != flags.nCuts (); cut++)
         {
-          ss_ << A_BRIGHT_BLUE << setw (maxCutWidth_) << left << cutDecisions->cuts.at (cut - cutDecisions->individualObjectFlags.begin ()).name << A_RESET;
-          for (auto flag = cut->at (*collection).begin (); flag != cut->at (*collection).end (); flag++)
+          ss_ << A_BRIGHT_BLUE << setw (maxCutWidth_) << left << cutDecisions->metadata->cuts.at (cut).name << A_RESET;
+          for (unsigned object = 0; object != flags.size (collectionID); object++)
             {
-              if (flag != cut->at (*collection).begin ())
+              if (object)
                 ss_ << ", ";
-              if (flag->second)
+              if (flags.valid (cut, collectionID, object))
                 {
-                  if (flag->first)
+                  if (flags.passes (cut, collectionID, object))
                     ss_ << A_BRIGHT_GREEN << "1" << A_RESET;
                   else
                     ss_ << A_BRIGHT_RED << "0" << A_RESET;
@@ -338,17 +342,17 @@ InfoPrinter::printIndividualObjectFlags ()
 bool
 InfoPrinter::printTriggerFlags ()
 {
-  if (!cutDecisions.isValid ())
+  if (!cutDecisions.isValid () || !cutDecisions->metadata)
     return false;
 
   ss_ << endl;
-  !maxTriggerWidth_ && (maxTriggerWidth_ = getMaxWidth (cutDecisions->triggers));
+  !maxTriggerWidth_ && (maxTriggerWidth_ = getMaxWidth (cutDecisions->metadata->triggers));
   ss_ << "--------------------------------------------------------------------------------" << endl;
   ss_ << A_BRIGHT_MAGENTA << "trigger flags" << A_RESET << endl;
   ss_ << "--------------------------------------------------------------------------------" << endl;
   for (auto flag = cutDecisions->triggerFlags.begin (); flag != cutDecisions->triggerFlags.end (); flag++)
     {
-      ss_ << A_BRIGHT_BLUE << setw (maxTriggerWidth_) << left << cutDecisions->triggers.at (flag - cutDecisions->triggerFlags.begin ()) << A_RESET;
+      ss_ << A_BRIGHT_BLUE << setw (maxTriggerWidth_) << left << cutDecisions->metadata->triggers.at (flag - cutDecisions->triggerFlags.begin ()) << A_RESET;
       if (*flag)
         ss_ << A_BRIGHT_GREEN << "true" << A_RESET << endl;
       else
@@ -361,17 +365,17 @@ InfoPrinter::printTriggerFlags ()
 bool
 InfoPrinter::printVetoTriggerFlags ()
 {
-  if (!cutDecisions.isValid ())
+  if (!cutDecisions.isValid () || !cutDecisions->metadata)
     return false;
 
   ss_ << endl;
-  !maxVetoTriggerWidth_ && (maxVetoTriggerWidth_ = getMaxWidth (cutDecisions->triggersToVeto));
+  !maxVetoTriggerWidth_ && (maxVetoTriggerWidth_ = getMaxWidth (cutDecisions->metadata->triggersToVeto));
   ss_ << "--------------------------------------------------------------------------------" << endl;
   ss_ << A_BRIGHT_MAGENTA << "veto trigger flags" << A_RESET << endl;
   ss_ << "--------------------------------------------------------------------------------" << endl;
   for (auto flag = cutDecisions->vetoTriggerFlags.begin (); flag != cutDecisions->vetoTriggerFlags.end (); flag++)
     {
-      ss_ << A_BRIGHT_BLUE << setw (maxVetoTriggerWidth_) << left << cutDecisions->triggersToVeto.at (flag - cutDecisions->vetoTriggerFlags.begin ()) << A_RESET;
+      ss_ << A_BRIGHT_BLUE << setw (maxVetoTriggerWidth_) << left << cutDecisions->metadata->triggersToVeto.at (flag - cutDecisions->vetoTriggerFlags.begin ()) << A_RESET;
       if (*flag)
         ss_ << A_BRIGHT_GREEN << "true" << A_RESET << endl;
       else
@@ -384,17 +388,17 @@ InfoPrinter::printVetoTriggerFlags ()
 bool
 InfoPrinter::printTriggerFilterFlags ()
 {
-  if (!cutDecisions.isValid ())
+  if (!cutDecisions.isValid () || !cutDecisions->metadata)
     return false;
 
   ss_ << endl;
-  !maxTriggerWidth_ && (maxTriggerWidth_ = getMaxWidth (cutDecisions->triggerFilters));
+  !maxTriggerWidth_ && (maxTriggerWidth_ = getMaxWidth (cutDecisions->metadata->triggerFilters));
   ss_ << "--------------------------------------------------------------------------------" << endl;
   ss_ << A_BRIGHT_MAGENTA << "trigger filter flags" << A_RESET << endl;
   ss_ << "--------------------------------------------------------------------------------" << endl;
   for (auto flag = cutDecisions->triggerFilterFlags.begin (); flag != cutDecisions->triggerFilterFlags.end (); flag++)
     {
-      ss_ << A_BRIGHT_BLUE << setw (maxTriggerWidth_) << left << cutDecisions->triggerFilters.at (flag - cutDecisions->triggerFilterFlags.begin ()) << A_RESET;
+      ss_ << A_BRIGHT_BLUE << setw (maxTriggerWidth_) << left << cutDecisions->metadata->triggerFilters.at (flag - cutDecisions->triggerFilterFlags.begin ()) << A_RESET;
       if (*flag)
         ss_ << A_BRIGHT_GREEN << "true" << A_RESET << endl;
       else
@@ -407,17 +411,17 @@ InfoPrinter::printTriggerFilterFlags ()
 bool
 InfoPrinter::printTriggerInMenuFlags ()
 {
-  if (!cutDecisions.isValid ())
+  if (!cutDecisions.isValid () || !cutDecisions->metadata)
     return false;
 
   ss_ << endl;
-  !maxTriggerWidth_ && (maxTriggerWidth_ = getMaxWidth (cutDecisions->triggersInMenu));
+  !maxTriggerWidth_ && (maxTriggerWidth_ = getMaxWidth (cutDecisions->metadata->triggersInMenu));
   ss_ << "--------------------------------------------------------------------------------" << endl;
   ss_ << A_BRIGHT_MAGENTA << "trigger in menu flags" << A_RESET << endl;
   ss_ << "--------------------------------------------------------------------------------" << endl;
   for (auto flag = cutDecisions->triggerInMenuFlags.begin (); flag != cutDecisions->triggerInMenuFlags.end (); flag++)
     {
-      ss_ << A_BRIGHT_BLUE << setw (maxTriggerWidth_) << left << cutDecisions->triggersInMenu.at (flag - cutDecisions->triggerInMenuFlags.begin ()) << A_RESET;
+      ss_ << A_BRIGHT_BLUE << setw (maxTriggerWidth_) << left << cutDecisions->metadata->triggersInMenu.at (flag - cutDecisions->triggerInMenuFlags.begin ()) << A_RESET;
       if (*flag)
         ss_ << A_BRIGHT_GREEN << "true" << A_RESET << endl;
       else
@@ -430,17 +434,17 @@ InfoPrinter::printTriggerInMenuFlags ()
 bool
 InfoPrinter::printMETFilterFlags ()
 {
-  if (!cutDecisions.isValid ())
+  if (!cutDecisions.isValid () || !cutDecisions->metadata)
     return false;
 
   ss_ << endl;
-  !maxMETFilterWidth_ && (maxMETFilterWidth_ = getMaxWidth (cutDecisions->metFilters));
+  !maxMETFilterWidth_ && (maxMETFilterWidth_ = getMaxWidth (cutDecisions->metadata->metFilters));
   ss_ << "--------------------------------------------------------------------------------" << endl;
   ss_ << A_BRIGHT_MAGENTA << "MET filter flags" << A_RESET << endl;
   ss_ << "--------------------------------------------------------------------------------" << endl;
   for (auto flag = cutDecisions->metFilterFlags.begin (); flag != cutDecisions->metFilterFlags.end (); flag++)
     {
-      ss_ << A_BRIGHT_BLUE << setw (maxMETFilterWidth_) << left << cutDecisions->metFilters.at (flag - cutDecisions->metFilterFlags.begin ()) << A_RESET;
+      ss_ << A_BRIGHT_BLUE << setw (maxMETFilterWidth_) << left << cutDecisions->metadata->metFilters.at (flag - cutDecisions->metFilterFlags.begin ()) << A_RESET;
       if (*flag)
         ss_ << A_BRIGHT_GREEN << "true" << A_RESET << endl;
       else
@@ -577,12 +581,9 @@ InfoPrinter::printAllTriggerFilters (const edm::Event &event)
   }
 
 #if DATA_FORMAT_FROM_MINIAOD
-  for(auto triggerObj : *handles_.trigobjs) {
-#if CMSSW_VERSION_CODE >= CMSSW_VERSION(9,2,0)
-    triggerObj.unpackNamesAndLabels(event, *handles_.triggers);
-#else
-    triggerObj.unpackPathNames(event.triggerNames(*handles_.triggers));
-#endif
+  const anatools::TriggerObjectIndex &index = anatools::TriggerObjectIndex::get(event, *handles_.triggers, *handles_.trigobjs);
+  for(unsigned i = 0; i < handles_.trigobjs->size(); i++) {
+    const pat::TriggerObjectStandAlone &triggerObj = index.at(i);
     triggerCollections.push_back (triggerObj.collection ());
 
     string filters = "", paths = "";
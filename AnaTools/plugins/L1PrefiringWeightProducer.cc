@@ -3,7 +3,11 @@
 
 L1PrefiringWeightProducer::L1PrefiringWeightProducer(const edm::ParameterSet &cfg) :
    EventVariableProducer(cfg),
-   dataera_(cfg.getParameter<string>("DataEra"))
+   dataera_(cfg.getParameter<string>("DataEra")),
+   prefiringWeight_     (declareVariable ("L1ECALPrefiringWeight")),
+   prefiringWeightUp_   (declareVariable ("L1ECALPrefiringWeightUp")),
+   prefiringWeightDown_ (declareVariable ("L1ECALPrefiringWeightDown")),
+   hasPrefiredJets_     (declareVariable ("hasPrefiredJets"))
 {
   if(dataera_ != "2016BtoH" && dataera_ != "2017BtoF") {
     edm::LogError ("L1PrefiringWeightProducer") << "ERROR [L1PrefiringWeightProducer]: Invalid setting for DataEra: \"" << dataera_ << "\"; only \"2016BtoH\" and \"2017BtoF\" are supported." << endl;
@@ -53,11 +57,11 @@ L1PrefiringWeightProducer::AddVariables(const edm::Event &event, const edm::Even
 
   }
 
-  (*eventvariables)["L1ECALPrefiringWeight"]     = w;
-  (*eventvariables)["L1ECALPrefiringWeightUp"]   = wUp;
-  (*eventvariables)["L1ECALPrefiringWeightDown"] = wDown;
+  eventvariables->set (prefiringWeight_,     w);
+  eventvariables->set (prefiringWeightUp_,   wUp);
+  eventvariables->set (prefiringWeightDown_, wDown);
 
-  (*eventvariables)["hasPrefiredJets"] = hasPrefiredJets;
+  eventvariables->set (hasPrefiredJets_, hasPrefiredJets);
 }
 
 #include "FWCore/Framework/interface/MakerMacros.h"
@@ -19,6 +19,11 @@ class L1PrefiringWeightProducer : public EventVariableProducer
 
         edm::EDGetTokenT<vector<TYPE(jets)> > tokenJets_;
 
+        unsigned prefiringWeight_;
+        unsigned prefiringWeightUp_;
+        unsigned prefiringWeightDown_;
+        unsigned hasPrefiredJets_;
+
         void AddVariables(const edm::Event &, const edm::EventSetup &);
 };
 #endif
@@ -13,7 +13,8 @@ LifetimeWeightProducer::LifetimeWeightProducer(const edm::ParameterSet &cfg) :
   reweightingRules_       (cfg.getParameter<edm::VParameterSet> ("reweightingRules")),
   requireLastNotFirstCopy_(cfg.getParameter<bool> ("requireLastNotFirstCopy")),
   requireLastAndFirstCopy_(cfg.getParameter<bool> ("requireLastAndFirstCopy")),
-  specialRHadronsForDispLeptons_(cfg.getParameter<bool> ("specialRHadronsForDispLeptons"))
+  specialRHadronsForDispLeptons_(cfg.getParameter<bool> ("specialRHadronsForDispLeptons")),
+  lifetimeWeight_         (declareVariable ("lifetimeWeight"))
 {
   mcparticlesToken_ = consumes<vector<TYPE(hardInteractionMcparticles)> >(collections_.getParameter<edm::InputTag>("hardInteractionMcparticles"));
 
@@ -44,6 +45,12 @@ LifetimeWeightProducer::LifetimeWeightProducer(const edm::ParameterSet &cfg) :
 
     weights_.push_back(1.0);
     weightNames_.push_back("lifetimeWeight" + suffix.str());
+    weightSlots_.push_back(declareVariable(weightNames_.back()));
+
+    particleSlots_.push_back(vector<vector<ParticleSlots> > (pdgIds_.back().size()));
+    for(unsigned int iPdgId = 0; iPdgId < pdgIds_.back().size(); iPdgId++)
+      for(unsigned int index = 0; index < 10; index++)
+        getParticleSlots(iRule, iPdgId, index);
   }
 
 }
@@ -61,9 +68,9 @@ LifetimeWeightProducer::AddVariables(const edm::Event &event, const edm::EventSe
   if(!event.getByToken(mcparticlesToken_, mcparticles)) {
     // Save the weights
     for(unsigned int iRule = 0; iRule < weights_.size(); iRule++) {
-      (*eventvariables)[weightNames_[iRule]] = weights_[iRule];
+      eventvariables->set(weightSlots_[iRule], weights_[iRule]);
       if(isDefaultRule_[iRule]) {
-        (*eventvariables)["lifetimeWeight"] = weights_[iRule];
+        eventvariables->set(lifetimeWeight_, weights_[iRule]);
       }
     }
     return;
@@ -124,7 +131,6 @@ LifetimeWeightProducer::AddVariables(const edm::Event &event, const edm::EventSe
 
     } // for mcparticles
 
-    stringstream suffix;
     for(unsigned int iPdgId = 0; iPdgId < pdgIds_[iRule].size(); iPdgId++) {
       unsigned index = 0;
       for(unsigned int i_cTau = 0; i_cTau < cTaus[iPdgId].size(); i_cTau++) {
@@ -133,13 +139,12 @@ LifetimeWeightProducer::AddVariables(const edm::Event &event, const edm::EventSe
         // Save the cTau for every mcparticle used for reweighting, along with other information
         // If the same pdgId is used in multiple rules, this value will be
         // overwritten for every rule but the ordering/index is always the same, so it will be fine
-        suffix.str("");
-        suffix << "_" << abs(pdgIds_[iRule][iPdgId]) << "_" << index++;
+        const ParticleSlots &slots = getParticleSlots(iRule, iPdgId, index++);
 
-        (*eventvariables)["cTau" + suffix.str()] = cTau;
-        (*eventvariables)["decayLength" + suffix.str()] = decayLengths[iPdgId][i_cTau];
-        (*eventvariables)["beta" + suffix.str()] = betaFactors[iPdgId][i_cTau];
-        (*eventvariables)["gamma" + suffix.str()] = gammaFactors[iPdgId][i_cTau];
+        eventvariables->set(slots.cTau, cTau);
+        eventvariables->set(slots.decayLength, decayLengths[iPdgId][i_cTau]);
+        eventvariables->set(slots.beta, betaFactors[iPdgId][i_cTau]);
+        eventvariables->set(slots.gamma, gammaFactors[iPdgId][i_cTau]);
 
         double srcPDF = exp(-cTau / srcCTau_[iRule][iPdgId]) / srcCTau_[iRule][iPdgId];
         double dstPDF = exp(-cTau / dstCTau_[iRule][iPdgId]) / dstCTau_[iRule][iPdgId];
@@ -150,13 +155,12 @@ LifetimeWeightProducer::AddVariables(const edm::Event &event, const edm::EventSe
       // That is, if your sample contains a variable number of charginos, still save INVALID_VALUE
       // for 10 charginos in case there ever could be that many.
       while(index < 10) {
-        suffix.str("");
-        suffix << "_" << abs(pdgIds_[iRule][iPdgId]) << "_" << index++;
+        const ParticleSlots &slots = getParticleSlots(iRule, iPdgId, index++);
 
-        (*eventvariables)["cTau" + suffix.str()] = INVALID_VALUE;
-        (*eventvariables)["decayLength" + suffix.str()] = INVALID_VALUE;
-        (*eventvariables)["beta" + suffix.str()] = INVALID_VALUE;
-        (*eventvariables)["gamma" + suffix.str()] = INVALID_VALUE;
+        eventvariables->set(slots.cTau, INVALID_VALUE);
+        eventvariables->set(slots.decayLength, INVALID_VALUE);
+        eventvariables->set(slots.beta, INVALID_VALUE);
+        eventvariables->set(slots.gamma, INVALID_VALUE);
       }
     } // for pdgIds in this rule
 
@@ -165,14 +169,32 @@ LifetimeWeightProducer::AddVariables(const edm::Event &event, const edm::EventSe
 
   // Save the weights
   for(unsigned int iRule = 0; iRule < weights_.size(); iRule++) {
-    (*eventvariables)[weightNames_[iRule]] = weights_[iRule];
+    eventvariables->set(weightSlots_[iRule], weights_[iRule]);
     //cout << "Saving weight named: " << weightNames_[iRule] << endl;
     if(isDefaultRule_[iRule]) {
-      (*eventvariables)["lifetimeWeight"] = weights_[iRule];
+      eventvariables->set(lifetimeWeight_, weights_[iRule]);
     }
   }
 }
 
+// getParticleSlots: slots of the variables saved for the particle with the
+//                   given index, declaring them the first time they are needed
+const LifetimeWeightProducer::ParticleSlots &
+LifetimeWeightProducer::getParticleSlots(const unsigned iRule, const unsigned iPdgId, const unsigned index)
+{
+  vector<ParticleSlots> &slots = particleSlots_[iRule][iPdgId];
+  while(slots.size() <= index) {
+    stringstream suffix;
+    suffix << "_" << abs(pdgIds_[iRule][iPdgId]) << "_" << slots.size();
+
+    slots.push_back({declareVariable("cTau" + suffix.str()),
+                     declareVariable("decayLength" + suffix.str()),
+                     declareVariable("beta" + suffix.str()),
+                     declareVariable("gamma" + suffix.str())});
+  }
+  return slots[index];
+}
+
 bool
 LifetimeWeightProducer::isOriginalParticle(const TYPE(hardInteractionMcparticles) &mcparticle, const int pdgId) const
 {
@@ -27,6 +27,24 @@ class LifetimeWeightProducer : public EventVariableProducer {
         vector<double> weights_;
         vector<string> weightNames_;
 
+        // Slots in the payload of the weights and of the variables saved for
+        // each particle used in the reweighting, e.g., cTau_1000024_0. The
+        // particle variables are indexed by rule, pdgId, and the index of the
+        // particle, with the first 10 declared in the constructor and any more
+        // declared as they are needed.
+        struct ParticleSlots
+        {
+          unsigned cTau;
+          unsigned decayLength;
+          unsigned beta;
+          unsigned gamma;
+        };
+        vector<unsigned> weightSlots_;
+        unsigned lifetimeWeight_;
+        vector<vector<vector<ParticleSlots> > > particleSlots_;
+
+        const ParticleSlots &getParticleSlots(const unsigned, const unsigned, const unsigned);
+
         bool isOriginalParticle(const TYPE(hardInteractionMcparticles) &, const int) const;
         double getCTau(const TYPE(hardInteractionMcparticles) &) const;
         TVector3 getEndVertex(const TYPE(hardInteractionMcparticles) &) const;
@@ -1,9 +1,13 @@
 #include "OSUT3Analysis/AnaTools/interface/CommonUtils.h"
 #include "OSUT3Analysis/AnaTools/plugins/ObjectScalingFactorProducer.h"
+#include <algorithm>
 #include <typeinfo>
 
 ObjectScalingFactorProducer::ObjectScalingFactorProducer(const edm::ParameterSet &cfg) :
-  EventVariableProducer(cfg)
+  EventVariableProducer(cfg),
+  doTrackSF_ (false),
+  tablesLoaded_ (false),
+  trackScalingFactor_ (declareVariable ("trackScalingFactor"))
 {
 
   if (cfg.exists ("electronFile"))
@@ -44,6 +48,10 @@ ObjectScalingFactorProducer::ObjectScalingFactorProducer(const edm::ParameterSet
               sf.inputLumis.push_back(lumi);
     }
 
+    sf.outputSlot = declareVariable (sf.outputVariable);
+    sf.outputSlotUp = declareVariable (sf.outputVariable + "Up");
+    sf.outputSlotDown = declareVariable (sf.outputVariable + "Down");
+
     objectsToGet_.insert(sf.inputCollection);
     scaleFactors_.push_back(sf);
 
@@ -54,68 +62,151 @@ ObjectScalingFactorProducer::ObjectScalingFactorProducer(const edm::ParameterSet
 
 ObjectScalingFactorProducer::~ObjectScalingFactorProducer() {}
 
+TFile *
+ObjectScalingFactorProducer::openFile (const string &fileName) const
+{
+  TFile *fin = TFile::Open (fileName.c_str ());
+  if (!fin || fin->IsZombie()) {
+    clog << "ERROR [ObjectScalingFactorProducer]: Could not find file: " << fileName
+               << "; will cause a seg fault." << endl;
+    exit(1);
+  }
+  return fin;
+}
+
+void
+ObjectScalingFactorProducer::loadTables ()
+{
+  TFile *electronInputFile = 0;
+  if (objectsToGet_.count ("electrons"))
+    electronInputFile = openFile (electronFile_);
+
+  TFile *muonInputFile = 0;
+  if (objectsToGet_.count ("muons"))
+    muonInputFile = openFile (muonFile_);
+
+  tables_.clear ();
+  for (const auto &sf : scaleFactors_) {
+    tables_.push_back (SFTables ());
+    SFTables &tables = tables_.back ();
+    tables.isGraph = false;
+
+    // electron SFs aren't split into separate eras, so only the first plot is used
+    if (sf.inputCollection == "electrons") {
+      TH2F * plot = (TH2F*)electronInputFile->Get(sf.inputPlots[0].c_str());
+      if(!plot){
+        clog << "ERROR [ObjectScalingFactorProducer]: Could not find histogram: " << sf.inputPlots[0]
+             << "; will cause a seg fault." << endl;
+        exit(1);
+      }
+      tables.histograms.push_back (BinnedLookup2D (*plot));
+      delete plot;
+    }
+
+    // muons are split up into eras, and can be either TH2F's or
+    // TGraphAsymmErrors, where the first era decides which
+    else if (sf.inputCollection == "muons") {
+      TObject * tempObj = muonInputFile->Get(sf.inputPlots[0].c_str());
+      if(!tempObj) {
+        clog << "ERROR [ObjectScalingFactorProducer]: Could not find object: " << sf.inputPlots[0]
+             << "; will cause a seg fault." << endl;
+        exit(1);
+      }
+
+      if (tempObj->InheritsFrom("TGraphAsymmErrors")) {
+        tables.isGraph = true;
+        for (const auto &inputPlot : sf.inputPlots) {
+          TGraphAsymmErrors * plot = (TGraphAsymmErrors*)muonInputFile->Get(inputPlot.c_str());
+          if(!plot) {
+             clog << "ERROR [ObjectScalingFactorProducer]: Could not find TGraphAsymmErrors: " << inputPlot
+                  << "; will cause a seg fault." << endl;
+             exit(1);
+          }
+          tables.graphs.push_back (BinnedGraph (*plot));
+          delete plot;
+        }
+      }
+      else if (tempObj->InheritsFrom("TH2")) {
+        for (const auto &inputPlot : sf.inputPlots) {
+          TH2F * plot = (TH2F*)muonInputFile->Get(inputPlot.c_str());
+          if(!plot) {
+             clog << "ERROR [ObjectScalingFactorProducer]: Could not find histogram: " << inputPlot
+                  << "; will cause a seg fault." << endl;
+             exit(1);
+          }
+          tables.histograms.push_back (BinnedLookup2D (*plot));
+          delete plot;
+        }
+      }
+      delete tempObj;
+    }
+  }
+
+  if (electronInputFile) {
+    electronInputFile->Close();
+    delete electronInputFile;
+  }
+  if (muonInputFile) {
+    muonInputFile->Close();
+    delete muonInputFile;
+  }
+
+  if (doTrackSF_) {
+    TFile *trackSF = openFile (trackFile_);
+    TH1D *data = (TH1D *) trackSF->Get ("missingOuterHits_data");
+    data->SetDirectory (0);
+    TH1D *mc = (TH1D *) trackSF->Get ("missingOuterHits_mc");
+    mc->SetDirectory (0);
+    trackSF->Close ();
+    delete trackSF;
+
+    data->Scale (1.0 / data->Integral ());
+    mc->Scale (1.0 / mc->Integral ());
+    data->Divide (mc);
+    trackTable_ = BinnedLookup1D (*data);
+    delete data;
+    delete mc;
+  }
+
+  tablesLoaded_ = true;
+}
+
 void
 ObjectScalingFactorProducer::AddVariables (const edm::Event &event, const edm::EventSetup &setup) {
 #if DATA_FORMAT_FROM_MINIAOD
   if (event.isRealData ()) {
     for (auto &sf : scaleFactors_) {
-      (*eventvariables)[sf.outputVariable] = 1.0;
-      (*eventvariables)[sf.outputVariable + "Up"] = 1.0;
-      (*eventvariables)[sf.outputVariable + "Down"] = 1.0;
+      eventvariables->set (sf.outputSlot, 1.0);
+      eventvariables->set (sf.outputSlotUp, 1.0);
+      eventvariables->set (sf.outputSlotDown, 1.0);
     }
     return;
   }
 
   anatools::getRequiredCollections (objectsToGet_, handles_, event, tokens_);
 
-  TFile *electronInputFile = 0;
-  bool doElectrons = false;
-  if(find(objectsToGet_.begin(), objectsToGet_.end(), "electrons") != objectsToGet_.end())
-    doElectrons = true;
-
-  if (doElectrons) {
-    electronInputFile = TFile::Open (electronFile_.c_str ());
-    if (!electronInputFile || electronInputFile->IsZombie()) {
-      clog << "ERROR [ObjectScalingFactorProducer]: Could not find file: " << electronFile_
-                 << "; will cause a seg fault." << endl;
-      exit(1);
-    }
-  }
-
-  TFile *muonInputFile = 0;
-  bool doMuons = false;
-  if(find(objectsToGet_.begin(), objectsToGet_.end(), "muons") != objectsToGet_.end())
-    doMuons = true;
-
-  if (doMuons) {
-    muonInputFile = TFile::Open (muonFile_.c_str ());
-    if (!muonInputFile || muonInputFile->IsZombie()) {
-      clog << "ERROR [ObjectScalingFactorProducer]: Could not find file: " << muonFile_
-                 << "; will cause a seg fault." << endl;
-      exit(1);
-    }
-  }
+  // the scale factors are read from their files only once, on the first
+  // simulated event, so that jobs on data never need the files
+  if (!tablesLoaded_)
+    loadTables ();
 
   // loop over desired scale factors, treating each case independently
-  for (auto &sf : scaleFactors_){
+  for (unsigned iSF = 0; iSF < scaleFactors_.size(); iSF++){
+    const ScaleFactor &sf = scaleFactors_.at(iSF);
+    const SFTables &tables = tables_.at(iSF);
     double sfCentral = 1;
     double sfDown = 1;
     double sfUp = 1;
 
     // loop over different types of electron SFs
     // these aren't split into separate eras, so don't bother with looping over eras
-    if (doElectrons && sf.inputCollection == "electrons") {
-      TH2F * plot = (TH2F*)electronInputFile->Get(sf.inputPlots[0].c_str());
-      if(!plot){
-               clog << "ERROR [ObjectScalingFactorProducer]: Could not find histogram: " << sf.inputPlots[0]
-                    << "; will cause a seg fault." << endl;
-         exit(1);
-      }
+    if (sf.inputCollection == "electrons") {
+      const BinnedLookup2D &plot = tables.histograms.at (0);
 
-      float xMin = plot->GetXaxis()->GetBinCenter(1);
-      float xMax = plot->GetXaxis()->GetBinCenter(plot->GetNbinsX());
-      float yMin = plot->GetYaxis()->GetBinCenter(1);
-      float yMax = plot->GetYaxis()->GetBinCenter(plot->GetNbinsY());
+      float xMin = plot.xAxis().center(1);
+      float xMax = plot.xAxis().center(plot.xAxis().nBins());
+      float yMin = plot.yAxis().center(1);
+      float yMax = plot.yAxis().center(plot.yAxis().nBins());
       for (const auto &electron1 : *handles_.electrons) {
          float eta = electron1.eta();
          // the 2015 ID plots are in |eta| yet the rest are in eta, so check xMin
@@ -128,8 +219,9 @@ ObjectScalingFactorProducer::AddVariables (const edm::Event &event, const edm::E
          if(pt < yMin) pt = yMin;
          if(pt > yMax) pt = yMax;
 
-               float sfValue = plot->GetBinContent(plot->FindBin(eta, pt));
-               float sfError = plot->GetBinError(plot->FindBin(eta, pt));
+         int bin = plot.findBin(eta, pt);
+               float sfValue = plot.content(bin);
+               float sfError = plot.error(bin);
 
          // for 80X Moriond series (https://twiki.cern.ch/twiki/bin/view/CMS/EgammaIDRecipesRun2#Electron_efficiencies_and_scale)
          // special systematic recommendation for pt<20 and pt>80
@@ -140,33 +232,18 @@ ObjectScalingFactorProducer::AddVariables (const edm::Event &event, const edm::E
                sfUp *= sfValue + sfError;
          sfDown *= sfValue - sfError;
       } // end loop over electrons
-      delete plot;
     }
 
     // muons are split up into eras, so loop over any provided
     // also can be either TH2F's or TGraphAsymmErrors, so test for each case
-    else if (doMuons && sf.inputCollection == "muons") {
-
-      TObject * tempObj = muonInputFile->Get(sf.inputPlots[0].c_str());
-      if(!tempObj) {
-        clog << "ERROR [ObjectScalingFactorProducer]: Could not find object: " << sf.inputPlots[0]
-             << "; will cause a seg fault." << endl;
-        exit(1);
-      }
+    else if (sf.inputCollection == "muons") {
 
-      int numPlots = sf.inputPlots.size();
       vector<float> valuesByEra, valuesByEraUp, valuesByEraDown;
 
-      if (tempObj->InheritsFrom("TGraphAsymmErrors")) {
+      if (tables.isGraph) {
 
         // find values and errors for each era, and store them in vectors
-        for (int iGraph = 0; iGraph < numPlots; iGraph++) {
-          TGraphAsymmErrors * plot = (TGraphAsymmErrors*)muonInputFile->Get(sf.inputPlots[iGraph].c_str());
-          if(!plot) {
-             clog << "ERROR [ObjectScalingFactorProducer]: Could not find TGraphAsymmErrors: " << sf.inputPlots[iGraph]
-                  << "; will cause a seg fault." << endl;
-             exit(1);
-          }
+        for (const auto &plot : tables.graphs) {
 
           // For this era/graph, find the SF as the product of all muons' SFs
           float thisEraSF = 1.0;
@@ -174,21 +251,12 @@ ObjectScalingFactorProducer::AddVariables (const edm::Event &event, const edm::E
           float thisEraSFDown = 1.0;
 
           for (const auto &muon1 : *handles_.muons) {
-             // find the point in the TGraph for this muon's |eta|
-             double eta = abs(muon1.eta());
-             int iPoint = 0;
-             while(iPoint < plot->GetN()) {
-               if(eta < plot->GetX()[iPoint] + plot->GetErrorXhigh(iPoint) &&
-                  eta > plot->GetX()[iPoint] - plot->GetErrorXlow(iPoint))
-                  break;
-                else iPoint++;
-             }
-             // if the |eta| is past the highest point, just use the highest \eta| point with a value; |eta| can't be < 0 so no need to check
-             if(iPoint == plot->GetN()) iPoint = plot->GetN() - 1;
+             // find the point in the TGraph for this muon's |eta|; |eta| can't be < 0 so no need to check
+             unsigned iPoint = plot.findPoint(abs(muon1.eta()));
 
              // Now include this muon's scale factor
-             float thisMuonSF = plot->GetY()[iPoint];
-             float thisMuonSFError = plot->GetErrorYhigh(iPoint);
+             float thisMuonSF = plot.content(iPoint);
+             float thisMuonSFError = plot.errorHigh(iPoint);
 
              thisEraSF *= thisMuonSF;
              thisEraSFUp *= thisMuonSF + thisMuonSFError;
@@ -197,40 +265,32 @@ ObjectScalingFactorProducer::AddVariables (const edm::Event &event, const edm::E
           valuesByEra.push_back(thisEraSF);
           valuesByEraUp.push_back(thisEraSFUp);
           valuesByEraDown.push_back(thisEraSFDown);
-
-          delete plot;
         } // end loop over eras
 
       } // end TGraphAsymmErrors case -- now have vectors of values and errors by era
 
-      else if(tempObj->InheritsFrom("TH2")) {
+      else {
 
         // find values and errors for each era, and store them in vectors
-        for (int iPlot = 0; iPlot < numPlots; iPlot++) {
-          TH2F * plot = (TH2F*)muonInputFile->Get(sf.inputPlots[iPlot].c_str());
-          if(!plot) {
-             clog << "ERROR [ObjectScalingFactorProducer]: Could not find histogram: " << sf.inputPlots[iPlot]
-                  << "; will cause a seg fault." << endl;
-             exit(1);
-          }
+        for (const auto &plot : tables.histograms) {
 
           float thisEraSF = 1.0;
           float thisEraSFUp = 1.0;
           float thisEraSFDown = 1.0;
 
-          float xMin = plot->GetXaxis()->GetBinCenter(1);
-          float xMax = plot->GetXaxis()->GetBinCenter(plot->GetNbinsX());
-          float yMax = plot->GetYaxis()->GetBinCenter(plot->GetNbinsY());
+          float xMin = plot.xAxis().center(1);
+          float xMax = plot.xAxis().center(plot.xAxis().nBins());
+          float yMax = plot.yAxis().center(plot.yAxis().nBins());
 
           for (const auto &muon1 : *handles_.muons) {
             float pt = muon1.pt();
             if(pt > xMax) pt = xMax;
             if(pt < xMin) pt = xMin;
             float eta = (abs(muon1.eta()) > yMax) ? yMax : abs(muon1.eta());
-            int bin = plot->FindBin(pt, eta);
+            int bin = plot.findBin(pt, eta);
 
-            float thisMuonSF = plot->GetBinContent(bin);
-            float thisMuonSFError = plot->GetBinError(bin);
+            float thisMuonSF = plot.content(bin);
+            float thisMuonSFError = plot.error(bin);
 
             thisEraSF *= thisMuonSF;
             thisEraSFUp *= thisMuonSF + thisMuonSFError;
@@ -240,14 +300,10 @@ ObjectScalingFactorProducer::AddVariables (const edm::Event &event, const edm::E
           valuesByEra.push_back(thisEraSF);
           valuesByEraUp.push_back(thisEraSFUp);
           valuesByEraDown.push_back(thisEraSFDown);
-
-          delete plot;
         } // end loop over eras
 
       } // end TH2 case -- now have vectors of values and errors by era
 
-      delete tempObj;
-
       // now we find the lumi-weighted averages amongst the eras
 
       double totalLumi = 0;
@@ -273,53 +329,28 @@ ObjectScalingFactorProducer::AddVariables (const edm::Event &event, const edm::E
       sfDown -= sf.additionalSystematic * sfCentral;
     }
 
-    (*eventvariables)[sf.outputVariable] = sfCentral;
-    (*eventvariables)[sf.outputVariable + "Up"] = sfUp;
-    (*eventvariables)[sf.outputVariable + "Down"] = sfDown;
+    eventvariables->set (sf.outputSlot, sfCentral);
+    eventvariables->set (sf.outputSlotUp, sfUp);
+    eventvariables->set (sf.outputSlotDown, sfDown);
 
   }
 
-  if (doElectrons)
-    electronInputFile->Close();
-  if (doMuons)
-    muonInputFile->Close();
-
   return;
 
   if (doTrackSF_)
     {
       double sf = 1.0;
 #if IS_VALID(tracks)
-      TFile *trackSF = TFile::Open (trackFile_.c_str ());
-      if (!trackSF || trackSF->IsZombie()) {
-        clog << "ERROR [ObjectScalingFactorProducer]: Could not find file: " << trackFile_
-         << "; will cause a seg fault." << endl;
-        exit(1);
-      }
-
-      TH1D *data = (TH1D *) trackSF->Get ("missingOuterHits_data");
-      data->SetDirectory (0);
-      TH1D *mc = (TH1D *) trackSF->Get ("missingOuterHits_mc");
-      mc->SetDirectory (0);
-      trackSF->Close ();
-      delete trackSF;
-
-      data->Scale (1.0 / data->Integral ());
-      mc->Scale (1.0 / mc->Integral ());
-      data->Divide (mc);
-
       for (const auto &track : *handles_.tracks)
         {
           double missingOuterHits = track.hitPattern ().trackerLayersWithoutMeasurement (reco::HitPattern::MISSING_OUTER_HITS);
-          sf *= data->GetBinContent (data->FindBin (missingOuterHits));
+          sf *= trackTable_.at (missingOuterHits);
         }
-      delete data;
-      delete mc;
 #endif
-      (*eventvariables)["trackScalingFactor"] = sf;
+      eventvariables->set (trackScalingFactor_, sf);
     }
 #else
-  (*eventvariables)["trackScalingFactor"] = 1;
+  eventvariables->set (trackScalingFactor_, 1);
 # endif
 }
 
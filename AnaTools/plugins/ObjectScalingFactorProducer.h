@@ -12,6 +12,15 @@
 #include "TFile.h"
 
 #include "OSUT3Analysis/AnaTools/interface/AnalysisTypes.h"
+#include "OSUT3Analysis/AnaTools/interface/BinnedLookup.h"
+
+// Tables for one ScaleFactor, one entry per era.
+struct SFTables
+{
+  bool isGraph;
+  vector<BinnedLookup2D> histograms;
+  vector<BinnedGraph> graphs;
+};
 
 class ObjectScalingFactorProducer : public EventVariableProducer
   {
@@ -31,7 +40,16 @@ class ObjectScalingFactorProducer : public EventVariableProducer
         bool doMuSF_;
         bool doTrackSF_;
         void AddVariables(const edm::Event &, const edm::EventSetup &);
+        void loadTables ();
+        TFile *openFile (const string &) const;
               vector<ScaleFactor> scaleFactors_;
 
+        // parallel to scaleFactors_, filled on the first simulated event
+        bool tablesLoaded_;
+        vector<SFTables> tables_;
+        BinnedLookup1D trackTable_;
+
+        unsigned trackScalingFactor_;
+
 };
 #endif
@@ -11,7 +11,11 @@ PUScalingFactorProducer::PUScalingFactorProducer(const edm::ParameterSet &cfg) :
    puWeight_         (NULL),
    puWeightUp_       (NULL),
    puWeightDown_     (NULL),
-   isFirstEvent_     (true)
+   isFirstEvent_     (true),
+   puScalingFactor_     (declareVariable ("puScalingFactor")),
+   puScalingFactorUp_   (declareVariable ("puScalingFactorUp")),
+   puScalingFactorDown_ (declareVariable ("puScalingFactorDown")),
+   numTrueInteractions_ (declareVariable ("numTrueInteractions"))
 {
   if(collections_.exists ("pileupinfos"))
     pileUpInfosToken_ = consumes<vector<TYPE(pileupinfos)> > (collections_.getParameter<edm::InputTag> ("pileupinfos"));
@@ -131,10 +135,10 @@ PUScalingFactorProducer::AddVariables (const edm::Event &event, const edm::Event
              << "\", targetUp_: \"" << (targetUp_ != "" ? targetUp_ : "n/a")
              << "\", targetDown_: \"" << (targetDown_ != "" ? targetDown_ : "n/a")
              << "\")" << endl;
-      (*eventvariables)["puScalingFactor"]     = puWeight_->GetBinContent(puWeight_->FindBin(numTruePV));
-      (*eventvariables)["puScalingFactorUp"]   = puWeightUp_ ? puWeightUp_->GetBinContent(puWeightUp_->FindBin(numTruePV)) : 1;
-      (*eventvariables)["puScalingFactorDown"] = puWeightDown_ ? puWeightDown_->GetBinContent(puWeightDown_->FindBin(numTruePV)) : 1;
-      (*eventvariables)["numTrueInteractions"] = numTruePV;
+      eventvariables->set (puScalingFactor_,     puWeight_->GetBinContent(puWeight_->FindBin(numTruePV)));
+      eventvariables->set (puScalingFactorUp_,   puWeightUp_ ? puWeightUp_->GetBinContent(puWeightUp_->FindBin(numTruePV)) : 1);
+      eventvariables->set (puScalingFactorDown_, puWeightDown_ ? puWeightDown_->GetBinContent(puWeightDown_->FindBin(numTruePV)) : 1);
+      eventvariables->set (numTrueInteractions_, numTruePV);
     }
   else
     {
@@ -147,16 +151,16 @@ PUScalingFactorProducer::AddVariables (const edm::Event &event, const edm::Event
              << "\", targetUp_: \"" << (targetUp_ != "" ? targetUp_ : "n/a")
              << "\", targetDown_: \"" << (targetDown_ != "" ? targetDown_ : "n/a")
              << "\")" << endl;
-             (*eventvariables)["puScalingFactor"]     = 1;
-             (*eventvariables)["puScalingFactorUp"]   = 1;
-             (*eventvariables)["puScalingFactorDown"] = 1;
-             (*eventvariables)["numTrueInteractions"] = INVALID_VALUE;
+             eventvariables->set (puScalingFactor_,     1);
+             eventvariables->set (puScalingFactorUp_,   1);
+             eventvariables->set (puScalingFactorDown_, 1);
+             eventvariables->set (numTrueInteractions_, INVALID_VALUE);
     }
 #else
-    (*eventvariables)["puScalingFactor"]     = 1;
-    (*eventvariables)["puScalingFactorUp"]   = 1;
-    (*eventvariables)["puScalingFactorDown"] = 1;
-   (*eventvariables)["numTrueInteractions"] = INVALID_VALUE;
+    eventvariables->set (puScalingFactor_,     1);
+    eventvariables->set (puScalingFactorUp_,   1);
+    eventvariables->set (puScalingFactorDown_, 1);
+   eventvariables->set (numTrueInteractions_, INVALID_VALUE);
 # endif
     isFirstEvent_ = false;
 }
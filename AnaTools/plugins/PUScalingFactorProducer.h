@@ -25,6 +25,10 @@ class PUScalingFactorProducer : public EventVariableProducer
         TH1D *puWeightUp_;
         TH1D *puWeightDown_;
         bool isFirstEvent_;
+        unsigned puScalingFactor_;
+        unsigned puScalingFactorUp_;
+        unsigned puScalingFactorDown_;
+        unsigned numTrueInteractions_;
         void AddVariables(const edm::Event &, const edm::EventSetup &);
 
         edm::EDGetTokenT<vector<TYPE(pileupinfos)> > pileUpInfosToken_;
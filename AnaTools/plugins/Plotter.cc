@@ -10,11 +10,11 @@
 //   2. names of miniAOD collections to be used
 // It outputs a root file with corresponding histograms
 
-Plotter::Plotter (const edm::ParameterSet &cfg) :
+Plotter::Plotter (const edm::ParameterSet &cfg, const PlotterHistograms *booked) :
 
   // In the constructor, we parse the input histogram definitions
-  // We create the appropriate directory structure in the output file
-  // Then we book the TH1/TH2 objects in these directories
+  // Then we make this stream's copies of the histograms booked in
+  // initializeGlobalCache
 
   /// Retrieve parameters from the configuration file.
   collections_ (cfg.getParameter<edm::ParameterSet> ("collections")),
@@ -26,76 +26,35 @@ Plotter::Plotter (const edm::ParameterSet &cfg) :
 {
   if (verbose_) clog << "Beginning Plotter::Plotter constructor." << endl;
 
-  TH1::SetDefaultSumw2();
-
   /////////////////////////////////////
   // parse the histogram definitions //
   /////////////////////////////////////
 
-  // loop over each histogram set the user has included
-  for(unsigned histoSet = 0; histoSet != histogramSets_.size(); histoSet++){
-
-    vector<string> inputCollection = histogramSets_.at(histoSet).getParameter<vector<string> > ("inputCollection");
-    string catInputCollection = anatools::concatenateInputCollection (inputCollection);
-
-    objectsToGet_.insert (inputCollection.begin (), inputCollection.end ());
-#if DATA_FORMAT_FROM_MINIAOD
-    objectsToGet_.insert ("generatorweights");
-#endif
-
-    // get the appropriate directory name
-    string directoryName = getDirectoryName(catInputCollection);
-
-    // import all the histogram definitions for the current set
-    vector<edm::ParameterSet> histogramList (histogramSets_.at(histoSet).getParameter<vector<edm::ParameterSet> >("histograms"));
-
-    // loop over each histogram
-    vector<edm::ParameterSet>::const_iterator histogram;
-    for(histogram = histogramList.begin(); histogram != histogramList.end(); ++histogram){
-
-      // parse the definition to get the relevant info
-      HistoDef histoDefinition = parseHistoDef(*histogram,inputCollection,catInputCollection,directoryName);
-
-      // check whether a histogram of the same name / directory already exists; if not, add to the master list
-      bool alreadyExists = false;
-      for (vector<HistoDef>::iterator h = histogramDefinitions.begin(); h != histogramDefinitions.end(); ++h)
-        if (h->name      == histoDefinition.name &&
-            h->directory == histoDefinition.directory) { alreadyExists = true; break; }
-      if (alreadyExists) cerr << "WARNING:  Found duplicate histogram in directory " << histoDefinition.directory
-                              << " with name " << histoDefinition.name
-                              << "; will only keep the first instance." << endl;
-      else histogramDefinitions.push_back(histoDefinition);
-
-    } // end loop on histograms in the set
-
-  } // end loop on histogram sets
-
-  // loop over each parsed histogram configuration
-  vector<HistoDef>::iterator histogram;
-  for(histogram = histogramDefinitions.begin(); histogram != histogramDefinitions.end(); ++histogram){
-
-    // book a TH1/TH2 in the appropriate folder
-    bookHistogram(*histogram);
-
-  } // end loop on parsed histograms
+  histogramDefinitions = parseHistogramSets(histogramSets_, objectsToGet_);
 
   //////////////////////////////////
   // parse the weight definitions //
   //////////////////////////////////
 
-  for(unsigned weightDef = 0; weightDef != weightDefs_.size(); weightDef++){
-    vector<string> inputCollections = weightDefs_.at(weightDef).getParameter<vector<string> > ("inputCollections");
-    vector<string>::iterator inputCollection;
-    for(inputCollection = inputCollections.begin(); inputCollection != inputCollections.end(); ++inputCollection){
-      objectsToGet_.insert(*inputCollection);
+  // the nominal weights come first, followed by any variations of them
+  variationNames_ = getVariationNames (cfg);
+  addWeights (weightDefs_);
+  if (cfg.exists ("variations"))
+    {
+      vector<edm::ParameterSet> variations (cfg.getParameter<vector<edm::ParameterSet> > ("variations"));
+      for (const auto &variation : variations)
+        addWeights (variation.getParameter<vector<edm::ParameterSet> > ("weights"));
+    }
+  variationProducts_.resize (variationNames_.size (), 1.0);
+
+  // make a copy of each booked histogram, in the same order, which only this
+  // stream fills
+  for(unsigned i = 0; i != histogramDefinitions.size(); i++){
+    for(const auto &histogram : booked->histograms.at(i)){
+      TH1 *copy = (TH1 *) histogram->Clone();
+      copy->SetDirectory(0);
+      histogramDefinitions.at(i).histograms.push_back(HistogramFillBuffer(copy));
     }
-    string inputVariable = weightDefs_.at(weightDef).getParameter<string> ("inputVariable");
-    Weight weight;
-    weight.inputCollections = inputCollections;
-    weight.inputVariable = inputVariable;
-    weight.valueLookupTree = NULL;
-    weight.product = 1.0;
-    weights.push_back(weight);
   }
 
   anatools::getAllTokens (collections_, consumesCollector (), tokens_);
@@ -103,6 +62,28 @@ Plotter::Plotter (const edm::ParameterSet &cfg) :
 
 ////////////////////////////////////////////////////////////////////////
 
+// books the histograms with the TFileService once for the whole job, before
+// any of the streams are constructed
+unique_ptr<PlotterHistograms>
+Plotter::initializeGlobalCache (const edm::ParameterSet &cfg)
+{
+  TH1::SetDefaultSumw2();
+
+  unordered_set<string> objectsToGet;
+  vector<HistoDef> definitions = parseHistogramSets(cfg.getParameter<vector<edm::ParameterSet> >("histogramSets"), objectsToGet);
+  vector<string> variationNames = getVariationNames(cfg);
+
+  // book a TH1/TH2 in the appropriate folder for each parsed histogram
+  // configuration
+  unique_ptr<PlotterHistograms> booked (new PlotterHistograms);
+  for(const auto &definition : definitions)
+    booked->histograms.push_back(bookHistogram(definition, variationNames));
+
+  return booked;
+}
+
+////////////////////////////////////////////////////////////////////////
+
 // in the analyze function, we retrieve all the needed collections from the event
 // and then loop on over the histogram sets and fill each histogram
 
@@ -137,6 +118,14 @@ Plotter::analyze (const edm::Event &event, const edm::EventSetup &setup)
       }
     }
 
+  // then the product of the weights for each variation
+  for (unsigned variation = 0; variation != variationWeights_.size (); variation++)
+    {
+      variationProducts_.at (variation) = 1.0;
+      for (const auto &weight : variationWeights_.at (variation))
+        variationProducts_.at (variation) *= weights.at (weight).product;
+    }
+
   // now we'll loop over the histograms, filling each one as we go
 
   vector<HistoDef>::iterator histogram;
@@ -148,12 +137,40 @@ Plotter::analyze (const edm::Event &event, const edm::EventSetup &setup)
 
 ////////////////////////////////////////////////////////////////////////
 
+// the fills still in the buffers are added to this stream's copies, which
+// are then added to the booked histograms, one stream at a time
+void
+Plotter::endStream ()
+{
+  lock_guard<mutex> lock (globalCache ()->merging);
+  for (unsigned i = 0; i != histogramDefinitions.size (); i++)
+    for (unsigned variation = 0; variation != histogramDefinitions.at (i).histograms.size (); variation++)
+      {
+        HistogramFillBuffer &buffer = histogramDefinitions.at (i).histograms.at (variation);
+        buffer.flush ();
+        globalCache ()->histograms.at (i).at (variation)->Add (buffer.histogram ());
+      }
+}
+
+////////////////////////////////////////////////////////////////////////
+
+// every stream has already added its copies to the booked histograms, which
+// the TFileService writes after the end of the job
+void
+Plotter::globalEndJob (const PlotterHistograms *)
+{
+}
+
+////////////////////////////////////////////////////////////////////////
+
 Plotter::~Plotter ()
 {
   for (auto &histogram : histogramDefinitions)
     {
       for (auto &valueLookupTree : histogram.valueLookupTrees)
         delete valueLookupTree;
+      for (auto &buffer : histogram.histograms)
+        delete buffer.histogram ();
     }
 
   for (auto &weight : weights)
@@ -178,6 +195,103 @@ string Plotter::getDirectoryName(string inputName){
 
 ////////////////////////////////////////////////////////////////////////
 
+// adds a list of weights as a new variation, sharing any weight which is
+// already used by another variation
+void Plotter::addWeights(const vector<edm::ParameterSet> &weightDefs){
+
+  vector<unsigned> variationWeights;
+  for(const auto &weightDef : weightDefs){
+    vector<string> inputCollections = weightDef.getParameter<vector<string> > ("inputCollections");
+    string inputVariable = weightDef.getParameter<string> ("inputVariable");
+    objectsToGet_.insert(inputCollections.begin(), inputCollections.end());
+
+    unsigned index = 0;
+    for(; index != weights.size(); index++)
+      if(weights.at(index).inputVariable == inputVariable && weights.at(index).inputCollections == inputCollections)
+        break;
+    if(index == weights.size()){
+      Weight weight;
+      weight.inputCollections = inputCollections;
+      weight.inputVariable = inputVariable;
+      weight.valueLookupTree = NULL;
+      weight.product = 1.0;
+      weights.push_back(weight);
+    }
+    variationWeights.push_back(index);
+  }
+  variationWeights_.push_back(variationWeights);
+
+}
+
+////////////////////////////////////////////////////////////////////////
+
+// returns the name of each weight variation, starting with the nominal one,
+// which has no name
+vector<string> Plotter::getVariationNames(const edm::ParameterSet &cfg){
+
+  vector<string> variationNames (1, "");
+  if(cfg.exists("variations")){
+    vector<edm::ParameterSet> variations (cfg.getParameter<vector<edm::ParameterSet> >("variations"));
+    for(const auto &variation : variations)
+      variationNames.push_back(variation.getParameter<string>("name"));
+  }
+  return variationNames;
+
+}
+
+////////////////////////////////////////////////////////////////////////
+
+// parses every histogram set, adding the collections they need to
+// objectsToGet and keeping only the first of any histograms with the same
+// name and directory
+vector<HistoDef> Plotter::parseHistogramSets(const vector<edm::ParameterSet> &histogramSets, unordered_set<string> &objectsToGet){
+
+  vector<HistoDef> histogramDefinitions;
+
+  // loop over each histogram set the user has included
+  for(unsigned histoSet = 0; histoSet != histogramSets.size(); histoSet++){
+
+    vector<string> inputCollection = histogramSets.at(histoSet).getParameter<vector<string> > ("inputCollection");
+    string catInputCollection = anatools::concatenateInputCollection (inputCollection);
+
+    objectsToGet.insert (inputCollection.begin (), inputCollection.end ());
+#if DATA_FORMAT_FROM_MINIAOD
+    objectsToGet.insert ("generatorweights");
+#endif
+
+    // get the appropriate directory name
+    string directoryName = getDirectoryName(catInputCollection);
+
+    // import all the histogram definitions for the current set
+    vector<edm::ParameterSet> histogramList (histogramSets.at(histoSet).getParameter<vector<edm::ParameterSet> >("histograms"));
+
+    // loop over each histogram
+    vector<edm::ParameterSet>::const_iterator histogram;
+    for(histogram = histogramList.begin(); histogram != histogramList.end(); ++histogram){
+
+      // parse the definition to get the relevant info
+      HistoDef histoDefinition = parseHistoDef(*histogram,inputCollection,catInputCollection,directoryName);
+
+      // check whether a histogram of the same name / directory already exists; if not, add to the master list
+      bool alreadyExists = false;
+      for (vector<HistoDef>::iterator h = histogramDefinitions.begin(); h != histogramDefinitions.end(); ++h)
+        if (h->name      == histoDefinition.name &&
+            h->directory == histoDefinition.directory) { alreadyExists = true; break; }
+      if (alreadyExists) cerr << "WARNING:  Found duplicate histogram in directory " << histoDefinition.directory
+                              << " with name " << histoDefinition.name
+                              << "; will only keep the first instance." << endl;
+      else histogramDefinitions.push_back(histoDefinition);
+
+    } // end loop on histograms in the set
+
+  } // end loop on histogram sets
+
+  return histogramDefinitions;
+
+}
+
+////////////////////////////////////////////////////////////////////////
+
 // parses a histogram configuration and saves it in a C++ container
 HistoDef Plotter::parseHistoDef(const edm::ParameterSet &definition, const vector<string> &inputCollection, const string &catInputCollection, const string &subDir){
 
@@ -214,7 +328,7 @@ HistoDef Plotter::parseHistoDef(const edm::ParameterSet &definition, const vecto
 ////////////////////////////////////////////////////////////////////////
 
 // book TH1 or TH2 in appropriate directory with correct bin options
-void Plotter::bookHistogram(const HistoDef &definition){
+vector<TH1 *> Plotter::bookHistogram(const HistoDef &definition, const vector<string> &variationNames){
 
   // check for valid bins
   bool hasValidBinsX = definition.binsX.size() >= 3;
@@ -231,16 +345,34 @@ void Plotter::bookHistogram(const HistoDef &definition){
   if(!hasValidBinsX || !hasValidBinsY || !hasValidBinsZ){
     cout << "ERROR - invalid histogram bins for histogram " << definition.name
          << " in directory " << definition.directory <<  endl;
-    return;
+    return vector<TH1 *> ();
+  }
+
+  // book a copy for each variation, keeping the pointers so that the
+  // histograms never need to be looked up again
+  edm::Service<TFileService> fs;
+  vector<TH1 *> histograms;
+  for(unsigned variation = 0; variation != variationNames.size(); variation++){
+    TFileDirectory subdir = (variationNames.at(variation).empty() ? fs->mkdir(definition.directory) : fs->mkdir(variationNames.at(variation)).mkdir(definition.directory));
+    TH1 *histogram = makeHistogram(definition, subdir);
+    if(!histogram)
+      return vector<TH1 *> ();
+    histograms.push_back(histogram);
   }
 
-  TFileDirectory subdir = fs_->mkdir(definition.directory);
+  return histograms;
+
+}
+
+////////////////////////////////////////////////////////////////////////
+
+TH1 *Plotter::makeHistogram(const HistoDef &definition, TFileDirectory &subdir){
 
   // book 1D histogram
   if(definition.dimensions == 1){
     // equal X bins
     if(!definition.hasVariableBinsX){
-      subdir.make<TH1D>(TString(definition.name),
+      return subdir.make<TH1D>(TString(definition.name),
                         TString(definition.title),
                         definition.binsX.at(0),
                         definition.binsX.at(1),
@@ -248,7 +380,7 @@ void Plotter::bookHistogram(const HistoDef &definition){
     }
     // variable X bins
     else{
-      subdir.make<TH1D>(TString(definition.name),
+      return subdir.make<TH1D>(TString(definition.name),
                         TString(definition.title),
                         definition.binsX.size() - 1,
                         definition.binsX.data());
@@ -258,7 +390,7 @@ void Plotter::bookHistogram(const HistoDef &definition){
   else if(definition.dimensions == 2){
     // equal X bins and equal Y bins
     if(!definition.hasVariableBinsX && !definition.hasVariableBinsY){
-      subdir.make<TH2D>(TString(definition.name),
+      return subdir.make<TH2D>(TString(definition.name),
                         TString(definition.title),
                         definition.binsX.at(0),
                         definition.binsX.at(1),
@@ -269,7 +401,7 @@ void Plotter::bookHistogram(const HistoDef &definition){
     }
     // variable X bins and equal Y bins
     else if(definition.hasVariableBinsX && !definition.hasVariableBinsY){
-      subdir.make<TH2D>(TString(definition.name),
+      return subdir.make<TH2D>(TString(definition.name),
                         TString(definition.title),
                         definition.binsX.size() - 1,
                         definition.binsX.data(),
@@ -279,7 +411,7 @@ void Plotter::bookHistogram(const HistoDef &definition){
     }
     // equal X bins and variable Y bins
     else if(!definition.hasVariableBinsX && definition.hasVariableBinsY){
-      subdir.make<TH2D>(TString(definition.name),
+      return subdir.make<TH2D>(TString(definition.name),
                         TString(definition.title),
                         definition.binsX.at(0),
                         definition.binsX.at(1),
@@ -289,7 +421,7 @@ void Plotter::bookHistogram(const HistoDef &definition){
     }
     // variable X bins and variable Y bins
     else if(definition.hasVariableBinsX && definition.hasVariableBinsY){
-      subdir.make<TH2D>(TString(definition.name),
+      return subdir.make<TH2D>(TString(definition.name),
                         TString(definition.title),
                         definition.binsX.size() - 1,
                         definition.binsX.data(),
@@ -300,7 +432,7 @@ void Plotter::bookHistogram(const HistoDef &definition){
   else if(definition.dimensions == 3){
     // equal X bins, equal Y bins, and equal Z bins
     if(!definition.hasVariableBinsX && !definition.hasVariableBinsY && !definition.hasVariableBinsZ){
-      subdir.make<TH3D>(TString(definition.name),
+      return subdir.make<TH3D>(TString(definition.name),
                         TString(definition.title),
                         definition.binsX.at(0),
                         definition.binsX.at(1),
@@ -315,7 +447,7 @@ void Plotter::bookHistogram(const HistoDef &definition){
     // variable X bins, variable Y bins, and variable Z bins
     // TH3D objects only support variable bins along all three axes or along none
     else{
-      subdir.make<TH3D>(TString(definition.name),
+      return subdir.make<TH3D>(TString(definition.name),
                         TString(definition.title),
                         definition.binsX.size() - 1,
                         definition.binsX.data(),
@@ -327,15 +459,21 @@ void Plotter::bookHistogram(const HistoDef &definition){
   }
   else{
     cout << "WARNING - invalid histogram dimension" << endl;
-    return;
+    return NULL;
   }
 
+  return NULL;
+
 }
 
 ////////////////////////////////////////////////////////////////////////
 
 // fill TH1 or TH2 using one collection
-void Plotter::fillHistogram(const HistoDef &definition){
+void Plotter::fillHistogram(HistoDef &definition){
+
+  // nothing was booked if the definition was invalid
+  if(definition.histograms.empty())
+    return;
 
  if(definition.dimensions == 1){
    fill1DHistogram(definition);
@@ -355,9 +493,9 @@ void Plotter::fillHistogram(const HistoDef &definition){
 ////////////////////////////////////////////////////////////////////////
 
 // fill TH1 using one collection
-void Plotter::fill1DHistogram(const HistoDef &definition){
+void Plotter::fill1DHistogram(HistoDef &definition){
 
-  TH1D *histogram = fs_->getObject<TH1D>(definition.name, definition.directory);
+  vector<HistogramFillBuffer> &histograms = definition.histograms;
 
   // loop over objects in input collection and fill histogram
   for(vector<Leaf>::const_iterator leaf = definition.valueLookupTrees.at (0)->evaluate ().begin (); leaf != definition.valueLookupTrees.at (0)->evaluate ().end (); leaf++){
@@ -369,14 +507,14 @@ void Plotter::fill1DHistogram(const HistoDef &definition){
     if(IS_INVALID(value))
       continue;
     if(definition.hasVariableBinsX){
-      weight /= getBinSize(histogram,value);
+      weight /= getBinSize((TH1D *) histograms.at(0).histogram(),value);
     }
     if (handles_.generatorweights.isValid ())
       weight *= anatools::getGeneratorWeight (*handles_.generatorweights);
-    for (vector<Weight>::iterator sf = weights.begin (); sf != weights.end (); sf++)
-      weight *= sf->product;
-    histogram->Fill(value, (definition.weight ? weight : 1.0));
-    if (verbose_) clog << "Filled histogram " << definition.name << " with value=" << value << ", weight=" << weight << endl;
+    int bin = histograms.at(0).findBin(value);
+    for(unsigned variation = 0; variation != histograms.size(); variation++)
+      histograms.at(variation).fill(bin, (definition.weight ? weight * variationProducts_.at(variation) : 1.0), value);
+    if (verbose_) clog << "Filled histogram " << definition.name << " with value=" << value << ", weight=" << weight * variationProducts_.at(0) << endl;
 
   }
 
@@ -385,12 +523,7 @@ void Plotter::fill1DHistogram(const HistoDef &definition){
 ////////////////////////////////////////////////////////////////////////
 
 // fill TH2 using one collection
-void Plotter::fill2DHistogram(const HistoDef &definition){
-
-  double weight = 1.0;
-  for (vector<Weight>::iterator sf = weights.begin (); sf != weights.end (); sf++)
-    weight *= sf->product;
-
+void Plotter::fill2DHistogram(HistoDef &definition){
 
   // if there's a single input collection used on both axes
   // and no specific object is chosen from that collection,
@@ -409,7 +542,7 @@ void Plotter::fill2DHistogram(const HistoDef &definition){
       double valueX = boost::get<double> (*leafX),
         valueY = boost::get<double> (*leafY);
 
-      fill2DHistogram(definition, valueX, valueY, weight);
+      fill2DHistogram(definition, valueX, valueY);
     }
 
   } else {
@@ -425,7 +558,7 @@ void Plotter::fill2DHistogram(const HistoDef &definition){
         if (!IS_INVALID(definition.indexY) && leafY - definition.valueLookupTrees.at(1)->evaluate().begin() != definition.indexY)
           continue;
 
-        fill2DHistogram(definition, valueX, valueY, weight);
+        fill2DHistogram(definition, valueX, valueY);
       }
     }
   }
@@ -434,37 +567,32 @@ void Plotter::fill2DHistogram(const HistoDef &definition){
 
 ////////////////////////////////////////////////////////////////////////
 
-void Plotter::fill2DHistogram(const HistoDef & definition, double valueX, double valueY, double weight) {
+void Plotter::fill2DHistogram(HistoDef & definition, double valueX, double valueY) {
 
-  TH2D *histogram = fs_->getObject<TH2D>(definition.name, definition.directory);
-  if (!histogram) {
-    clog << "ERROR [Plotter::fill2DHistogram]:  Could not find histogram with name " << definition.name
-         << " in directory " << definition.directory << endl;
-    return;
-  }
+  vector<HistogramFillBuffer> &histograms = definition.histograms;
+
+  double weight = 1.0;
   if(IS_INVALID(valueX) || IS_INVALID(valueY))
     return;
   if(definition.hasVariableBinsX){
-    weight /= getBinSize(histogram,valueX,valueY).first;
+    weight /= getBinSize((TH2D *) histograms.at(0).histogram(),valueX,valueY).first;
   }
   if(definition.hasVariableBinsY){
-    weight /= getBinSize(histogram,valueX,valueY).second;
+    weight /= getBinSize((TH2D *) histograms.at(0).histogram(),valueX,valueY).second;
   }
   if (handles_.generatorweights.isValid ())
     weight *= anatools::getGeneratorWeight (*handles_.generatorweights);
-  histogram->Fill(valueX, valueY, (definition.weight ? weight : 1.0));
-  if (verbose_) clog << "Filled histogram " << definition.name << " with valueX=" << valueX << ", valueY=" << valueY << ", weight=" << weight << endl;
+  int bin = histograms.at(0).findBin(valueX, valueY);
+  for(unsigned variation = 0; variation != histograms.size(); variation++)
+    histograms.at(variation).fill(bin, (definition.weight ? weight * variationProducts_.at(variation) : 1.0), valueX, valueY);
+  if (verbose_) clog << "Filled histogram " << definition.name << " with valueX=" << valueX << ", valueY=" << valueY << ", weight=" << weight * variationProducts_.at(0) << endl;
 
 }
 
 ////////////////////////////////////////////////////////////////////////
 
 // fill TH3 using one collection
-void Plotter::fill3DHistogram(const HistoDef &definition){
-
-  double weight = 1.0;
-  for (vector<Weight>::iterator sf = weights.begin (); sf != weights.end (); sf++)
-    weight *= sf->product;
+void Plotter::fill3DHistogram(HistoDef &definition){
 
   // if there's a single input collection used on all axes
   // and no specific object is chosen from that collection,
@@ -486,7 +614,7 @@ void Plotter::fill3DHistogram(const HistoDef &definition){
       double valueX = boost::get<double> (*leafX),
         valueY = boost::get<double> (*leafY),
         valueZ = boost::get<double> (*leafZ);
-      fill3DHistogram(definition, valueX, valueY, valueZ, weight);
+      fill3DHistogram(definition, valueX, valueY, valueZ);
     }
 
   } else {
@@ -506,7 +634,7 @@ void Plotter::fill3DHistogram(const HistoDef &definition){
           if (!IS_INVALID(definition.indexZ) && leafZ - definition.valueLookupTrees.at(2)->evaluate().begin() != definition.indexZ)
             continue;
 
-          fill3DHistogram(definition, valueX, valueY, valueZ, weight);
+          fill3DHistogram(definition, valueX, valueY, valueZ);
         }
       }
     }
@@ -516,29 +644,28 @@ void Plotter::fill3DHistogram(const HistoDef &definition){
 
 ////////////////////////////////////////////////////////////////////////
 
-void Plotter::fill3DHistogram(const HistoDef & definition, double valueX, double valueY, double valueZ, double weight) {
+void Plotter::fill3DHistogram(HistoDef & definition, double valueX, double valueY, double valueZ) {
 
-  TH3D *histogram = fs_->getObject<TH3D>(definition.name, definition.directory);
-  if (!histogram) {
-    clog << "ERROR [Plotter::fill2DHistogram]:  Could not find histogram with name " << definition.name
-         << " in directory " << definition.directory << endl;
-    return;
-  }
+  vector<HistogramFillBuffer> &histograms = definition.histograms;
+
+  double weight = 1.0;
   if(IS_INVALID(valueX) || IS_INVALID(valueY) || IS_INVALID(valueZ))
     return;
   if(definition.hasVariableBinsX){
-    weight /= get<0> (getBinSize(histogram,valueX,valueY,valueZ));
+    weight /= get<0> (getBinSize((TH3D *) histograms.at(0).histogram(),valueX,valueY,valueZ));
   }
   if(definition.hasVariableBinsY){
-    weight /= get<1> (getBinSize(histogram,valueX,valueY,valueZ));
+    weight /= get<1> (getBinSize((TH3D *) histograms.at(0).histogram(),valueX,valueY,valueZ));
   }
   if(definition.hasVariableBinsZ){
-    weight /= get<2> (getBinSize(histogram,valueX,valueY,valueZ));
+    weight /= get<2> (getBinSize((TH3D *) histograms.at(0).histogram(),valueX,valueY,valueZ));
   }
   if (handles_.generatorweights.isValid ())
     weight *= anatools::getGeneratorWeight (*handles_.generatorweights);
-  histogram->Fill(valueX, valueY, valueZ, (definition.weight ? weight : 1.0));
-  if (verbose_) clog << "Filled histogram " << definition.name << " with valueX=" << valueX << ", valueY=" << valueY << ", valueZ=" << valueZ << ", weight=" << weight << endl;
+  int bin = histograms.at(0).findBin(valueX, valueY, valueZ);
+  for(unsigned variation = 0; variation != histograms.size(); variation++)
+    histograms.at(variation).fill(bin, (definition.weight ? weight * variationProducts_.at(variation) : 1.0), valueX, valueY, valueZ);
+  if (verbose_) clog << "Filled histogram " << definition.name << " with valueX=" << valueX << ", valueY=" << valueY << ", valueZ=" << valueZ << ", weight=" << weight * variationProducts_.at(0) << endl;
 
 }
 
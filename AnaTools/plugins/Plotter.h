@@ -1,12 +1,14 @@
 #ifndef PLOTTER
 #define PLOTTER
 
+#include <memory>
+#include <mutex>
 #include <tuple>
 #include <unordered_set>
 
-#include "FWCore/Framework/interface/EDAnalyzer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/stream/EDAnalyzer.h"
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
 #include "FWCore/ServiceRegistry/interface/Service.h"
 #include "CommonTools/UtilAlgos/interface/TFileService.h"
@@ -17,13 +19,29 @@
 #include "TH2.h"
 #include "TH3.h"
 
-class Plotter : public edm::EDAnalyzer
+// The histograms booked with the TFileService, once for the whole job, with
+// one vector for each histogram definition holding the copy for each weight
+// variation, or no copies if the definition is invalid.
+struct PlotterHistograms
+{
+  vector<vector<TH1 *> > histograms;
+  mutable mutex merging;
+};
+
+// There is one instance of the Plotter per stream, each filling its own copies
+// of the histograms, which are not attached to any directory. At the end of
+// the job, each stream adds its copies to the histograms booked with the
+// TFileService, which then writes them.
+class Plotter : public edm::stream::EDAnalyzer<edm::GlobalCache<PlotterHistograms> >
 {
     public:
 
-      Plotter (const edm::ParameterSet &);
+      Plotter (const edm::ParameterSet &, const PlotterHistograms *);
       ~Plotter ();
-      void analyze(const edm::Event&, const edm::EventSetup&);
+      static unique_ptr<PlotterHistograms> initializeGlobalCache (const edm::ParameterSet &);
+      void analyze(const edm::Event&, const edm::EventSetup&) override;
+      void endStream() override;
+      static void globalEndJob (const PlotterHistograms *);
 
     private:
 
@@ -40,31 +58,42 @@ class Plotter : public edm::EDAnalyzer
       bool initializeValueLookupForest (vector<HistoDef> &, Collections * const);
       bool initializeValueLookupForest (vector<Weight> &, Collections * const);
 
-      edm::Service<TFileService> fs_;
-
       unordered_set<string> objectsToGet_;
 
-      vector<TFileDirectory> subDirs;
-
       vector<HistoDef> histogramDefinitions;
 
+      // every distinct weight used by any of the variations, each evaluated
+      // once per event
       vector<Weight> weights;
 
-      string getDirectoryName(const string);
-      HistoDef parseHistoDef(const edm::ParameterSet &, const vector<string> &, const string &, const string &);
-      void bookHistogram(const HistoDef &);
-
-      void fillHistogram(const HistoDef &);
-      void fill1DHistogram(const HistoDef &);
-      void fill2DHistogram(const HistoDef &);
-      void fill2DHistogram(const HistoDef & definition, double valueX, double valueY, double weight);
-      void fill3DHistogram(const HistoDef &);
-      void fill3DHistogram(const HistoDef & definition, double valueX, double valueY, double valueZ, double weight);
+      // Each weight variation has its own copy of every histogram, filled
+      // with the same values but with the product of its own weights. The
+      // first variation is the nominal one, with its histograms in the
+      // top-level directory of the module, and the others each have a
+      // subdirectory named after them.
+      vector<string> variationNames_;
+      vector<vector<unsigned> > variationWeights_;
+      vector<double> variationProducts_;
+
+      void addWeights(const vector<edm::ParameterSet> &);
+      static vector<string> getVariationNames(const edm::ParameterSet &);
+      static vector<HistoDef> parseHistogramSets(const vector<edm::ParameterSet> &, unordered_set<string> &);
+      static string getDirectoryName(const string);
+      static HistoDef parseHistoDef(const edm::ParameterSet &, const vector<string> &, const string &, const string &);
+      static vector<TH1 *> bookHistogram(const HistoDef &, const vector<string> &);
+      static TH1 *makeHistogram(const HistoDef &, TFileDirectory &);
+
+      void fillHistogram(HistoDef &);
+      void fill1DHistogram(HistoDef &);
+      void fill2DHistogram(HistoDef &);
+      void fill2DHistogram(HistoDef & definition, double valueX, double valueY);
+      void fill3DHistogram(HistoDef &);
+      void fill3DHistogram(HistoDef & definition, double valueX, double valueY, double valueZ);
 
       double getBinSize(TH1D * const, const double);
       pair<double,double> getBinSize(TH2D * const, const double, const double);
       tuple<double,double,double>  getBinSize(TH3D * const, const double, const double, const double);
-      string setYaxisLabel(const HistoDef &);
+      static string setYaxisLabel(const HistoDef &);
 
 
 
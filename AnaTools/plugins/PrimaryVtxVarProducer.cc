@@ -3,7 +3,11 @@
 #include "DataFormats/VertexReco/interface/Vertex.h"
 
 PrimaryVtxVarProducer::PrimaryVtxVarProducer(const edm::ParameterSet &cfg) :
-  EventVariableProducer(cfg)
+  EventVariableProducer(cfg),
+  numPVReco_   (declareVariable ("numPVReco")),
+  leadingPV_x_ (declareVariable ("leadingPV_x")),
+  leadingPV_y_ (declareVariable ("leadingPV_y")),
+  leadingPV_z_ (declareVariable ("leadingPV_z"))
 {
   token_ = consumes<vector<TYPE(primaryvertexs)> > (collections_.getParameter<edm::InputTag> ("primaryvertexs"));
 }
@@ -25,10 +29,10 @@ PrimaryVtxVarProducer::AddVariables (const edm::Event &event, const edm::EventSe
   double leadingPV_y = pv.y();
   double leadingPV_z = pv.z();
 
-  (*eventvariables)["numPVReco"]       = numPVReco;
-  (*eventvariables)["leadingPV_x"]     = leadingPV_x;
-  (*eventvariables)["leadingPV_y"]     = leadingPV_y;
-  (*eventvariables)["leadingPV_z"]     = leadingPV_z;
+  eventvariables->set (numPVReco_,   numPVReco);
+  eventvariables->set (leadingPV_x_, leadingPV_x);
+  eventvariables->set (leadingPV_y_, leadingPV_y);
+  eventvariables->set (leadingPV_z_, leadingPV_z);
 
 }
 
@@ -16,6 +16,11 @@ class PrimaryVtxVarProducer : public EventVariableProducer
     private:
         void AddVariables(const edm::Event &, const edm::EventSetup &);
         edm::EDGetTokenT<vector<TYPE(primaryvertexs)> > token_;
+
+        unsigned numPVReco_;
+        unsigned leadingPV_x_;
+        unsigned leadingPV_y_;
+        unsigned leadingPV_z_;
   };
 
 #endif
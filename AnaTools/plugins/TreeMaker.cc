@@ -33,6 +33,8 @@ TreeMaker::TreeMaker(const edm::ParameterSet &cfg) :
 {
   if(verbose_) clog << "Beginning TreeMaker::TreeMaker constructor." << endl;
 
+  usesResource (TFileService::kSharedResource);
+
   //////////////////////////////////
   // parse the branch definitions //
   //////////////////////////////////
@@ -4,9 +4,9 @@
 #include <tuple>
 #include <unordered_set>
 
-#include "FWCore/Framework/interface/EDAnalyzer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/one/EDAnalyzer.h"
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
 #include "FWCore/ServiceRegistry/interface/Service.h"
 #include "CommonTools/UtilAlgos/interface/TFileService.h"
@@ -15,13 +15,13 @@
 
 #include "TTree.h"
 
-class TreeMaker : public edm::EDAnalyzer
+class TreeMaker : public edm::one::EDAnalyzer<edm::one::SharedResources>
 {
     public:
 
       TreeMaker (const edm::ParameterSet &);
       ~TreeMaker ();
-      void analyze(const edm::Event&, const edm::EventSetup&);
+      void analyze(const edm::Event&, const edm::EventSetup&) override;
 
     private:
 
@@ -0,0 +1,153 @@
+#include <algorithm>
+
+#include "OSUT3Analysis/AnaTools/interface/BinnedLookup.h"
+
+BinnedAxis::BinnedAxis () :
+  nBins_       (0),
+  xMin_        (0.0),
+  xMax_        (0.0),
+  fixedWidth_  (true)
+{
+}
+
+BinnedAxis::BinnedAxis (const TAxis &axis) :
+  nBins_       (axis.GetNbins ()),
+  xMin_        (axis.GetXmin ()),
+  xMax_        (axis.GetXmax ()),
+  fixedWidth_  (!axis.GetXbins ()->GetSize ())
+{
+  for (int bin = 1; bin <= nBins_ + 1; bin++)
+    edges_.push_back (axis.GetBinLowEdge (bin));
+}
+
+double
+BinnedAxis::lowEdge (const int bin) const
+{
+  return edges_.at (bin - 1);
+}
+
+double
+BinnedAxis::upEdge (const int bin) const
+{
+  return edges_.at (bin);
+}
+
+double
+BinnedAxis::center (const int bin) const
+{
+  // same arithmetic as TAxis::GetBinCenter ()
+  if (fixedWidth_)
+    {
+      double width = (xMax_ - xMin_) / nBins_;
+      return xMin_ + (bin - 1) * width + 0.5 * width;
+    }
+  return edges_.at (bin - 1) + 0.5 * (edges_.at (bin) - edges_.at (bin - 1));
+}
+
+BinnedLookup1D::BinnedLookup1D ()
+{
+}
+
+BinnedLookup1D::BinnedLookup1D (const TH1 &h) :
+  axis_ (*h.GetXaxis ())
+{
+  for (int bin = 0; bin <= axis_.nBins () + 1; bin++)
+    {
+      contents_.push_back (h.GetBinContent (bin));
+      errors_.push_back (h.GetBinError (bin));
+    }
+}
+
+bool
+BinnedLookup1D::empty () const
+{
+  return contents_.empty ();
+}
+
+const BinnedAxis &
+BinnedLookup1D::axis () const
+{
+  return axis_;
+}
+
+BinnedLookup2D::BinnedLookup2D ()
+{
+}
+
+BinnedLookup2D::BinnedLookup2D (const TH1 &h) :
+  xAxis_ (*h.GetXaxis ()),
+  yAxis_ (*h.GetYaxis ())
+{
+  int nBins = (xAxis_.nBins () + 2) * (yAxis_.nBins () + 2);
+  contents_.reserve (nBins);
+  errors_.reserve (nBins);
+  for (int bin = 0; bin < nBins; bin++)
+    {
+      contents_.push_back (h.GetBinContent (bin));
+      errors_.push_back (h.GetBinError (bin));
+    }
+}
+
+bool
+BinnedLookup2D::empty () const
+{
+  return contents_.empty ();
+}
+
+const BinnedAxis &
+BinnedLookup2D::xAxis () const
+{
+  return xAxis_;
+}
+
+const BinnedAxis &
+BinnedLookup2D::yAxis () const
+{
+  return yAxis_;
+}
+
+BinnedGraph::BinnedGraph () :
+  ordered_ (true)
+{
+}
+
+BinnedGraph::BinnedGraph (const TGraphAsymmErrors &graph) :
+  ordered_ (true)
+{
+  for (int i = 0; i < graph.GetN (); i++)
+    {
+      low_.push_back (graph.GetX ()[i] - graph.GetErrorXlow (i));
+      high_.push_back (graph.GetX ()[i] + graph.GetErrorXhigh (i));
+      contents_.push_back (graph.GetY ()[i]);
+      errorsHigh_.push_back (graph.GetErrorYhigh (i));
+      if (i > 0 && (low_.at (i) < high_.at (i - 1) || high_.at (i) < high_.at (i - 1)))
+        ordered_ = false;
+    }
+}
+
+bool
+BinnedGraph::empty () const
+{
+  return contents_.empty ();
+}
+
+unsigned
+BinnedGraph::findPoint (const double x) const
+{
+  unsigned point = 0;
+  if (ordered_)
+    {
+      // the first point whose interval ends above x is the only candidate
+      point = upper_bound (high_.begin (), high_.end (), x) - high_.begin ();
+      if (point < high_.size () && !(x > low_.at (point)))
+        point = high_.size ();
+    }
+  else
+    while (point < high_.size () && !(x < high_.at (point) && x > low_.at (point)))
+      point++;
+
+  // if x is past the highest point, just use the highest point with a value
+  if (point == high_.size ())
+    point = high_.size () - 1;
+  return point;
+}
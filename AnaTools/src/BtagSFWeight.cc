@@ -7,29 +7,9 @@ bool BtagSFWeight::filter(int t, int minTags)
 
 
 
-double BtagSFWeight::weight(vector<double> jets, int minTags)
+double BtagSFWeight::weight(const vector<double> &jets, int minTags)
 {
-  int njets=jets.size();
-  int comb= 1 << njets;
-  float pMC=0;
-  for(int i=0;i < comb; i++){
-    float mc=1.;
-    int ntagged=0;
-    for(int j=0;j<njets;j++){
-      bool tagged = ((i >> j) & 0x1) == 1;
-      if(tagged){
-        ntagged++;
-        mc*=jets[j];
-      }
-      else{
-        mc*=(1.-jets[j]);
-      }
-    }
-
-    if(filter(ntagged, minTags)){
-      pMC+=mc;
-    }
-  }
+  double pMC = atLeast(tagCountDistribution(jets), minTags);
   if( pMC > 0)
       return pMC;
   else{
@@ -38,6 +18,34 @@ double BtagSFWeight::weight(vector<double> jets, int minTags)
      }
 }
 
+vector<double> BtagSFWeight::tagCountDistribution(const vector<double> &jets) const
+{
+  // Adds the jets one at a time: after j jets, distribution[k] is the
+  // probability of k of the first j jets being tagged. Going down in k lets
+  // each entry be updated in place from the entries below it.
+  vector<double> distribution(jets.size() + 1, 0.);
+  distribution[0] = 1.;
+  for(unsigned j = 0; j < jets.size(); j++){
+    for(unsigned k = j + 1; k > 0; k--)
+      distribution[k] = distribution[k] * (1. - jets[j]) + distribution[k - 1] * jets[j];
+    distribution[0] *= (1. - jets[j]);
+  }
+  return distribution;
+}
+
+double BtagSFWeight::atLeast(const vector<double> &distribution, int minTags) const
+{
+  double p = 0.;
+  for(int k = max(minTags, 0); k < (int) distribution.size(); k++)
+    p += distribution[k];
+  return p;
+}
+
+double BtagSFWeight::exactly(const vector<double> &distribution, int nTags) const
+{
+  return (nTags >= 0 && nTags < (int) distribution.size() ? distribution[nTags] : 0.);
+}
+
 double BtagSFWeight::sflookup(double jetCSV, double pt, double flavor, double jetEta)
 {
     double jetSF = 1;
@@ -1,4 +1,9 @@
+#include <atomic>
+
+#include "FWCore/Framework/interface/Run.h"
+
 #include "OSUT3Analysis/AnaTools/interface/CommonUtils.h"
+#include "OSUT3Analysis/AnaTools/interface/ValueLookupCache.h"
 
 /**
  * Splits the concatenated object label into a vector of individual labels.
@@ -189,7 +194,15 @@ anatools::collectionIndexAscending (pair<string, DressedObject> a, pair<string,
 void
 anatools::getRequiredCollections (const unordered_set<string> &objectsToGet, Collections &handles, const edm::Event &event, const Tokens &tokens)
 {
-  static bool firstEvent = true;
+  //////////////////////////////////////////////////////////////////////////////
+  // The missing collections are only reported once per job, by whichever
+  // module on whichever stream gets here first.
+  //////////////////////////////////////////////////////////////////////////////
+  static atomic<bool> firstEvent (true);
+  //////////////////////////////////////////////////////////////////////////////
+
+  // Values cached by ValueLookupTree objects are only valid within one event.
+  handles.cache.beginEvent ();
 
   //////////////////////////////////////////////////////////////////////////////
   // Retrieve each object collection which we need and print a warning if it is
@@ -234,14 +247,23 @@ anatools::getRequiredCollections (const unordered_set<string> &objectsToGet, Col
   if  (VEC_CONTAINS  (objectsToGet,  "eventvariables"))
     {
       handles.eventvariables.clear ();
-      for (const auto &token : tokens.eventvariables)
+      handles.eventvariableNames.clear ();
+      handles.legacyEventvariables.clear ();
+      for (unsigned i = 0; i < tokens.eventvariables.size (); i++)
         {
           handles.eventvariables.resize (handles.eventvariables.size () + 1);
-          event.getByToken (token, handles.eventvariables.back ());
+          handles.eventvariableNames.resize (handles.eventvariableNames.size () + 1);
+          handles.legacyEventvariables.resize (handles.legacyEventvariables.size () + 1);
+          if (!event.getByToken (tokens.eventvariables.at (i), handles.eventvariables.back ()))
+            event.getByToken (tokens.legacyEventvariables.at (i), handles.legacyEventvariables.back ());
+          else if (!handles.eventvariables.back ()->schema ())
+            event.getRun ().getByToken (tokens.eventvariableNames.at (i), handles.eventvariableNames.back ());
         }
     }
+  if  (VEC_CONTAINS  (objectsToGet,  "uservariables") || VEC_CONTAINS  (objectsToGet,  "eventvariables"))
+    handles.variables.build (handles.uservariables, handles.eventvariables, handles.eventvariableNames, handles.legacyEventvariables);
 
-  if (firstEvent)
+  if (firstEvent.exchange (false))
     {
       stringstream ss;
       ss << "Will print any collections not retrieved. These INFO messages may be safely ignored.";
@@ -302,8 +324,6 @@ anatools::getRequiredCollections (const unordered_set<string> &objectsToGet, Col
       edm::LogInfo ("CommonUtils") << ss.str ();
     }
   //////////////////////////////////////////////////////////////////////////////
-
-  firstEvent = false;
 }
 
 #ifdef ROOT6
@@ -572,6 +592,270 @@ anatools::getRequiredCollections (const unordered_set<string> &objectsToGet, Col
     return value;
   }
 
+  anatools::MemberAccessor::MemberAccessor () :
+    resolved_ (false),
+    bound_ (false),
+    direct_ (false),
+    valueType_ (DOUBLE)
+  {
+  }
+
+/**
+ * Resolves a member of a type into a chain of steps which can be applied to
+ * any object of that type.
+ *
+ * @param  type string giving the type of the objects
+ * @param  member string giving the member, data or function, to evaluate
+ * @return true if the member could be resolved to a recognized type
+ */
+  bool
+  anatools::MemberAccessor::bind (const string &type, const string &member)
+  {
+    type_ = type;
+    member_ = member;
+    resolved_ = true;
+    bound_ = false;
+    direct_ = false;
+    steps_.clear ();
+
+    anatools::TypeWithDict memberType;
+    try
+      {
+        if (!resolve (anatools::TypeWithDict::byName (type), member, memberType))
+          {
+            steps_.clear ();
+            return false;
+          }
+      }
+    catch (...)
+      {
+        steps_.clear ();
+        return false;
+      }
+
+    string memberTypeName = memberType.name ();
+    if (memberTypeName == "float")
+      valueType_ = FLOAT;
+    else if (memberTypeName == "double")
+      valueType_ = DOUBLE;
+    else if (memberTypeName == "long double")
+      valueType_ = LONG_DOUBLE;
+    else if (memberTypeName == "char")
+      valueType_ = CHAR;
+    else if (memberTypeName == "int")
+      valueType_ = INT;
+    else if (memberTypeName == "unsigned" || memberTypeName == "unsigned int")
+      valueType_ = UNSIGNED;
+    else if (memberTypeName == "unsigned short" || memberTypeName == "unsigned short int")
+      valueType_ = UNSIGNED_SHORT;
+    else if (memberTypeName == "unsigned long" || memberTypeName == "unsigned long int")
+      valueType_ = UNSIGNED_LONG;
+    else if (memberTypeName == "bool")
+      valueType_ = BOOL;
+    else if (memberTypeName == "signed char")
+      valueType_ = SIGNED_CHAR;
+    else if (memberTypeName == "unsigned char")
+      valueType_ = UNSIGNED_CHAR;
+    else
+      {
+        steps_.clear ();
+        return false;
+      }
+
+    bound_ = true;
+    direct_ = true;
+    for (const auto &step : steps_)
+      direct_ = direct_ && (step.type == OFFSET || step.type == DEREFERENCE);
+    return true;
+  }
+
+  bool
+  anatools::MemberAccessor::isResolved () const
+  {
+    return resolved_;
+  }
+
+  bool
+  anatools::MemberAccessor::isBound () const
+  {
+    return bound_;
+  }
+
+  bool
+  anatools::MemberAccessor::isDirect () const
+  {
+    return direct_;
+  }
+
+/**
+ * Returns the value of the bound member of an object.
+ *
+ * @param  obj void pointer to the object
+ * @return value of the member of the given object, or INVALID_VALUE if a null
+ *         pointer or reference is encountered along the way
+ */
+  double
+  anatools::MemberAccessor::value (void *obj)
+  {
+    double value = INVALID_VALUE;
+    void *address = obj;
+    unsigned nSteps = 0;
+    bool isValid = true;
+
+    for (auto &step : steps_)
+      {
+        nSteps++;
+        switch (step.type)
+          {
+            case OFFSET:
+              address = (void *) ((char *) address + step.offset);
+              break;
+            case DEREFERENCE:
+              address = *((void **) address);
+              isValid = (address != NULL);
+              break;
+            case NONNULL:
+              {
+                bool isNonnull = false;
+                (*step.function) (address, 0, NULL, &isNonnull);
+                isValid = isNonnull;
+                break;
+              }
+            case INVOKE:
+              (*step.function) (address, 0, NULL, step.buffer.data ());
+              address = step.buffer.data ();
+              break;
+          }
+        if (!isValid)
+          break;
+      }
+
+    if (isValid)
+      {
+        switch (valueType_)
+          {
+            case FLOAT:           value = *((float *) address);           break;
+            case DOUBLE:          value = *((double *) address);          break;
+            case LONG_DOUBLE:     value = *((long double *) address);     break;
+            case CHAR:            value = *((char *) address);            break;
+            case INT:             value = *((int *) address);             break;
+            case UNSIGNED:        value = *((unsigned *) address);        break;
+            case UNSIGNED_SHORT:  value = *((unsigned short *) address);  break;
+            case UNSIGNED_LONG:   value = *((unsigned long *) address);   break;
+            case BOOL:            value = *((bool *) address);            break;
+            case SIGNED_CHAR:     value = *((signed char *) address);     break;
+            case UNSIGNED_CHAR:   value = *((unsigned char *) address);   break;
+          }
+      }
+    else
+      edm::LogInfo ("CommonUtils") << "Unable to access member \"" << member_ << "\" from \"" << type_ << "\".";
+
+    // Objects which were returned by value are destroyed in the reverse order
+    // of their construction, leaving the buffers to be reused.
+    for (int i = nSteps - 1; i >= 0; i--)
+      {
+        Step &step = steps_.at (i);
+        if (step.type == INVOKE && step.destruct)
+          step.returnType.destruct (step.buffer.data (), false);
+      }
+
+    return value;
+  }
+
+/**
+ * Appends the steps needed to reach a member of a type, following the same
+ * rules as the recursive getMember function above.
+ *
+ * @param  t type of the object
+ * @param  member string giving the member, data or function, to evaluate
+ * @param  memberType receives the type of the member
+ * @return true if the member was found
+ */
+  bool
+  anatools::MemberAccessor::resolve (const anatools::TypeWithDict &t, const string &member, anatools::TypeWithDict &memberType)
+  {
+    string typeName = t.name ();
+    size_t dot = member.find ('.'),
+           asterisk = typeName.rfind ('*'),
+           nSteps = steps_.size ();
+
+    if (t.isReference ())
+      return false;
+    if (t.isPointer ())
+      {
+        anatools::TypeWithDict derefType = anatools::TypeWithDict::byName (typeName.substr (0, asterisk) + typeName.substr (asterisk + 1));
+        steps_.push_back ({DEREFERENCE, 0, NULL, anatools::TypeWithDict (), false, {}});
+        if (resolve (derefType, member, memberType))
+          return true;
+        steps_.resize (nSteps);
+        return false;
+      }
+    if (typeName.find ("edm::Ref") == 0 && member == "operator->")
+      {
+        anatools::FunctionWithDict isNonnull = t.functionMemberByName ("isNonnull");
+        if (!isNonnull)
+          return false;
+        steps_.push_back ({NONNULL, 0, isNonnull.address (), anatools::TypeWithDict (), false, {}});
+      }
+    if (dot != string::npos)
+      {
+        anatools::TypeWithDict subType;
+        if (!resolve (t, member.substr (0, dot), subType))
+          return false;
+        size_t nSubSteps = steps_.size ();
+        if (resolve (subType, member.substr (dot + 1), memberType))
+          return true;
+        steps_.resize (nSubSteps);
+
+        string subMember = (member.substr (0, dot) == "operator->" ? "" : "operator->.") + member.substr (dot + 1);
+        if (resolve (subType, subMember, memberType))
+          return true;
+        steps_.resize (nSteps);
+        return false;
+      }
+
+    anatools::MemberWithDict dataMember = t.dataMemberByName (member);
+    anatools::FunctionWithDict functionMember = t.functionMemberByName (member);
+    if (dataMember)
+      {
+        memberType = dataMember.typeOf ();
+        if (memberType.isReference () || memberType.isArray ())
+          {
+            steps_.resize (nSteps);
+            return false;
+          }
+        steps_.push_back ({OFFSET, (long) dataMember.offset (), NULL, anatools::TypeWithDict (), false, {}});
+        return true;
+      }
+    else if (functionMember)
+      {
+        memberType = functionMember.finalReturnType ();
+        if (memberType.isReference ())
+          {
+            steps_.resize (nSteps);
+            return false;
+          }
+        size_t size = (memberType.isPointer () ? sizeof (void *) : memberType.size ());
+        steps_.push_back ({INVOKE, 0, functionMember.address (), memberType, memberType.isClass (), vector<max_align_t> (size / sizeof (max_align_t) + 1)});
+        return true;
+      }
+    else
+      {
+        anatools::TypeBases bases (t);
+        for (auto bi = bases.begin (); bi != bases.end (); ++bi)
+          {
+            anatools::BaseWithDict base (*bi);
+            steps_.push_back ({OFFSET, t.getBaseClassOffset (base.typeOf ()), NULL, anatools::TypeWithDict (), false, {}});
+            if (resolve (base.typeOf (), member, memberType))
+              return true;
+            steps_.resize (nSteps);
+          }
+      }
+
+    steps_.resize (nSteps);
+    return false;
+  }
+
 #else
   #include "Reflex/Base.h"
   #include "Reflex/Member.h"
@@ -750,6 +1034,49 @@ anatools::getRequiredCollections (const unordered_set<string> &objectsToGet, Col
     o.Invoke (member, value);
     return value;
   }
+
+  // Members are not resolved ahead of time with Reflex, so bind() always fails
+  // and getMember() is used instead.
+  anatools::MemberAccessor::MemberAccessor () :
+    resolved_ (false),
+    bound_ (false),
+    direct_ (false),
+    valueType_ (DOUBLE)
+  {
+  }
+
+  bool
+  anatools::MemberAccessor::bind (const string &type, const string &member)
+  {
+    type_ = type;
+    member_ = member;
+    resolved_ = true;
+    return false;
+  }
+
+  bool
+  anatools::MemberAccessor::isResolved () const
+  {
+    return resolved_;
+  }
+
+  bool
+  anatools::MemberAccessor::isBound () const
+  {
+    return bound_;
+  }
+
+  bool
+  anatools::MemberAccessor::isDirect () const
+  {
+    return direct_;
+  }
+
+  double
+  anatools::MemberAccessor::value (void *obj)
+  {
+    return getMember (type_, obj, member_);
+  }
 #endif
 
 #if IS_VALID(beamspots)
@@ -946,8 +1273,14 @@ anatools::getAllTokens (const edm::ParameterSet &collections, edm::ConsumesColle
   if (collections.exists ("eventvariables"))
     {
       tokens.eventvariables.clear ();
+      tokens.eventvariableNames.clear ();
+      tokens.legacyEventvariables.clear ();
       for (const auto &collection : collections.getParameter<vector<edm::InputTag> > ("eventvariables"))
-        tokens.eventvariables.push_back (cc.consumes<osu::Eventvariable> (collection));
+        {
+          tokens.eventvariables.push_back (cc.consumes<osu::Eventvariable> (collection));
+          tokens.eventvariableNames.push_back (cc.consumes<vector<string>, edm::InRun> (collection));
+          tokens.legacyEventvariables.push_back (cc.consumes<map<string, double> > (collection));
+        }
     }
 }
 
@@ -960,30 +1293,12 @@ anatools::getTriggerObjects (const edm::Event &event, const edm::TriggerResults
       selectedTrigObjs.push_back (NULL);
       return false;
     }
+  const TriggerObjectIndex &index = TriggerObjectIndex::get (event, triggers, trigObjs);
   vector<const pat::TriggerObjectStandAlone *> trigObjsToAdd;
-  int i = -1;
-  for (auto trigObj : trigObjs)
+  for (const auto &i : index.inCollection (collection))
     {
-      i++;
-#if CMSSW_VERSION_CODE >= CMSSW_VERSION(9,2,0)
-      trigObj.unpackNamesAndLabels(event, triggers);
-#else
-      trigObj.unpackPathNames(event.triggerNames(triggers));
-#endif
-      if (trigObj.collection () != collection)
+      if (filter != "" && !index.hasFilter (i, filter))
         continue;
-      if (filter != "")
-        {
-          bool flag = false;
-          for (const auto &filterLabel : trigObj.filterLabels ())
-            if (filterLabel == filter)
-              {
-                flag = true;
-                break;
-              }
-          if (!flag)
-            continue;
-        }
 
       trigObjsToAdd.push_back (&trigObjs.at (i));
     }
@@ -1002,20 +1317,12 @@ anatools::getTriggerObjectsByFilterSubstring (const edm::Event &event, const edm
     return false;
   }
 
+  const TriggerObjectIndex &index = TriggerObjectIndex::get(event, triggers, trigObjs);
   vector<const pat::TriggerObjectStandAlone*> trigObjsToAdd;
-  int i = -1;
-
-  for(auto trigObj : trigObjs) {
-    i++;
-
-#if CMSSW_VERSION_CODE >= CMSSW_VERSION(9,2,0)
-    trigObj.unpackNamesAndLabels(event, triggers);
-#else
-    trigObj.unpackPathNames(event.triggerNames(triggers));
-#endif
 
-    // Require the collection names to match
-    if(trigObj.collection() != collectionName) continue;
+  // Require the collection names to match
+  for(const auto &i : index.inCollection(collectionName)) {
+    const pat::TriggerObjectStandAlone &trigObj = index.at(i);
 
     bool isSelected = false;
 
@@ -1041,7 +1348,7 @@ anatools::getTriggerObjectsByFilterSubstring (const edm::Event &event, const edm
     }
 
     if(isSelected) trigObjsToAdd.push_back(&trigObjs.at(i));
-  } // for trigObj : trigObjs
+  } // for i : index.inCollection(collectionName)
 
   if(!trigObjsToAdd.empty()) selectedTrigObjs.insert(selectedTrigObjs.end(), trigObjsToAdd.begin(), trigObjsToAdd.end());
   else selectedTrigObjs.push_back(NULL);
@@ -1054,43 +1361,20 @@ anatools::triggerObjectExists (const edm::Event &event, const edm::TriggerResult
 {
   if (collection == "")
     return false;
-  for (auto trigObj : trigObjs)
-    {
-#if CMSSW_VERSION_CODE >= CMSSW_VERSION(9,2,0)
-      trigObj.unpackNamesAndLabels(event, triggers);
-#else
-      trigObj.unpackPathNames(event.triggerNames(triggers));
-#endif
-      if (trigObj.collection () != collection)
-        continue;
-      if (filter != "")
-        {
-          bool flag = false;
-          for (const auto &filterLabel : trigObj.filterLabels ())
-            if (filterLabel == filter)
-              {
-                flag = true;
-                break;
-              }
-          if (!flag)
-            continue;
-        }
-
+  const TriggerObjectIndex &index = TriggerObjectIndex::get (event, triggers, trigObjs);
+  for (const auto &i : index.inCollection (collection))
+    if (filter == "" || index.hasFilter (i, filter))
       return true;
-    }
   return false;
 }
 
 bool
 anatools::passesL1ETM (const edm::Event &event, const edm::TriggerResults &triggers, const vector<pat::TriggerObjectStandAlone> &trigObjs, double &l1ETM)
 {
-  for (auto trigObj : trigObjs)
+  const TriggerObjectIndex &index = TriggerObjectIndex::get (event, triggers, trigObjs);
+  for (unsigned i = 0; i < trigObjs.size (); i++)
     {
-#if CMSSW_VERSION_CODE >= CMSSW_VERSION(9,2,0)
-      trigObj.unpackNamesAndLabels(event, triggers);
-#else
-      trigObj.unpackPathNames(event.triggerNames(triggers));
-#endif
+      const pat::TriggerObjectStandAlone &trigObj = index.at (i);
       if (trigObj.collection () != "hltL1extraParticles:MET:HLT"
        || trigObj.collection () != "hltCaloStage2Digis:EtSum:HLT")
         continue;
@@ -1,32 +1,60 @@
 #include "OSUT3Analysis/AnaTools/interface/EventVariableProducer.h"
 
 EventVariableProducer::EventVariableProducer(const edm::ParameterSet &cfg) :
-  collections_  (cfg.getParameter<edm::ParameterSet>  ("collections"))
+  collections_     (cfg.getParameter<edm::ParameterSet>  ("collections")),
+  schema_          (EventVariableSchema::forProducer (cfg.getParameter<string> ("@module_label"))),
+  filterDecision_  (declareVariable ("EventVariableProducerFilterDecision"))
 {
   produces<EventVariableProducerPayload> ("eventvariables");
+  produces<vector<string>, edm::InRun> ("eventvariables");
 }
 
 EventVariableProducer::~EventVariableProducer()
 {
 }
 
+shared_ptr<EventVariableProducerRunCache>
+EventVariableProducer::globalBeginRun (const edm::Run &run, const edm::EventSetup &setup, const GlobalCache *)
+{
+  return shared_ptr<EventVariableProducerRunCache> (new EventVariableProducerRunCache ());
+}
+
+void
+EventVariableProducer::globalEndRun (const edm::Run &run, const edm::EventSetup &setup, const RunContext *context)
+{
+}
+
+void
+EventVariableProducer::globalEndRunProduce (edm::Run &run, const edm::EventSetup &setup, const RunContext *context)
+{
+  // write the names of the variables of this producer once for the run, so
+  // that the payloads can be read by other jobs
+
+  const EventVariableSchema *schema = context->run ()->schema.load ();
+  unique_ptr<vector<string> > names (new vector<string> (schema ? schema->names () : vector<string> ()));
+  run.put (std::move (names), "eventvariables");
+}
+
+void
+EventVariableProducer::beginRun (const edm::Run &run, const edm::EventSetup &setup)
+{
+  runCache ()->schema.store (schema_);
+}
+
 bool
 EventVariableProducer::filter (edm::Event &event, const edm::EventSetup &setup)
 {
-  // define structure that will be put into the event
-  // string is the variable name
-  // double is the value of the variable
-  // it is a vector because  other collections are also vectors
-  // the vector will have size=1 for each event
+  // define structure that will be put into the event, with an entry for each
+  // variable of this producer declared so far
 
-  eventvariables = unique_ptr<EventVariableProducerPayload> (new EventVariableProducerPayload);
+  eventvariables = unique_ptr<EventVariableProducerPayload> (new EventVariableProducerPayload (schema_));
 
   ////////////////////////////////////////////////////////////////////////
   AddVariables(event, setup);
 
   bool filterDecision = true;
-  if (eventvariables->count ("EventVariableProducerFilterDecision"))
-    filterDecision = eventvariables->at ("EventVariableProducerFilterDecision");
+  if (eventvariables->isSet (filterDecision_))
+    filterDecision = eventvariables->get (filterDecision_);
 
   // store all of our calculated quantities in the event
   event.put (std::move (eventvariables), "eventvariables");
@@ -34,3 +62,9 @@ EventVariableProducer::filter (edm::Event &event, const edm::EventSetup &setup)
 
   return filterDecision;
 }
+
+unsigned
+EventVariableProducer::declareVariable (const string &name) const
+{
+  return schema_->declare (name);
+}
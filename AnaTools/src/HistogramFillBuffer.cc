@@ -0,0 +1,80 @@
+#include <algorithm>
+
+#include "OSUT3Analysis/AnaTools/interface/HistogramFillBuffer.h"
+
+HistogramFillBuffer::HistogramFillBuffer () :
+  histogram_  (NULL),
+  capacity_   (1)
+{
+}
+
+HistogramFillBuffer::HistogramFillBuffer (TH1 * const histogram, const unsigned capacity) :
+  histogram_  (histogram),
+  capacity_   (max (capacity, 1u))
+{
+  fills_.reserve (capacity_);
+}
+
+void
+HistogramFillBuffer::flush ()
+{
+  if (fills_.empty ())
+    return;
+
+  // the statistics are, in order, the sums of w, w^2, wx, wx^2, wy, wy^2, wxy,
+  // wz, wz^2, wxz, and wyz, as used by TH1::GetStats () and TH1::PutStats ()
+  // for histograms of up to three dimensions
+  double stats[11] = {0.0};
+  const int dimension = histogram_->GetDimension ();
+  histogram_->GetStats (stats);
+
+  TArrayD * const sumw2 = histogram_->GetSumw2 ();
+  const int nBinsX = histogram_->GetNbinsX (),
+            nBinsY = histogram_->GetNbinsY (),
+            nBinsZ = histogram_->GetNbinsZ ();
+  for (const auto &fill : fills_)
+    {
+      if (fill.bin < 0)
+        continue;
+      const double w = fill.weight, x = fill.x, y = fill.y, z = fill.z;
+
+      histogram_->AddBinContent (fill.bin, w);
+      if (sumw2->fN)
+        sumw2->fArray[fill.bin] += w * w;
+
+      int binX, binY, binZ;
+      histogram_->GetBinXYZ (fill.bin, binX, binY, binZ);
+      if (binX == 0 || binX > nBinsX)
+        continue;
+      if (dimension > 1 && (binY == 0 || binY > nBinsY))
+        continue;
+      if (dimension > 2 && (binZ == 0 || binZ > nBinsZ))
+        continue;
+
+      stats[0] += w;
+      stats[1] += w * w;
+      stats[2] += w * x;
+      stats[3] += w * x * x;
+      if (dimension > 1)
+        {
+          stats[4] += w * y;
+          stats[5] += w * y * y;
+          stats[6] += w * x * y;
+        }
+      if (dimension > 2)
+        {
+          stats[7] += w * z;
+          stats[8] += w * z * z;
+          stats[9] += w * x * z;
+          stats[10] += w * y * z;
+        }
+    }
+
+  // PutStats () resets the number of entries in some versions of ROOT, so it
+  // is set afterward
+  const double entries = histogram_->GetEntries () + fills_.size ();
+  histogram_->PutStats (stats);
+  histogram_->SetEntries (entries);
+
+  fills_.clear ();
+}
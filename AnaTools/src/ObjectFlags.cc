@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <bitset>
+
+#include "OSUT3Analysis/AnaTools/interface/ObjectFlags.h"
+
+ObjectFlags::ObjectFlags () :
+  nCuts_        (0),
+  wordsPerCut_  (0)
+{
+}
+
+void
+ObjectFlags::reset (const unsigned nCuts, const vector<string> &collections, const vector<unsigned> &sizes)
+{
+  //////////////////////////////////////////////////////////////////////////////
+  // The bitsets for all the collections in one cut are stored contiguously,
+  // followed by those for the next cut.
+  //////////////////////////////////////////////////////////////////////////////
+  nCuts_ = nCuts;
+  collections_ = collections;
+  sizes_ = sizes;
+  offsets_.resize (sizes_.size ());
+  wordsPerCut_ = 0;
+  for (unsigned collection = 0; collection != sizes_.size (); collection++)
+    {
+      offsets_.at (collection) = wordsPerCut_;
+      wordsPerCut_ += nWordsFor (sizes_.at (collection));
+    }
+  passes_.assign (nCuts_ * wordsPerCut_, 0);
+  valid_.assign (nCuts_ * wordsPerCut_, 0);
+  //////////////////////////////////////////////////////////////////////////////
+}
+
+bool
+ObjectFlags::empty () const
+{
+  return !nCuts_;
+}
+
+unsigned
+ObjectFlags::nCuts () const
+{
+  return nCuts_;
+}
+
+unsigned
+ObjectFlags::nCollections () const
+{
+  return collections_.size ();
+}
+
+int
+ObjectFlags::collectionID (const string &name) const
+{
+  auto collection = find (collections_.begin (), collections_.end (), name);
+  return (collection != collections_.end () ? collection - collections_.begin () : -1);
+}
+
+const string &
+ObjectFlags::collectionName (const unsigned collection) const
+{
+  return collections_.at (collection);
+}
+
+unsigned
+ObjectFlags::size (const unsigned collection) const
+{
+  return sizes_.at (collection);
+}
+
+unsigned
+ObjectFlags::nWords (const unsigned collection) const
+{
+  return nWordsFor (sizes_.at (collection));
+}
+
+void
+ObjectFlags::set (const unsigned cut, const unsigned collection, const unsigned object, const bool passes, const bool valid)
+{
+  setBit (passesWords (cut, collection), object, passes);
+  setBit (validWords (cut, collection), object, valid);
+}
+
+void
+ObjectFlags::setPasses (const unsigned cut, const unsigned collection, const unsigned object, const bool passes)
+{
+  setBit (passesWords (cut, collection), object, passes);
+}
+
+unsigned
+ObjectFlags::count (const unsigned cut, const unsigned collection) const
+{
+  const Word * const passes = passesWords (cut, collection),
+             * const valid = validWords (cut, collection);
+  unsigned n = 0;
+  for (unsigned i = 0; i != nWords (collection); i++)
+    n += bitset<BITS_PER_WORD> (passes[i] & valid[i]).count ();
+  return n;
+}
@@ -41,6 +41,19 @@
       clog << "WARNING: failed to retrieve cut decisions from the event." << endl;
     //////////////////////////////////////////////////////////////////////////////
 
+    //////////////////////////////////////////////////////////////////////////////
+    // Find the integer identifying the collection to filter in the cut
+    // decisions, and quit if no flags were set for it.
+    //////////////////////////////////////////////////////////////////////////////
+    int collectionID = -1;
+    if (cutDecisions.isValid () && !cutDecisions->cumulativeObjectFlags.empty ()
+     && (collectionID = cutDecisions->cumulativeObjectFlags.collectionID (collectionToFilter_)) < 0)
+      {
+        clog << "ERROR: no flags have been set for " << collectionToFilter_ << "." << endl;
+        exit (EXIT_CODE);
+      }
+    //////////////////////////////////////////////////////////////////////////////
+
     //////////////////////////////////////////////////////////////////////////////
     // Fill the payload with the objects from the collection which pass all cuts.
     // If the collection could not be retrieved, the payload remains empty. If the
@@ -55,13 +68,11 @@
         unsigned iObject = 0;
         bool passes = true;
 
-        if (cutDecisions.isValid ())
+        if (cutDecisions.isValid () && !cutDecisions->cumulativeObjectFlags.empty ())
           {
-            for (int iCut = cutDecisions->cumulativeObjectFlags.size () - 1; iCut >= 0; iCut--)
-              {
-                passes = (cutDecisions->cumulativeObjectFlags.at (iCut).at (collectionToFilter_).at (iObject).second ? cutDecisions->cumulativeObjectFlags.at (iCut).at (collectionToFilter_).at (iObject).first : false);
-                break;
-              }
+            const ObjectFlags &flags = cutDecisions->cumulativeObjectFlags;
+            unsigned iCut = flags.nCuts () - 1;
+            passes = (flags.valid (iCut, collectionID, iObject) ? flags.passes (iCut, collectionID, iObject) : false);
           }
         if (passes)
           {
@@ -11,32 +11,30 @@ PUWeight::PUWeight (const string &puFile, const string &dataPU, const string &mc
 
   TH1D *mc;
   fin->GetObject(mcPU.c_str(), mc);
-  fin->GetObject(dataPU.c_str(), puWeight_);
+  TH1D *data;
+  fin->GetObject(dataPU.c_str(), data);
   if (!mc) {
     clog << "ERROR [PUWeight]: Could not find histogram: " << mcPU
          << "; will cause a seg fault." << endl;
     exit(1);
   }
-  if (!puWeight_) {
+  if (!data) {
     clog << "ERROR [PUWeight]: Could not find histogram: " << dataPU
          << "; will cause a seg fault." << endl;
     exit(1);
   }
 
   mc->SetDirectory (0);
-  puWeight_->SetDirectory (0);
-  mc->Scale (puWeight_->Integral () / mc->Integral ());
-  TH1D *trimmedMC = new TH1D ("bla", "bla", puWeight_->GetNbinsX(), 0, puWeight_->GetNbinsX());
-  for (int bin = 1; bin <= puWeight_->GetNbinsX(); bin++)
+  data->SetDirectory (0);
+  mc->Scale (data->Integral () / mc->Integral ());
+  TH1D *trimmedMC = new TH1D ("bla", "bla", data->GetNbinsX(), 0, data->GetNbinsX());
+  for (int bin = 1; bin <= data->GetNbinsX(); bin++)
     trimmedMC->SetBinContent (bin, mc->GetBinContent (bin));
-  puWeight_->Divide (trimmedMC);
+  data->Divide (trimmedMC);
+  puWeight_ = BinnedLookup1D (*data);
   fin->Close ();
   delete fin;
+  delete data;
   delete mc;
   delete trimmedMC;
 }
-
-PUWeight::~PUWeight ()
-{
-  delete puWeight_;
-}
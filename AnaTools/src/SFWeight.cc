@@ -1,5 +1,33 @@
+#include "FWCore/Utilities/interface/Exception.h"
+
 #include "OSUT3Analysis/AnaTools/interface/SFWeight.h"
 
+// Reads a data/MC histogram from a file and copies it into a lookup table, so
+// that the histogram itself does not need to be kept. A missing file or
+// histogram is a configuration error, so the job is stopped.
+template<class T> static T
+readLookup (const string &sfFile, const string &dataOverMC, const string &caller)
+{
+  TFile *fin = TFile::Open (sfFile.c_str ());
+  if (!fin || fin->IsZombie ())
+    {
+      delete fin;
+      throw cms::Exception ("FatalError") << "[" << caller << "]: could not open " << sfFile << ".";
+    }
+  TH1 *dataOverMCHist = (TH1 *) fin->Get (dataOverMC.c_str ());
+  if (!dataOverMCHist)
+    {
+      fin->Close ();
+      delete fin;
+      throw cms::Exception ("FatalError") << "[" << caller << "]: could not find histogram " << dataOverMC << " in " << sfFile << ".";
+    }
+  T lookup (*dataOverMCHist);
+  delete dataOverMCHist;
+  fin->Close ();
+  delete fin;
+  return lookup;
+}
+
 
 double
 TrackSFWeight::at(const double &correctedD0, const int &shiftUpDown)
@@ -27,48 +55,40 @@ TrackSFWeight::~TrackSFWeight ()
 
 
 
-MuonSFWeight::MuonSFWeight (const string &sfFile, const string &dataOverMC)
+MuonSFWeight::MuonSFWeight (const string &sfFile, const string &dataOverMC) :
+  muonSFWeight_ (readLookup<BinnedLookup2D> (sfFile, dataOverMC, "MuonSFWeight::MuonSFWeight"))
 {
-  TFile *fin = TFile::Open (sfFile.c_str ());
-  TH2F* SF_Combined_TOT = (TH2F *) fin->Get(dataOverMC.c_str ());
-  muonSFWeight_ = (TH2F*)SF_Combined_TOT->Clone();
-  muonSFWeight_->GetEntries();// to avoid the crashing warning
-  delete SF_Combined_TOT;
-  fin->Close ();
-  delete fin;
- }
+}
 
 
 double
-MuonSFWeight::at(const double &eta, const double &pt, const int &shiftUpDown)
+MuonSFWeight::at(const double &eta, const double &pt, const int &shiftUpDown) const
 {
+  const BinnedAxis &xAxis = muonSFWeight_.xAxis (),
+                   &yAxis = muonSFWeight_.yAxis ();
   double pt_hist= pt;
   double eta_hist= eta;
   // to give a non null SF for muons being out of eta and/or pt range of the input histo
-  if (pt > 300 && abs(eta) < muonSFWeight_->GetXaxis()->GetBinUpEdge(muonSFWeight_->GetXaxis()->GetLast()) )
+  if (pt > 300 && abs(eta) < xAxis.upEdge(xAxis.nBins()) )
     {
-      pt_hist =( muonSFWeight_->GetYaxis()->GetBinUpEdge(muonSFWeight_->GetYaxis()->GetNbins() - 1) + muonSFWeight_->GetYaxis()->GetBinUpEdge(muonSFWeight_->GetYaxis()->GetNbins() - 2))/2;
+      pt_hist =( yAxis.upEdge(yAxis.nBins() - 1) + yAxis.upEdge(yAxis.nBins() - 2))/2;
       if (pt > 300 && abs(eta) < 0.9)
         {
-          pt_hist =( muonSFWeight_->GetYaxis()->GetBinUpEdge(muonSFWeight_->GetYaxis()->GetNbins()) + muonSFWeight_->GetYaxis()->GetBinUpEdge(muonSFWeight_->GetYaxis()->GetNbins() - 1))/2;
+          pt_hist =( yAxis.upEdge(yAxis.nBins()) + yAxis.upEdge(yAxis.nBins() - 1))/2;
         }
     }
-  else if (pt < 300 && abs(eta) > muonSFWeight_->GetXaxis()->GetBinUpEdge(muonSFWeight_->GetXaxis()->GetLast()))
+  else if (pt < 300 && abs(eta) > xAxis.upEdge(xAxis.nBins()))
     {
-      eta_hist =(muonSFWeight_->GetXaxis()->GetBinUpEdge(muonSFWeight_->GetXaxis()->GetLast()) + muonSFWeight_->GetXaxis()->GetBinUpEdge(muonSFWeight_->GetXaxis()->GetNbins() - 1))/2;
+      eta_hist =(xAxis.upEdge(xAxis.nBins()) + xAxis.upEdge(xAxis.nBins() - 1))/2;
     }
-  else if (pt > 300 && abs(eta) > muonSFWeight_->GetXaxis()->GetBinUpEdge(muonSFWeight_->GetXaxis()->GetLast()))
+  else if (pt > 300 && abs(eta) > xAxis.upEdge(xAxis.nBins()))
     {
-      pt_hist =( muonSFWeight_->GetYaxis()->GetBinUpEdge(muonSFWeight_->GetYaxis()->GetNbins() - 1) + muonSFWeight_->GetYaxis()->GetBinUpEdge(muonSFWeight_->GetYaxis()->GetNbins() - 2))/2;
-      eta_hist =(muonSFWeight_->GetXaxis()->GetBinUpEdge(muonSFWeight_->GetXaxis()->GetLast()) + muonSFWeight_->GetXaxis()->GetBinUpEdge(muonSFWeight_->GetXaxis()->GetNbins() - 1))/2;
+      pt_hist =( yAxis.upEdge(yAxis.nBins() - 1) + yAxis.upEdge(yAxis.nBins() - 2))/2;
+      eta_hist =(xAxis.upEdge(xAxis.nBins()) + xAxis.upEdge(xAxis.nBins() - 1))/2;
     }
 
-  return muonSFWeight_->GetBinContent(muonSFWeight_->FindBin(abs(eta_hist),pt_hist)) + shiftUpDown * muonSFWeight_->GetBinError(muonSFWeight_->FindBin(abs(eta_hist),pt_hist));
-}
-
-MuonSFWeight::~MuonSFWeight ()
-{
-  delete muonSFWeight_;
+  int bin = muonSFWeight_.findBin(abs(eta_hist),pt_hist);
+  return muonSFWeight_.content(bin) + shiftUpDown * muonSFWeight_.error(bin);
 }
 
 
@@ -76,41 +96,45 @@ MuonSFWeight::~MuonSFWeight ()
 ElectronSFWeight::ElectronSFWeight (const string &cmsswRelease, const string &id, const string &sfFile, const string &dataOverMC) :
   cmsswRelease_ (cmsswRelease),
   id_ (id),
-  electronSFWeight_ (NULL)
+  ptOnXAxis_ (false)
 {
   ifstream finStream (sfFile);
   if (!finStream)
     return;
   finStream.close ();
   TFile *fin = TFile::Open (sfFile.c_str ());
-  electronSFWeight_ = (TH2F *) fin->Get (dataOverMC.c_str ());
-  electronSFWeight_->SetDirectory (0);
+  TH2F *electronSFWeight = (TH2F *) fin->Get (dataOverMC.c_str ());
+  if (!electronSFWeight)
+    {
+      fin->Close ();
+      delete fin;
+      throw cms::Exception ("FatalError") << "[ElectronSFWeight::ElectronSFWeight]: could not find histogram " << dataOverMC << " in " << sfFile << ".";
+    }
+  electronSFWeight_ = BinnedLookup2D (*electronSFWeight);
+  ptOnXAxis_ = strcasestr (electronSFWeight->GetYaxis ()->GetTitle (), "eta");
+  delete electronSFWeight;
   fin->Close ();
   delete fin;
 }
 
 double
-ElectronSFWeight::at (const double &eta, const double &pt, const int &shiftUpDown)
+ElectronSFWeight::at (const double &eta, const double &pt, const int &shiftUpDown) const
 {
   double scaleFactor = 1.0, minus = 0.0, plus = 0.0;
 
-  if (electronSFWeight_)
+  if (!electronSFWeight_.empty ())
     {
       double x = eta, y = pt;
-      if (strcasestr (electronSFWeight_->GetYaxis ()->GetTitle (), "eta"))
+      if (ptOnXAxis_)
         {
           x = pt;
           y = eta;
         }
-      int xBin = electronSFWeight_->GetXaxis ()->FindBin (x),
-          yBin = electronSFWeight_->GetYaxis ()->FindBin (y);
-      xBin = min (xBin, electronSFWeight_->GetXaxis ()->GetNbins ());
-      xBin = max (xBin, 1);
-      yBin = min (yBin, electronSFWeight_->GetYaxis ()->GetNbins ());
-      yBin = max (yBin, 1);
-
-      scaleFactor = electronSFWeight_->GetBinContent (xBin, yBin);
-      minus = plus = electronSFWeight_->GetBinError (xBin, yBin);
+      int bin = electronSFWeight_.bin (electronSFWeight_.xAxis ().clampBin (x),
+                                       electronSFWeight_.yAxis ().clampBin (y));
+
+      scaleFactor = electronSFWeight_.content (bin);
+      minus = plus = electronSFWeight_.error (bin);
     }
   else if (cmsswRelease_ == "53X")
     {
@@ -360,222 +384,120 @@ ElectronSFWeight::at (const double &eta, const double &pt, const int &shiftUpDow
   return scaleFactor + shiftUpDown * error;
 }
 
-ElectronSFWeight::~ElectronSFWeight ()
-{
-  if (electronSFWeight_)
-    delete electronSFWeight_;
-}
-
 double
-TriggerMetSFWeight::at(const double &Met, const int &shiftUpDown)
+TriggerMetSFWeight::at(const double &Met, const int &shiftUpDown) const
 {
-  int bin = triggerMetSFWeight_->FindBin(Met);
-  return 1.0 + triggerMetSFWeight_->GetBinContent(bin) + shiftUpDown * triggerMetSFWeight_->GetBinError(bin);\
+  int bin = triggerMetSFWeight_.axis ().findBin(Met);
+  return 1.0 + triggerMetSFWeight_.content(bin) + shiftUpDown * triggerMetSFWeight_.error(bin);\
   // Add 1.0 because the histogram bin content is (data-MC)/MC
 }
 
-TriggerMetSFWeight::~TriggerMetSFWeight ()
+TriggerMetSFWeight::TriggerMetSFWeight (const string &sfFile, const string &dataOverMC) :
+  triggerMetSFWeight_ (readLookup<BinnedLookup1D> (sfFile, dataOverMC, "TriggerMetSFWeight::TriggerMetSFWeight"))
 {
-  delete triggerMetSFWeight_;
 }
 
-TriggerMetSFWeight::TriggerMetSFWeight (const string &sfFile, const string &dataOverMC)
-{
-  TFile *fin = TFile::Open (sfFile.c_str ());
-  TH1F* dataOverMCHist = (TH1F *) fin->Get(dataOverMC.c_str ());
-  if (!dataOverMCHist) cout << "Fatal Error [TriggerMetSFWeight::TriggerMetSFWeight]:  could not find histogram " << dataOverMC << " in " << sfFile << endl;
-  triggerMetSFWeight_ = (TH1F*)  dataOverMCHist->Clone();
-  triggerMetSFWeight_->GetEntries();// to avoid the crashing warning
-  delete dataOverMCHist;
-  fin->Close ();
-  delete fin;
- }
-
 
 double
-TrackNMissOutSFWeight::at(const double &NMissOut, const int &shiftUpDown)
+TrackNMissOutSFWeight::at(const double &NMissOut, const int &shiftUpDown) const
 {
-  int bin = trackNMissOutSFWeight_->FindBin(NMissOut);
-  return 1.0 + trackNMissOutSFWeight_->GetBinContent(bin) + shiftUpDown * trackNMissOutSFWeight_->GetBinError(bin);  // Add 1.0 because the histogram bin content is (data-MC)/MC
+  int bin = trackNMissOutSFWeight_.axis ().findBin(NMissOut);
+  return 1.0 + trackNMissOutSFWeight_.content(bin) + shiftUpDown * trackNMissOutSFWeight_.error(bin);  // Add 1.0 because the histogram bin content is (data-MC)/MC
 }
 
-TrackNMissOutSFWeight::~TrackNMissOutSFWeight ()
-{
-  delete trackNMissOutSFWeight_;
-}
 
 
 
-
-TrackNMissOutSFWeight::TrackNMissOutSFWeight (const string &sfFile, const string &dataOverMC)
+TrackNMissOutSFWeight::TrackNMissOutSFWeight (const string &sfFile, const string &dataOverMC) :
+  trackNMissOutSFWeight_ (readLookup<BinnedLookup1D> (sfFile, dataOverMC, "TrackNMissOutSFWeight::TrackNMissOutSFWeight"))
 {
-  TFile *fin = TFile::Open (sfFile.c_str ());
-  TH1F* dataOverMCHist = (TH1F *) fin->Get(dataOverMC.c_str ());
-  if (!dataOverMCHist) cout << "Fatal Error [TrackNMissOutSFWeight::TrackNMissOutSFWeight]:  could not find histogram " << dataOverMC << " in " << sfFile << endl;
-  trackNMissOutSFWeight_ = (TH1F*)  dataOverMCHist->Clone();
-  trackNMissOutSFWeight_->GetEntries();  // to avoid the crashing warning
-  delete dataOverMCHist;
-  fin->Close ();
-  delete fin;
 }
 
 
 double
-EcaloVarySFWeight::at(const double &EcaloVary, const int &shiftUpDown)
-{
-  int bin = EcaloVarySFWeight_->FindBin(EcaloVary);
-  return 1.0 + EcaloVarySFWeight_->GetBinContent(bin) + shiftUpDown * EcaloVarySFWeight_->GetBinError(bin);  // Add 1.0 because the histogram bin content is (data-MC)/MC
-}
-
-EcaloVarySFWeight::~EcaloVarySFWeight ()
+EcaloVarySFWeight::at(const double &EcaloVary, const int &shiftUpDown) const
 {
-  delete EcaloVarySFWeight_;
+  int bin = EcaloVarySFWeight_.axis ().findBin(EcaloVary);
+  return 1.0 + EcaloVarySFWeight_.content(bin) + shiftUpDown * EcaloVarySFWeight_.error(bin);  // Add 1.0 because the histogram bin content is (data-MC)/MC
 }
 
-EcaloVarySFWeight::EcaloVarySFWeight (const string &sfFile, const string &dataOverMC)
+EcaloVarySFWeight::EcaloVarySFWeight (const string &sfFile, const string &dataOverMC) :
+  EcaloVarySFWeight_ (readLookup<BinnedLookup1D> (sfFile, dataOverMC, "EcaloVarySFWeight::EcaloVarySFWeight"))
 {
-  TFile *fin = TFile::Open (sfFile.c_str ());
-  TH1F* dataOverMCHist = (TH1F *) fin->Get(dataOverMC.c_str ());
-  if (!dataOverMCHist) cout << "Fatal Error [EcaloVarySFWeight::EcaloVarySFWeight]:  could not find histogram " << dataOverMC << " in " << sfFile << endl;
-  EcaloVarySFWeight_ = (TH1F*)  dataOverMCHist->Clone();
-  EcaloVarySFWeight_->GetEntries();  // to avoid the crashing warning
-  delete dataOverMCHist;
-  fin->Close ();
-  delete fin;
 }
 
 
-IsrVarySFWeight::IsrVarySFWeight (const string &sfFile, const string &dataOverMC)
+IsrVarySFWeight::IsrVarySFWeight (const string &sfFile, const string &dataOverMC) :
+  isrVarySFWeight_ (readLookup<BinnedLookup1D> (sfFile, dataOverMC, "IsrVarySFWeight::IsrVarySFWeight"))
 {
-  TFile *fin = TFile::Open (sfFile.c_str ());
-  TH1F* dataOverMCHist = (TH1F *) fin->Get(dataOverMC.c_str ());
-  if (!dataOverMCHist) cout << "Fatal Error [IsrVarySFWeight::IsrVarySFWeight]:  could not find histogram " << dataOverMC << " in " << sfFile << endl;
-  isrVarySFWeight_ = (TH1F*)  dataOverMCHist->Clone();
-  isrVarySFWeight_->GetEntries();// to avoid the crashing warning
-  delete dataOverMCHist;
-  clog << "Will use hist " << isrVarySFWeight_->GetName() << " from file " << sfFile << " to do ISR reweighting." << endl;
-  fin->Close ();
-  delete fin;
- }
-
-double
-IsrVarySFWeight::at(const double &ptSusy, const int &shiftUpDown)
-{
-  int bin = isrVarySFWeight_->FindBin(ptSusy);
-  return 1.0 + isrVarySFWeight_->GetBinContent(bin) + shiftUpDown * isrVarySFWeight_->GetBinError(bin);  // Add 1.0 because the histogram bin content is (data-MC)/MC
+  clog << "Will use hist " << dataOverMC << " from file " << sfFile << " to do ISR reweighting." << endl;
 }
 
-IsrVarySFWeight::~IsrVarySFWeight ()
+double
+IsrVarySFWeight::at(const double &ptSusy, const int &shiftUpDown) const
 {
-  delete isrVarySFWeight_;
+  int bin = isrVarySFWeight_.axis ().findBin(ptSusy);
+  return 1.0 + isrVarySFWeight_.content(bin) + shiftUpDown * isrVarySFWeight_.error(bin);  // Add 1.0 because the histogram bin content is (data-MC)/MC
 }
 
 
 // Define four classes that will be used to reweight generated event to emulate the CMS reconstruction and the set of cut applied in the displaced susy analysis
 
 // MuonCutWeight
-MuonCutWeight::MuonCutWeight (const string &sfFile, const string &dataOverMC)
+MuonCutWeight::MuonCutWeight (const string &sfFile, const string &dataOverMC) :
+  muonCutWeight_ (readLookup<BinnedLookup1D> (sfFile, dataOverMC, "MuonCutWeight::MuonCutWeight"))
 {
-  TFile *fin = TFile::Open (sfFile.c_str ());
-  TH1F* dataOverMCHist = (TH1F *) fin->Get(dataOverMC.c_str ());
-  if (!dataOverMCHist) cout << "Fatal Error [MuonCutWeight::MuonCutWeight]:  could not find histogram " << dataOverMC << " in " << sfFile << endl;
-  muonCutWeight_ = (TH1F*)  dataOverMCHist->Clone();
-  muonCutWeight_->GetEntries();  // to avoid the crashing warning
-  delete dataOverMCHist;
-  fin->Close ();
-  delete fin;
 }
 
 
 double
-MuonCutWeight::at(const double &pt)
+MuonCutWeight::at(const double &pt) const
 {
-  int bin = muonCutWeight_->FindBin(pt);
-  return  muonCutWeight_->GetBinContent(bin);
-}
-
-MuonCutWeight::~MuonCutWeight ()
-{
-  delete muonCutWeight_;
+  int bin = muonCutWeight_.axis ().findBin(pt);
+  return  muonCutWeight_.content(bin);
 }
 
 
 // ElectronCutWeight
-ElectronCutWeight::ElectronCutWeight (const string &sfFile, const string &dataOverMC)
+ElectronCutWeight::ElectronCutWeight (const string &sfFile, const string &dataOverMC) :
+  electronCutWeight_ (readLookup<BinnedLookup1D> (sfFile, dataOverMC, "ElectronCutWeight::ElectronCutWeight"))
 {
-  TFile *fin = TFile::Open (sfFile.c_str ());
-  TH1F* dataOverMCHist = (TH1F *) fin->Get(dataOverMC.c_str ());
-  if (!dataOverMCHist) cout << "Fatal Error [ElectronCutWeight::ElectronCutWeight]:  could not find histogram " << dataOverMC << " in " << sfFile << endl;
-  electronCutWeight_ = (TH1F*)  dataOverMCHist->Clone();
-  electronCutWeight_->GetEntries();  // to avoid the crashing warning
-  delete dataOverMCHist;
-  fin->Close ();
-  delete fin;
 }
 
 
 double
-ElectronCutWeight::at(const double &pt)
-{
-  int bin = electronCutWeight_->FindBin(pt);
-  return  electronCutWeight_->GetBinContent(bin);
-}
-
-ElectronCutWeight::~ElectronCutWeight ()
+ElectronCutWeight::at(const double &pt) const
 {
-  delete electronCutWeight_;
+  int bin = electronCutWeight_.axis ().findBin(pt);
+  return  electronCutWeight_.content(bin);
 }
 
 // RecoElectronWeight
-RecoElectronWeight::RecoElectronWeight (const string &sfFile, const string &dataOverMC)
+RecoElectronWeight::RecoElectronWeight (const string &sfFile, const string &dataOverMC) :
+  recoElectronWeight_ (readLookup<BinnedLookup1D> (sfFile, dataOverMC, "RecoElectronWeight::RecoElectronWeight"))
 {
-  TFile *fin = TFile::Open (sfFile.c_str ());
-  TH1F* dataOverMCHist = (TH1F *) fin->Get(dataOverMC.c_str ());
-  if (!dataOverMCHist) cout << "Fatal Error [RecoElectronWeight::RecoElectronWeight]:  could not find histogram " << dataOverMC << " in " << sfFile << endl;
-  recoElectronWeight_ = (TH1F*)  dataOverMCHist->Clone();
-  recoElectronWeight_->GetEntries();
-  delete dataOverMCHist;
-  fin->Close ();
-  delete fin;
 }
 
 
 double
-RecoElectronWeight::at(const double &d0)
+RecoElectronWeight::at(const double &d0) const
 {
-  int bin = recoElectronWeight_->FindBin(d0);
-  return recoElectronWeight_->GetBinContent(bin);
-}
-
-RecoElectronWeight::~RecoElectronWeight ()
-{
-  delete recoElectronWeight_;
+  int bin = recoElectronWeight_.axis ().findBin(d0);
+  return recoElectronWeight_.content(bin);
 }
 
 // RecoMuonWeight
-RecoMuonWeight::RecoMuonWeight (const string &sfFile, const string &dataOverMC)
+RecoMuonWeight::RecoMuonWeight (const string &sfFile, const string &dataOverMC) :
+  recoMuonWeight_ (readLookup<BinnedLookup1D> (sfFile, dataOverMC, "RecoMuonWeight::RecoMuonWeight"))
 {
-  TFile *fin = TFile::Open (sfFile.c_str ());
-  TH1F* dataOverMCHist = (TH1F *) fin->Get(dataOverMC.c_str ());
-  if (!dataOverMCHist) cout << "Fatal Error [RecoMuonWeight::RecoMuonWeight]:  could not find histogram " << dataOverMC << " in " << sfFile << endl;
-  recoMuonWeight_ = (TH1F*)  dataOverMCHist->Clone();
-  recoMuonWeight_->GetEntries();  // to avoid the crashing warning
-  delete dataOverMCHist;
-  fin->Close ();
-  delete fin;
 }
 
 
 double
-RecoMuonWeight::at(const double &d0)
-{
-  int bin = recoMuonWeight_->FindBin(d0);
-  return  recoMuonWeight_->GetBinContent(bin);
-}
-
-RecoMuonWeight::~RecoMuonWeight ()
+RecoMuonWeight::at(const double &d0) const
 {
-  delete recoMuonWeight_;
+  int bin = recoMuonWeight_.axis ().findBin(d0);
+  return  recoMuonWeight_.content(bin);
 }
 
 
@@ -0,0 +1,74 @@
+#include <algorithm>
+
+#include "OSUT3Analysis/AnaTools/interface/TriggerObjectIndex.h"
+
+#if IS_VALID(trigobjs)
+
+anatools::TriggerObjectIndex::TriggerObjectIndex () :
+  trigObjs_ (NULL)
+{
+}
+
+const anatools::TriggerObjectIndex &
+anatools::TriggerObjectIndex::get (const edm::Event &event, const edm::TriggerResults &triggers, const vector<pat::TriggerObjectStandAlone> &trigObjs)
+{
+  static thread_local TriggerObjectIndex index;
+  if (event.id () != index.eventID_ || &trigObjs != index.trigObjs_ || trigObjs.size () != index.unpacked_.size ())
+    index.build (event, triggers, trigObjs);
+  return index;
+}
+
+const vector<unsigned> &
+anatools::TriggerObjectIndex::inCollection (const string &collection) const
+{
+  auto objects = byCollection_.find (collection);
+  return (objects != byCollection_.end () ? objects->second : none_);
+}
+
+const vector<unsigned> &
+anatools::TriggerObjectIndex::withFilter (const string &filter) const
+{
+  auto objects = byFilter_.find (filter);
+  return (objects != byFilter_.end () ? objects->second : none_);
+}
+
+bool
+anatools::TriggerObjectIndex::hasFilter (const unsigned i, const string &filter) const
+{
+  const vector<unsigned> &objects = withFilter (filter);
+  return binary_search (objects.begin (), objects.end (), i);
+}
+
+void
+anatools::TriggerObjectIndex::build (const edm::Event &event, const edm::TriggerResults &triggers, const vector<pat::TriggerObjectStandAlone> &trigObjs)
+{
+  eventID_ = event.id ();
+  trigObjs_ = &trigObjs;
+
+  unpacked_ = trigObjs;
+  byCollection_.clear ();
+  byFilter_.clear ();
+#if CMSSW_VERSION_CODE < CMSSW_VERSION(9,2,0)
+  const edm::TriggerNames &triggerNames = event.triggerNames (triggers);
+#endif
+  for (unsigned i = 0; i < unpacked_.size (); i++)
+    {
+      pat::TriggerObjectStandAlone &trigObj = unpacked_.at (i);
+#if CMSSW_VERSION_CODE >= CMSSW_VERSION(9,2,0)
+      trigObj.unpackNamesAndLabels (event, triggers);
+#else
+      trigObj.unpackPathNames (triggerNames);
+#endif
+      byCollection_[trigObj.collection ()].push_back (i);
+
+      // an object can list the same filter more than once
+      for (const auto &filterLabel : trigObj.filterLabels ())
+        {
+          vector<unsigned> &objects = byFilter_[filterLabel];
+          if (objects.empty () || objects.back () != i)
+            objects.push_back (i);
+        }
+    }
+}
+
+#endif
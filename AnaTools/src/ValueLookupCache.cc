@@ -0,0 +1,129 @@
+#include <mutex>
+#include <sstream>
+#include <tuple>
+#include <unordered_map>
+
+#include "OSUT3Analysis/AnaTools/interface/ValueLookupCache.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Keys which are shared by all the caches.
+////////////////////////////////////////////////////////////////////////////////
+static mutex                                                   keysMutex;
+static unordered_map<string, unsigned>                         collectionKeys;
+static unordered_map<string, unsigned>                         memberKeys;
+static unordered_map<string, ValueLookupCache::Subexpression>  subexpressions;
+////////////////////////////////////////////////////////////////////////////////
+
+ValueLookupCache::ValueLookupCache () :
+  event_ (0)
+{
+}
+
+void
+ValueLookupCache::beginEvent ()
+{
+  //////////////////////////////////////////////////////////////////////////////
+  // Every value stored so far has a stamp which is now out of date. In the
+  // unlikely case that the stamp wraps around, the columns are cleared so that
+  // no value from an old event can match.
+  //////////////////////////////////////////////////////////////////////////////
+  if (++event_ == 0)
+    {
+      members_.clear ();
+      subexpressions_.clear ();
+      event_ = 1;
+    }
+  //////////////////////////////////////////////////////////////////////////////
+}
+
+unsigned
+ValueLookupCache::getCollectionKey (const string &collection)
+{
+  lock_guard<mutex> lock (keysMutex);
+  auto key = collectionKeys.find (collection);
+  if (key != collectionKeys.end ())
+    return key->second;
+  unsigned newKey = collectionKeys.size ();
+  collectionKeys[collection] = newKey;
+  return newKey;
+}
+
+unsigned
+ValueLookupCache::getMemberKey (const string &member)
+{
+  lock_guard<mutex> lock (keysMutex);
+  auto key = memberKeys.find (member);
+  if (key != memberKeys.end ())
+    return key->second;
+  unsigned newKey = memberKeys.size ();
+  memberKeys[member] = newKey;
+  return newKey;
+}
+
+const ValueLookupCache::Subexpression *
+ValueLookupCache::registerSubexpression (const string &expression)
+{
+  //////////////////////////////////////////////////////////////////////////////
+  // Elements of an unordered_map are never moved, so the returned pointer
+  // stays valid while other subexpressions are being registered.
+  //////////////////////////////////////////////////////////////////////////////
+  lock_guard<mutex> lock (keysMutex);
+  auto subexpression = subexpressions.find (expression);
+  if (subexpression == subexpressions.end ())
+    {
+      unsigned newKey = subexpressions.size ();
+      subexpression = subexpressions.emplace (piecewise_construct, forward_as_tuple (expression), forward_as_tuple ()).first;
+      subexpression->second.key = newKey;
+    }
+  return &subexpression->second;
+  //////////////////////////////////////////////////////////////////////////////
+}
+
+void
+ValueLookupCache::set (Table &table, const unsigned collection, const unsigned key, const unsigned index, const double value)
+{
+  //////////////////////////////////////////////////////////////////////////////
+  // The table only grows the first time a collection, key, or index is seen,
+  // so after the first few events storing a value allocates nothing.
+  //////////////////////////////////////////////////////////////////////////////
+  if (collection >= table.size ())
+    table.resize (collection + 1);
+  vector<Column> &columns = table[collection];
+  if (key >= columns.size ())
+    columns.resize (key + 1);
+  Column &column = columns[key];
+  if (index >= column.events.size ())
+    {
+      column.values.resize (index + 1, 0.0);
+      column.events.resize (index + 1, 0);
+    }
+  //////////////////////////////////////////////////////////////////////////////
+
+  column.values[index] = value;
+  column.events[index] = event_;
+}
+
+ValueLookupCache::Counters &
+ValueLookupCache::Counters::operator+= (const Counters &counters)
+{
+  memberHits += counters.memberHits;
+  memberMisses += counters.memberMisses;
+  subexpressionHits += counters.subexpressionHits;
+  subexpressionMisses += counters.subexpressionMisses;
+  return *this;
+}
+
+const ValueLookupCache::Counters &
+ValueLookupCache::counters () const
+{
+  return counters_;
+}
+
+string
+ValueLookupCache::summary (const Counters &counters)
+{
+  stringstream ss;
+  ss << "ValueLookupCache: " << counters.memberHits << " hits and " << counters.memberMisses << " misses for members, "
+     << counters.subexpressionHits << " hits and " << counters.subexpressionMisses << " misses for shared subexpressions.";
+  return ss.str ();
+}
@@ -10,7 +10,12 @@
 ValueLookupTree::ValueLookupTree () :
   root_ (NULL),
   evaluationError_ (false),
-  allCollectionsNonEmpty_ (false)
+  allCollectionsNonEmpty_ (false),
+  compiled_ (false),
+  cacheSubexpressions_ (false),
+  cacheCollection_ (0),
+  collectionsResolved_ (false),
+  columnar_ (false)
 {
 }
 
@@ -18,39 +23,60 @@ ValueLookupTree::ValueLookupTree (const Cut &cut) :
   root_ (insert_ (cut.cutString, NULL)),
   inputCollections_ (cut.inputCollections),
   evaluationError_ (false),
-  allCollectionsNonEmpty_ (false)
+  allCollectionsNonEmpty_ (false),
+  compiled_ (false),
+  cacheSubexpressions_ (false),
+  cacheCollection_ (0),
+  collectionsResolved_ (false),
+  columnar_ (false)
 {
   pruneCommas (root_);
   pruneParentheses (root_);
   pruneDots (root_);
 
   sort (inputCollections_.begin (), inputCollections_.end ());
+  setComponents ();
+  compile ();
 }
 
 ValueLookupTree::ValueLookupTree (const ValueToPrint &value) :
   root_ (insert_ (value.valueToPrint, NULL)),
   inputCollections_ (value.inputCollections),
   evaluationError_ (false),
-  allCollectionsNonEmpty_ (false)
+  allCollectionsNonEmpty_ (false),
+  compiled_ (false),
+  cacheSubexpressions_ (false),
+  cacheCollection_ (0),
+  collectionsResolved_ (false),
+  columnar_ (false)
 {
   pruneCommas (root_);
   pruneParentheses (root_);
   pruneDots (root_);
 
   sort (inputCollections_.begin (), inputCollections_.end ());
+  setComponents ();
+  compile ();
 }
 
 ValueLookupTree::ValueLookupTree (const string &expression, const vector<string> &inputCollections) :
   root_ (insert_ (expression, NULL)),
   inputCollections_ (inputCollections),
   evaluationError_ (false),
-  allCollectionsNonEmpty_ (false)
+  allCollectionsNonEmpty_ (false),
+  compiled_ (false),
+  cacheSubexpressions_ (false),
+  cacheCollection_ (0),
+  collectionsResolved_ (false),
+  columnar_ (false)
 {
   pruneCommas (root_);
   pruneParentheses (root_);
   pruneDots (root_);
 
   sort (inputCollections_.begin (), inputCollections_.end ());
+  setComponents ();
+  compile ();
 }
 
 ValueLookupTree::~ValueLookupTree ()
@@ -85,6 +111,23 @@ ValueLookupTree::setCollections (Collections * const handles)
     }
   //////////////////////////////////////////////////////////////////////////////
 
+  //////////////////////////////////////////////////////////////////////////////
+  // Resolve the user variables read by the compiled program once, when the
+  // tree is first given the collections, rather than while evaluating it, and
+  // count the subexpressions of the program in the cache of the collections.
+  //////////////////////////////////////////////////////////////////////////////
+  if (!collectionsResolved_)
+    {
+      for (auto &slot : memberSlots_)
+        if (slot.collection == "uservariables")
+          slot.variableSlot = handles_->variables.userVariable (slot.variable);
+      for (const auto &instruction : program_)
+        if (instruction.opcode == OP_CACHE_LOAD)
+          handles_->cache.addSubexpressionUse (instruction.subexpression);
+    }
+  collectionsResolved_ = true;
+  //////////////////////////////////////////////////////////////////////////////
+
   return handles_;
 }
 
@@ -104,6 +147,7 @@ void
 ValueLookupTree::insert (const string &cut)
 {
   root_ = insert_ (cut, NULL);
+  compile ();
 }
 
 const vector<Leaf> &
@@ -117,26 +161,35 @@ ValueLookupTree::evaluate ()
   if (values_.empty () && allCollectionsNonEmpty_)
     {
       evaluationError_ = false;
-      uservariablesToDelete_.clear ();
-      eventvariablesToDelete_.clear ();
+      if (columnar_)
+        {
+          evaluateColumns ();
+          return values_;
+        }
+      for (unsigned j = 0; j < inputCollections_.size (); j++)
+        {
+          if (firstComponents_[j] != j)
+            continue;
+          collectionObjects_[j].clear ();
+          for (unsigned localIndex = 0; localIndex < collectionSizes_.at (j); localIndex++)
+            collectionObjects_[j].push_back (getObject (inputCollections_.at (j), localIndex));
+        }
       for (unsigned i = 0; i < nCombinations_.at (0); i++)
         {
-          objIterators_.clear ();
-          shouldIterate_.clear ();
-          ObjMap objs;
-          unordered_set<string> keys;
-          for (auto collection = inputCollections_.begin (); collection != inputCollections_.end (); collection++)
+          for (unsigned j = 0; j < inputCollections_.size (); j++)
             {
-              unsigned j = collection - inputCollections_.begin (),
-                       localIndex = getLocalIndex (i, j);
-              objs.insert ({*collection, {j, localIndex, getObject (*collection, localIndex)}});
-              keys.insert (*collection);
+              localIndices_[j] = getLocalIndex (i, j);
+              componentObjects_[j] = collectionObjects_[firstComponents_[j]][localIndices_[j]];
             }
-          if (isUniqueCase (objs, keys)) {
-            values_.push_back (evaluate_ (root_, objs));
+          fill (currentComponents_.begin (), currentComponents_.end (), -1);
+          if (isUniqueCase ()) {
+            if (compiled_)
+              values_.push_back (execute ());
+            else
+              values_.push_back (evaluate_ (root_));
             if (verbose_) {
               cout << "ValueLookupTree::evaluate is adding the Leaf: " << endl;
-              cout << "  " << evaluate_ (root_, objs) << endl;
+              cout << "  " << evaluate_ (root_) << endl;
               cout << "  printNode = " << endl;
               cout << "  " << printNode(root_) << endl;
               cout << "  printValue = " << endl;
@@ -146,14 +199,6 @@ ValueLookupTree::evaluate ()
           } else
             values_.push_back (INVALID_VALUE);
         }
-#if IS_VALID(uservariables)
-      for (auto &uservariable : uservariablesToDelete_)
-        delete ((osu::Uservariable *) uservariable);
-#endif
-#if IS_VALID(eventvariables)
-      for (auto &eventvariable : eventvariablesToDelete_)
-        delete ((osu::Eventvariable *) eventvariable);
-#endif
     }
 
   return values_;
@@ -287,19 +332,10 @@ ValueLookupTree::getCollectionSize (const string &name) const
     return handles_->secondaryTracks->size ();
   else if (EQ_VALID(name,pileupinfos))
     return handles_->pileupinfos->size ();
-  else if (EQ_VALID(name,uservariables)){
-    // !!!
-    //    return handles_->uservariables[printValue(root_)].size ();
-    //    return handles_->uservariables["electronPt"].size ();
-    //cout << handles_->uservariables.at(printValue(root_)).size () << endl;
-    //    auto isFound = handles_->uservariables.size();
-    //    cout << printValue(root_) << endl;
-    //    cout << "\t" << isFound << endl;
-    return 1;  // FIXME
-  }
-  else if (EQ_VALID(name,eventvariables)){
-    return 1;  // FIXME
-  }
+  else if (EQ_VALID(name,uservariables))
+    return 1;  // one object per event, read from handles_->variables
+  else if (EQ_VALID(name,eventvariables))
+    return 1;  // one object per event, read from handles_->variables
   return 0;
 }
 
@@ -554,7 +590,7 @@ ValueLookupTree::printValue (Node* tree) const
 }
 
 Leaf
-ValueLookupTree::evaluate_ (const Node * const tree, const ObjMap &objs)
+ValueLookupTree::evaluate_ (const Node * const tree)
 {
   //////////////////////////////////////////////////////////////////////////////
   // Do nothing if the tree is null.
@@ -571,9 +607,9 @@ ValueLookupTree::evaluate_ (const Node * const tree, const ObjMap &objs)
     {
       vector<Leaf> operands;
       for (const auto &branch : tree->branches)
-        operands.push_back (evaluate_ (branch, objs));
+        operands.push_back (evaluate_ (branch));
       if (verbose_) cout << "    Debug evalute 0 (no branches) for tree->value = " << tree->value << endl;
-      return evaluateOperator (tree->value, operands, objs);
+      return evaluateOperator (tree->value, operands);
     }
   //////////////////////////////////////////////////////////////////////////////
 
@@ -602,7 +638,7 @@ ValueLookupTree::evaluate_ (const Node * const tree, const ObjMap &objs)
                                << ", calling valueLookup for value: " << tree->value
                                << ", collection: " << inputCollections_.at (0)
                                << endl;
-            return valueLookup (inputCollections_.at (0), objs, tree->value);
+            return valueLookup (inputCollections_.at (0), tree->value);
           }
           clog << "ERROR: cannot infer ownership of \"" << tree->value << "\"" << endl;
           evaluationError_ = true;
@@ -613,7 +649,7 @@ ValueLookupTree::evaluate_ (const Node * const tree, const ObjMap &objs)
 }
 
 Leaf
-ValueLookupTree::evaluateOperator (const string &op, const vector<Leaf> &operands, const ObjMap &objs)
+ValueLookupTree::evaluateOperator (const string &op, const vector<Leaf> &operands)
 {
   // Tries to return the result of operating on the operands. Prints out a
   // warning, sets evaluationError_ to true, and returns the minimum unsigned
@@ -762,8 +798,8 @@ ValueLookupTree::evaluateOperator (const string &op, const vector<Leaf> &operand
       else if (op == "abs" || op == "fabs")
         return (fabs (boost::get<double> (operands.at (0))));
       else if (op == "deltaPhi")
-        return deltaPhi (valueLookup (boost::get<string> (operands.at (0)) + "s", objs, "phi"),
-                         valueLookup (boost::get<string> (operands.at (1)) + "s", objs, "phi"));
+        return deltaPhi (valueLookup (boost::get<string> (operands.at (0)) + "s", "phi"),
+                         valueLookup (boost::get<string> (operands.at (1)) + "s", "phi"));
       else if (op == "dPhi")
         return deltaPhi (boost::get<double> (operands.at (0)), boost::get<double> (operands.at (1)));
       else if (op == "normalizedPhi")
@@ -772,10 +808,10 @@ ValueLookupTree::evaluateOperator (const string &op, const vector<Leaf> &operand
         {
           double px0, px1, py0, py1, phi;
 
-          px0 = valueLookup (boost::get<string> (operands.at (0)) + "s", objs, "px");
-          py0 = valueLookup (boost::get<string> (operands.at (0)) + "s", objs, "py", false);
-          px1 = valueLookup (boost::get<string> (operands.at (1)) + "s", objs, "px");
-          py1 = valueLookup (boost::get<string> (operands.at (1)) + "s", objs, "py", false);
+          px0 = valueLookup (boost::get<string> (operands.at (0)) + "s", "px");
+          py0 = valueLookup (boost::get<string> (operands.at (0)) + "s", "py", false);
+          px1 = valueLookup (boost::get<string> (operands.at (1)) + "s", "px");
+          py1 = valueLookup (boost::get<string> (operands.at (1)) + "s", "py", false);
 
           phi = acos ((px0 + px1) / hypot (px0 + px1, py0 + py1));
           if ((py0 + py1) < 0.0)
@@ -787,10 +823,10 @@ ValueLookupTree::evaluateOperator (const string &op, const vector<Leaf> &operand
         {
           double eta0, phi0, eta1, phi1;
 
-          eta0 = valueLookup (boost::get<string> (operands.at (0)) + "s", objs, "eta");
-          phi0 = valueLookup (boost::get<string> (operands.at (0)) + "s", objs, "phi", false);
-          eta1 = valueLookup (boost::get<string> (operands.at (1)) + "s", objs, "eta");
-          phi1 = valueLookup (boost::get<string> (operands.at (1)) + "s", objs, "phi", false);
+          eta0 = valueLookup (boost::get<string> (operands.at (0)) + "s", "eta");
+          phi0 = valueLookup (boost::get<string> (operands.at (0)) + "s", "phi", false);
+          eta1 = valueLookup (boost::get<string> (operands.at (1)) + "s", "eta");
+          phi1 = valueLookup (boost::get<string> (operands.at (1)) + "s", "phi", false);
 
           return deltaR (eta0, phi0, eta1, phi1);
         }
@@ -803,24 +839,24 @@ ValueLookupTree::evaluateOperator (const string &op, const vector<Leaf> &operand
 	      // As the track collection does not have measured energy associated to it,
 	      // we assume tracks are massless while calculating invariant mass.
 	      if( boost::get<string> (operand) == "track" ){
-                energy += valueLookup (boost::get<string> (operand) + "s", objs, "p");
+                energy += valueLookup (boost::get<string> (operand) + "s", "p");
               }
               else{
-                energy += valueLookup (boost::get<string> (operand) + "s", objs, "energy");
+                energy += valueLookup (boost::get<string> (operand) + "s", "energy");
               }
-              px += valueLookup (boost::get<string> (operand) + "s", objs, "px", false);
-              py += valueLookup (boost::get<string> (operand) + "s", objs, "py", false);
-              pz += valueLookup (boost::get<string> (operand) + "s", objs, "pz", false);
+              px += valueLookup (boost::get<string> (operand) + "s", "px", false);
+              py += valueLookup (boost::get<string> (operand) + "s", "py", false);
+              pz += valueLookup (boost::get<string> (operand) + "s", "pz", false);
             }
 
           return sqrt (energy * energy - px * px - py * py - pz * pz);
         }
       else if (op == "transMass")
         {
-	  double pt0 = valueLookup (boost::get<string> (operands.at (0)) + "s", objs, "pt"),
-	    phi0 = valueLookup (boost::get<string> (operands.at (0)) + "s", objs, "phi", false),
-	    pt1 = valueLookup (boost::get<string> (operands.at (1)) + "s", objs, "pt"),
-	    phi1 = valueLookup (boost::get<string> (operands.at (1)) + "s", objs, "phi", false);
+	  double pt0 = valueLookup (boost::get<string> (operands.at (0)) + "s", "pt"),
+	    phi0 = valueLookup (boost::get<string> (operands.at (0)) + "s", "phi", false),
+	    pt1 = valueLookup (boost::get<string> (operands.at (1)) + "s", "pt"),
+	    phi1 = valueLookup (boost::get<string> (operands.at (1)) + "s", "phi", false);
 
 	  double dPhi = deltaPhi (phi0, phi1);
 	  return sqrt (2.0 * pt0 * pt1 * (1 - cos (dPhi)));
@@ -830,19 +866,19 @@ ValueLookupTree::evaluateOperator (const string &op, const vector<Leaf> &operand
           double px = 0.0, py = 0.0;
 	  for (const auto &operand : operands)
             {
-              px += valueLookup (boost::get<string> (operand) + "s", objs, "px");
-              py += valueLookup (boost::get<string> (operand) + "s", objs, "py", false);
+              px += valueLookup (boost::get<string> (operand) + "s", "px");
+              py += valueLookup (boost::get<string> (operand) + "s", "py", false);
             }
           return hypot(px,py);
         }
       else if (op == "cosAlpha")
 	{
-	  double px0 = valueLookup (boost::get<string> (operands.at (0)) + "s", objs, "px"),
-	    py0 = valueLookup (boost::get<string> (operands.at (0)) + "s", objs, "py", false),
-	    pz0 = valueLookup (boost::get<string> (operands.at (0)) + "s", objs, "pz", false),
-	    px1 = valueLookup (boost::get<string> (operands.at (1)) + "s", objs, "px"),
-	    py1 = valueLookup (boost::get<string> (operands.at (1)) + "s", objs, "py", false),
-	    pz1 = valueLookup (boost::get<string> (operands.at (1)) + "s", objs, "pz", false);
+	  double px0 = valueLookup (boost::get<string> (operands.at (0)) + "s", "px"),
+	    py0 = valueLookup (boost::get<string> (operands.at (0)) + "s", "py", false),
+	    pz0 = valueLookup (boost::get<string> (operands.at (0)) + "s", "pz", false),
+	    px1 = valueLookup (boost::get<string> (operands.at (1)) + "s", "px"),
+	    py1 = valueLookup (boost::get<string> (operands.at (1)) + "s", "py", false),
+	    pz1 = valueLookup (boost::get<string> (operands.at (1)) + "s", "pz", false);
 	  double cosAlpha = (px0*px1 + py0*py1 + pz0*pz1)/(sqrt(px0*px0 + py0*py0 + pz0*pz0)*sqrt(px1*px1 + py1*py1 + pz1*pz1));
 
 	  return cosAlpha;
@@ -850,7 +886,7 @@ ValueLookupTree::evaluateOperator (const string &op, const vector<Leaf> &operand
       else if (op == "number")
         return getCollectionSize (boost::get<string> (operands.at (0)) + "s");
       else if (op == ".")
-        return valueLookup (boost::get<string> (operands.at (0)) + "s", objs, boost::get<string> (operands.at (1)));
+        return valueLookup (boost::get<string> (operands.at (0)) + "s", boost::get<string> (operands.at (1)));
     }
   catch (...)
     {
@@ -867,6 +903,762 @@ ValueLookupTree::evaluateOperator (const string &op, const vector<Leaf> &operand
   return INVALID_VALUE;
 }
 
+void
+ValueLookupTree::compile ()
+{
+  //////////////////////////////////////////////////////////////////////////////
+  // Lowers the pruned tree into a flat program in postfix order. If any part
+  // of the tree cannot be compiled, the program is discarded and evaluate()
+  // falls back to walking the tree, so that errors are reported exactly as
+  // before.
+  //////////////////////////////////////////////////////////////////////////////
+  program_.clear ();
+  memberSlots_.clear ();
+  collectionsResolved_ = false;
+  subexpressionsToRegister_.clear ();
+  cacheSubexpressions_ = (inputCollections_.size () == 1
+                       && inputCollections_.at (0) != "uservariables"
+                       && inputCollections_.at (0) != "eventvariables");
+  if (cacheSubexpressions_)
+    cacheCollection_ = ValueLookupCache::getCollectionKey (inputCollections_.at (0));
+  compiled_ = (root_ && compile_ (root_));
+  if (!compiled_)
+    {
+      program_.clear ();
+      memberSlots_.clear ();
+      subexpressionsToRegister_.clear ();
+    }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Subexpressions are only given keys once the whole tree has been compiled,
+  // so that programs which are discarded do not take any. Their uses are
+  // counted by the cache of the collections given to the tree.
+  //////////////////////////////////////////////////////////////////////////////
+  for (const auto &subexpression : subexpressionsToRegister_)
+    {
+      const ValueLookupCache::Subexpression *registered = ValueLookupCache::registerSubexpression (subexpression.second);
+      program_.at (subexpression.first).subexpression = registered;
+      program_.at (program_.at (subexpression.first).target).subexpression = registered;
+    }
+  subexpressionsToRegister_.clear ();
+  //////////////////////////////////////////////////////////////////////////////
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Programs which only read members of a single input collection can be run
+  // over the whole collection at once by evaluateColumns(). User-defined
+  // variables are copied out of the event for each object, so they always use
+  // the scalar path.
+  //////////////////////////////////////////////////////////////////////////////
+  columnar_ = (compiled_
+            && inputCollections_.size () == 1
+            && inputCollections_.at (0) != "uservariables"
+            && inputCollections_.at (0) != "eventvariables");
+  for (const auto &instruction : program_)
+    {
+      if (instruction.opcode == OP_NUMBER || instruction.opcode == OP_CACHE_LOAD || instruction.opcode == OP_CACHE_STORE)
+        continue;
+      for (const auto &slot : instruction.slots)
+        columnar_ = columnar_ && (memberSlots_.at (slot).collection == inputCollections_.at (0));
+    }
+  //////////////////////////////////////////////////////////////////////////////
+
+  if (verbose_)
+    cout << "ValueLookupTree::compile " << (compiled_ ? "compiled " : "could not compile ") << printNode (root_)
+         << " into " << program_.size () << " instructions" << (columnar_ ? " (columnar)" : "") << endl;
+  //////////////////////////////////////////////////////////////////////////////
+}
+
+bool
+ValueLookupTree::compile_ (const Node * const tree)
+{
+  Instruction instruction;
+  instruction.nOperands = 0;
+  instruction.constant = 0.0;
+  instruction.subexpression = NULL;
+  instruction.target = 0;
+
+  //////////////////////////////////////////////////////////////////////////////
+  // The node is a leaf, so it is either a number, which is parsed now, or a
+  // variable of the single input collection. Collection names are only valid
+  // as the operands of the operators handled by compileCollectionOperator().
+  //////////////////////////////////////////////////////////////////////////////
+  if (tree->branches.empty ())
+    {
+      double value;
+      if (isnumber (tree->value, value))
+        {
+          instruction.opcode = OP_CONSTANT;
+          instruction.constant = value;
+        }
+      else if (isCollectionLeaf (tree) || inputCollections_.size () != 1)
+        return false;
+      else
+        {
+          instruction.opcode = OP_LOOKUP;
+          instruction.slots.push_back (addMemberSlot (inputCollections_.at (0), tree->value, true));
+        }
+      program_.push_back (instruction);
+      return true;
+    }
+  //////////////////////////////////////////////////////////////////////////////
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Operators which act on collections rather than on numbers.
+  //////////////////////////////////////////////////////////////////////////////
+  if (compileCollectionOperator (tree, instruction))
+    {
+      program_.push_back (instruction);
+      return true;
+    }
+  //////////////////////////////////////////////////////////////////////////////
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Otherwise, compile each of the daughters in order and then append the
+  // operator which acts on them. For single-collection programs, the
+  // instructions are bracketed by CACHE_LOAD and CACHE_STORE so that the
+  // value of this subexpression can be shared with other trees.
+  //////////////////////////////////////////////////////////////////////////////
+  const bool cacheThis = (cacheSubexpressions_ && hasLookup (tree));
+  const unsigned load = program_.size ();
+  if (cacheThis)
+    {
+      Instruction cacheLoad = instruction;
+      cacheLoad.opcode = OP_CACHE_LOAD;
+      program_.push_back (cacheLoad);
+    }
+  for (const auto &branch : tree->branches)
+    {
+      if (!compile_ (branch))
+        return false;
+    }
+  instruction.nOperands = tree->branches.size ();
+  if (!getOpcode (tree->value, instruction.nOperands, instruction.opcode))
+    return false;
+  program_.push_back (instruction);
+  if (cacheThis)
+    {
+      Instruction cacheStore = program_.at (load);
+      cacheStore.opcode = OP_CACHE_STORE;
+      program_.at (load).target = program_.size ();
+      program_.push_back (cacheStore);
+      subexpressionsToRegister_.push_back (make_pair (load, inputCollections_.at (0) + ":" + canonicalForm (tree)));
+    }
+  return true;
+  //////////////////////////////////////////////////////////////////////////////
+}
+
+bool
+ValueLookupTree::compileCollectionOperator (const Node * const tree, Instruction &instruction)
+{
+  //////////////////////////////////////////////////////////////////////////////
+  // Returns false if the node is not one of the operators which take
+  // collection names as operands, or if its operands are not all collection
+  // names. The member slots are added in the same order in which
+  // evaluateOperator() looks them up.
+  //////////////////////////////////////////////////////////////////////////////
+  const string &op = tree->value;
+  unsigned nRequired;
+  if (op == "deltaPhi" || op == "compositePhi" || op == "deltaR" || op == "transMass" || op == "cosAlpha" || op == ".")
+    nRequired = 2;
+  else if (op == "number")
+    nRequired = 1;
+  else if (op == "invMass" || op == "pT")
+    nRequired = tree->branches.size ();
+  else
+    return false;
+
+  if (tree->branches.size () != nRequired)
+    return false;
+  for (const auto &branch : tree->branches)
+    {
+      if (!isCollectionLeaf (branch))
+        return false;
+    }
+
+  vector<string> collections;
+  for (const auto &branch : tree->branches)
+    collections.push_back (branch->value + "s");
+
+  if (op == "deltaPhi")
+    {
+      instruction.opcode = OP_DELTA_PHI;
+      instruction.slots.push_back (addMemberSlot (collections.at (0), "phi", true));
+      instruction.slots.push_back (addMemberSlot (collections.at (1), "phi", true));
+    }
+  else if (op == "compositePhi")
+    {
+      instruction.opcode = OP_COMPOSITE_PHI;
+      for (const auto &collection : collections)
+        {
+          instruction.slots.push_back (addMemberSlot (collection, "px", true));
+          instruction.slots.push_back (addMemberSlot (collection, "py", false));
+        }
+    }
+  else if (op == "deltaR")
+    {
+      instruction.opcode = OP_DELTA_R;
+      for (const auto &collection : collections)
+        {
+          instruction.slots.push_back (addMemberSlot (collection, "eta", true));
+          instruction.slots.push_back (addMemberSlot (collection, "phi", false));
+        }
+    }
+  else if (op == "invMass")
+    {
+      // As the track collection does not have measured energy associated to
+      // it, we assume tracks are massless while calculating invariant mass.
+      instruction.opcode = OP_INV_MASS;
+      for (const auto &collection : collections)
+        {
+          instruction.slots.push_back (addMemberSlot (collection, (collection == "tracks" ? "p" : "energy"), true));
+          instruction.slots.push_back (addMemberSlot (collection, "px", false));
+          instruction.slots.push_back (addMemberSlot (collection, "py", false));
+          instruction.slots.push_back (addMemberSlot (collection, "pz", false));
+        }
+    }
+  else if (op == "transMass")
+    {
+      instruction.opcode = OP_TRANS_MASS;
+      for (const auto &collection : collections)
+        {
+          instruction.slots.push_back (addMemberSlot (collection, "pt", true));
+          instruction.slots.push_back (addMemberSlot (collection, "phi", false));
+        }
+    }
+  else if (op == "pT")
+    {
+      instruction.opcode = OP_PT;
+      for (const auto &collection : collections)
+        {
+          instruction.slots.push_back (addMemberSlot (collection, "px", true));
+          instruction.slots.push_back (addMemberSlot (collection, "py", false));
+        }
+    }
+  else if (op == "cosAlpha")
+    {
+      instruction.opcode = OP_COS_ALPHA;
+      for (const auto &collection : collections)
+        {
+          instruction.slots.push_back (addMemberSlot (collection, "px", true));
+          instruction.slots.push_back (addMemberSlot (collection, "py", false));
+          instruction.slots.push_back (addMemberSlot (collection, "pz", false));
+        }
+    }
+  else if (op == "number")
+    {
+      instruction.opcode = OP_NUMBER;
+      instruction.slots.push_back (addMemberSlot (collections.at (0), "", false));
+    }
+  else if (op == ".")
+    {
+      instruction.opcode = OP_MEMBER;
+      instruction.slots.push_back (addMemberSlot (collections.at (0), tree->branches.at (1)->value, true));
+    }
+
+  return true;
+  //////////////////////////////////////////////////////////////////////////////
+}
+
+bool
+ValueLookupTree::getOpcode (const string &op, const unsigned nOperands, Opcode &opcode) const
+{
+  //////////////////////////////////////////////////////////////////////////////
+  // Translates a numeric operator into its opcode, returning false if the
+  // operator is not recognized or does not have enough operands.
+  //////////////////////////////////////////////////////////////////////////////
+  if (nOperands >= 2)
+    {
+      if      (op == "||" || op == "|")   opcode = OP_OR;
+      else if (op == "&&" || op == "&")   opcode = OP_AND;
+      else if (op == "==" || op == "=")   opcode = OP_EQ;
+      else if (op == "!=")                opcode = OP_NE;
+      else if (op == "<")                 opcode = OP_LT;
+      else if (op == "<=")                opcode = OP_LE;
+      else if (op == ">")                 opcode = OP_GT;
+      else if (op == ">=")                opcode = OP_GE;
+      else if (op == "+")                 opcode = OP_ADD;
+      else if (op == "-")                 opcode = OP_SUB;
+      else if (op == "*")                 opcode = OP_MUL;
+      else if (op == "/")                 opcode = OP_DIV;
+      else if (op == "%")                 opcode = OP_MOD;
+      else if (op == "atan2")             opcode = OP_ATAN2;
+      else if (op == "ldexp")             opcode = OP_LDEXP;
+      else if (op == "pow")               opcode = OP_POW;
+      else if (op == "hypot")             opcode = OP_HYPOT;
+      else if (op == "fmod")              opcode = OP_FMOD;
+      else if (op == "remainder")         opcode = OP_REMAINDER;
+      else if (op == "copysign")          opcode = OP_COPYSIGN;
+      else if (op == "nextafter")         opcode = OP_NEXTAFTER;
+      else if (op == "fdim")              opcode = OP_FDIM;
+      else if (op == "fmax" || op == "max")  opcode = OP_FMAX;
+      else if (op == "fmin" || op == "min")  opcode = OP_FMIN;
+      else if (op == "dPhi")              opcode = OP_DPHI;
+      else
+        return false;
+      return true;
+    }
+  if (nOperands == 1)
+    {
+      if      (op == "+")                 opcode = OP_POS;
+      else if (op == "-")                 opcode = OP_NEG;
+      else if (op == "!")                 opcode = OP_NOT;
+      else if (op == "cos")               opcode = OP_COS;
+      else if (op == "sin")               opcode = OP_SIN;
+      else if (op == "tan")               opcode = OP_TAN;
+      else if (op == "acos")              opcode = OP_ACOS;
+      else if (op == "asin")              opcode = OP_ASIN;
+      else if (op == "atan")              opcode = OP_ATAN;
+      else if (op == "cosh")              opcode = OP_COSH;
+      else if (op == "sinh")              opcode = OP_SINH;
+      else if (op == "tanh")              opcode = OP_TANH;
+      else if (op == "acosh")             opcode = OP_ACOSH;
+      else if (op == "asinh")             opcode = OP_ASINH;
+      else if (op == "atanh")             opcode = OP_ATANH;
+      else if (op == "exp")               opcode = OP_EXP;
+      else if (op == "log")               opcode = OP_LOG;
+      else if (op == "log10")             opcode = OP_LOG10;
+      else if (op == "exp2")              opcode = OP_EXP2;
+      else if (op == "expm1")             opcode = OP_EXPM1;
+      else if (op == "ilogb")             opcode = OP_ILOGB;
+      else if (op == "log1p")             opcode = OP_LOG1P;
+      else if (op == "log2")              opcode = OP_LOG2;
+      else if (op == "logb")              opcode = OP_LOGB;
+      else if (op == "sqrt")              opcode = OP_SQRT;
+      else if (op == "cbrt")              opcode = OP_CBRT;
+      else if (op == "erf")               opcode = OP_ERF;
+      else if (op == "erfc")              opcode = OP_ERFC;
+      else if (op == "tgamma")            opcode = OP_TGAMMA;
+      else if (op == "lgamma")            opcode = OP_LGAMMA;
+      else if (op == "ceil")              opcode = OP_CEIL;
+      else if (op == "floor")             opcode = OP_FLOOR;
+      else if (op == "trunc")             opcode = OP_TRUNC;
+      else if (op == "round")             opcode = OP_ROUND;
+      else if (op == "rint")              opcode = OP_RINT;
+      else if (op == "nearbyint")         opcode = OP_NEARBYINT;
+      else if (op == "abs" || op == "fabs")  opcode = OP_FABS;
+      else if (op == "normalizedPhi")     opcode = OP_NORMALIZED_PHI;
+      else
+        return false;
+      return true;
+    }
+  return false;
+  //////////////////////////////////////////////////////////////////////////////
+}
+
+bool
+ValueLookupTree::isCollectionLeaf (const Node * const tree) const
+{
+  // Mirrors the check in evaluate_() for leaves which evaluate to strings.
+  double value;
+  return (tree->branches.empty ()
+       && !isnumber (tree->value, value)
+       && (isCollection (tree->value + "s") || (tree->parent && tree->parent->value == ".")));
+}
+
+bool
+ValueLookupTree::hasLookup (const Node * const tree) const
+{
+  // Returns true if any leaf of the tree is something other than a number.
+  double value;
+  if (tree->branches.empty ())
+    return !isnumber (tree->value, value);
+  for (const auto &branch : tree->branches)
+    {
+      if (hasLookup (branch))
+        return true;
+    }
+  return false;
+}
+
+string
+ValueLookupTree::canonicalForm (const Node * const tree) const
+{
+  // Returns a string which is the same for any two identical trees, e.g.,
+  // "<(abs(eta),2.5)" for "abs(eta) < 2.5".
+  if (tree->branches.empty ())
+    return tree->value;
+  string expression = tree->value + "(";
+  for (auto branch = tree->branches.begin (); branch != tree->branches.end (); branch++)
+    expression += (branch == tree->branches.begin () ? "" : ",") + canonicalForm (*branch);
+  return expression + ")";
+}
+
+// Event variables are resolved to slots when the trees using them are built.
+// A producer may only declare a variable the first time it sets it, so one
+// which has not been declared yet is resolved again when it is looked up, and
+// gives INVALID_VALUE until then.
+static int
+declaredEventVariable (const string &collection, const string &variable)
+{
+  if (collection != "eventvariables" || variable == "")
+    return -1;
+  return EventVariableRegistry::instance ().find (variable);
+}
+
+unsigned
+ValueLookupTree::addMemberSlot (const string &collection, const string &variable, const bool iterateObj)
+{
+  memberSlots_.push_back ({collection, variable, iterateObj, anatools::MemberAccessor (), 0, 0, firstComponent (collection), declaredEventVariable (collection, variable)});
+  return (memberSlots_.size () - 1);
+}
+
+double
+ValueLookupTree::execute ()
+{
+  //////////////////////////////////////////////////////////////////////////////
+  // Runs the compiled program for the given objects. Each instruction first
+  // looks up its member slots, in the same order as evaluateOperator() would,
+  // then replaces its operands on the top of the stack with its result. As in
+  // evaluateOperator(), an invalid operand makes the result invalid.
+  //////////////////////////////////////////////////////////////////////////////
+  ValueLookupCache &cache = handles_->cache;
+  const unsigned index = (localIndices_.empty () ? 0 : localIndices_[0]);
+
+  stack_.clear ();
+  for (unsigned pc = 0; pc < program_.size (); pc++)
+    {
+      const Instruction &instruction = program_[pc];
+
+      //////////////////////////////////////////////////////////////////////////
+      // Subexpressions which appear in more than one tree are retrieved from,
+      // or saved to, the cache.
+      //////////////////////////////////////////////////////////////////////////
+      if (instruction.opcode == OP_CACHE_LOAD)
+        {
+          double value;
+          if (cache.isShared (instruction.subexpression) && cache.getSubexpression (cacheCollection_, instruction.subexpression, index, value))
+            {
+              stack_.push_back (value);
+              pc = instruction.target;
+            }
+          continue;
+        }
+      if (instruction.opcode == OP_CACHE_STORE)
+        {
+          if (cache.isShared (instruction.subexpression))
+            cache.setSubexpression (cacheCollection_, instruction.subexpression, index, stack_.back ());
+          continue;
+        }
+      //////////////////////////////////////////////////////////////////////////
+
+      slotValues_.clear ();
+      if (instruction.opcode != OP_NUMBER)
+        {
+          for (const auto &slot : instruction.slots)
+            {
+              MemberSlot &member = memberSlots_[slot];
+              slotValues_.push_back (valueLookup (member, member.iterateObj));
+            }
+        }
+
+      const double *x = stack_.data () + stack_.size () - instruction.nOperands;
+      const double *s = slotValues_.data ();
+      bool isInvalid = false;
+      for (unsigned i = 0; i < instruction.nOperands; i++)
+        isInvalid = isInvalid || IS_INVALID(x[i]);
+
+      double result = INVALID_VALUE;
+      if (!isInvalid)
+        result = applyInstruction (instruction, x, s, slotValues_.size ());
+      stack_.resize (stack_.size () - instruction.nOperands);
+      stack_.push_back (result);
+    }
+
+  return (stack_.empty () ? INVALID_VALUE : stack_.back ());
+  //////////////////////////////////////////////////////////////////////////////
+}
+
+double
+ValueLookupTree::applyInstruction (const Instruction &instruction, const double * const x, const double * const s, const unsigned nSlots) const
+{
+  //////////////////////////////////////////////////////////////////////////////
+  // Returns the result of a single instruction, given its operands, x, and the
+  // values of its member slots, s. The operands are assumed to be valid.
+  //////////////////////////////////////////////////////////////////////////////
+  switch (instruction.opcode)
+    {
+      case OP_CONSTANT:        return instruction.constant;
+      case OP_LOOKUP:          return s[0];
+      case OP_OR:              return (x[0] || x[1]);
+      case OP_AND:             return (x[0] && x[1]);
+      case OP_EQ:              return (x[0] == x[1]);
+      case OP_NE:              return (x[0] != x[1]);
+      case OP_LT:              return (x[0] < x[1]);
+      case OP_LE:              return (x[0] <= x[1]);
+      case OP_GT:              return (x[0] > x[1]);
+      case OP_GE:              return (x[0] >= x[1]);
+      case OP_ADD:             return (x[0] + x[1]);
+      case OP_SUB:             return (x[0] - x[1]);
+      case OP_MUL:             return (x[0] * x[1]);
+      case OP_DIV:             return (x[0] / x[1]);
+      case OP_MOD:             return ((int) x[0] % (int) x[1]);
+      case OP_POS:             return +x[0];
+      case OP_NEG:             return -x[0];
+      case OP_NOT:             return !x[0];
+      case OP_ATAN2:           return atan2 (x[0], x[1]);
+      case OP_LDEXP:           return ldexp (x[0], x[1]);
+      case OP_POW:             return pow (x[0], x[1]);
+      case OP_HYPOT:           return hypot (x[0], x[1]);
+      case OP_FMOD:            return fmod (x[0], x[1]);
+      case OP_REMAINDER:       return remainder (x[0], x[1]);
+      case OP_COPYSIGN:        return copysign (x[0], x[1]);
+      case OP_NEXTAFTER:       return nextafter (x[0], x[1]);
+      case OP_FDIM:            return fdim (x[0], x[1]);
+      case OP_FMAX:            return fmax (x[0], x[1]);
+      case OP_FMIN:            return fmin (x[0], x[1]);
+      case OP_COS:             return cos (x[0]);
+      case OP_SIN:             return sin (x[0]);
+      case OP_TAN:             return tan (x[0]);
+      case OP_ACOS:            return acos (x[0]);
+      case OP_ASIN:            return asin (x[0]);
+      case OP_ATAN:            return atan (x[0]);
+      case OP_COSH:            return cosh (x[0]);
+      case OP_SINH:            return sinh (x[0]);
+      case OP_TANH:            return tanh (x[0]);
+      case OP_ACOSH:           return acosh (x[0]);
+      case OP_ASINH:           return asinh (x[0]);
+      case OP_ATANH:           return atanh (x[0]);
+      case OP_EXP:             return exp (x[0]);
+      case OP_LOG:             return log (x[0]);
+      case OP_LOG10:           return log10 (x[0]);
+      case OP_EXP2:            return exp2 (x[0]);
+      case OP_EXPM1:           return expm1 (x[0]);
+      case OP_ILOGB:           return ilogb (x[0]);
+      case OP_LOG1P:           return log1p (x[0]);
+      case OP_LOG2:            return log2 (x[0]);
+      case OP_LOGB:            return logb (x[0]);
+      case OP_SQRT:            return sqrt (x[0]);
+      case OP_CBRT:            return cbrt (x[0]);
+      case OP_ERF:             return erf (x[0]);
+      case OP_ERFC:            return erfc (x[0]);
+      case OP_TGAMMA:          return tgamma (x[0]);
+      case OP_LGAMMA:          return lgamma (x[0]);
+      case OP_CEIL:            return ceil (x[0]);
+      case OP_FLOOR:           return floor (x[0]);
+      case OP_TRUNC:           return trunc (x[0]);
+      case OP_ROUND:           return round (x[0]);
+      case OP_RINT:            return rint (x[0]);
+      case OP_NEARBYINT:       return nearbyint (x[0]);
+      case OP_FABS:            return fabs (x[0]);
+      case OP_DPHI:            return deltaPhi (x[0], x[1]);
+      case OP_NORMALIZED_PHI:  return normalizedPhi (x[0]);
+      case OP_DELTA_PHI:       return deltaPhi (s[0], s[1]);
+      case OP_COMPOSITE_PHI:
+        {
+          double phi = acos ((s[0] + s[2]) / hypot (s[0] + s[2], s[1] + s[3]));
+          if ((s[1] + s[3]) < 0.0)
+            phi *= -1.0;
+          return normalizedPhi (phi);
+        }
+      case OP_DELTA_R:         return deltaR (s[0], s[1], s[2], s[3]);
+      case OP_INV_MASS:
+        {
+          double energy = 0.0, px = 0.0, py = 0.0, pz = 0.0;
+          for (unsigned i = 0; i + 3 < nSlots; i += 4)
+            {
+              energy += s[i];
+              px += s[i + 1];
+              py += s[i + 2];
+              pz += s[i + 3];
+            }
+          return sqrt (energy * energy - px * px - py * py - pz * pz);
+        }
+      case OP_TRANS_MASS:      return sqrt (2.0 * s[0] * s[2] * (1 - cos (deltaPhi (s[1], s[3]))));
+      case OP_PT:
+        {
+          double px = 0.0, py = 0.0;
+          for (unsigned i = 0; i + 1 < nSlots; i += 2)
+            {
+              px += s[i];
+              py += s[i + 1];
+            }
+          return hypot (px, py);
+        }
+      case OP_COS_ALPHA:
+        return (s[0] * s[3] + s[1] * s[4] + s[2] * s[5]) / (sqrt (s[0] * s[0] + s[1] * s[1] + s[2] * s[2]) * sqrt (s[3] * s[3] + s[4] * s[4] + s[5] * s[5]));
+      case OP_NUMBER:          return getCollectionSize (memberSlots_[instruction.slots.at (0)].collection);
+      case OP_MEMBER:          return s[0];
+      case OP_CACHE_LOAD:
+      case OP_CACHE_STORE:     break;
+    }
+
+  return INVALID_VALUE;
+  //////////////////////////////////////////////////////////////////////////////
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Helpers for evaluateColumns(), which apply an operator to whole columns.
+// They are kept free of branches so that the loops can be vectorized; as in
+// execute(), an invalid operand makes the result invalid.
+////////////////////////////////////////////////////////////////////////////////
+template<class F> static inline void
+applyUnary (const double * const x0, double * const r, const unsigned n, F f)
+{
+  for (unsigned i = 0; i < n; i++)
+    r[i] = IS_INVALID(x0[i]) ? INVALID_VALUE : f (x0[i]);
+}
+
+template<class F> static inline void
+applyBinary (const double * const x0, const double * const x1, double * const r, const unsigned n, F f)
+{
+  for (unsigned i = 0; i < n; i++)
+    r[i] = (IS_INVALID(x0[i]) | IS_INVALID(x1[i])) ? INVALID_VALUE : f (x0[i], x1[i]);
+}
+
+// Returns false if the operator is not one which is applied column-at-a-time.
+static bool
+applyColumnOperator (const Opcode opcode, const unsigned nOperands, const double * const x0, const double * const x1, double * const r, const unsigned n)
+{
+  if (nOperands == 2)
+    {
+      switch (opcode)
+        {
+          case OP_OR:   applyBinary (x0, x1, r, n, [] (double a, double b) -> double { return (a || b); });  return true;
+          case OP_AND:  applyBinary (x0, x1, r, n, [] (double a, double b) -> double { return (a && b); });  return true;
+          case OP_EQ:   applyBinary (x0, x1, r, n, [] (double a, double b) -> double { return (a == b); });  return true;
+          case OP_NE:   applyBinary (x0, x1, r, n, [] (double a, double b) -> double { return (a != b); });  return true;
+          case OP_LT:   applyBinary (x0, x1, r, n, [] (double a, double b) -> double { return (a < b); });   return true;
+          case OP_LE:   applyBinary (x0, x1, r, n, [] (double a, double b) -> double { return (a <= b); });  return true;
+          case OP_GT:   applyBinary (x0, x1, r, n, [] (double a, double b) -> double { return (a > b); });   return true;
+          case OP_GE:   applyBinary (x0, x1, r, n, [] (double a, double b) -> double { return (a >= b); });  return true;
+          case OP_ADD:  applyBinary (x0, x1, r, n, [] (double a, double b) -> double { return (a + b); });   return true;
+          case OP_SUB:  applyBinary (x0, x1, r, n, [] (double a, double b) -> double { return (a - b); });   return true;
+          case OP_MUL:  applyBinary (x0, x1, r, n, [] (double a, double b) -> double { return (a * b); });   return true;
+          case OP_DIV:  applyBinary (x0, x1, r, n, [] (double a, double b) -> double { return (a / b); });   return true;
+          default:      return false;
+        }
+    }
+  if (nOperands == 1)
+    {
+      switch (opcode)
+        {
+          case OP_POS:   applyUnary (x0, r, n, [] (double a) -> double { return +a; });        return true;
+          case OP_NEG:   applyUnary (x0, r, n, [] (double a) -> double { return -a; });        return true;
+          case OP_NOT:   applyUnary (x0, r, n, [] (double a) -> double { return !a; });        return true;
+          case OP_FABS:  applyUnary (x0, r, n, [] (double a) -> double { return fabs (a); });  return true;
+          default:       return false;
+        }
+    }
+  return false;
+}
+////////////////////////////////////////////////////////////////////////////////
+
+void
+ValueLookupTree::evaluateColumns ()
+{
+  //////////////////////////////////////////////////////////////////////////////
+  // Runs the compiled program once for the whole input collection. Each member
+  // slot is gathered into a contiguous column of doubles, and each instruction
+  // replaces its operand columns on the top of the stack with a result column.
+  // The results are identical to running execute() for each object in turn.
+  //////////////////////////////////////////////////////////////////////////////
+  const string &collection = inputCollections_.at (0);
+  const unsigned n = collectionSizes_.at (0);
+
+  objects_.resize (n);
+  for (unsigned i = 0; i < n; i++)
+    objects_[i] = getObject (collection, i);
+
+  ValueLookupCache &cache = handles_->cache;
+  unsigned depth = 0;
+  for (unsigned pc = 0; pc < program_.size (); pc++)
+    {
+      const Instruction &instruction = program_[pc];
+
+      //////////////////////////////////////////////////////////////////////////
+      // Shared subexpressions are only taken from the cache if they have been
+      // computed for every object in the collection.
+      //////////////////////////////////////////////////////////////////////////
+      if (instruction.opcode == OP_CACHE_LOAD)
+        {
+          if (cache.isShared (instruction.subexpression))
+            {
+              resultColumn_.resize (n);
+              bool allFound = true;
+              for (unsigned i = 0; allFound && i < n; i++)
+                allFound = cache.getSubexpression (cacheCollection_, instruction.subexpression, i, resultColumn_[i]);
+              if (allFound)
+                {
+                  if (columns_.size () < depth + 1)
+                    columns_.resize (depth + 1);
+                  columns_[depth++].swap (resultColumn_);
+                  pc = instruction.target;
+                }
+            }
+          continue;
+        }
+      if (instruction.opcode == OP_CACHE_STORE)
+        {
+          if (cache.isShared (instruction.subexpression))
+            {
+              for (unsigned i = 0; i < n; i++)
+                cache.setSubexpression (cacheCollection_, instruction.subexpression, i, columns_[depth - 1][i]);
+            }
+          continue;
+        }
+      //////////////////////////////////////////////////////////////////////////
+
+      //////////////////////////////////////////////////////////////////////////
+      // Gather the member slots of this instruction.
+      //////////////////////////////////////////////////////////////////////////
+      const unsigned nSlots = (instruction.opcode == OP_NUMBER ? 0 : instruction.slots.size ());
+      if (slotColumns_.size () < nSlots)
+        slotColumns_.resize (nSlots);
+      for (unsigned j = 0; j < nSlots; j++)
+        {
+          MemberSlot &member = memberSlots_[instruction.slots[j]];
+          vector<double> &column = slotColumns_[j];
+          column.resize (n);
+          for (unsigned i = 0; i < n; i++)
+            column[i] = memberValue (member, objects_[i], i);
+        }
+      //////////////////////////////////////////////////////////////////////////
+
+      const unsigned first = depth - instruction.nOperands;
+      if (columns_.size () < first + max (instruction.nOperands, 1u))
+        columns_.resize (first + max (instruction.nOperands, 1u));
+      const double *x0 = (instruction.nOperands > 0 ? columns_[first].data () : NULL),
+                   *x1 = (instruction.nOperands > 1 ? columns_[first + 1].data () : NULL);
+      resultColumn_.resize (n);
+      double *r = resultColumn_.data ();
+
+      //////////////////////////////////////////////////////////////////////////
+      // The most common operators are applied column-at-a-time. Everything
+      // else is applied one object at a time with applyInstruction().
+      //////////////////////////////////////////////////////////////////////////
+      if (instruction.opcode == OP_CONSTANT)
+        resultColumn_.assign (n, instruction.constant);
+      else if (instruction.opcode == OP_LOOKUP || instruction.opcode == OP_MEMBER)
+        resultColumn_ = slotColumns_.at (0);
+      else if (!applyColumnOperator (instruction.opcode, instruction.nOperands, x0, x1, r, n))
+        {
+          stack_.resize (instruction.nOperands);
+          slotValues_.resize (nSlots);
+          for (unsigned i = 0; i < n; i++)
+            {
+              bool isInvalid = false;
+              for (unsigned j = 0; j < instruction.nOperands; j++)
+                {
+                  stack_[j] = columns_[first + j][i];
+                  isInvalid = isInvalid || IS_INVALID(stack_[j]);
+                }
+              for (unsigned j = 0; j < nSlots; j++)
+                slotValues_[j] = slotColumns_[j][i];
+              r[i] = (isInvalid ? INVALID_VALUE : applyInstruction (instruction, stack_.data (), slotValues_.data (), nSlots));
+            }
+        }
+      //////////////////////////////////////////////////////////////////////////
+
+      columns_[first].swap (resultColumn_);
+      depth = first + 1;
+    }
+
+  values_.reserve (n);
+  for (unsigned i = 0; i < n; i++)
+    values_.push_back (depth ? columns_[0][i] : INVALID_VALUE);
+  //////////////////////////////////////////////////////////////////////////////
+}
+
 void *
 ValueLookupTree::getObject (const string &name, const unsigned i)
 {
@@ -916,24 +1708,12 @@ ValueLookupTree::getObject (const string &name, const unsigned i)
     return ((void *) &handles_->secondaryTracks->at (i));
   else if (EQ_VALID(name,pileupinfos))
     return ((void *) &handles_->pileupinfos->at (i));
+  // The values of both are read from the merged handles_->variables, so these
+  // only serve to mark which component of a combination they belong to.
   else if (EQ_VALID(name,uservariables))
-    {
-      //!!!
-      osu::Uservariable *obj = new osu::Uservariable ();
-      for (const auto &handle : handles_->uservariables)
-        obj->insert (handle->begin (), handle->end ());
-      uservariablesToDelete_.push_back (obj);
-      return obj;
-    }
+    return ((void *) &handles_->uservariables);
   else if (EQ_VALID(name,eventvariables))
-    {
-      //!!!
-      osu::Eventvariable *obj = new osu::Eventvariable ();
-      for (const auto &handle : handles_->eventvariables)
-        obj->insert (handle->begin (), handle->end ());
-      eventvariablesToDelete_.push_back (obj);
-      return obj;
-    }
+    return ((void *) &handles_->eventvariables);
   return NULL;
 }
 
@@ -1195,36 +1975,47 @@ ValueLookupTree::vetoMatch (const string &s, const string &target, const size_t
 }
 
 bool
-ValueLookupTree::isUniqueCase (const ObjMap &objs, const unordered_set<string> &keys) const
+ValueLookupTree::isUniqueCase () const
 {
   //////////////////////////////////////////////////////////////////////////////
   // Returns true only if the given objects are unique and in a specific order.
-  // This is to avoid double counting.
+  // This is to avoid double counting. Components from the same collection are
+  // adjacent, so it is enough to compare each with the one before it.
   //////////////////////////////////////////////////////////////////////////////
-  bool pass = true;
-
-  for (const auto &key : keys)
+  for (unsigned j = 1; j < localIndices_.size (); j++)
     {
-      if (objs.count (key) <= 1)
-        continue;
-      else
-        {
-          auto range = objs.equal_range (key);
-          vector<pair<string, DressedObject> > objsOfThisType (range.first, range.second);
-          sort (objsOfThisType.begin (), objsOfThisType.end (), anatools::collectionIndexAscending);
-          int previousLocalIndex = -1;
-          for (const auto &obj : objsOfThisType)
-            {
-              pass = pass && ((int) obj.second.localIndex > previousLocalIndex);
-              previousLocalIndex = obj.second.localIndex;
-            }
-        }
+      if (firstComponents_[j] != j && localIndices_[j] <= localIndices_[j - 1])
+        return false;
     }
 
-  return pass;
+  return true;
+  //////////////////////////////////////////////////////////////////////////////
+}
+
+void
+ValueLookupTree::setComponents ()
+{
+  //////////////////////////////////////////////////////////////////////////////
+  // Identifies each component by the first component from the same collection
+  // and sizes the vectors describing the current combination.
+  //////////////////////////////////////////////////////////////////////////////
+  firstComponents_.clear ();
+  for (unsigned j = 0; j < inputCollections_.size (); j++)
+    firstComponents_.push_back ((j > 0 && inputCollections_.at (j) == inputCollections_.at (j - 1)) ? firstComponents_.at (j - 1) : j);
+  collectionObjects_.assign (inputCollections_.size (), vector<void *> ());
+  localIndices_.assign (inputCollections_.size (), 0);
+  componentObjects_.assign (inputCollections_.size (), NULL);
+  currentComponents_.assign (inputCollections_.size (), -1);
   //////////////////////////////////////////////////////////////////////////////
 }
 
+int
+ValueLookupTree::firstComponent (const string &collection) const
+{
+  auto component = find (inputCollections_.begin (), inputCollections_.end (), collection);
+  return (component != inputCollections_.end () ? component - inputCollections_.begin () : -1);
+}
+
 bool
 ValueLookupTree::insertBinaryInfixOperator (const string &s, Node * const tree, const vector<string> &operators, const vector<string> &vetoOperators) const
 {
@@ -1365,25 +2156,84 @@ ValueLookupTree::insertParentheses (const string &s, Node * const tree) const
 }
 
 double
-ValueLookupTree::valueLookup (const string &collection, const ObjMap &objs, const string &variable, const bool iterateObj)
+ValueLookupTree::valueLookup (const string &collection, const string &variable, const bool iterateObj)
 {
-  if (!objIterators_.count (collection))
+  MemberSlot &slot = lookupSlots_[make_pair (collection, variable)];
+  if (slot.collection.empty ())
     {
-      auto range = objs.equal_range (collection);
-      objIterators_[collection] = range.first;
-      shouldIterate_[collection] = (objs.count (collection) > 1);
+      slot.collection = collection;
+      slot.variable = variable;
+      slot.component = firstComponent (collection);
+      slot.variableSlot = declaredEventVariable (collection, variable);
     }
-  else if (shouldIterate_.at (collection) && iterateObj)
-    objIterators_.at (collection)++;
-  void *obj = objIterators_.at (collection)->second.addr;
+  return valueLookup (slot, iterateObj);
+}
+
+double
+ValueLookupTree::valueLookup (MemberSlot &slot, const bool iterateObj)
+{
+  //////////////////////////////////////////////////////////////////////////////
+  // The first lookup in a collection uses its first component, and each
+  // subsequent lookup which iterates moves on to the next component from the
+  // same collection, if there is one.
+  //////////////////////////////////////////////////////////////////////////////
+  if (slot.component < 0)
+    return INVALID_VALUE;
+  int &current = currentComponents_[slot.component];
+  if (current < 0)
+    current = slot.component;
+  else if (iterateObj && current + 1 < (int) firstComponents_.size () && (int) firstComponents_[current + 1] == slot.component)
+    current++;
+  void *obj = componentObjects_[current];
+  //////////////////////////////////////////////////////////////////////////////
+
+  return memberValue (slot, obj, localIndices_[current]);
+}
 
+double
+ValueLookupTree::memberValue (MemberSlot &slot, void *obj, const unsigned index)
+{
+  const string &collection = slot.collection,
+               &variable = slot.variable;
   try
     {
       if (collection == "uservariables")
-        return 1; // FIXME
+        {
+          if (slot.variableSlot < 0)
+            slot.variableSlot = handles_->variables.userVariable (variable);
+          return handles_->variables.userVariable ((unsigned) slot.variableSlot);
+        }
       if (collection == "eventvariables")
-        return (((EventVariableProducerPayload *) obj)->at (variable));
-      return anatools::getMember (getCollectionType (collection), obj, variable, &functionLookupTable_);
+        {
+          if (slot.variableSlot < 0)
+            slot.variableSlot = declaredEventVariable (collection, variable);
+          return (slot.variableSlot < 0 ? INVALID_VALUE : handles_->variables.eventVariable (slot.variableSlot));
+        }
+      if (!slot.accessor.isResolved ())
+        {
+          slot.accessor.bind (getCollectionType (collection), variable);
+          slot.cacheCollection = ValueLookupCache::getCollectionKey (collection);
+          slot.cacheKey = ValueLookupCache::getMemberKey (getCollectionType (collection) + "." + variable);
+        }
+
+      // Data members are cheaper to read again than to look up in the cache.
+      if (slot.accessor.isDirect ())
+        return slot.accessor.value (obj);
+
+      //////////////////////////////////////////////////////////////////////////
+      // The value may already have been read by another tree in this event.
+      //////////////////////////////////////////////////////////////////////////
+      ValueLookupCache &cache = handles_->cache;
+      double value;
+      if (cache.getMember (slot.cacheCollection, slot.cacheKey, index, value))
+        return value;
+      if (slot.accessor.isBound ())
+        value = slot.accessor.value (obj);
+      else
+        value = anatools::getMember (getCollectionType (collection), obj, variable, &functionLookupTable_);
+      cache.setMember (slot.cacheCollection, slot.cacheKey, index, value);
+      return value;
+      //////////////////////////////////////////////////////////////////////////
     }
   catch (...)
     {
@@ -0,0 +1,117 @@
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "OSUT3Analysis/AnaTools/interface/VariableIndex.h"
+
+anatools::VariableIndex::VariableIndex () :
+  uservariables_ (NULL)
+{
+}
+
+void
+anatools::VariableIndex::build (const vector<edm::Handle<osu::Uservariable> > &uservariables, const vector<edm::Handle<osu::Eventvariable> > &eventvariables, const vector<edm::Handle<vector<string> > > &eventvariableNames, const vector<edm::Handle<map<string, double> > > &legacyEventvariables)
+{
+  eventvariables_.clear ();
+#if IS_VALID(eventvariables)
+  producerNames_.resize (eventvariables.size ());
+  producerSlots_.resize (eventvariables.size ());
+  for (unsigned i = 0; i < eventvariables.size (); i++)
+    {
+      const auto &handle = eventvariables.at (i);
+      if (!handle.isValid ())
+        {
+          if (i < legacyEventvariables.size () && legacyEventvariables.at (i).isValid ())
+            eventvariables_.merge (*legacyEventvariables.at (i));
+          continue;
+        }
+      vector<string> &names = producerNames_.at (i);
+      vector<unsigned> &slots = producerSlots_.at (i);
+
+      //////////////////////////////////////////////////////////////////////////
+      // A producer in this job only ever adds variables to its schema, so the
+      // schema is only read again when a payload has more variables than have
+      // been found. The names written for a run are only compared with those
+      // already found, and the slots are only found again when they change.
+      //////////////////////////////////////////////////////////////////////////
+      if (handle->schema ())
+        {
+          if (handle->size () > slots.size ())
+            names = handle->schema ()->names ();
+        }
+      else
+        {
+          if (i >= eventvariableNames.size () || !eventvariableNames.at (i).isValid ())
+            throw cms::Exception ("ProductNotFound") << "the names of the event variables of producer " << i << " were not written for this run.";
+          if (*eventvariableNames.at (i) != names)
+            {
+              names = *eventvariableNames.at (i);
+              slots.clear ();
+            }
+        }
+      while (slots.size () < names.size ())
+        slots.push_back (EventVariableRegistry::instance ().slot (names.at (slots.size ())));
+      //////////////////////////////////////////////////////////////////////////
+
+      eventvariables_.merge (*handle, slots);
+    }
+#endif
+
+  uservariables_ = &uservariables;
+  for (unsigned id = 0; id < userVariableNames_.size (); id++)
+    findUserVariable (id);
+}
+
+unsigned
+anatools::VariableIndex::userVariable (const string &name)
+{
+  auto id = userVariableIDs_.find (name);
+  if (id != userVariableIDs_.end ())
+    return id->second;
+
+  unsigned newID = userVariableNames_.size ();
+  userVariableIDs_[name] = newID;
+  userVariableNames_.push_back (name);
+  userVariableValues_.push_back (INVALID_VALUE);
+  userVariableProducers_.push_back (-1);
+  findUserVariable (newID);
+  return newID;
+}
+
+void
+anatools::VariableIndex::findUserVariable (const unsigned id)
+{
+  double &value = userVariableValues_[id];
+  value = INVALID_VALUE;
+#if IS_VALID(uservariables)
+  if (!uservariables_)
+    return;
+  const string &name = userVariableNames_[id];
+  int &producer = userVariableProducers_[id];
+
+  //////////////////////////////////////////////////////////////////////////////
+  // As when the payloads were merged into one map, the first producer to set
+  // the variable takes precedence. It is only searched for until it is found,
+  // and after that only the payload of that producer is read.
+  //////////////////////////////////////////////////////////////////////////////
+  if (producer < 0)
+    for (unsigned i = 0; producer < 0 && i < uservariables_->size (); i++)
+      if (uservariables_->at (i).isValid () && uservariables_->at (i)->count (name))
+        producer = i;
+  if (producer < 0 || !uservariables_->at (producer).isValid ())
+    return;
+  const auto &payload = *uservariables_->at (producer);
+  auto values = payload.find (name);
+  if (values == payload.end () || values->second.empty ())
+    return;
+  //////////////////////////////////////////////////////////////////////////////
+
+  //////////////////////////////////////////////////////////////////////////////
+  // A variable with a value for each combination of objects cannot be reduced
+  // to a single value for the event, and cannot be matched to the objects
+  // being cut on, so it is rejected rather than giving the first value.
+  //////////////////////////////////////////////////////////////////////////////
+  if (values->second.size () != 1 || !values->second.front ().objects.empty ())
+    throw cms::Exception ("Configuration") << "user variable \"" << name << "\" has a value for each combination of objects, which is not supported in cuts or histograms.";
+  value = values->second.front ().value;
+  //////////////////////////////////////////////////////////////////////////////
+#endif
+}
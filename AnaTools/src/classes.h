@@ -15,6 +15,8 @@ namespace {
      edm::Wrapper<CutCalculatorPayload> CutCalculatorPayloadDummy2;
      edm::Wrapper<vector<CutCalculatorPayload> > CutCalculatorPayloadDummy3;
 
+     ObjectFlags ObjectFlagsDummy0;
+
      Cut cutdummy0;
      edm::Wrapper<Cut> cutdummy1;
      vector<Cut> cutdummy2;
@@ -29,6 +31,8 @@ namespace {
      vector<EventVariableProducerPayload> EventVariableProducerPayloadDummy1;
      edm::Wrapper<EventVariableProducerPayload> EventVariableProducerPayloadDummy2;
      edm::Wrapper<vector<EventVariableProducerPayload> > EventVariableProducerPayloadDummy3;
+     map<string, double> EventVariableProducerPayloadDummy4;
+     edm::Wrapper<map<string, double> > EventVariableProducerPayloadDummy5;
 
      map<string, vector<vector<bool> > > mapcharbooldummy0;
      edm::Wrapper<map<string, vector<vector<bool> > > > mapcharbooldummy1;
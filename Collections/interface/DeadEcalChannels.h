@@ -0,0 +1,58 @@
+#ifndef OSU_DEAD_ECAL_CHANNELS
+#define OSU_DEAD_ECAL_CHANNELS
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/*
+A DeadEcalChannels object holds the position and status of every ECAL channel
+whose status is at or above some threshold, stored as separate arrays sorted
+by eta. Since deltaR is never smaller than the difference in eta, the channels
+near a track are found by a binary search for the window [eta - dR, eta + dR]
+followed by a scan of just that window.
+
+The OSUGenericTrackProducer fills it from the channel status and geometry
+records, and can save it to and load it from a small binary file, so that the
+walk over every crystal is only done once per set of conditions. The key
+passed to read() and write() identifies those conditions; read() fails if the
+key in the file is different.
+*/
+
+namespace osu
+{
+  class DeadEcalChannels
+    {
+      public:
+        DeadEcalChannels ();
+
+        void clear ();
+        void add (const double, const double, const int);
+        void sort ();   // must be called after the last add () and before any query
+
+        unsigned size () const;
+        double eta (const unsigned) const;
+        double phi (const unsigned) const;
+        int status (const unsigned) const;
+
+        // Returns the range [first, last) of indices of the channels with eta
+        // in the given closed interval.
+        pair<unsigned, unsigned> etaWindow (const double, const double) const;
+
+        // Returns whether there is a channel within the given deltaR of
+        // (eta, phi), including on the edge of the cone.
+        bool anyWithin (const double, const double, const double) const;
+
+        bool read (const string &, const string &);
+        bool write (const string &, const string &) const;
+
+      private:
+        vector<double> eta_;
+        vector<double> phi_;
+        vector<int> status_;
+    };
+}
+
+#endif
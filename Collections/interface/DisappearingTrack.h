@@ -22,21 +22,43 @@
 #include "DataFormats/PatCandidates/interface/IsolatedTrack.h"
 #endif
 
+namespace osu {
+  // The parameters of the DisappTrks constructor on top of those of
+  // TrackBase. Whether to match to the candidate and isolated tracks depends
+  // only on the label of the tracks collection, so it is also decided once.
+  struct DisappearingTrackConfig : public TrackConfig
+    {
+      vector<double> eleVtx_d0Cuts_barrel, eleVtx_d0Cuts_endcap;
+      vector<double> eleVtx_dzCuts_barrel, eleVtx_dzCuts_endcap;
+
+      bool matchCandidateTracks;
+      double maxDeltaRForCandidateTrackMatching;
+
+      bool matchIsolatedTracks;
+      double maxDeltaRForIsolatedTrackMatching;
+
+      DisappearingTrackConfig ();
+      DisappearingTrackConfig (const edm::ParameterSet &);
+    };
+}
+
 #if IS_VALID(tracks)
 
 namespace osu {
   class DisappearingTrack : public TrackBase {
     public:
+      typedef DisappearingTrackConfig Config;
+
       DisappearingTrack();
       DisappearingTrack(const TYPE(tracks) &);
       DisappearingTrack(const TYPE(tracks) &, 
                         const edm::Handle<vector<osu::Mcparticle> > &);
       DisappearingTrack(const TYPE(tracks) &, 
                         const edm::Handle<vector<osu::Mcparticle> > &, 
-                        const edm::ParameterSet &);
+                        const TrackConfig &);
       DisappearingTrack(const TYPE(tracks) &, 
                         const edm::Handle<vector<osu::Mcparticle> > &, 
-                        const edm::ParameterSet &, 
+                        const TrackConfig &, 
                         const edm::Handle<vector<reco::GsfTrack> > &, 
                         const EtaPhiList &, 
                         const EtaPhiList &);
@@ -44,12 +66,11 @@ namespace osu {
                         const edm::Handle<vector<osu::Mcparticle> > &, 
                         const edm::Handle<vector<pat::PackedCandidate> > &, 
                         const edm::Handle<vector<TYPE(jets)> > &,
-                        const edm::ParameterSet &, 
+                        const TrackConfig &, 
                         const edm::Handle<vector<reco::GsfTrack> > &, 
                         const EtaPhiList &, 
                         const EtaPhiList &, 
-                        const map<DetId, vector<double> > * const, 
-                        const map<DetId, vector<int> > * const, 
+                        const osu::DeadEcalChannels &, 
                         const bool);
 
       // the DisappTrks constructor
@@ -58,12 +79,11 @@ namespace osu {
                         const edm::Handle<vector<pat::PackedCandidate> > &,
                         const edm::Handle<vector<pat::PackedCandidate> > &,
                         const edm::Handle<vector<TYPE(jets)> > &,
-                        const edm::ParameterSet &, 
+                        const DisappearingTrackConfig &, 
                         const edm::Handle<vector<reco::GsfTrack> > &, 
                         const EtaPhiList &, 
                         const EtaPhiList &, 
-                        const map<DetId, vector<double> > * const, 
-                        const map<DetId, vector<int> > * const, 
+                        const osu::DeadEcalChannels &, 
                         const bool,
 #if DATA_FORMAT_FROM_MINIAOD && DATA_FORMAT_IS_2017
                         const edm::Handle<vector<CandidateTrack> > &,
@@ -184,10 +204,10 @@ namespace osu {
                                  const edm::Handle<vector<osu::Mcparticle> > &);
       SecondaryDisappearingTrack(const TYPE(tracks) &, 
                                  const edm::Handle<vector<osu::Mcparticle> > &, 
-                                 const edm::ParameterSet &);
+                                 const TrackConfig &);
       SecondaryDisappearingTrack(const TYPE(tracks) &, 
                                  const edm::Handle<vector<osu::Mcparticle> > &, 
-                                 const edm::ParameterSet &, 
+                                 const TrackConfig &, 
                                  const edm::Handle<vector<reco::GsfTrack> > &, 
                                  const EtaPhiList &, 
                                  const EtaPhiList &);
@@ -195,12 +215,11 @@ namespace osu {
                                  const edm::Handle<vector<osu::Mcparticle> > &, 
                                  const edm::Handle<vector<pat::PackedCandidate> > &, 
                                  const edm::Handle<vector<TYPE(jets)> > &,
-                                 const edm::ParameterSet &, 
+                                 const TrackConfig &, 
                                  const edm::Handle<vector<reco::GsfTrack> > &, 
                                  const EtaPhiList &, 
                                  const EtaPhiList &, 
-                                 const map<DetId, vector<double> > * const, 
-                                 const map<DetId, vector<int> > * const, 
+                                 const osu::DeadEcalChannels &, 
                                  const bool);
       // the DisappTrks constructor
       SecondaryDisappearingTrack(const TYPE(tracks) &, 
@@ -208,12 +227,11 @@ namespace osu {
                                  const edm::Handle<vector<pat::PackedCandidate> > &,
                                  const edm::Handle<vector<pat::PackedCandidate> > &,
                                  const edm::Handle<vector<TYPE(jets)> > &,
-                                 const edm::ParameterSet &, 
+                                 const DisappearingTrackConfig &, 
                                  const edm::Handle<vector<reco::GsfTrack> > &, 
                                  const EtaPhiList &, 
                                  const EtaPhiList &, 
-                                 const map<DetId, vector<double> > * const, 
-                                 const map<DetId, vector<int> > * const, 
+                                 const osu::DeadEcalChannels &, 
                                  const bool,
 #if DATA_FORMAT_FROM_MINIAOD && DATA_FORMAT_IS_2017
                                  const edm::Handle<vector<CandidateTrack> > &,
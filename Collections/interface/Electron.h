@@ -15,8 +15,8 @@ namespace osu
         Electron ();
         Electron (const TYPE(electrons) &);
         Electron (const TYPE(electrons) &, const edm::Handle<vector<osu::Mcparticle> > &);
-        Electron (const TYPE(electrons) &, const edm::Handle<vector<osu::Mcparticle> > &, const edm::ParameterSet &);
-        Electron (const TYPE(electrons) &, const edm::Handle<vector<osu::Mcparticle> > &, const edm::ParameterSet &, const osu::Met &);
+        Electron (const TYPE(electrons) &, const edm::Handle<vector<osu::Mcparticle> > &, const osu::GenMatchConfig &);
+        Electron (const TYPE(electrons) &, const edm::Handle<vector<osu::Mcparticle> > &, const osu::GenMatchConfig &, const osu::Met &);
         
         const float rho() const;
         const float AEff () const;
@@ -99,7 +99,7 @@ namespace osu
         Electron ();
         Electron (const TYPE(electrons) &);
         Electron (const TYPE(electrons) &, const edm::Handle<vector<osu::Mcparticle> > &);
-        Electron (const TYPE(electrons) &, const edm::Handle<vector<osu::Mcparticle> > &, const edm::ParameterSet &);
+        Electron (const TYPE(electrons) &, const edm::Handle<vector<osu::Mcparticle> > &, const osu::GenMatchConfig &);
 #endif
         ~Electron ();
 
@@ -0,0 +1,68 @@
+#ifndef OSU_ETA_PHI_GRID
+#define OSU_ETA_PHI_GRID
+
+#include <vector>
+
+using namespace std;
+
+/*
+An EtaPhiGrid sorts a list of points in (eta, phi) into square cells of a
+given size, so that finding the points within some deltaR of a direction only
+requires looking at the cells around that direction instead of at every point.
+The cells cover [-maxEta, maxEta] in eta, with one more cell on each side for
+everything beyond, and wrap around in phi.
+
+The points are numbered in the order they are added with add(), and build()
+must be called after the last one is added and before the grid is queried.
+candidates() returns a superset of the points within the given deltaR, so the
+caller is still responsible for the exact comparison, but the indices are
+always in increasing order, so that sums and ties are handled exactly as when
+looping over all of the points.
+*/
+
+namespace osu
+{
+  class EtaPhiGrid
+    {
+      public:
+        EtaPhiGrid (const double = 0.1, const double = 5.0);
+
+        void clear ();
+        void add (const double, const double);
+        void build ();
+
+        bool built () const;
+        unsigned size () const;
+        double eta (const unsigned) const;
+        double phi (const unsigned) const;
+
+        // Fills the last argument with the indices, in increasing order, of
+        // all the points which might be within the given deltaR of (eta,
+        // phi), including any points with an eta or phi which is not a finite
+        // number. If the direction is not finite or the deltaR is negative,
+        // all of the points are returned.
+        void candidates (const double, const double, const double, vector<unsigned> &) const;
+
+      private:
+        int etaCell (const double) const;
+        int phiCell (const double) const;
+
+        double maxEta_;
+        int nEtaCells_;
+        int nPhiCells_;
+        double etaCellSize_;
+        double phiCellSize_;
+        bool built_;
+
+        vector<double> eta_;
+        vector<double> phi_;
+
+        // cells are numbered (eta cell) * nPhiCells_ + (phi cell), with the
+        // indices of the points in each cell stored contiguously
+        vector<unsigned> cellStart_;
+        vector<unsigned> cellPoints_;
+        vector<unsigned> unbinned_;
+    };
+}
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef OSU_GEN_MATCH_INDEX
+#define OSU_GEN_MATCH_INDEX
+
+#include <map>
+#include <vector>
+
+#include "DataFormats/Common/interface/Handle.h"
+#include "DataFormats/Provenance/interface/EventID.h"
+#include "DataFormats/Provenance/interface/ProductID.h"
+
+#include "OSUT3Analysis/Collections/interface/EtaPhiGrid.h"
+#include "OSUT3Analysis/Collections/interface/Mcparticle.h"
+
+using namespace std;
+
+/*
+A GenMatchIndex sorts the generator particles of an event into a grid of cells
+in eta and phi, so that GenMatchable only has to compute the deltaR to the
+particles in the cells near each object instead of to every particle in the
+event. It also keeps a list of the particles with each |pdgId|, for the
+matching to particles of the same type.
+
+There is one index per thread, returned by get(), which rebuilds it the first
+time it is called for a new event or a new collection of particles. The event
+is part of the key, since the address and product ID of the particles can be
+the same from one event to the next. An index requested without an event, i.e.,
+with a default-constructed EventID, is always rebuilt.
+*/
+
+namespace osu
+{
+  class GenMatchIndex
+    {
+      public:
+        static const GenMatchIndex &get (const edm::EventID &, const edm::Handle<vector<osu::Mcparticle> > &);
+
+        // Fills the last argument with the indices, in increasing order, of
+        // all the particles which might be within the given deltR of (eta,
+        // phi), including any particles with an eta or phi which is not a
+        // finite number.
+        void candidates (const double, const double, const double, vector<unsigned> &) const;
+
+        // Returns the indices, in increasing order, of all the particles with
+        // the given |pdgId|.
+        const vector<unsigned> &particlesWithAbsPdgId (const int) const;
+
+      private:
+        GenMatchIndex ();
+
+        static GenMatchIndex &instance ();
+
+        void build (const vector<osu::Mcparticle> &);
+
+        edm::EventID eventID_;
+        edm::ProductID productID_;
+        const vector<osu::Mcparticle> *product_;
+
+        EtaPhiGrid grid_;
+        map<int, vector<unsigned> > byAbsPdgId_;
+        vector<unsigned> none_;
+    };
+}
+
+#endif
@@ -8,10 +8,24 @@
 
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
 
+#include "OSUT3Analysis/Collections/interface/GenMatchIndex.h"
 #include "OSUT3Analysis/Collections/interface/Mcparticle.h"
 
 namespace osu
 {
+  // The parameters of the gen-matching, which a producer reads from its
+  // ParameterSet once and passes to the constructor of each object, along
+  // with the event being produced, which it sets for each event.
+  struct GenMatchConfig
+    {
+      double maxDeltaR;
+      double minPt;
+      edm::EventID eventID;
+
+      GenMatchConfig ();
+      GenMatchConfig (const edm::ParameterSet &);
+    };
+
   template<class T, int PdgId>
   class GenMatchable : public T
     {
@@ -80,7 +94,7 @@ namespace osu
         GenMatchable ();
         GenMatchable (const T &);
         GenMatchable (const T &, const edm::Handle<vector<osu::Mcparticle> > &);
-        GenMatchable (const T &, const edm::Handle<vector<osu::Mcparticle> > &, const edm::ParameterSet &);
+        GenMatchable (const T &, const edm::Handle<vector<osu::Mcparticle> > &, const GenMatchConfig &);
         ~GenMatchable ();
 
         const GenMatchedParticle genMatchedParticle () const;
@@ -99,10 +113,25 @@ namespace osu
         double maxDeltaR_;
         double minPt_;
 
-        const GenMatchedParticle &findGenMatchedParticle (const edm::Handle<vector<osu::Mcparticle> > &, GenMatchedParticle &, DRToGenMatchedParticle &, const bool = false) const;
+        const GenMatchedParticle &findGenMatchedParticle (const edm::EventID &, const edm::Handle<vector<osu::Mcparticle> > &, GenMatchedParticle &, DRToGenMatchedParticle &, const bool = false) const;
+        void compareToGenParticle (const edm::Handle<vector<osu::Mcparticle> > &, const unsigned, GenMatchedParticle &, DRToGenMatchedParticle &, const bool) const;
     };
 }
 
+inline
+osu::GenMatchConfig::GenMatchConfig () :
+  maxDeltaR (-1.0),
+  minPt (-1.0)
+{
+}
+
+inline
+osu::GenMatchConfig::GenMatchConfig (const edm::ParameterSet &cfg) :
+  maxDeltaR (cfg.getParameter<double> ("maxDeltaRForGenMatching")),
+  minPt (cfg.getParameter<double> ("minPtForGenMatching"))
+{
+}
+
 template<class T, int PdgId>
 osu::GenMatchable<T, PdgId>::GenMatchable () :
   genMatchedParticle_ (),
@@ -132,23 +161,23 @@ osu::GenMatchable<T, PdgId>::GenMatchable (const T &object, const edm::Handle<ve
 {
   if (particles.isValid ())
     {
-      findGenMatchedParticle (particles, genMatchedParticle_, dRToGenMatchedParticle_);
-      findGenMatchedParticle (particles, genMatchedParticleOfSameType_, dRToGenMatchedParticleOfSameType_, true);
+      findGenMatchedParticle (edm::EventID (), particles, genMatchedParticle_, dRToGenMatchedParticle_);
+      findGenMatchedParticle (edm::EventID (), particles, genMatchedParticleOfSameType_, dRToGenMatchedParticleOfSameType_, true);
     }
   else
     edm::LogWarning ("osu_GenMatchable") << "No generator particles collection found. Skipping gen-matching...";
 }
 
 template<class T, int PdgId>
-osu::GenMatchable<T, PdgId>::GenMatchable (const T &object, const edm::Handle<vector<osu::Mcparticle> > &particles, const edm::ParameterSet &cfg) :
+osu::GenMatchable<T, PdgId>::GenMatchable (const T &object, const edm::Handle<vector<osu::Mcparticle> > &particles, const GenMatchConfig &cfg) :
   GenMatchable<T, PdgId> (object)
 {
-  maxDeltaR_ = cfg.getParameter<double> ("maxDeltaRForGenMatching");
-  minPt_ = cfg.getParameter<double> ("minPtForGenMatching");
+  maxDeltaR_ = cfg.maxDeltaR;
+  minPt_ = cfg.minPt;
   if (particles.isValid ())
     {
-      findGenMatchedParticle (particles, genMatchedParticle_, dRToGenMatchedParticle_);
-      findGenMatchedParticle (particles, genMatchedParticleOfSameType_, dRToGenMatchedParticleOfSameType_, true);
+      findGenMatchedParticle (cfg.eventID, particles, genMatchedParticle_, dRToGenMatchedParticle_);
+      findGenMatchedParticle (cfg.eventID, particles, genMatchedParticleOfSameType_, dRToGenMatchedParticleOfSameType_, true);
     }
   else
     edm::LogWarning ("osu_GenMatchable") << "No generator particles collection found. Skipping gen-matching...";
@@ -160,7 +189,7 @@ osu::GenMatchable<T, PdgId>::~GenMatchable ()
 }
 
 template<class T, int PdgId> const typename osu::GenMatchable<T, PdgId>::GenMatchedParticle &
-osu::GenMatchable<T, PdgId>::findGenMatchedParticle (const edm::Handle<vector<osu::Mcparticle> > &particles, osu::GenMatchable<T, PdgId>::GenMatchedParticle &genMatchedParticle, osu::GenMatchable<T, PdgId>::DRToGenMatchedParticle &dRToGenMatchedParticle, const bool usePdgId) const
+osu::GenMatchable<T, PdgId>::findGenMatchedParticle (const edm::EventID &eventID, const edm::Handle<vector<osu::Mcparticle> > &particles, osu::GenMatchable<T, PdgId>::GenMatchedParticle &genMatchedParticle, osu::GenMatchable<T, PdgId>::DRToGenMatchedParticle &dRToGenMatchedParticle, const bool usePdgId) const
 {
   dRToGenMatchedParticle.promptFinalState = INVALID_VALUE;
   dRToGenMatchedParticle.directPromptTauDecayProductFinalState = INVALID_VALUE;
@@ -168,72 +197,98 @@ osu::GenMatchable<T, PdgId>::findGenMatchedParticle (const edm::Handle<vector<os
   dRToGenMatchedParticle.directHardProcessTauDecayProductFinalState = INVALID_VALUE;
   dRToGenMatchedParticle.promptOrTauDecay = INVALID_VALUE;
   dRToGenMatchedParticle.noFlags = INVALID_VALUE;
-  for (vector<osu::Mcparticle>::const_iterator particle = particles->begin (); particle != particles->end (); particle++)
+  //////////////////////////////////////////////////////////////////////////////
+  // Only the particles of the same type, or the particles in the cells of the
+  // GenMatchIndex near this object, can pass the cuts in
+  // compareToGenParticle (), so only these are considered when possible. They
+  // are considered in the same order as in the full collection.
+  //////////////////////////////////////////////////////////////////////////////
+  if (usePdgId)
+    {
+      for (const auto &i : GenMatchIndex::get (eventID, particles).particlesWithAbsPdgId (PdgId))
+        compareToGenParticle (particles, i, genMatchedParticle, dRToGenMatchedParticle, usePdgId);
+    }
+  else if (maxDeltaR_ >= 0.0 && isfinite (this->eta ()) && isfinite (this->phi ()))
+    {
+      vector<unsigned> candidates;
+      GenMatchIndex::get (eventID, particles).candidates (this->eta (), this->phi (), maxDeltaR_, candidates);
+      for (const auto &i : candidates)
+        compareToGenParticle (particles, i, genMatchedParticle, dRToGenMatchedParticle, usePdgId);
+    }
+  else
+    {
+      for (unsigned i = 0; i != particles->size (); i++)
+        compareToGenParticle (particles, i, genMatchedParticle, dRToGenMatchedParticle, usePdgId);
+    }
+  //////////////////////////////////////////////////////////////////////////////
+
+  return genMatchedParticle;
+}
+
+template<class T, int PdgId> void
+osu::GenMatchable<T, PdgId>::compareToGenParticle (const edm::Handle<vector<osu::Mcparticle> > &particles, const unsigned i, osu::GenMatchable<T, PdgId>::GenMatchedParticle &genMatchedParticle, osu::GenMatchable<T, PdgId>::DRToGenMatchedParticle &dRToGenMatchedParticle, const bool usePdgId) const
+{
+  vector<osu::Mcparticle>::const_iterator particle = particles->begin () + i;
+  int pdgId = 0;
+  pdgId = particle->pdgId ();
+
+  if (minPt_ >= 0.0 && particle->pt () < minPt_)
+    return;
+  if (usePdgId && abs (pdgId) != PdgId)
+    return;
+
+  double dR = deltaR (*particle, *this);
+  if (maxDeltaR_ >= 0.0 && dR > maxDeltaR_)
+    return;
+
+  if (dR < dRToGenMatchedParticle.noFlags || dRToGenMatchedParticle.noFlags < 0.0)
     {
-      int pdgId = 0;
-      pdgId = particle->pdgId ();
-
-      if (minPt_ >= 0.0 && particle->pt () < minPt_)
-        continue;
-      if (usePdgId && abs (pdgId) != PdgId)
-        continue;
-
-      double dR = deltaR (*particle, *this);
-      if (maxDeltaR_ >= 0.0 && dR > maxDeltaR_)
-        continue;
-
-      if (dR < dRToGenMatchedParticle.noFlags || dRToGenMatchedParticle.noFlags < 0.0)
-	{
-	  dRToGenMatchedParticle.noFlags = genMatchedParticle.noFlagsDR = dR;
-	  genMatchedParticle.noFlags = edm::Ref<vector<osu::Mcparticle> > (particles, particle - particles->begin ());
-	  genMatchedParticle.noFlagsPdgId = particle->pdgId ();
-	}
-
-      if (particle->isPromptFinalState () || particle->isDirectPromptTauDecayProductFinalState ())
+      dRToGenMatchedParticle.noFlags = genMatchedParticle.noFlagsDR = dR;
+      genMatchedParticle.noFlags = edm::Ref<vector<osu::Mcparticle> > (particles, particle - particles->begin ());
+      genMatchedParticle.noFlagsPdgId = particle->pdgId ();
+    }
+
+  if (particle->isPromptFinalState () || particle->isDirectPromptTauDecayProductFinalState ())
+    {
+      if (dR < dRToGenMatchedParticle.promptOrTauDecay || dRToGenMatchedParticle.promptOrTauDecay < 0.0)
         {
-          if (dR < dRToGenMatchedParticle.promptOrTauDecay || dRToGenMatchedParticle.promptOrTauDecay < 0.0)
-            {
-              dRToGenMatchedParticle.promptOrTauDecay = genMatchedParticle.promptOrTauDecayDR = dR;
-              genMatchedParticle.promptOrTauDecay = edm::Ref<vector<osu::Mcparticle> > (particles, particle - particles->begin ());
-              genMatchedParticle.promptOrTauDecayPdgId = ((particle->isDirectPromptTauDecayProductFinalState () && abs (particle->pdgId ()) > 100) ? 15 : particle->pdgId ());
-            }
+          dRToGenMatchedParticle.promptOrTauDecay = genMatchedParticle.promptOrTauDecayDR = dR;
+          genMatchedParticle.promptOrTauDecay = edm::Ref<vector<osu::Mcparticle> > (particles, particle - particles->begin ());
+          genMatchedParticle.promptOrTauDecayPdgId = ((particle->isDirectPromptTauDecayProductFinalState () && abs (particle->pdgId ()) > 100) ? 15 : particle->pdgId ());
         }
-      if (particle->isPromptFinalState ())
+    }
+  if (particle->isPromptFinalState ())
+    {
+      if (dR < dRToGenMatchedParticle.promptFinalState || dRToGenMatchedParticle.promptFinalState < 0.0)
         {
-          if (dR < dRToGenMatchedParticle.promptFinalState || dRToGenMatchedParticle.promptFinalState < 0.0)
-            {
-              dRToGenMatchedParticle.promptFinalState = dR;
-              genMatchedParticle.promptFinalState = edm::Ref<vector<osu::Mcparticle> > (particles, particle - particles->begin ());
-            }
+          dRToGenMatchedParticle.promptFinalState = dR;
+          genMatchedParticle.promptFinalState = edm::Ref<vector<osu::Mcparticle> > (particles, particle - particles->begin ());
         }
-      if (particle->isDirectPromptTauDecayProductFinalState ())
+    }
+  if (particle->isDirectPromptTauDecayProductFinalState ())
+    {
+      if (dR < dRToGenMatchedParticle.directPromptTauDecayProductFinalState || dRToGenMatchedParticle.directPromptTauDecayProductFinalState < 0.0)
         {
-          if (dR < dRToGenMatchedParticle.directPromptTauDecayProductFinalState || dRToGenMatchedParticle.directPromptTauDecayProductFinalState < 0.0)
-            {
-              dRToGenMatchedParticle.directPromptTauDecayProductFinalState = dR;
-              genMatchedParticle.directPromptTauDecayProductFinalState = edm::Ref<vector<osu::Mcparticle> > (particles, particle - particles->begin ());
-            }
+          dRToGenMatchedParticle.directPromptTauDecayProductFinalState = dR;
+          genMatchedParticle.directPromptTauDecayProductFinalState = edm::Ref<vector<osu::Mcparticle> > (particles, particle - particles->begin ());
         }
-      if (particle->fromHardProcessFinalState ())
+    }
+  if (particle->fromHardProcessFinalState ())
+    {
+      if (dR < dRToGenMatchedParticle.hardProcessFinalState || dRToGenMatchedParticle.hardProcessFinalState < 0.0)
         {
-          if (dR < dRToGenMatchedParticle.hardProcessFinalState || dRToGenMatchedParticle.hardProcessFinalState < 0.0)
-            {
-              dRToGenMatchedParticle.hardProcessFinalState = dR;
-              genMatchedParticle.hardProcessFinalState = edm::Ref<vector<osu::Mcparticle> > (particles, particle - particles->begin ());
-            }
+          dRToGenMatchedParticle.hardProcessFinalState = dR;
+          genMatchedParticle.hardProcessFinalState = edm::Ref<vector<osu::Mcparticle> > (particles, particle - particles->begin ());
         }
-      if (particle->isDirectHardProcessTauDecayProductFinalState ())
+    }
+  if (particle->isDirectHardProcessTauDecayProductFinalState ())
+    {
+      if (dR < dRToGenMatchedParticle.directHardProcessTauDecayProductFinalState || dRToGenMatchedParticle.directHardProcessTauDecayProductFinalState < 0.0)
         {
-          if (dR < dRToGenMatchedParticle.directHardProcessTauDecayProductFinalState || dRToGenMatchedParticle.directHardProcessTauDecayProductFinalState < 0.0)
-            {
-              dRToGenMatchedParticle.directHardProcessTauDecayProductFinalState = dR;
-              genMatchedParticle.directHardProcessTauDecayProductFinalState = edm::Ref<vector<osu::Mcparticle> > (particles, particle - particles->begin ());
-            }
+          dRToGenMatchedParticle.directHardProcessTauDecayProductFinalState = dR;
+          genMatchedParticle.directHardProcessTauDecayProductFinalState = edm::Ref<vector<osu::Mcparticle> > (particles, particle - particles->begin ());
         }
-
     }
-
-  return genMatchedParticle;
 }
 
 template<class T, int PdgId> const typename osu::GenMatchable<T, PdgId>::GenMatchedParticle
@@ -14,7 +14,7 @@ namespace osu
         Jet ();
         Jet (const TYPE(jets) &);
         Jet (const TYPE(jets) &, const edm::Handle<vector<osu::Mcparticle> > &);
-        Jet (const TYPE(jets) &, const edm::Handle<vector<osu::Mcparticle> > &, const edm::ParameterSet &);
+        Jet (const TYPE(jets) &, const edm::Handle<vector<osu::Mcparticle> > &, const osu::GenMatchConfig &);
         ~Jet ();
         const int matchedToLepton () const;
         const float pfCombinedSecondaryVertexV2BJetTags () const;
@@ -99,7 +99,7 @@ namespace osu
         Bjet();
         Bjet(const TYPE(jets) &);
         Bjet(const TYPE(jets) &, const edm::Handle<vector<osu::Mcparticle> > &);
-        Bjet(const TYPE(jets) &, const edm::Handle<vector<osu::Mcparticle> > &, const edm::ParameterSet &);
+        Bjet(const TYPE(jets) &, const edm::Handle<vector<osu::Mcparticle> > &, const osu::GenMatchConfig &);
         ~Bjet();
     };
 #else // STOPPPED_PTLS
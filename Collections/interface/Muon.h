@@ -17,8 +17,8 @@ namespace osu
         Muon ();
         Muon (const TYPE(muons) &);
         Muon (const TYPE(muons) &, const edm::Handle<vector<osu::Mcparticle> > &);
-        Muon (const TYPE(muons) &, const edm::Handle<vector<osu::Mcparticle> > &, const edm::ParameterSet &);
-        Muon (const TYPE(muons) &, const edm::Handle<vector<osu::Mcparticle> > &, const edm::ParameterSet &, const osu::Met &);
+        Muon (const TYPE(muons) &, const edm::Handle<vector<osu::Mcparticle> > &, const osu::GenMatchConfig &);
+        Muon (const TYPE(muons) &, const edm::Handle<vector<osu::Mcparticle> > &, const osu::GenMatchConfig &, const osu::Met &);
         ~Muon ();
 
         const float rho() const;
@@ -16,8 +16,8 @@ namespace osu
         Tau ();
         Tau (const TYPE(taus) &);
         Tau (const TYPE(taus) &, const edm::Handle<vector<osu::Mcparticle> > &);
-        Tau (const TYPE(taus) &, const edm::Handle<vector<osu::Mcparticle> > &, const edm::ParameterSet &);
-        Tau (const TYPE(taus) &, const edm::Handle<vector<osu::Mcparticle> > &, const edm::ParameterSet &, const osu::Met &);
+        Tau (const TYPE(taus) &, const edm::Handle<vector<osu::Mcparticle> > &, const osu::GenMatchConfig &);
+        Tau (const TYPE(taus) &, const edm::Handle<vector<osu::Mcparticle> > &, const osu::GenMatchConfig &, const osu::Met &);
         ~Tau ();
 
         const bool passesDecayModeReconstruction () const;
@@ -1,12 +1,11 @@
 #ifndef TRACK_BASE
 #define TRACK_BASE
 
-#include <random>
-#include <chrono>
-
 #include "DataFormats/GsfTrackReco/interface/GsfTrack.h"
 #include "DataFormats/PatCandidates/interface/PackedCandidate.h"
 
+#include "OSUT3Analysis/Collections/interface/DeadEcalChannels.h"
+#include "OSUT3Analysis/Collections/interface/EtaPhiGrid.h"
 #include "OSUT3Analysis/Collections/interface/GenMatchable.h"
 
 #ifndef MAX_DR
@@ -30,31 +29,75 @@ struct EtaPhi {
   }
 };
 
+// A list of points in (eta, phi), e.g., the hot spots of the fiducial maps.
+// Once the list is complete, buildGrid() sorts it into
+// an osu::EtaPhiGrid so that candidates() only has to return the entries near
+// a given direction; until then, candidates() returns every entry.
 struct EtaPhiList : public vector<EtaPhi> {
   double minDeltaR;
+  osu::EtaPhiGrid grid;
 
   EtaPhiList() :
     minDeltaR(0.0)
   {
   }
+
+  void buildGrid()
+  {
+    grid.clear();
+    for (const auto &etaPhi : *this)
+      grid.add(etaPhi.eta, etaPhi.phi);
+    grid.build();
+  }
+
+  void candidates(const double eta, const double phi, const double dR, vector<unsigned> &indices) const
+  {
+    if (grid.built() && grid.size() == size())
+      grid.candidates(eta, phi, dR, indices);
+    else
+      {
+        indices.clear();
+        for (unsigned i = 0; i != size(); i++)
+          indices.push_back(i);
+      }
+  }
 };
 
+namespace osu
+{
+  // The parameters of the track constructors, read once by the producer.
+  struct TrackConfig : public GenMatchConfig
+    {
+      double minDeltaRForFiducialTrack;
+      double maxDeltaRForGsfTrackMatching;
+      double dropTOBProbability;
+      double preTOBDropHitInefficiency;
+      double postTOBDropHitInefficiency;
+      double hitInefficiency;
+
+      TrackConfig ();
+      TrackConfig (const edm::ParameterSet &);
+    };
+}
+
 #if IS_VALID(tracks)
 
 namespace osu
 {
   class TrackBase : public GenMatchable<TYPE(tracks), 0> {
     public:
+      typedef TrackConfig Config;
+
       TrackBase();
       TrackBase(const TYPE(tracks) &);
       TrackBase(const TYPE(tracks) &, 
                 const edm::Handle<vector<osu::Mcparticle> > &);
       TrackBase(const TYPE(tracks) &, 
                 const edm::Handle<vector<osu::Mcparticle> > &, 
-                const edm::ParameterSet &);
+                const TrackConfig &);
       TrackBase(const TYPE(tracks) &, 
                 const edm::Handle<vector<osu::Mcparticle> > &, 
-                const edm::ParameterSet &, 
+                const TrackConfig &, 
                 const edm::Handle<vector<reco::GsfTrack> > &, 
                 const EtaPhiList &, 
                 const EtaPhiList &);
@@ -62,12 +105,11 @@ namespace osu
                 const edm::Handle<vector<osu::Mcparticle> > &, 
                 const edm::Handle<vector<pat::PackedCandidate> > &, 
                 const edm::Handle<vector<TYPE(jets)> > &,
-                const edm::ParameterSet &, 
+                const TrackConfig &, 
                 const edm::Handle<vector<reco::GsfTrack> > &, 
                 const EtaPhiList &, 
                 const EtaPhiList &, 
-                const map<DetId, vector<double> > * const, 
-                const map<DetId, vector<int> > * const, 
+                const osu::DeadEcalChannels &, 
                 const bool);
 
       ~TrackBase();
@@ -109,6 +151,13 @@ namespace osu
       const int hitAndTOBDrop_gsfTrackMissingOuterHits() const;
       const int hitAndTOBDrop_bestTrackMissingOuterHits() const;
 
+      // The hit-dropping decisions above are drawn from a counter-based
+      // generator keyed by hitDropSeed(), which the producer sets from the job
+      // seed, the event, and the index of the track, so they are reproducible
+      // and only drawn when one of the methods is called.
+      static const unsigned long long hitDropSeed(const unsigned long long, const unsigned, const unsigned, const unsigned long long, const unsigned);
+      void set_hitDropSeed(const unsigned long long seed) { hitDropSeed_ = seed; };
+
       // Methods for HitPattern
       const bool hasValidHitInPixelBarrelLayer(const uint16_t layer) const;
       const bool hasValidHitInPixelBarrelLayer1() const { return hasValidHitInPixelBarrelLayer(1); };
@@ -259,9 +308,6 @@ namespace osu
 
       double maxDeltaR_;
 
-      const map<DetId, vector<double> > * EcalAllDeadChannelsValMap_;
-      const map<DetId, vector<int> >    * EcalAllDeadChannelsBitMap_;
-
       bool isFiducialECALTrack_;
 
       double dropTOBProbability_;
@@ -269,9 +315,7 @@ namespace osu
       double postTOBDropHitProbability_;
       double hitProbability_;
 
-      bool dropTOBDecision_;
-      vector<bool> dropHitDecisions_;
-      vector<bool> dropMiddleHitDecisions_;
+      unsigned long long hitDropSeed_;
 
       float deltaRToClosestPFElectron_;
       float deltaRToClosestPFMuon_;
@@ -280,10 +324,15 @@ namespace osu
       const bool isFiducialTrack(const EtaPhiList &, const double, double &) const;
       const edm::Ref<vector<reco::GsfTrack> > &findMatchedGsfTrack(const edm::Handle<vector<reco::GsfTrack> > &, edm::Ref<vector<reco::GsfTrack> > &, double &) const;
       const bool isBadGsfTrack(const reco::GsfTrack &) const;
-      int isCloseToBadEcalChannel(const double &);
+      int isCloseToBadEcalChannel(const osu::DeadEcalChannels &, const double &) const;
       template<class T> const int extraMissingMiddleHits(const T &) const;
       template<class T> const int extraMissingOuterHits(const T &) const;
 
+      const double hitDropRandom(const unsigned, const unsigned) const;
+      const bool dropTOBDecision() const;
+      const bool dropHitDecision(const unsigned) const;
+      const bool dropMiddleHitDecision(const unsigned) const;
+
       const double energyGivenMass(const double) const;
 
       const std::array<reco::HitPattern::HitCategory, 3> hitCategories = {{reco::HitPattern::TRACK_HITS, reco::HitPattern::MISSING_INNER_HITS, reco::HitPattern::MISSING_OUTER_HITS}};
@@ -302,10 +351,10 @@ namespace osu
                          const edm::Handle<vector<osu::Mcparticle> > &);
       SecondaryTrackBase(const TYPE(tracks) &, 
                          const edm::Handle<vector<osu::Mcparticle> > &, 
-                         const edm::ParameterSet &);
+                         const TrackConfig &);
       SecondaryTrackBase(const TYPE(tracks) &, 
                          const edm::Handle<vector<osu::Mcparticle> > &, 
-                         const edm::ParameterSet &, 
+                         const TrackConfig &, 
                          const edm::Handle<vector<reco::GsfTrack> > &, 
                          const EtaPhiList &, 
                          const EtaPhiList &);
@@ -313,12 +362,11 @@ namespace osu
                          const edm::Handle<vector<osu::Mcparticle> > &, 
                          const edm::Handle<vector<pat::PackedCandidate> > &, 
                          const edm::Handle<vector<TYPE(jets)> > &,
-                         const edm::ParameterSet &, 
+                         const TrackConfig &, 
                          const edm::Handle<vector<reco::GsfTrack> > &, 
                          const EtaPhiList &, 
                          const EtaPhiList &, 
-                         const map<DetId, vector<double> > * const, 
-                         const map<DetId, vector<int> > * const, 
+                         const osu::DeadEcalChannels &, 
                          const bool);
 
       ~SecondaryTrackBase();
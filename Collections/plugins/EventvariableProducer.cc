@@ -5,13 +5,16 @@
 #include "OSUT3Analysis/AnaTools/interface/CommonUtils.h"
 
 EventvariableProducer::EventvariableProducer (const edm::ParameterSet &cfg) :
-  collections_ (cfg.getParameter<edm::ParameterSet> ("collections"))
+  collections_ (cfg.getParameter<edm::ParameterSet> ("collections")),
+  schema_      (NULL)
 {
   collection_ = collections_.getParameter<edm::InputTag> ("eventvariables");
 
   produces<osu::Eventvariable> (collection_.instance ());
+  produces<vector<string>, edm::InRun> (collection_.instance ());
 
   token_ = consumes<TYPE(eventvariables)> (collection_);
+  namesToken_ = consumes<vector<string>, edm::InRun> (collection_);
 }
 
 EventvariableProducer::~EventvariableProducer ()
@@ -25,11 +28,31 @@ EventvariableProducer::produce (edm::Event &event, const edm::EventSetup &setup)
   if (!event.getByToken (token_, collection))
     return;
 
+  if (collection->schema ())
+    schema_ = collection->schema ();
   pl_ = unique_ptr<osu::Eventvariable> (new osu::Eventvariable (*collection));
   event.put (std::move (pl_), collection_.instance ());
   pl_.reset ();
 }
 
+void
+EventvariableProducer::endRunProduce (edm::Run &run, const edm::EventSetup &setup)
+{
+  //////////////////////////////////////////////////////////////////////////////
+  // The names are taken from the schema of the producer if the payloads were
+  // made in this job, and otherwise from those written for the run by the job
+  // which made them.
+  //////////////////////////////////////////////////////////////////////////////
+  unique_ptr<vector<string> > names (new vector<string> ());
+  edm::Handle<vector<string> > inputNames;
+  if (schema_)
+    *names = schema_->names ();
+  else if (run.getByToken (namesToken_, inputNames))
+    *names = *inputNames;
+  run.put (std::move (names), collection_.instance ());
+  //////////////////////////////////////////////////////////////////////////////
+}
+
 #include "FWCore/Framework/interface/MakerMacros.h"
 DEFINE_FWK_MODULE(EventvariableProducer);
 
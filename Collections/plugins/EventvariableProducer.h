@@ -1,20 +1,22 @@
 #ifndef EVENTVARIABLE_PRODUCER
 #define EVENTVARIABLE_PRODUCER
 
-#include "FWCore/Framework/interface/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/Run.h"
+#include "FWCore/Framework/interface/one/EDProducer.h"
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
 
 #include "OSUT3Analysis/Collections/interface/Eventvariable.h"
 
-class EventvariableProducer : public edm::EDProducer
+class EventvariableProducer : public edm::one::EDProducer<edm::EndRunProducer>
 {
   public:
     EventvariableProducer (const edm::ParameterSet &);
     ~EventvariableProducer ();
 
-    void produce (edm::Event &, const edm::EventSetup &);
+    void produce (edm::Event &, const edm::EventSetup &) override;
+    void endRunProduce (edm::Run &, const edm::EventSetup &) override;
 
   private:
     ////////////////////////////////////////////////////////////////////////////
@@ -23,8 +25,13 @@ class EventvariableProducer : public edm::EDProducer
     edm::ParameterSet  collections_;
     edm::InputTag      collection_;
     edm::EDGetTokenT<TYPE(eventvariables)> token_;
+    edm::EDGetTokenT<vector<string> > namesToken_;
     ////////////////////////////////////////////////////////////////////////////
 
+    // Schema of the producer of the payloads copied in this job, whose names
+    // are copied for each run along with the payloads.
+    const EventVariableSchema *schema_;
+
     // Payload for this EDFilter.
     unique_ptr<osu::Eventvariable> pl_;
 };
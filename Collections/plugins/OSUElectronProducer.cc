@@ -67,6 +67,7 @@ OSUElectronProducer::produce (edm::Event &event, const edm::EventSetup &setup)
 
   Handle<vector<osu::Mcparticle> > particles;
   event.getByToken (mcparticleToken_, particles);
+  cfg_.eventID = event.id ();
 
   Handle<vector<reco::GenParticle> > prunedParticles;
   event.getByToken (prunedParticleToken_, prunedParticles);
@@ -242,6 +243,7 @@ OSUElectronProducer::produce (edm::Event &event, const edm::EventSetup &setup)
     return;
   edm::Handle<vector<osu::Mcparticle> > particles;
   event.getByToken (mcparticleToken_, particles);
+  cfg_.eventID = event.id ();
 
   pl_ = unique_ptr<vector<osu::Electron> > (new vector<osu::Electron> ());
   for (const auto &object : *collection)
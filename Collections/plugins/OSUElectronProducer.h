@@ -42,7 +42,7 @@ class OSUElectronProducer : public edm::EDProducer
     edm::EDGetTokenT<edm::ValueMap<bool> > vidMediumIdMapToken_;
     edm::EDGetTokenT<edm::ValueMap<bool> > vidTightIdMapToken_;
 
-    edm::ParameterSet  cfg_;
+    osu::GenMatchConfig  cfg_;
     edm::InputTag      pfCandidate_;
     edm::InputTag      conversions_;
     edm::InputTag      rho_;
@@ -55,6 +55,7 @@ OSUGenericJetProducer<T>::produce (edm::Event &event, const edm::EventSetup &set
 #ifndef STOPPPED_PTLS
   edm::Handle<vector<osu::Mcparticle> > particles;
   event.getByToken (mcparticleToken_, particles);
+  cfg_.eventID = event.id ();
 
 #if DATA_FORMAT_FROM_MINIAOD
   // get JetCorrector parameters to get the jec uncertainty
@@ -48,7 +48,7 @@ class OSUGenericJetProducer : public edm::EDProducer
   edm::EDGetTokenT<double> rhoToken_;
   edm::EDGetTokenT<vector<TYPE(primaryvertexs)> > primaryvertexsToken_;
 
-  edm::ParameterSet  cfg_;
+  osu::GenMatchConfig  cfg_;
   ////////////////////////////////////////////////////////////////////////////
 
   // Payload for this EDFilter.
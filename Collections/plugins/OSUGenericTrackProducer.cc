@@ -1,7 +1,10 @@
 #include "TFile.h"
 #include "TH2D.h"
 
+#include "FWCore/Framework/interface/getProcessParameterSetContainingModule.h"
 #include "FWCore/ParameterSet/interface/FileInPath.h"
+#include "FWCore/ServiceRegistry/interface/Service.h"
+#include "FWCore/Utilities/interface/RandomNumberGenerator.h"
 
 #include "OSUT3Analysis/Collections/plugins/OSUGenericTrackProducer.h"
 
@@ -17,7 +20,14 @@ template<class T>
 OSUGenericTrackProducer<T>::OSUGenericTrackProducer (const edm::ParameterSet &cfg) :
   collections_ (cfg.getParameter<edm::ParameterSet> ("collections")),
   cfg_ (cfg),
-  useEraByEraFiducialMaps_ (cfg.getParameter<bool> ("useEraByEraFiducialMaps"))
+  useEraByEraFiducialMaps_ (cfg.getParameter<bool> ("useEraByEraFiducialMaps")),
+  hitDropJobSeed_ (0),
+  deadEcalChannelsCacheDir_ (cfg.getUntrackedParameter<string> ("deadEcalChannelsCacheDir", "")),
+  ecalStatusCacheID_ (0),
+  caloGeometryCacheID_ (0),
+  trackGrid_ (0.2),
+  ecalRecHitGrid_ (0.1),
+  hcalRecHitGrid_ (0.1)
 {
   collection_ = collections_.getParameter<edm::InputTag> ("tracks");
 
@@ -101,6 +111,17 @@ OSUGenericTrackProducer<T>::OSUGenericTrackProducer (const edm::ParameterSet &cf
 
   sort (electronVetoList_.begin (), electronVetoList_.end (), [] (EtaPhi a, EtaPhi b) -> bool { return (a.eta < b.eta && a.phi < b.phi); });
   sort (muonVetoList_.begin (), muonVetoList_.end (), [] (EtaPhi a, EtaPhi b) -> bool { return (a.eta < b.eta && a.phi < b.phi); });
+  electronVetoList_.buildGrid ();
+  muonVetoList_.buildGrid ();
+
+  ss << "================================================================================" << endl;
+  ss << "probabilities of dropping hits in simulation" << endl;
+  ss << "--------------------------------------------------------------------------------" << endl;
+  ss  <<  "dropTOBProbability:         "  <<  (cfg_.dropTOBProbability          *  100.0)  <<  "%"   <<  endl
+      <<  "preTOBDropHitProbability:   "  <<  (cfg_.preTOBDropHitInefficiency   *  100.0)  <<  "%"   <<  endl
+      <<  "postTOBDropHitProbability:  "  <<  (cfg_.postTOBDropHitInefficiency  *  100.0)  <<  "%"   <<  endl
+      <<  "hitProbability:             "  <<  (cfg_.hitInefficiency             *  100.0)  <<  "%"   <<  endl;
+  ss << "================================================================================" << endl;
 
   ss << "================================================================================" << endl;
   ss << "electron veto regions in (eta, phi)" << endl;
@@ -127,9 +148,35 @@ OSUGenericTrackProducer<T>::~OSUGenericTrackProducer ()
 template<class T> void 
 OSUGenericTrackProducer<T>::beginRun (const edm::Run &run, const edm::EventSetup& setup)
 {
+  // The hit-dropping decisions are keyed by the seed of this module in the
+  // RandomNumberGeneratorService, if it has one, and by the event and the
+  // index of the track, so they are the same whenever the job is rerun.
+  edm::Service<edm::RandomNumberGenerator> rng;
+  if (rng.isAvailable ())
+    {
+      try
+        {
+          hitDropJobSeed_ = rng->mySeed ();
+        }
+      catch (cms::Exception &)
+        {
+          hitDropJobSeed_ = 0;
+        }
+    }
+
 #if DATA_FORMAT_FROM_MINIAOD
   envSet (setup);
-  getChannelStatusMaps ();
+
+  // the list of masked channels only needs to be refilled when one of the
+  // records it is made from has changed
+  const unsigned long long ecalStatusCacheID = setup.get<EcalChannelStatusRcd> ().cacheIdentifier (),
+                           caloGeometryCacheID = setup.get<CaloGeometryRecord> ().cacheIdentifier ();
+  if (ecalStatusCacheID != ecalStatusCacheID_ || caloGeometryCacheID != caloGeometryCacheID_)
+    {
+      getChannelStatusMaps (setup);
+      ecalStatusCacheID_ = ecalStatusCacheID;
+      caloGeometryCacheID_ = caloGeometryCacheID;
+    }
 #endif // DATA_FORMAT_FROM_MINIAOD
 }
 
@@ -150,6 +197,7 @@ OSUGenericTrackProducer<T>::produce (edm::Event &event, const edm::EventSetup &s
 
   edm::Handle<vector<osu::Mcparticle> > particles;
   event.getByToken (mcparticleToken_, particles);
+  cfg_.eventID = event.id ();
 
   edm::Handle<EBRecHitCollection> EBRecHits;
   event.getByToken(EBRecHitsToken_, EBRecHits);
@@ -196,6 +244,29 @@ OSUGenericTrackProducer<T>::produce (edm::Event &event, const edm::EventSetup &s
   event.getByToken (candidateTracksToken_, candidateTracks);
 #endif // DISAPP_TRKS
 
+#if defined(DISAPP_TRKS) && DATA_FORMAT_IS_CUSTOM
+  if (!collection->empty () && EBRecHits.isValid () && EERecHits.isValid () && HBHERecHits.isValid ())
+    {
+      ecalRecHitGrid_.clear ();
+      hcalRecHitGrid_.clear ();
+      ecalRecHitEnergies_.clear ();
+      hcalRecHitEnergies_.clear ();
+      addRecHits (*EBRecHits, ecalRecHitGrid_, ecalRecHitEnergies_);
+      addRecHits (*EERecHits, ecalRecHitGrid_, ecalRecHitEnergies_);
+      addRecHits (*HBHERecHits, hcalRecHitGrid_, hcalRecHitEnergies_);
+      ecalRecHitGrid_.build ();
+      hcalRecHitGrid_.build ();
+    }
+
+  if (!collection->empty () && tracks.isValid ())
+    {
+      trackGrid_.clear ();
+      for (const auto &t : *tracks)
+        trackGrid_.add (t.eta (), t.phi ());
+      trackGrid_.build ();
+    }
+#endif
+
 #endif // DATA_FORMAT_FROM_MINIAOD
 
   pl_ = unique_ptr<vector<T> > (new vector<T> ());
@@ -212,8 +283,7 @@ OSUGenericTrackProducer<T>::produce (edm::Event &event, const edm::EventSetup &s
                          gsfTracks,
                          electronVetoList_,
                          muonVetoList_,
-                         &EcalAllDeadChannelsValMap_,
-                         &EcalAllDeadChannelsBitMap_,
+                         deadEcalChannels_,
                          !event.isRealData (),
 #if DATA_FORMAT_FROM_MINIAOD && DATA_FORMAT_IS_2017
                          candidateTracks,
@@ -230,13 +300,16 @@ OSUGenericTrackProducer<T>::produce (edm::Event &event, const edm::EventSetup &s
                          gsfTracks, 
                          electronVetoList_, 
                          muonVetoList_, 
-                         &EcalAllDeadChannelsValMap_, 
-                         &EcalAllDeadChannelsBitMap_, 
+                         deadEcalChannels_, 
                          !event.isRealData ());
 #else
       pl_->emplace_back (object);
 #endif
 
+#if defined(DISAPP_TRKS) || DATA_FORMAT_FROM_MINIAOD
+      pl_->back ().set_hitDropSeed (T::hitDropSeed (hitDropJobSeed_, event.id ().run (), event.id ().luminosityBlock (), event.id ().event (), pl_->size () - 1));
+#endif
+
 #ifdef DISAPP_TRKS
       T &track = pl_->back ();
 
@@ -249,50 +322,30 @@ OSUGenericTrackProducer<T>::produce (edm::Event &event, const edm::EventSetup &s
       // then these values need not be recalculated -- and RecHits can all be dropped
       if (EBRecHits.isValid () && EERecHits.isValid () && HBHERecHits.isValid ())
         {
-          double eEM = 0;
-          double dR = 0.5;
-          for (EBRecHitCollection::const_iterator hit=EBRecHits->begin(); hit!=EBRecHits->end(); hit++) {
-            if (insideCone(track, (*hit).detid(), dR)) {
-              eEM += (*hit).energy();
-              // cout << "       Added EB rec hit with (eta, phi) = "
-              //      << getPosition((*hit).detid()).eta() << ", "
-              //      << getPosition((*hit).detid()).phi() << endl;
-            }
-          }
-          for (EERecHitCollection::const_iterator hit=EERecHits->begin(); hit!=EERecHits->end(); hit++) {
-            if (insideCone(track, (*hit).detid(), dR)) {
-              eEM += (*hit).energy();
-              // cout << "       Added EE rec hit with (eta, phi) = "
-              //      << getPosition((*hit).detid()).eta() << ", "
-              //      << getPosition((*hit).detid()).phi() << endl;
-            }
-          }
-          double eHad = 0;
-          for (HBHERecHitCollection::const_iterator hit = HBHERecHits->begin(); hit != HBHERecHits->end(); hit++) {
-            if (insideCone(track, (*hit).detid(), dR)) {
-              eHad += (*hit).energy();
-            }
-          }
-
-          track.set_caloNewEMDRp5(eEM);
-          track.set_caloNewHadDRp5(eHad);
+          track.set_caloNewEMDRp5 (getCaloEnergy (track, ecalRecHitGrid_, ecalRecHitEnergies_, 0.5));
+          track.set_caloNewHadDRp5 (getCaloEnergy (track, hcalRecHitGrid_, hcalRecHitEnergies_, 0.5));
         }
 
       // this is called only for ntuples with generalTracks explicitly kept (really just signal),
       // to re-calculate the track isolations calculated wrong when ntuples were produces (thus "old" vs not-old)
       if (tracks.isValid ())
         {
-          track.set_trackIsoDRp3 (getTrackIsolation (track, *tracks, false, false, 0.3));
-          track.set_trackIsoDRp5 (getTrackIsolation (track, *tracks, false, false, 0.5));
-          track.set_trackIsoNoPUDRp3 (getTrackIsolation (track, *tracks, true, false, 0.3));
-          track.set_trackIsoNoPUDRp5 (getTrackIsolation (track, *tracks, true, false, 0.5));
-          track.set_trackIsoNoFakesDRp3 (getTrackIsolation (track, *tracks, false, true, 0.3));
-          track.set_trackIsoNoFakesDRp5 (getTrackIsolation (track, *tracks, false, true, 0.5));
-          track.set_trackIsoNoPUNoFakesDRp3 (getTrackIsolation (track, *tracks, true, true, 0.3));
-          track.set_trackIsoNoPUNoFakesDRp5 (getTrackIsolation (track, *tracks, true, true, 0.5));
-
-          track.set_trackIsoOldNoPUDRp3 (getOldTrackIsolation (track, *tracks, true, 0.3));
-          track.set_trackIsoOldNoPUDRp5 (getOldTrackIsolation (track, *tracks, true, 0.5));
+          double sumPt[2][2][2];
+          getTrackIsolations (track, *tracks, sumPt);
+
+          track.set_trackIsoDRp3 (sumPt[false][false][0]);
+          track.set_trackIsoDRp5 (sumPt[false][false][1]);
+          track.set_trackIsoNoPUDRp3 (sumPt[true][false][0]);
+          track.set_trackIsoNoPUDRp5 (sumPt[true][false][1]);
+          track.set_trackIsoNoFakesDRp3 (sumPt[false][true][0]);
+          track.set_trackIsoNoFakesDRp5 (sumPt[false][true][1]);
+          track.set_trackIsoNoPUNoFakesDRp3 (sumPt[true][true][0]);
+          track.set_trackIsoNoPUNoFakesDRp5 (sumPt[true][true][1]);
+
+          // the "old" isolation with pileup removed also removed fake tracks,
+          // so it is the same sum as the one with both removed
+          track.set_trackIsoOldNoPUDRp3 (sumPt[true][true][0]);
+          track.set_trackIsoOldNoPUDRp5 (sumPt[true][true][1]);
         }
 #endif // DATA_FORMAT_IS_CUSTOM
 
@@ -311,13 +364,31 @@ OSUGenericTrackProducer<T>::produce (edm::Event &event, const edm::EventSetup &s
   pl_.reset ();
 }
 
-template<class T> bool 
-OSUGenericTrackProducer<T>::insideCone(TYPE(tracks)& candTrack, const DetId& id, const double dR)
+template<class T> template<class RecHits> void 
+OSUGenericTrackProducer<T>::addRecHits (const RecHits &recHits, osu::EtaPhiGrid &grid, vector<double> &energies)
+{
+  for (const auto &hit : recHits)
+    {
+      GlobalPoint position = getPosition (hit.detid ());
+      if (position.mag () < 0.01)
+        continue;
+      math::XYZVector positionRoot (position.x (), position.y (), position.z ());
+      grid.add (positionRoot.eta (), positionRoot.phi ());
+      energies.push_back (hit.energy ());
+    }
+}
+
+template<class T> const double 
+OSUGenericTrackProducer<T>::getCaloEnergy (const T &track, const osu::EtaPhiGrid &grid, const vector<double> &energies, const double dR)
 {
-   GlobalPoint idPosition = getPosition(id);
-   if (idPosition.mag()<0.01) return false;
-   math::XYZVector idPositionRoot( idPosition.x(), idPosition.y(), idPosition.z() );
-   return deltaR(candTrack, idPositionRoot) < dR;
+  double energy = 0.0;
+
+  grid.candidates (track.eta (), track.phi (), dR, candidates_);
+  for (const auto &i : candidates_)
+    if (deltaR (track.eta (), track.phi (), grid.eta (i), grid.phi (i)) < dR)
+      energy += energies.at (i);
+
+  return energy;
 }
 
 template<class T> GlobalPoint 
@@ -454,10 +525,23 @@ OSUGenericTrackProducer<T>::envSet (const edm::EventSetup& iSetup)
 }
 
 template<class T> int 
-OSUGenericTrackProducer<T>::getChannelStatusMaps ()
+OSUGenericTrackProducer<T>::getChannelStatusMaps (const edm::EventSetup &setup)
 {
-  EcalAllDeadChannelsValMap_.clear(); EcalAllDeadChannelsBitMap_.clear();
-  TH2D *badChannels = (outputBadEcalChannels_ ? new TH2D ("badChannels", ";#eta;#phi", 360, -3.0, 3.0, 360, -3.2, 3.2) : NULL);
+  string key = "", cacheFile = "";
+  if (!deadEcalChannelsCacheDir_.empty ())
+    {
+      key = deadEcalChannelsKey (setup);
+      cacheFile = deadEcalChannelsCacheDir_ + "/deadEcalChannels_" + key + ".bin";
+      if (deadEcalChannels_.read (cacheFile, key))
+        {
+          edm::LogInfo ("OSUGenericTrackProducer") << "Read " << deadEcalChannels_.size () << " masked ECAL channels from \"" << cacheFile << "\".";
+          if (outputBadEcalChannels_)
+            plotBadEcalChannels ();
+          return 1;
+        }
+    }
+
+  deadEcalChannels_.clear();
 
 // Loop over EB ...
   for( int ieta=-85; ieta<=85; ieta++ ){
@@ -473,16 +557,9 @@ OSUGenericTrackProducer<T>::getChannelStatusMaps ()
         auto cellGeom = subGeom->getGeometry (detid);
         double eta = cellGeom->getPosition ().eta ();
         double phi = cellGeom->getPosition ().phi ();
-        double theta = cellGeom->getPosition().theta();
 
         if(status >= maskedEcalChannelStatusThreshold_){
-           std::vector<double> valVec; std::vector<int> bitVec;
-           valVec.push_back(eta); valVec.push_back(phi); valVec.push_back(theta);
-           bitVec.push_back(1); bitVec.push_back(ieta); bitVec.push_back(iphi); bitVec.push_back(status);
-           EcalAllDeadChannelsValMap_.insert( std::make_pair(detid, valVec) );
-           EcalAllDeadChannelsBitMap_.insert( std::make_pair(detid, bitVec) );
-           if (outputBadEcalChannels_)
-             badChannels->Fill (eta, phi);
+           deadEcalChannels_.add(eta, phi, status);
         }
      } // end loop iphi
   } // end loop ieta
@@ -502,80 +579,110 @@ OSUGenericTrackProducer<T>::getChannelStatusMaps ()
            auto cellGeom = subGeom->getGeometry (detid);
            double eta = cellGeom->getPosition ().eta () ;
            double phi = cellGeom->getPosition ().phi () ;
-           double theta = cellGeom->getPosition().theta();
 
            if(status >= maskedEcalChannelStatusThreshold_){
-              std::vector<double> valVec; std::vector<int> bitVec;
-              valVec.push_back(eta); valVec.push_back(phi); valVec.push_back(theta);
-              bitVec.push_back(2); bitVec.push_back(ix); bitVec.push_back(iy); bitVec.push_back(iz); bitVec.push_back(status);
-              EcalAllDeadChannelsValMap_.insert( std::make_pair(detid, valVec) );
-              EcalAllDeadChannelsBitMap_.insert( std::make_pair(detid, bitVec) );
-               if (outputBadEcalChannels_)
-                 badChannels->Fill (eta, phi);
+              deadEcalChannels_.add(eta, phi, status);
            }
         } // end loop iz
      } // end loop iy
   } // end loop ix
 
-  if (outputBadEcalChannels_)
-    {
-      TFile *fout = new TFile ("badEcalChannels.root", "recreate");
-      fout->cd ();
-      badChannels->Write ();
-      fout->Close ();
+  deadEcalChannels_.sort();
 
-      delete badChannels;
-      delete fout;
+  if (!cacheFile.empty ())
+    {
+      if (deadEcalChannels_.write (cacheFile, key))
+        edm::LogInfo ("OSUGenericTrackProducer") << "Saved " << deadEcalChannels_.size () << " masked ECAL channels to \"" << cacheFile << "\".";
+      else
+        edm::LogWarning ("OSUGenericTrackProducer") << "Could not save the masked ECAL channels to \"" << cacheFile << "\".";
     }
 
+  if (outputBadEcalChannels_)
+    plotBadEcalChannels ();
+
   return 1;
 }
 
-template<class T> const double 
-OSUGenericTrackProducer<T>::getTrackIsolation (const reco::Track &track, const vector<reco::Track> &tracks, const bool noPU, const bool noFakes, const double outerDeltaR, const double innerDeltaR) const
+// The cache of masked channels is only valid for the same conditions, which
+// are identified by the global tag, the start of the interval of validity of
+// the channel status, and the status threshold. Characters which would be a
+// problem in a file name are replaced.
+template<class T> const string 
+OSUGenericTrackProducer<T>::deadEcalChannelsKey (const edm::EventSetup &setup) const
 {
-  double sumPt = 0.0;
-
-  for (const auto &t : tracks)
+  string globalTag = "noGlobalTag";
+  const edm::ParameterSet &process = edm::getProcessParameterSetContainingModule (moduleDescription ());
+  if (process.existsAs<edm::ParameterSet> ("GlobalTag"))
     {
+      const edm::ParameterSet &globalTagSource = process.getParameterSet ("GlobalTag");
+      if (globalTagSource.existsAs<string> ("globaltag"))
+        globalTag = globalTagSource.getParameter<string> ("globaltag");
+    }
 
-      if (noFakes && (t.normalizedChi2() > 20.0 ||
-                      t.hitPattern().pixelLayersWithMeasurement() < 2 ||
-                      t.hitPattern().trackerLayersWithMeasurement() < 5 ||
-                      fabs(t.d0() / t.d0Error()) > 5.0))
-        continue;
-      if (noPU && track.dz(t.vertex()) > 3.0 * hypot(track.dzError(), t.dzError()))
-        continue;
+  const edm::IOVSyncValue &iovStart = setup.get<EcalChannelStatusRcd> ().validityInterval ().first ();
 
-      double dR = deltaR (track, t);
-      if (dR < outerDeltaR && dR > innerDeltaR)
-        sumPt += t.pt ();
-    }
+  stringstream key;
+  key << globalTag << "_run" << iovStart.eventID ().run () << "_lumi" << iovStart.eventID ().luminosityBlock () << "_status" << maskedEcalChannelStatusThreshold_;
 
-  return sumPt;
+  string k = key.str ();
+  for (auto &c : k)
+    if (!isalnum (c) && c != '_' && c != '-' && c != '.')
+      c = '_';
+  return k;
 }
 
-// this is actually a fix of a bugged function, normally it would be track. instead of t.
-template<class T> const double 
-OSUGenericTrackProducer<T>::getOldTrackIsolation (const reco::Track &track, const vector<reco::Track> &tracks, const bool noPU, const double outerDeltaR, const double innerDeltaR) const
+template<class T> void 
+OSUGenericTrackProducer<T>::plotBadEcalChannels () const
 {
-  double sumPt = 0.0;
+  TH2D *badChannels = new TH2D ("badChannels", ";#eta;#phi", 360, -3.0, 3.0, 360, -3.2, 3.2);
+  for (unsigned i = 0; i != deadEcalChannels_.size (); i++)
+    badChannels->Fill (deadEcalChannels_.eta (i), deadEcalChannels_.phi (i));
 
-  for (const auto &t : tracks)
+  TFile *fout = new TFile ("badEcalChannels.root", "recreate");
+  fout->cd ();
+  badChannels->Write ();
+  fout->Close ();
+
+  delete badChannels;
+  delete fout;
+}
+
+template<class T> void 
+OSUGenericTrackProducer<T>::getTrackIsolations (const reco::Track &track, const vector<reco::Track> &tracks, double sumPt[2][2][2])
+{
+  const double outerDeltaR[2] = {0.3, 0.5},
+               innerDeltaR = 1.0e-12;
+
+  for (int noPU = 0; noPU < 2; noPU++)
+    for (int noFakes = 0; noFakes < 2; noFakes++)
+      for (int cone = 0; cone < 2; cone++)
+        sumPt[noPU][noFakes][cone] = 0.0;
+
+  trackGrid_.candidates (track.eta (), track.phi (), outerDeltaR[1], candidates_);
+  for (const auto &i : candidates_)
     {
-      if (noPU && (t.normalizedChi2() > 20.0 ||
-                   t.hitPattern().pixelLayersWithMeasurement() < 2 ||
-                   t.hitPattern().trackerLayersWithMeasurement() < 5 ||
-                   fabs(t.d0() / t.d0Error()) > 5.0 ||
-                   track.dz(t.vertex()) > 3.0 * hypot(track.dzError(), t.dzError())))
-        continue;
+      const reco::Track &t = tracks.at (i);
 
       double dR = deltaR (track, t);
-      if (dR < outerDeltaR && dR > innerDeltaR)
-        sumPt += t.pt ();
-    }
+      if (!(dR < outerDeltaR[1] && dR > innerDeltaR))
+        continue;
 
-  return sumPt;
+      bool isFake = (t.normalizedChi2() > 20.0 ||
+                     t.hitPattern().pixelLayersWithMeasurement() < 2 ||
+                     t.hitPattern().trackerLayersWithMeasurement() < 5 ||
+                     fabs(t.d0() / t.d0Error()) > 5.0);
+      bool isPU = track.dz(t.vertex()) > 3.0 * hypot(track.dzError(), t.dzError());
+
+      for (int noPU = 0; noPU < 2; noPU++)
+        for (int noFakes = 0; noFakes < 2; noFakes++)
+          {
+            if ((noPU && isPU) || (noFakes && isFake))
+              continue;
+            for (int cone = 0; cone < 2; cone++)
+              if (dR < outerDeltaR[cone])
+                sumPt[noPU][noFakes][cone] += t.pt ();
+          }
+    }
 }
 
 #include "FWCore/Framework/interface/MakerMacros.h"
@@ -71,11 +71,14 @@ template<class T>
 
     edm::EDGetTokenT<vector<reco::Track> >       tracksToken_;
     edm::EDGetTokenT<vector<pat::PackedCandidate> > pfCandidatesToken_;
-    edm::ParameterSet  cfg_;
+    typename T::Config  cfg_;
     ////////////////////////////////////////////////////////////////////////////
 
     bool useEraByEraFiducialMaps_;
 
+    // Seed of this module in the RandomNumberGeneratorService, or zero.
+    unsigned long long hitDropJobSeed_;
+
     EtaPhiList electronVetoList_;
     EtaPhiList muonVetoList_;
 
@@ -84,21 +87,46 @@ template<class T>
 
     void extractFiducialMap (const edm::ParameterSet &, EtaPhiList &, stringstream &) const;
     void envSet (const edm::EventSetup &);
-    int getChannelStatusMaps ();
+    int getChannelStatusMaps (const edm::EventSetup &);
+    const string deadEcalChannelsKey (const edm::EventSetup &) const;
+    void plotBadEcalChannels () const;
 
     edm::ESHandle<CaloGeometry> caloGeometry_;
     edm::ESHandle<EcalChannelStatus> ecalStatus_;
-    bool insideCone(TYPE(tracks)& track, const DetId& id, const double dR);
     GlobalPoint getPosition( const DetId& id);
 
     int maskedEcalChannelStatusThreshold_;
     bool outputBadEcalChannels_;
 
-    map<DetId, vector<double> > EcalAllDeadChannelsValMap_;
-    map<DetId, vector<int> >    EcalAllDeadChannelsBitMap_;
+    // The masked ECAL channels, refilled only when the channel status or the
+    // geometry changes. If deadEcalChannelsCacheDir_ is not empty, they are
+    // also saved there for each global tag and interval of validity, and read
+    // back instead of walking over all the crystals again.
+    osu::DeadEcalChannels deadEcalChannels_;
+    string deadEcalChannelsCacheDir_;
+    unsigned long long ecalStatusCacheID_;
+    unsigned long long caloGeometryCacheID_;
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Grids of the general tracks and of the calorimeter rechits, refilled for
+    // each event, so that the isolation sums and calorimeter energies of each
+    // track only need the objects near it.
+    ////////////////////////////////////////////////////////////////////////////
+    osu::EtaPhiGrid trackGrid_;
+    osu::EtaPhiGrid ecalRecHitGrid_;
+    osu::EtaPhiGrid hcalRecHitGrid_;
+    vector<double> ecalRecHitEnergies_;
+    vector<double> hcalRecHitEnergies_;
+    vector<unsigned> candidates_;
+    ////////////////////////////////////////////////////////////////////////////
+
+    template<class RecHits> void addRecHits (const RecHits &, osu::EtaPhiGrid &, vector<double> &);
+    const double getCaloEnergy (const T &, const osu::EtaPhiGrid &, const vector<double> &, const double);
 
-    const double getTrackIsolation (const reco::Track &, const vector<reco::Track> &, const bool, const bool, const double, const double = 1.0e-12) const;
-    const double getOldTrackIsolation (const reco::Track &, const vector<reco::Track> &, const bool, const double, const double = 1.0e-12) const;
+    // Fills the last argument with the scalar sum of the pt of the general
+    // tracks around a track, indexed by [noPU][noFakes][cone], where the cones
+    // are dR < 0.3 and dR < 0.5.
+    void getTrackIsolations (const reco::Track &, const vector<reco::Track> &, double [2][2][2]);
 };
 
 #endif
@@ -28,6 +28,7 @@ OSUGenjetProducer::produce (edm::Event &event, const edm::EventSetup &setup)
     return;
   edm::Handle<vector<osu::Mcparticle> > particles;
   event.getByToken (mcparticleToken_, particles);
+  cfg_.eventID = event.id ();
 
   pl_ = unique_ptr<vector<osu::Genjet> > (new vector<osu::Genjet> ());
   for (const auto &object : *collection)
@@ -24,7 +24,7 @@ class OSUGenjetProducer : public edm::EDProducer
     edm::InputTag      collection_;
     edm::EDGetTokenT<vector<TYPE(genjets)> > token_;
     edm::EDGetTokenT<vector<osu::Mcparticle> > mcparticleToken_;
-    edm::ParameterSet  cfg_;
+    osu::GenMatchConfig  cfg_;
     ////////////////////////////////////////////////////////////////////////////
 
     // Payload for this EDFilter.
@@ -60,6 +60,7 @@ OSUMuonProducer::produce (edm::Event &event, const edm::EventSetup &setup)
 
   Handle<vector<osu::Mcparticle> > particles;
   event.getByToken (mcparticleToken_, particles);
+  cfg_.eventID = event.id ();
 
   Handle<vector<reco::GenParticle> > prunedParticles;
   event.getByToken (prunedParticleToken_, prunedParticles);
@@ -223,8 +224,7 @@ OSUMuonProducer::produce (edm::Event &event, const edm::EventSetup &setup)
 #include "OSUT3Analysis/AnaTools/interface/CommonUtils.h"
 
 OSUMuonProducer::OSUMuonProducer (const edm::ParameterSet &cfg) :
-  collections_ (cfg.getParameter<edm::ParameterSet> ("collections")),
-  cfg_ (cfg)
+  collections_ (cfg.getParameter<edm::ParameterSet> ("collections"))
 {
   collection_ = collections_.getParameter<edm::InputTag> ("muons");
 
@@ -36,7 +36,7 @@ class OSUMuonProducer : public edm::EDProducer
     edm::EDGetTokenT<vector<pat::TriggerObjectStandAlone> > trigobjsToken_;
 #endif
 
-    edm::ParameterSet  cfg_;
+    osu::GenMatchConfig  cfg_;
     edm::InputTag      pfCandidate_;
     edm::InputTag      rho_;
     double             d0SmearingWidth_;
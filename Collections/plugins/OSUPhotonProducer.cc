@@ -40,6 +40,7 @@ OSUPhotonProducer::produce (edm::Event &event, const edm::EventSetup &setup)
     return;
   edm::Handle<vector<osu::Mcparticle> > particles;
   event.getByToken (mcparticleToken_, particles);
+  cfg_.eventID = event.id ();
 
   edm::Handle<double> rho;
 
@@ -29,7 +29,7 @@ class OSUPhotonProducer : public edm::EDProducer
     edm::EDGetTokenT<edm::ValueMap<bool> > vidLooseIdMapToken_;
     edm::EDGetTokenT<edm::ValueMap<bool> > vidMediumIdMapToken_;
     edm::EDGetTokenT<edm::ValueMap<bool> > vidTightIdMapToken_;
-    edm::ParameterSet  cfg_;
+    osu::GenMatchConfig  cfg_;
     edm::InputTag      rho_;
     edm::InputTag      vidLooseIdMap_;
     edm::InputTag      vidMediumIdMap_;
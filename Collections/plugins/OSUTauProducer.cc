@@ -33,6 +33,7 @@ OSUTauProducer::produce (edm::Event &event, const edm::EventSetup &setup)
     return;
   edm::Handle<vector<osu::Mcparticle> > particles;
   event.getByToken (mcparticleToken_, particles);
+  cfg_.eventID = event.id ();
   edm::Handle<vector<osu::Met> > met;
   event.getByToken (metToken_, met);
   edm::Handle<edm::TriggerResults> triggers;
@@ -29,7 +29,7 @@ class OSUTauProducer : public edm::EDProducer
 #if IS_VALID(trigobjs)
     edm::EDGetTokenT<vector<pat::TriggerObjectStandAlone> > trigobjsToken_;
 #endif
-    edm::ParameterSet  cfg_;
+    osu::GenMatchConfig  cfg_;
     ////////////////////////////////////////////////////////////////////////////
 
     // Payload for this EDFilter.
@@ -24,7 +24,7 @@ class OSUTrigobjProducer : public edm::EDProducer
     edm::InputTag      collection_;
     edm::EDGetTokenT<vector<TYPE(trigobjs)> > token_;
     edm::EDGetTokenT<vector<osu::Mcparticle> > mcparticleToken_;
-    edm::ParameterSet  cfg_;
+    osu::GenMatchConfig  cfg_;
     ////////////////////////////////////////////////////////////////////////////
 
     // Payload for this EDFilter.
@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+
+#include <unistd.h>
+
+#include "DataFormats/Math/interface/deltaR.h"
+
+#include "OSUT3Analysis/Collections/interface/DeadEcalChannels.h"
+
+namespace
+{
+  // added to the half-width of each eta window so that rounding never drops
+  // a channel exactly on the edge of the cone
+  const double MARGIN = 1.0e-6;
+
+  // identifies the format of the cache files; change it whenever the format
+  // changes so that old files are ignored
+  const char MAGIC[8] = {'O', 'S', 'U', 'D', 'E', 'C', '0', '1'};
+
+  // more than the number of crystals in the ECAL, so that a corrupted file
+  // is rejected instead of causing a huge allocation
+  const uint64_t MAX_CHANNELS = 1 << 20;
+  const uint32_t MAX_KEY_LENGTH = 1 << 12;
+}
+
+osu::DeadEcalChannels::DeadEcalChannels ()
+{
+}
+
+void
+osu::DeadEcalChannels::clear ()
+{
+  eta_.clear ();
+  phi_.clear ();
+  status_.clear ();
+}
+
+void
+osu::DeadEcalChannels::add (const double eta, const double phi, const int status)
+{
+  eta_.push_back (eta);
+  phi_.push_back (phi);
+  status_.push_back (status);
+}
+
+void
+osu::DeadEcalChannels::sort ()
+{
+  vector<unsigned> order (eta_.size ());
+  iota (order.begin (), order.end (), 0);
+  stable_sort (order.begin (), order.end (), [&] (const unsigned a, const unsigned b) -> bool { return eta_.at (a) < eta_.at (b); });
+
+  vector<double> eta, phi;
+  vector<int> status;
+  eta.reserve (order.size ());
+  phi.reserve (order.size ());
+  status.reserve (order.size ());
+  for (const auto &i : order)
+    {
+      eta.push_back (eta_.at (i));
+      phi.push_back (phi_.at (i));
+      status.push_back (status_.at (i));
+    }
+  eta_.swap (eta);
+  phi_.swap (phi);
+  status_.swap (status);
+}
+
+unsigned
+osu::DeadEcalChannels::size () const
+{
+  return eta_.size ();
+}
+
+double
+osu::DeadEcalChannels::eta (const unsigned i) const
+{
+  return eta_.at (i);
+}
+
+double
+osu::DeadEcalChannels::phi (const unsigned i) const
+{
+  return phi_.at (i);
+}
+
+int
+osu::DeadEcalChannels::status (const unsigned i) const
+{
+  return status_.at (i);
+}
+
+pair<unsigned, unsigned>
+osu::DeadEcalChannels::etaWindow (const double minEta, const double maxEta) const
+{
+  unsigned first = lower_bound (eta_.begin (), eta_.end (), minEta) - eta_.begin (),
+           last = upper_bound (eta_.begin (), eta_.end (), maxEta) - eta_.begin ();
+  return make_pair (first, max (first, last));
+}
+
+bool
+osu::DeadEcalChannels::anyWithin (const double eta, const double phi, const double dR) const
+{
+  if (!isfinite (eta) || !isfinite (phi))
+    return false;
+
+  pair<unsigned, unsigned> window = etaWindow (eta - dR - MARGIN, eta + dR + MARGIN);
+  for (unsigned i = window.first; i != window.second; i++)
+    if (reco::deltaR (eta_.at (i), phi_.at (i), eta, phi) <= dR)
+      return true;
+  return false;
+}
+
+bool
+osu::DeadEcalChannels::read (const string &fileName, const string &key)
+{
+  ifstream fin (fileName, ios::binary);
+  if (!fin)
+    return false;
+
+  char magic[sizeof (MAGIC)];
+  uint32_t keyLength;
+  if (!fin.read (magic, sizeof (magic)) || !equal (magic, magic + sizeof (magic), MAGIC)
+   || !fin.read ((char *) &keyLength, sizeof (keyLength)) || keyLength > MAX_KEY_LENGTH)
+    return false;
+
+  string fileKey (keyLength, '\0');
+  uint64_t n;
+  if (!fin.read (&fileKey[0], keyLength) || fileKey != key
+   || !fin.read ((char *) &n, sizeof (n)) || n > MAX_CHANNELS)
+    return false;
+
+  vector<double> eta (n), phi (n);
+  vector<int32_t> status (n);
+  if (!fin.read ((char *) eta.data (), n * sizeof (double))
+   || !fin.read ((char *) phi.data (), n * sizeof (double))
+   || !fin.read ((char *) status.data (), n * sizeof (int32_t)))
+    return false;
+
+  eta_.swap (eta);
+  phi_.swap (phi);
+  status_.assign (status.begin (), status.end ());
+  return true;
+}
+
+bool
+osu::DeadEcalChannels::write (const string &fileName, const string &key) const
+{
+  // write to a temporary file and rename it, so that jobs sharing the cache
+  // never see a partially written file
+  const string tmpName = fileName + "." + to_string (getpid ()) + ".tmp";
+  {
+    ofstream fout (tmpName, ios::binary | ios::trunc);
+    if (!fout)
+      return false;
+
+    uint32_t keyLength = key.size ();
+    uint64_t n = eta_.size ();
+    vector<int32_t> status (status_.begin (), status_.end ());
+    fout.write (MAGIC, sizeof (MAGIC));
+    fout.write ((const char *) &keyLength, sizeof (keyLength));
+    fout.write (key.data (), keyLength);
+    fout.write ((const char *) &n, sizeof (n));
+    fout.write ((const char *) eta_.data (), n * sizeof (double));
+    fout.write ((const char *) phi_.data (), n * sizeof (double));
+    fout.write ((const char *) status.data (), n * sizeof (int32_t));
+    if (!fout)
+      {
+        fout.close ();
+        remove (tmpName.c_str ());
+        return false;
+      }
+  }
+  if (rename (tmpName.c_str (), fileName.c_str ()))
+    {
+      remove (tmpName.c_str ());
+      return false;
+    }
+  return true;
+}
@@ -2,6 +2,45 @@
 
 #ifdef DISAPP_TRKS
 
+osu::DisappearingTrackConfig::DisappearingTrackConfig () :
+  matchCandidateTracks (false),
+  maxDeltaRForCandidateTrackMatching (-1.0),
+  matchIsolatedTracks (false),
+  maxDeltaRForIsolatedTrackMatching (-1.0)
+{
+}
+
+osu::DisappearingTrackConfig::DisappearingTrackConfig (const edm::ParameterSet &cfg) :
+  TrackConfig (cfg),
+  eleVtx_d0Cuts_barrel (cfg.getParameter<vector<double> > ("eleVtx_d0Cuts_barrel")),
+  eleVtx_d0Cuts_endcap (cfg.getParameter<vector<double> > ("eleVtx_d0Cuts_endcap")),
+  eleVtx_dzCuts_barrel (cfg.getParameter<vector<double> > ("eleVtx_dzCuts_barrel")),
+  eleVtx_dzCuts_endcap (cfg.getParameter<vector<double> > ("eleVtx_dzCuts_endcap")),
+  matchCandidateTracks (false),
+  maxDeltaRForCandidateTrackMatching (-1.0),
+  matchIsolatedTracks (false),
+  maxDeltaRForIsolatedTrackMatching (-1.0)
+{
+  assert(eleVtx_d0Cuts_barrel.size() == 4);
+  assert(eleVtx_dzCuts_barrel.size() == 4);
+  assert(eleVtx_d0Cuts_endcap.size() == 4);
+  assert(eleVtx_dzCuts_endcap.size() == 4);
+
+  const string tracksLabel = cfg.getParameter<edm::ParameterSet>("collections").getParameter<edm::InputTag>("tracks").label();
+
+  // if the tracks collection itself is CandidateTracks, don't bother with matching this to itself
+  matchCandidateTracks = (tracksLabel != "candidateTrackProducer");
+  if(matchCandidateTracks)
+    maxDeltaRForCandidateTrackMatching = cfg.getParameter<double> ("maxDeltaRForCandidateTrackMatching");
+
+#if DATA_FORMAT_FROM_MINIAOD && DATA_FORMAT_IS_2017
+  // if the tracks collection itself is IsolatedTracks, don't bother with matching this to itself
+  matchIsolatedTracks = (tracksLabel != "isolatedTracks");
+  if(matchIsolatedTracks)
+    maxDeltaRForIsolatedTrackMatching = cfg.getParameter<double> ("maxDeltaRForIsolatedTrackMatching");
+#endif
+}
+
 #if IS_VALID(tracks)
 
 osu::DisappearingTrack::DisappearingTrack() : 
@@ -99,7 +138,7 @@ osu::DisappearingTrack::DisappearingTrack(const TYPE(tracks) &track,
 }
 
 osu::DisappearingTrack::DisappearingTrack(const TYPE(tracks) &track, 
-                                          const edm::Handle<vector<osu::Mcparticle> > &particles, const edm::ParameterSet &cfg) :
+                                          const edm::Handle<vector<osu::Mcparticle> > &particles, const TrackConfig &cfg) :
   TrackBase(track, particles, cfg),
   deltaRToClosestElectron_       (INVALID_VALUE),
   deltaRToClosestVetoElectron_   (INVALID_VALUE),
@@ -132,7 +171,7 @@ osu::DisappearingTrack::DisappearingTrack(const TYPE(tracks) &track,
 
 osu::DisappearingTrack::DisappearingTrack(const TYPE(tracks) &track, 
                                           const edm::Handle<vector<osu::Mcparticle> > &particles, 
-                                          const edm::ParameterSet &cfg, 
+                                          const TrackConfig &cfg, 
                                           const edm::Handle<vector<reco::GsfTrack> > &gsfTracks, 
                                           const EtaPhiList &electronVetoList, 
                                           const EtaPhiList &muonVetoList) :
@@ -170,14 +209,13 @@ osu::DisappearingTrack::DisappearingTrack(const TYPE(tracks) &track,
                                           const edm::Handle<vector<osu::Mcparticle> > &particles,
                                           const edm::Handle<vector<pat::PackedCandidate> > &pfCandidates, 
                                           const edm::Handle<vector<TYPE(jets)> > &jets,
-                                          const edm::ParameterSet &cfg, 
+                                          const TrackConfig &cfg, 
                                           const edm::Handle<vector<reco::GsfTrack> > &gsfTracks, 
                                           const EtaPhiList &electronVetoList, 
                                           const EtaPhiList &muonVetoList, 
-                                          const map<DetId, vector<double> > * const EcalAllDeadChannelsValMap, 
-                                          const map<DetId, vector<int> > * const EcalAllDeadChannelsBitMap, 
+                                          const osu::DeadEcalChannels &deadEcalChannels, 
                                           const bool dropHits) :
-  TrackBase(track, particles, pfCandidates, jets, cfg, gsfTracks, electronVetoList, muonVetoList, EcalAllDeadChannelsValMap, EcalAllDeadChannelsBitMap, dropHits),
+  TrackBase(track, particles, pfCandidates, jets, cfg, gsfTracks, electronVetoList, muonVetoList, deadEcalChannels, dropHits),
   deltaRToClosestElectron_       (INVALID_VALUE),
   deltaRToClosestVetoElectron_   (INVALID_VALUE),
   deltaRToClosestLooseElectron_  (INVALID_VALUE),
@@ -213,12 +251,11 @@ osu::DisappearingTrack::DisappearingTrack (const TYPE(tracks) &track,
                    const edm::Handle<vector<pat::PackedCandidate> > &pfCandidates,
                    const edm::Handle<vector<pat::PackedCandidate> > &lostTracks,
                    const edm::Handle<vector<TYPE(jets)> > &jets,
-                   const edm::ParameterSet &cfg,
+                   const DisappearingTrackConfig &cfg,
                    const edm::Handle<vector<reco::GsfTrack> > &gsfTracks,
                    const EtaPhiList &electronVetoList,
                    const EtaPhiList &muonVetoList,
-                   const map<DetId, vector<double> > * const EcalAllDeadChannelsValMap,
-                   const map<DetId, vector<int> > * const EcalAllDeadChannelsBitMap,
+                   const osu::DeadEcalChannels &deadEcalChannels,
                    const bool dropHits,
 #if DATA_FORMAT_FROM_MINIAOD && DATA_FORMAT_IS_2017
                    const edm::Handle<vector<CandidateTrack> > &candidateTracks,
@@ -226,7 +263,7 @@ osu::DisappearingTrack::DisappearingTrack (const TYPE(tracks) &track,
 #else
                    const edm::Handle<vector<CandidateTrack> > &candidateTracks) :
 #endif
-  TrackBase(track, particles, pfCandidates, jets, cfg, gsfTracks, electronVetoList, muonVetoList, EcalAllDeadChannelsValMap, EcalAllDeadChannelsBitMap, dropHits),
+  TrackBase(track, particles, pfCandidates, jets, cfg, gsfTracks, electronVetoList, muonVetoList, deadEcalChannels, dropHits),
   deltaRToClosestElectron_       (INVALID_VALUE),
   deltaRToClosestVetoElectron_   (INVALID_VALUE),
   deltaRToClosestLooseElectron_  (INVALID_VALUE),
@@ -254,30 +291,23 @@ osu::DisappearingTrack::DisappearingTrack (const TYPE(tracks) &track,
   pfPhotonIsoDR03_               (INVALID_VALUE),
   pfPUPhotonIsoDR03_             (INVALID_VALUE)
 {
-  eleVtx_d0Cuts_barrel_ = cfg.getParameter<vector<double> > ("eleVtx_d0Cuts_barrel");
-  eleVtx_dzCuts_barrel_ = cfg.getParameter<vector<double> > ("eleVtx_dzCuts_barrel");
-  eleVtx_d0Cuts_endcap_ = cfg.getParameter<vector<double> > ("eleVtx_d0Cuts_endcap");
-  eleVtx_dzCuts_endcap_ = cfg.getParameter<vector<double> > ("eleVtx_dzCuts_endcap");
-
-  assert(eleVtx_d0Cuts_barrel_.size() == 4);
-  assert(eleVtx_dzCuts_barrel_.size() == 4);
-  assert(eleVtx_d0Cuts_endcap_.size() == 4);
-  assert(eleVtx_dzCuts_endcap_.size() == 4);
+  eleVtx_d0Cuts_barrel_ = cfg.eleVtx_d0Cuts_barrel;
+  eleVtx_dzCuts_barrel_ = cfg.eleVtx_dzCuts_barrel;
+  eleVtx_d0Cuts_endcap_ = cfg.eleVtx_d0Cuts_endcap;
+  eleVtx_dzCuts_endcap_ = cfg.eleVtx_dzCuts_endcap;
 
   set_primaryPFIsolations(pfCandidates);
   set_additionalPFIsolations(pfCandidates, lostTracks);
 
-  // if the tracks collection itself is CandidateTracks, don't bother with matching this to itself
-  if(cfg.getParameter<edm::ParameterSet>("collections").getParameter<edm::InputTag>("tracks").label() != "candidateTrackProducer") {
-    maxDeltaR_candidateTrackMatching_ = cfg.getParameter<double> ("maxDeltaRForCandidateTrackMatching");
+  if(cfg.matchCandidateTracks) {
+    maxDeltaR_candidateTrackMatching_ = cfg.maxDeltaRForCandidateTrackMatching;
     if(candidateTracks.isValid()) findMatchedCandidateTrack(candidateTracks, matchedCandidateTrack_, dRToMatchedCandidateTrack_);
   }
   else dRToMatchedCandidateTrack_ = INVALID_VALUE;
 
 #if DATA_FORMAT_FROM_MINIAOD && DATA_FORMAT_IS_2017
-  // if the tracks collection itself is IsolatedTracks, don't bother with matching this to itself
-  if(cfg.getParameter<edm::ParameterSet>("collections").getParameter<edm::InputTag>("tracks").label() != "isolatedTracks") {
-    maxDeltaR_isolatedTrackMatching_ = cfg.getParameter<double> ("maxDeltaRForIsolatedTrackMatching");
+  if(cfg.matchIsolatedTracks) {
+    maxDeltaR_isolatedTrackMatching_ = cfg.maxDeltaRForIsolatedTrackMatching;
     if(isolatedTracks.isValid()) findMatchedIsolatedTrack(isolatedTracks, matchedIsolatedTrack_, dRToMatchedIsolatedTrack_);
   }
   else dRToMatchedIsolatedTrack_ = INVALID_VALUE;
@@ -632,12 +662,12 @@ osu::SecondaryDisappearingTrack::SecondaryDisappearingTrack(const TYPE(tracks) &
 
 osu::SecondaryDisappearingTrack::SecondaryDisappearingTrack(const TYPE(tracks) &secondaryTrack, 
                                                             const edm::Handle<vector<osu::Mcparticle> > &particles, 
-                                                            const edm::ParameterSet &cfg) :
+                                                            const TrackConfig &cfg) :
   osu::DisappearingTrack(secondaryTrack, particles, cfg) {}
 
 osu::SecondaryDisappearingTrack::SecondaryDisappearingTrack(const TYPE(secondaryTracks) &secondaryTrack, 
                                                             const edm::Handle<vector<osu::Mcparticle> > &particles, 
-                                                            const edm::ParameterSet &cfg, 
+                                                            const TrackConfig &cfg, 
                                                             const edm::Handle<vector<reco::GsfTrack> > &gsfTracks, 
                                                             const EtaPhiList &electronVetoList, 
                                                             const EtaPhiList &muonVetoList) :
@@ -647,14 +677,13 @@ osu::SecondaryDisappearingTrack::SecondaryDisappearingTrack(const TYPE(tracks) &
                                                             const edm::Handle<vector<osu::Mcparticle> > &particles, 
                                                             const edm::Handle<vector<pat::PackedCandidate> > &pfCandidates,
                                                             const edm::Handle<vector<TYPE(jets)> > &jets,
-                                                            const edm::ParameterSet &cfg, 
+                                                            const TrackConfig &cfg, 
                                                             const edm::Handle<vector<reco::GsfTrack> > &gsfTracks, 
                                                             const EtaPhiList &electronVetoList, 
                                                             const EtaPhiList &muonVetoList, 
-                                                            const map<DetId, vector<double> > * const EcalAllDeadChannelsValMap, 
-                                                            const map<DetId, vector<int> > * const EcalAllDeadChannelsBitMap, 
+                                                            const osu::DeadEcalChannels &deadEcalChannels, 
                                                             const bool dropHits) :
-  osu::DisappearingTrack(secondaryTrack, particles, pfCandidates, jets, cfg, gsfTracks, electronVetoList, muonVetoList, EcalAllDeadChannelsValMap, EcalAllDeadChannelsBitMap, dropHits) {}
+  osu::DisappearingTrack(secondaryTrack, particles, pfCandidates, jets, cfg, gsfTracks, electronVetoList, muonVetoList, deadEcalChannels, dropHits) {}
 
 // the DisappTrks constructor
 osu::SecondaryDisappearingTrack::SecondaryDisappearingTrack (const TYPE(tracks) &track, 
@@ -662,20 +691,19 @@ osu::SecondaryDisappearingTrack::SecondaryDisappearingTrack (const TYPE(tracks)
                                                              const edm::Handle<vector<pat::PackedCandidate> > &pfCandidates, 
                                                              const edm::Handle<vector<pat::PackedCandidate> > &lostTracks, 
                                                              const edm::Handle<vector<TYPE(jets)> > &jets,
-                                                             const edm::ParameterSet &cfg, 
+                                                             const DisappearingTrackConfig &cfg, 
                                                              const edm::Handle<vector<reco::GsfTrack> > &gsfTracks, 
                                                              const EtaPhiList &electronVetoList, 
                                                              const EtaPhiList &muonVetoList, 
-                                                             const map<DetId, vector<double> > * const EcalAllDeadChannelsValMap, 
-                                                             const map<DetId, vector<int> > * const EcalAllDeadChannelsBitMap, 
+                                                             const osu::DeadEcalChannels &deadEcalChannels, 
                                                              const bool dropHits,
 #if DATA_FORMAT_FROM_MINIAOD && DATA_FORMAT_IS_2017
                                                              const edm::Handle<vector<CandidateTrack> > &candidateTracks,
                                                              const edm::Handle<vector<pat::IsolatedTrack> > &isolatedTracks) :
-  osu::DisappearingTrack(track, particles, pfCandidates, lostTracks, jets, cfg, gsfTracks, electronVetoList, muonVetoList, EcalAllDeadChannelsValMap, EcalAllDeadChannelsBitMap, dropHits, candidateTracks, isolatedTracks) {}
+  osu::DisappearingTrack(track, particles, pfCandidates, lostTracks, jets, cfg, gsfTracks, electronVetoList, muonVetoList, deadEcalChannels, dropHits, candidateTracks, isolatedTracks) {}
 #else
                                                              const edm::Handle<vector<CandidateTrack> > &candidateTracks) :
-  osu::DisappearingTrack(track, particles, pfCandidates, lostTracks, jets, cfg, gsfTracks, electronVetoList, muonVetoList, EcalAllDeadChannelsValMap, EcalAllDeadChannelsBitMap, dropHits, candidateTracks) {}
+  osu::DisappearingTrack(track, particles, pfCandidates, lostTracks, jets, cfg, gsfTracks, electronVetoList, muonVetoList, deadEcalChannels, dropHits, candidateTracks) {}
 #endif
 
 osu::SecondaryDisappearingTrack::~SecondaryDisappearingTrack ()
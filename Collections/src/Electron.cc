@@ -93,7 +93,7 @@ osu::Electron::Electron (const TYPE(electrons) &electron, const edm::Handle<vect
 {
 }
 
-osu::Electron::Electron (const TYPE(electrons) &electron, const edm::Handle<vector<osu::Mcparticle> > &particles, const edm::ParameterSet &cfg) :
+osu::Electron::Electron (const TYPE(electrons) &electron, const edm::Handle<vector<osu::Mcparticle> > &particles, const osu::GenMatchConfig &cfg) :
   GenMatchable                          (electron, particles, cfg),
   rho_                                  (INVALID_VALUE),
   pfdRhoIsoCorr_                        (INVALID_VALUE),
@@ -134,7 +134,7 @@ osu::Electron::Electron (const TYPE(electrons) &electron, const edm::Handle<vect
 {
 }
 
-osu::Electron::Electron (const TYPE(electrons) &electron, const edm::Handle<vector<osu::Mcparticle> > &particles, const edm::ParameterSet &cfg, const osu::Met &met) :
+osu::Electron::Electron (const TYPE(electrons) &electron, const edm::Handle<vector<osu::Mcparticle> > &particles, const osu::GenMatchConfig &cfg, const osu::Met &met) :
   GenMatchable                          (electron, particles, cfg),
   rho_                                  (INVALID_VALUE),
   pfdRhoIsoCorr_                        (INVALID_VALUE),
@@ -566,7 +566,7 @@ osu::Electron::Electron (const TYPE(electrons) &electron, const edm::Handle<vect
 {
 }
 
-osu::Electron::Electron (const TYPE(electrons) &electron, const edm::Handle<vector<osu::Mcparticle> > &particles, const edm::ParameterSet &cfg) :
+osu::Electron::Electron (const TYPE(electrons) &electron, const edm::Handle<vector<osu::Mcparticle> > &particles, const osu::GenMatchConfig &cfg) :
   GenMatchable (electron, particles, cfg)
 {
 }
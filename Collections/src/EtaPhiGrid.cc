@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <cmath>
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "OSUT3Analysis/Collections/interface/EtaPhiGrid.h"
+
+namespace
+{
+  // added to the radius of each query so that rounding never drops a point
+  // exactly on the edge of the cone
+  const double MARGIN = 1.0e-6;
+
+  // phi + pi, reduced to [0, 2pi)
+  double
+  reducedPhi (const double phi)
+  {
+    double x = fmod (phi + M_PI, 2.0 * M_PI);
+    return (x < 0.0 ? x + 2.0 * M_PI : x);
+  }
+}
+
+osu::EtaPhiGrid::EtaPhiGrid (const double cellSize, const double maxEta) :
+  maxEta_ (maxEta),
+  built_  (false)
+{
+  if (!(cellSize > 0.0) || !(maxEta > 0.0))
+    throw cms::Exception ("FatalError") << "EtaPhiGrid needs a positive cell size and maximum eta, not " << cellSize << " and " << maxEta << ".";
+
+  nEtaCells_ = 2 * (int) ceil (maxEta_ / cellSize) + 2;
+  nPhiCells_ = max ((int) floor (2.0 * M_PI / cellSize), 1);
+  etaCellSize_ = 2.0 * maxEta_ / (nEtaCells_ - 2);
+  phiCellSize_ = 2.0 * M_PI / nPhiCells_;
+}
+
+void
+osu::EtaPhiGrid::clear ()
+{
+  eta_.clear ();
+  phi_.clear ();
+  cellStart_.clear ();
+  cellPoints_.clear ();
+  unbinned_.clear ();
+  built_ = false;
+}
+
+void
+osu::EtaPhiGrid::add (const double eta, const double phi)
+{
+  eta_.push_back (eta);
+  phi_.push_back (phi);
+  built_ = false;
+}
+
+void
+osu::EtaPhiGrid::build ()
+{
+  vector<int> cells (eta_.size (), -1);
+  vector<unsigned> counts (nEtaCells_ * nPhiCells_, 0);
+
+  unbinned_.clear ();
+  for (unsigned i = 0; i != eta_.size (); i++)
+    {
+      if (!isfinite (eta_.at (i)) || !isfinite (phi_.at (i)))
+        {
+          unbinned_.push_back (i);
+          continue;
+        }
+      cells.at (i) = etaCell (eta_.at (i)) * nPhiCells_ + phiCell (phi_.at (i));
+      counts.at (cells.at (i))++;
+    }
+
+  cellStart_.assign (nEtaCells_ * nPhiCells_ + 1, 0);
+  for (unsigned cell = 0; cell != counts.size (); cell++)
+    cellStart_.at (cell + 1) = cellStart_.at (cell) + counts.at (cell);
+
+  cellPoints_.resize (cellStart_.back ());
+  vector<unsigned> next (cellStart_.begin (), cellStart_.end () - 1);
+  for (unsigned i = 0; i != eta_.size (); i++)
+    if (cells.at (i) >= 0)
+      cellPoints_.at (next.at (cells.at (i))++) = i;
+
+  built_ = true;
+}
+
+bool
+osu::EtaPhiGrid::built () const
+{
+  return built_;
+}
+
+unsigned
+osu::EtaPhiGrid::size () const
+{
+  return eta_.size ();
+}
+
+double
+osu::EtaPhiGrid::eta (const unsigned i) const
+{
+  return eta_.at (i);
+}
+
+double
+osu::EtaPhiGrid::phi (const unsigned i) const
+{
+  return phi_.at (i);
+}
+
+void
+osu::EtaPhiGrid::candidates (const double eta, const double phi, const double dR, vector<unsigned> &indices) const
+{
+  if (!built_)
+    throw cms::Exception ("FatalError") << "EtaPhiGrid queried before build() was called.";
+
+  indices.clear ();
+  if (!isfinite (eta) || !isfinite (phi) || !(dR >= 0.0) || !isfinite (dR))
+    {
+      for (unsigned i = 0; i != eta_.size (); i++)
+        indices.push_back (i);
+      return;
+    }
+
+  indices.assign (unbinned_.begin (), unbinned_.end ());
+
+  int minEta = etaCell (eta - dR - MARGIN),
+      maxEta = etaCell (eta + dR + MARGIN);
+  double x = reducedPhi (phi);
+  int minPhi = (int) floor ((x - dR - MARGIN) / phiCellSize_),
+      maxPhi = (int) floor ((x + dR + MARGIN) / phiCellSize_);
+  if (maxPhi - minPhi >= nPhiCells_ - 1)
+    {
+      minPhi = 0;
+      maxPhi = nPhiCells_ - 1;
+    }
+
+  for (int i = minEta; i <= maxEta; i++)
+    for (int j = minPhi; j <= maxPhi; j++)
+      {
+        int cell = i * nPhiCells_ + ((j % nPhiCells_) + nPhiCells_) % nPhiCells_;
+        indices.insert (indices.end (), cellPoints_.begin () + cellStart_.at (cell), cellPoints_.begin () + cellStart_.at (cell + 1));
+      }
+
+  sort (indices.begin (), indices.end ());
+}
+
+int
+osu::EtaPhiGrid::etaCell (const double eta) const
+{
+  if (eta < -maxEta_)
+    return 0;
+  if (eta >= maxEta_)
+    return nEtaCells_ - 1;
+  return min (1 + (int) floor ((eta + maxEta_) / etaCellSize_), nEtaCells_ - 2);
+}
+
+int
+osu::EtaPhiGrid::phiCell (const double phi) const
+{
+  return min ((int) floor (reducedPhi (phi) / phiCellSize_), nPhiCells_ - 1);
+}
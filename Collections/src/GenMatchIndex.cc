@@ -0,0 +1,63 @@
+#include <cstdlib>
+
+#include "OSUT3Analysis/Collections/interface/GenMatchIndex.h"
+
+namespace
+{
+  // comparable to the largest cones normally used for gen-matching
+  const double CELL_SIZE = 0.2;
+}
+
+osu::GenMatchIndex::GenMatchIndex () :
+  product_ (NULL),
+  grid_    (CELL_SIZE)
+{
+}
+
+osu::GenMatchIndex &
+osu::GenMatchIndex::instance ()
+{
+  static thread_local GenMatchIndex index;
+  return index;
+}
+
+const osu::GenMatchIndex &
+osu::GenMatchIndex::get (const edm::EventID &eventID, const edm::Handle<vector<osu::Mcparticle> > &particles)
+{
+  GenMatchIndex &index = instance ();
+  if (eventID == edm::EventID () || eventID != index.eventID_ || particles.id () != index.productID_ || particles.product () != index.product_)
+    {
+      index.build (*particles);
+      index.eventID_ = eventID;
+      index.productID_ = particles.id ();
+      index.product_ = particles.product ();
+    }
+  return index;
+}
+
+void
+osu::GenMatchIndex::build (const vector<osu::Mcparticle> &particles)
+{
+  grid_.clear ();
+  byAbsPdgId_.clear ();
+  for (unsigned i = 0; i != particles.size (); i++)
+    {
+      const osu::Mcparticle &particle = particles.at (i);
+      byAbsPdgId_[abs (particle.pdgId ())].push_back (i);
+      grid_.add (particle.eta (), particle.phi ());
+    }
+  grid_.build ();
+}
+
+void
+osu::GenMatchIndex::candidates (const double eta, const double phi, const double dR, vector<unsigned> &indices) const
+{
+  grid_.candidates (eta, phi, dR, indices);
+}
+
+const vector<unsigned> &
+osu::GenMatchIndex::particlesWithAbsPdgId (const int absPdgId) const
+{
+  map<int, vector<unsigned> >::const_iterator particles = byAbsPdgId_.find (absPdgId);
+  return (particles != byAbsPdgId_.end () ? particles->second : none_);
+}
@@ -16,7 +16,7 @@ osu::Genjet::Genjet (const TYPE(genjets) &genjet, const edm::Handle<vector<osu::
 {
 }
 
-osu::Genjet::Genjet (const TYPE(genjets) &genjet, const edm::Handle<vector<osu::Mcparticle> > &particles, const edm::ParameterSet &cfg) :
+osu::Genjet::Genjet (const TYPE(genjets) &genjet, const edm::Handle<vector<osu::Mcparticle> > &particles, const osu::GenMatchConfig &cfg) :
   GenMatchable (genjet, particles, cfg)
 {
 }
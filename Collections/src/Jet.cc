@@ -50,7 +50,7 @@ osu::Jet::Jet (const TYPE(jets) &jet, const edm::Handle<vector<osu::Mcparticle>
 {
 }
 
-osu::Jet::Jet (const TYPE(jets) &jet, const edm::Handle<vector<osu::Mcparticle> > &particles, const edm::ParameterSet &cfg) :
+osu::Jet::Jet (const TYPE(jets) &jet, const edm::Handle<vector<osu::Mcparticle> > &particles, const osu::GenMatchConfig &cfg) :
   GenMatchable (jet, particles, cfg),
   matchedToLepton_                               (INVALID_VALUE),
   pfCombinedSecondaryVertexV2BJetTags_           (INVALID_VALUE),
@@ -197,7 +197,7 @@ osu::Bjet::Bjet(const TYPE(jets) &bjet,
 
 osu::Bjet::Bjet(const TYPE(jets) &bjet,
                 const edm::Handle<vector<osu::Mcparticle> > &particles,
-                const edm::ParameterSet &cfg) :
+                const osu::GenMatchConfig &cfg) :
   osu::Jet(bjet, particles, cfg) {}
 #else // STOPPPED_PTLS
 osu::Bjet::Bjet(const TYPE(jets) &bjet) : 
@@ -61,7 +61,7 @@ osu::Muon::Muon (const TYPE(muons) &muon, const edm::Handle<vector<osu::Mcpartic
 {
 }
 
-osu::Muon::Muon (const TYPE(muons) &muon, const edm::Handle<vector<osu::Mcparticle> > &particles, const edm::ParameterSet &cfg) :
+osu::Muon::Muon (const TYPE(muons) &muon, const edm::Handle<vector<osu::Mcparticle> > &particles, const osu::GenMatchConfig &cfg) :
   GenMatchable             (muon, particles, cfg),
   rho_                     (INVALID_VALUE),
   isTightMuonWRTVtx_       (false),
@@ -87,7 +87,7 @@ osu::Muon::Muon (const TYPE(muons) &muon, const edm::Handle<vector<osu::Mcpartic
 {
 }
 
-osu::Muon::Muon (const TYPE(muons) &muon, const edm::Handle<vector<osu::Mcparticle> > &particles, const edm::ParameterSet &cfg, const osu::Met &met) :
+osu::Muon::Muon (const TYPE(muons) &muon, const edm::Handle<vector<osu::Mcparticle> > &particles, const osu::GenMatchConfig &cfg, const osu::Met &met) :
   GenMatchable             (muon, particles, cfg),
   rho_                     (INVALID_VALUE),
   isTightMuonWRTVtx_       (false),
@@ -24,7 +24,7 @@ osu::Photon::Photon (const TYPE(photons) &photon, const edm::Handle<vector<osu::
 {
 }
 
-osu::Photon::Photon (const TYPE(photons) &photon, const edm::Handle<vector<osu::Mcparticle> > &particles, const edm::ParameterSet &cfg) :
+osu::Photon::Photon (const TYPE(photons) &photon, const edm::Handle<vector<osu::Mcparticle> > &particles, const osu::GenMatchConfig &cfg) :
   GenMatchable (photon, particles, cfg),
   rho_ (INVALID_VALUE),
   passesVID_looseID_  (false),
@@ -48,7 +48,7 @@ osu::Tau::Tau (const TYPE(taus) &tau, const edm::Handle<vector<osu::Mcparticle>
 {
 }
 
-osu::Tau::Tau (const TYPE(taus) &tau, const edm::Handle<vector<osu::Mcparticle> > &particles, const edm::ParameterSet &cfg) :
+osu::Tau::Tau (const TYPE(taus) &tau, const edm::Handle<vector<osu::Mcparticle> > &particles, const osu::GenMatchConfig &cfg) :
   GenMatchable         (tau,             particles,  cfg),
   metMinusOnePt_       (INVALID_VALUE),
   metMinusOnePx_       (INVALID_VALUE),
@@ -69,7 +69,7 @@ osu::Tau::Tau (const TYPE(taus) &tau, const edm::Handle<vector<osu::Mcparticle>
 {
 }
 
-osu::Tau::Tau (const TYPE(taus) &tau, const edm::Handle<vector<osu::Mcparticle> > &particles, const edm::ParameterSet &cfg, const osu::Met &met) :
+osu::Tau::Tau (const TYPE(taus) &tau, const edm::Handle<vector<osu::Mcparticle> > &particles, const osu::GenMatchConfig &cfg, const osu::Met &met) :
   GenMatchable         (tau,             particles,  cfg),
   metMinusOnePt_       (INVALID_VALUE),
   metMinusOnePx_       (INVALID_VALUE),
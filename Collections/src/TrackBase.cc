@@ -1,5 +1,26 @@
 #include "OSUT3Analysis/Collections/interface/TrackBase.h"
 
+osu::TrackConfig::TrackConfig () :
+  minDeltaRForFiducialTrack (-1.0),
+  maxDeltaRForGsfTrackMatching (-1.0),
+  dropTOBProbability (0.0),
+  preTOBDropHitInefficiency (0.0),
+  postTOBDropHitInefficiency (0.0),
+  hitInefficiency (0.0)
+{
+}
+
+osu::TrackConfig::TrackConfig (const edm::ParameterSet &cfg) :
+  GenMatchConfig (cfg),
+  minDeltaRForFiducialTrack (cfg.getParameter<double> ("minDeltaRForFiducialTrack")),
+  maxDeltaRForGsfTrackMatching (cfg.getParameter<double> ("maxDeltaRForGsfTrackMatching")),
+  dropTOBProbability (cfg.getParameter<double> ("dropTOBProbability")),
+  preTOBDropHitInefficiency (cfg.getParameter<double> ("preTOBDropHitInefficiency")),
+  postTOBDropHitInefficiency (cfg.getParameter<double> ("postTOBDropHitInefficiency")),
+  hitInefficiency (cfg.getParameter<double> ("hitInefficiency"))
+{
+}
+
 #if IS_VALID(tracks)
 
 osu::TrackBase::TrackBase () :
@@ -11,12 +32,12 @@ osu::TrackBase::TrackBase () :
   matchedGsfTrack_ (),
   dRToMatchedGsfTrack_ (INVALID_VALUE),
   maxDeltaR_ (-1.0),
-  EcalAllDeadChannelsValMap_ (NULL),
-  EcalAllDeadChannelsBitMap_ (NULL),
   isFiducialECALTrack_ (true),
-  dropTOBDecision_ (-1.0),
-  dropHitDecisions_ ({}),
-  dropMiddleHitDecisions_ ({}),
+  dropTOBProbability_ (0.0),
+  preTOBDropHitProbability_ (0.0),
+  postTOBDropHitProbability_ (0.0),
+  hitProbability_ (0.0),
+  hitDropSeed_ (0),
   deltaRToClosestPFElectron_ (INVALID_VALUE),
   deltaRToClosestPFMuon_     (INVALID_VALUE),
   deltaRToClosestPFChHad_    (INVALID_VALUE)
@@ -33,12 +54,12 @@ osu::TrackBase::TrackBase (const TYPE(tracks) &track) :
   matchedGsfTrack_ (),
   dRToMatchedGsfTrack_ (INVALID_VALUE),
   maxDeltaR_ (-1.0),
-  EcalAllDeadChannelsValMap_ (NULL),
-  EcalAllDeadChannelsBitMap_ (NULL),
   isFiducialECALTrack_ (true),
-  dropTOBDecision_ (-1.0),
-  dropHitDecisions_ ({}),
-  dropMiddleHitDecisions_ ({}),
+  dropTOBProbability_ (0.0),
+  preTOBDropHitProbability_ (0.0),
+  postTOBDropHitProbability_ (0.0),
+  hitProbability_ (0.0),
+  hitDropSeed_ (0),
   deltaRToClosestPFElectron_ (INVALID_VALUE),
   deltaRToClosestPFMuon_     (INVALID_VALUE),
   deltaRToClosestPFChHad_    (INVALID_VALUE)
@@ -56,12 +77,12 @@ osu::TrackBase::TrackBase (const TYPE(tracks) &track,
   matchedGsfTrack_ (),
   dRToMatchedGsfTrack_ (INVALID_VALUE),
   maxDeltaR_ (-1.0),
-  EcalAllDeadChannelsValMap_ (NULL),
-  EcalAllDeadChannelsBitMap_ (NULL),
   isFiducialECALTrack_ (true),
-  dropTOBDecision_ (-1.0),
-  dropHitDecisions_ ({}),
-  dropMiddleHitDecisions_ ({}),
+  dropTOBProbability_ (0.0),
+  preTOBDropHitProbability_ (0.0),
+  postTOBDropHitProbability_ (0.0),
+  hitProbability_ (0.0),
+  hitDropSeed_ (0),
   deltaRToClosestPFElectron_ (INVALID_VALUE),
   deltaRToClosestPFMuon_     (INVALID_VALUE),
   deltaRToClosestPFChHad_    (INVALID_VALUE)
@@ -70,7 +91,7 @@ osu::TrackBase::TrackBase (const TYPE(tracks) &track,
 
 osu::TrackBase::TrackBase (const TYPE(tracks) &track, 
                    const edm::Handle<vector<osu::Mcparticle> > &particles, 
-                   const edm::ParameterSet &cfg) :
+                   const TrackConfig &cfg) :
   GenMatchable (track, particles, cfg),
   dRMinJet_ (INVALID_VALUE),
   isFiducialElectronTrack_ (true),
@@ -80,12 +101,12 @@ osu::TrackBase::TrackBase (const TYPE(tracks) &track,
   matchedGsfTrack_ (),
   dRToMatchedGsfTrack_ (INVALID_VALUE),
   maxDeltaR_ (-1.0),
-  EcalAllDeadChannelsValMap_ (NULL),
-  EcalAllDeadChannelsBitMap_ (NULL),
   isFiducialECALTrack_ (true),
-  dropTOBDecision_ (-1.0),
-  dropHitDecisions_ ({}),
-  dropMiddleHitDecisions_ ({}),
+  dropTOBProbability_ (0.0),
+  preTOBDropHitProbability_ (0.0),
+  postTOBDropHitProbability_ (0.0),
+  hitProbability_ (0.0),
+  hitDropSeed_ (0),
   deltaRToClosestPFElectron_ (INVALID_VALUE),
   deltaRToClosestPFMuon_     (INVALID_VALUE),
   deltaRToClosestPFChHad_    (INVALID_VALUE)
@@ -94,26 +115,26 @@ osu::TrackBase::TrackBase (const TYPE(tracks) &track,
 
 osu::TrackBase::TrackBase (const TYPE(tracks) &track, 
                    const edm::Handle<vector<osu::Mcparticle> > &particles, 
-                   const edm::ParameterSet &cfg, 
+                   const TrackConfig &cfg, 
                    const edm::Handle<vector<reco::GsfTrack> > &gsfTracks, 
                    const EtaPhiList &electronVetoList, 
                    const EtaPhiList &muonVetoList) :
   GenMatchable (track, particles, cfg),
   dRMinJet_ (INVALID_VALUE),
-  minDeltaRForFiducialTrack_ (cfg.getParameter<double> ("minDeltaRForFiducialTrack")),
+  minDeltaRForFiducialTrack_ (cfg.minDeltaRForFiducialTrack),
   isFiducialElectronTrack_ (isFiducialTrack (electronVetoList, minDeltaRForFiducialTrack_, maxSigmaForFiducialElectronTrack_)),
   isFiducialMuonTrack_ (isFiducialTrack (muonVetoList, minDeltaRForFiducialTrack_, maxSigmaForFiducialMuonTrack_)),
-  EcalAllDeadChannelsValMap_ (NULL),
-  EcalAllDeadChannelsBitMap_ (NULL),
-  isFiducialECALTrack_ (!isCloseToBadEcalChannel (minDeltaRForFiducialTrack_)),
-  dropTOBDecision_ (-1.0),
-  dropHitDecisions_ ({}),
-  dropMiddleHitDecisions_ ({}),
+  isFiducialECALTrack_ (true),
+  dropTOBProbability_ (0.0),
+  preTOBDropHitProbability_ (0.0),
+  postTOBDropHitProbability_ (0.0),
+  hitProbability_ (0.0),
+  hitDropSeed_ (0),
   deltaRToClosestPFElectron_ (INVALID_VALUE),
   deltaRToClosestPFMuon_     (INVALID_VALUE),
   deltaRToClosestPFChHad_    (INVALID_VALUE)
 {
-  maxDeltaR_ = cfg.getParameter<double> ("maxDeltaRForGsfTrackMatching");
+  maxDeltaR_ = cfg.maxDeltaRForGsfTrackMatching;
   if (gsfTracks.isValid ())
     findMatchedGsfTrack (gsfTracks, matchedGsfTrack_, dRToMatchedGsfTrack_);
 
@@ -125,54 +146,30 @@ osu::TrackBase::TrackBase (const TYPE(tracks) &track,
                    const edm::Handle<vector<osu::Mcparticle> > &particles,
                    const edm::Handle<vector<pat::PackedCandidate> > &pfCandidates, 
                    const edm::Handle<vector<TYPE(jets)> > &jets,
-                   const edm::ParameterSet &cfg, 
+                   const TrackConfig &cfg, 
                    const edm::Handle<vector<reco::GsfTrack> > &gsfTracks, 
                    const EtaPhiList &electronVetoList, 
                    const EtaPhiList &muonVetoList, 
-                   const map<DetId, vector<double> > * const EcalAllDeadChannelsValMap, 
-                   const map<DetId, vector<int> > * const EcalAllDeadChannelsBitMap, 
+                   const osu::DeadEcalChannels &deadEcalChannels, 
                    const bool dropHits) :
   GenMatchable (track, particles, cfg),
   dRMinJet_ (INVALID_VALUE),
-  minDeltaRForFiducialTrack_ (cfg.getParameter<double> ("minDeltaRForFiducialTrack")),
+  minDeltaRForFiducialTrack_ (cfg.minDeltaRForFiducialTrack),
   isFiducialElectronTrack_ (isFiducialTrack (electronVetoList, minDeltaRForFiducialTrack_, maxSigmaForFiducialElectronTrack_)),
   isFiducialMuonTrack_ (isFiducialTrack (muonVetoList, minDeltaRForFiducialTrack_, maxSigmaForFiducialMuonTrack_)),
-  EcalAllDeadChannelsValMap_ (EcalAllDeadChannelsValMap),
-  EcalAllDeadChannelsBitMap_ (EcalAllDeadChannelsBitMap),
-  isFiducialECALTrack_ (!isCloseToBadEcalChannel (minDeltaRForFiducialTrack_)),
-  dropTOBDecision_ (-1.0),
-  dropHitDecisions_ ({}),
-  dropMiddleHitDecisions_ ({}),
+  isFiducialECALTrack_ (!isCloseToBadEcalChannel (deadEcalChannels, minDeltaRForFiducialTrack_)),
+  dropTOBProbability_ (dropHits ? cfg.dropTOBProbability : 0.0),
+  preTOBDropHitProbability_ (dropHits ? cfg.preTOBDropHitInefficiency : 0.0),
+  postTOBDropHitProbability_ (dropHits ? cfg.postTOBDropHitInefficiency : 0.0),
+  hitProbability_ (dropHits ? cfg.hitInefficiency : 0.0),
+  hitDropSeed_ (0),
   deltaRToClosestPFElectron_ (INVALID_VALUE),
   deltaRToClosestPFMuon_     (INVALID_VALUE),
   deltaRToClosestPFChHad_    (INVALID_VALUE)
 {
-  maxDeltaR_ = cfg.getParameter<double> ("maxDeltaRForGsfTrackMatching");
+  maxDeltaR_ = cfg.maxDeltaRForGsfTrackMatching;
   if (gsfTracks.isValid ())
     findMatchedGsfTrack (gsfTracks, matchedGsfTrack_, dRToMatchedGsfTrack_);
-  EcalAllDeadChannelsValMap_ = NULL;
-  EcalAllDeadChannelsBitMap_ = NULL;
-
-  dropTOBProbability_ = cfg.getParameter<double> ("dropTOBProbability");
-  preTOBDropHitProbability_ = cfg.getParameter<double> ("preTOBDropHitInefficiency");
-  postTOBDropHitProbability_ = cfg.getParameter<double> ("postTOBDropHitInefficiency");
-  hitProbability_ = cfg.getParameter<double> ("hitInefficiency");
-
-  stringstream ss;
-  ss  <<  "dropTOBProbability:         "  <<  (dropTOBProbability_         *  100.0)  <<  "%"   <<  endl
-      <<  "preTOBDropHitProbability:   "  <<  (preTOBDropHitProbability_   *  100.0)  <<  "%"   <<  endl
-      <<  "postTOBDropHitProbability:  "  <<  (postTOBDropHitProbability_  *  100.0)  <<  "%"   <<  endl
-      <<  "hitProbability:             "  <<  (hitProbability_             *  100.0)  <<  "%";
-  edm::LogInfo ("osu_Track") << ss.str ();
-
-  unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
-  default_random_engine generator (seed);
-  uniform_real_distribution<double> distribution (0.0, 1.0);
-  dropTOBDecision_ = (dropHits ? distribution (generator) : 1.0e6) < dropTOBProbability_;
-  for (int i = 0; i < 50; i++)
-    dropHitDecisions_.push_back ((dropHits ? distribution (generator) : 1.0e6) < (dropTOBDecision_ ? postTOBDropHitProbability_ : preTOBDropHitProbability_));
-  for (int i = 0; i < 50; i++)
-    dropMiddleHitDecisions_.push_back ((dropHits ? distribution (generator) : 1.0e6) < hitProbability_);
 
   if(jets.isValid()) {
     for(const auto &jet : *jets) {
@@ -229,8 +226,12 @@ osu::TrackBase::isFiducialTrack (const EtaPhiList &vetoList, const double minDel
   const double minDR = max (minDeltaR, vetoList.minDeltaR); // use the given parameter unless the bin size from which the veto list is calculated is larger
   bool isFiducial = true;
   maxSigma = 0.0;
-  for (const auto &etaPhi : vetoList)
+
+  static thread_local vector<unsigned> candidates;
+  vetoList.candidates (this->eta (), this->phi (), minDR, candidates);
+  for (const auto &i : candidates)
     {
+      const EtaPhi &etaPhi = vetoList.at (i);
       if (deltaR (this->eta (), this->phi (), etaPhi.eta, etaPhi.phi) < minDR)
         {
           isFiducial = false;
@@ -397,6 +398,57 @@ osu::TrackBase::bestTrackMissingOuterHits () const
  * Methods for testing effect of dropping random hits and all the TOB hits.
 *******************************************************************************/
 
+/* Hit-dropping decisions */
+
+// The decisions are a counter-based random sequence: the i-th decision of
+// each kind is a hash of hitDropSeed_, the kind, and i, so nothing is stored
+// besides the key and any decision can be drawn independently of the others.
+// The hash is the finalizer of SplitMix64.
+
+static inline unsigned long long
+splitMix64 (unsigned long long x)
+{
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+const unsigned long long
+osu::TrackBase::hitDropSeed (const unsigned long long jobSeed, const unsigned run, const unsigned lumi, const unsigned long long event, const unsigned index)
+{
+  unsigned long long seed = splitMix64 (jobSeed);
+  seed = splitMix64 (seed ^ run);
+  seed = splitMix64 (seed ^ lumi);
+  seed = splitMix64 (seed ^ event);
+  return splitMix64 (seed ^ index);
+}
+
+const double
+osu::TrackBase::hitDropRandom (const unsigned kind, const unsigned i) const
+{
+  // uniform in [0, 1), from the upper 53 bits
+  return (splitMix64 (hitDropSeed_ ^ (((unsigned long long) kind << 32) | i)) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+const bool
+osu::TrackBase::dropTOBDecision () const
+{
+  return hitDropRandom (0, 0) < dropTOBProbability_;
+}
+
+const bool
+osu::TrackBase::dropHitDecision (const unsigned i) const
+{
+  return hitDropRandom (1, i) < (dropTOBDecision () ? postTOBDropHitProbability_ : preTOBDropHitProbability_);
+}
+
+const bool
+osu::TrackBase::dropMiddleHitDecision (const unsigned i) const
+{
+  return hitDropRandom (2, i) < hitProbability_;
+}
+
 /* Missing middle hits */
 
 template<class T> const int
@@ -404,9 +456,9 @@ osu::TrackBase::extraMissingMiddleHits (const T &track) const
 {
   int nHits = 0;
   bool countMissingMiddleHits = false;
-  for (int i = 0; i < track.hitPattern ().stripLayersWithMeasurement () - (dropTOBDecision_ ? this->hitPattern ().stripTOBLayersWithMeasurement () : 0); i++)
+  for (int i = 0; i < track.hitPattern ().stripLayersWithMeasurement () - (dropTOBDecision () ? this->hitPattern ().stripTOBLayersWithMeasurement () : 0); i++)
     {
-      bool hit = !dropMiddleHitDecisions_.at (i);
+      bool hit = !dropMiddleHitDecision (i);
       if (!hit && countMissingMiddleHits)
         nHits++;
       if (hit)
@@ -451,9 +503,9 @@ template<class T> const int
 osu::TrackBase::extraMissingOuterHits (const T &track) const
 {
   int nHits = 0;
-  for (int i = 0; i < track.hitPattern ().stripLayersWithMeasurement () - (dropTOBDecision_ ? this->hitPattern ().stripTOBLayersWithMeasurement () : 0); i++)
+  for (int i = 0; i < track.hitPattern ().stripLayersWithMeasurement () - (dropTOBDecision () ? this->hitPattern ().stripTOBLayersWithMeasurement () : 0); i++)
     {
-      bool hit = !dropHitDecisions_.at (i);
+      bool hit = !dropHitDecision (i);
       if (!hit)
         nHits++;
       else
@@ -466,7 +518,7 @@ osu::TrackBase::extraMissingOuterHits (const T &track) const
 const int
 osu::TrackBase::hitAndTOBDrop_missingOuterHits () const
 {
-  int nDropTOBHits = (dropTOBDecision_ ? this->hitPattern ().stripTOBLayersWithMeasurement () : 0);
+  int nDropTOBHits = (dropTOBDecision () ? this->hitPattern ().stripTOBLayersWithMeasurement () : 0);
   int nDropHits = extraMissingOuterHits (*this);
   return this->hitPattern ().trackerLayersWithoutMeasurement (reco::HitPattern::MISSING_OUTER_HITS) + nDropTOBHits + nDropHits;
 }
@@ -476,7 +528,7 @@ osu::TrackBase::hitAndTOBDrop_gsfTrackMissingOuterHits () const
 {
   if (this->matchedGsfTrack_.isNonnull ())
     {
-      int nDropTOBHits = (dropTOBDecision_ ? this->matchedGsfTrack_->hitPattern ().stripTOBLayersWithMeasurement () : 0);
+      int nDropTOBHits = (dropTOBDecision () ? this->matchedGsfTrack_->hitPattern ().stripTOBLayersWithMeasurement () : 0);
       int nDropHits = extraMissingOuterHits (*this->matchedGsfTrack_);
       return this->matchedGsfTrack_->hitPattern ().trackerLayersWithoutMeasurement (reco::HitPattern::MISSING_OUTER_HITS) + nDropTOBHits + nDropHits;
     }
@@ -1015,31 +1067,12 @@ osu::TrackBase::isBadGsfTrack (const reco::GsfTrack &track) const
 }
 
 int
-osu::TrackBase::isCloseToBadEcalChannel (const double &deltaRCut)
+osu::TrackBase::isCloseToBadEcalChannel (const osu::DeadEcalChannels &deadEcalChannels, const double &deltaRCut) const
 {
-   double trackEta = this->eta(), trackPhi = this->phi();
-
-   double min_dist = 999;
-   DetId min_detId;
-
-   std::map<DetId, std::vector<int> >::const_iterator bitItor;
-   for(bitItor = EcalAllDeadChannelsBitMap_->begin(); bitItor != EcalAllDeadChannelsBitMap_->end(); bitItor++){
-
-      DetId maskedDetId = bitItor->first;
-
-      std::map<DetId, std::vector<double> >::const_iterator valItor = EcalAllDeadChannelsValMap_->find(maskedDetId);
-      if( valItor == EcalAllDeadChannelsValMap_->end() ){ std::cout<<"Error cannot find maskedDetId in EcalAllDeadChannelsValMap_ ?!"<<std::endl; continue; }
-
-      double eta = (valItor->second)[0], phi = (valItor->second)[1];
-
-      double dist = reco::deltaR(eta, phi, trackEta, trackPhi);
-
-      if( min_dist > dist ){ min_dist = dist; min_detId = maskedDetId; }
-   }
-
-   if( min_dist > deltaRCut && deltaRCut >0 ) return 0;
+   if (deltaRCut <= 0)
+     return 1;
 
-   return 1;
+   return deadEcalChannels.anyWithin (this->eta (), this->phi (), deltaRCut);
 }
 
 const double
@@ -1313,12 +1346,12 @@ osu::SecondaryTrackBase::SecondaryTrackBase(const TYPE(tracks) &secondaryTrack,
 
 osu::SecondaryTrackBase::SecondaryTrackBase(const TYPE(tracks) &secondaryTrack, 
                                             const edm::Handle<vector<osu::Mcparticle> > &particles, 
-                                            const edm::ParameterSet &cfg) :
+                                            const TrackConfig &cfg) :
   osu::TrackBase(secondaryTrack, particles, cfg) {}
 
 osu::SecondaryTrackBase::SecondaryTrackBase(const TYPE(secondaryTracks) &secondaryTrack, 
                                             const edm::Handle<vector<osu::Mcparticle> > &particles, 
-                                            const edm::ParameterSet &cfg, 
+                                            const TrackConfig &cfg, 
                                             const edm::Handle<vector<reco::GsfTrack> > &gsfTracks, 
                                             const EtaPhiList &electronVetoList, 
                                             const EtaPhiList &muonVetoList) :
@@ -1328,14 +1361,13 @@ osu::SecondaryTrackBase::SecondaryTrackBase(const TYPE(tracks) &secondaryTrack,
                                             const edm::Handle<vector<osu::Mcparticle> > &particles, 
                                             const edm::Handle<vector<pat::PackedCandidate> > &pfCandidates,
                                             const edm::Handle<vector<TYPE(jets)> > &jets,
-                                            const edm::ParameterSet &cfg, 
+                                            const TrackConfig &cfg, 
                                             const edm::Handle<vector<reco::GsfTrack> > &gsfTracks, 
                                             const EtaPhiList &electronVetoList, 
                                             const EtaPhiList &muonVetoList, 
-                                            const map<DetId, vector<double> > * const EcalAllDeadChannelsValMap, 
-                                            const map<DetId, vector<int> > * const EcalAllDeadChannelsBitMap, 
+                                            const osu::DeadEcalChannels &deadEcalChannels, 
                                             const bool dropHits) :
-  osu::TrackBase(secondaryTrack, particles, pfCandidates, jets, cfg, gsfTracks, electronVetoList, muonVetoList, EcalAllDeadChannelsValMap, EcalAllDeadChannelsBitMap, dropHits) {}
+  osu::TrackBase(secondaryTrack, particles, pfCandidates, jets, cfg, gsfTracks, electronVetoList, muonVetoList, deadEcalChannels, dropHits) {}
 
 osu::SecondaryTrackBase::~SecondaryTrackBase() {}
 #endif // IS_VALID(secondaryTracks)
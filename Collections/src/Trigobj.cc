@@ -16,7 +16,7 @@ osu::Trigobj::Trigobj (const TYPE(trigobjs) &trigobj, const edm::Handle<vector<o
 {
 }
 
-osu::Trigobj::Trigobj (const TYPE(trigobjs) &trigobj, const edm::Handle<vector<osu::Mcparticle> > &particles, const edm::ParameterSet &cfg) :
+osu::Trigobj::Trigobj (const TYPE(trigobjs) &trigobj, const edm::Handle<vector<osu::Mcparticle> > &particles, const osu::GenMatchConfig &cfg) :
   GenMatchable (trigobj, particles, cfg)
 {
 }
@@ -279,6 +279,7 @@ collectionProducer.tracks = cms.EDProducer ("OSUTrackProducer",
     minDeltaRForFiducialTrack = cms.double (0.05),
     maskedEcalChannelStatusThreshold = cms.int32 (3),
     outputBadEcalChannels = cms.bool (False),
+    deadEcalChannelsCacheDir = cms.untracked.string (""), # if not empty, the masked ECAL channels are cached here for each global tag
 
     EBRecHits          =  cms.InputTag  ("reducedEcalRecHitsEB"),
     EERecHits          =  cms.InputTag  ("reducedEcalRecHitsEE"),
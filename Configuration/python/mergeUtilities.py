@@ -11,7 +11,6 @@ import shutil
 import math
 import socket
 import tempfile
-from threading import Thread, Lock, Semaphore
 from multiprocessing import cpu_count
 from OSUT3Analysis.Configuration.configurationOptions import *
 from OSUT3Analysis.Configuration.processingUtilities import *
@@ -320,45 +319,10 @@ def SkimFileValidator(skimFile):
     InvalidOrEmpty = not Valid or not FileToTest.Get ("Events").GetEntries ()
     return Valid, InvalidOrEmpty
 
-###############################################################################
-#                   Merge an intermediate file with a thread.                 #
-###############################################################################
-threadLog = ""
-outputFiles = []
-lock = Lock () # to control appending to threadLog and outputFiles
-semaphore = None # to control how many merging threads are active at a given time
-def MergeIntermediateFile (files, outputDir, dataset, weight, threadIndex, verbose):
-    global threadLog
-    global outputFiles
-    global lock
-    global semaphore
-    localThreadLog = ""
-
-    weightString = MakeWeightsString(weight, files)
-    outputFile = dataset + '_' + str (threadIndex) + '.root'
-    cmd = 'mergeTFileServiceHistograms -i ' + " ".join (files) + ' -o ' + outputDir + "/" + outputFile + ' -w ' + weightString
-
-    semaphore.acquire ()
-    if verbose:
-        print "Executing: ", cmd
-    try:
-        localThreadLog += subprocess.check_output (cmd.split (), stderr = subprocess.STDOUT)
-    except subprocess.CalledProcessError as e:
-        localThreadLog += e.output
-    semaphore.release ()
-
-    lock.acquire ()
-    threadLog += localThreadLog
-    outputFiles.append (outputDir + '/' + outputFile)
-    lock.release ()
-
 ###############################################################################
 #                       Main function to do merging work.                     #
 ###############################################################################
 def mergeOneDataset(dataSet, IntLumi, CondorDir, OutputDir="", optional_dict_ntupleEff = {}, nThreadsActive = cpu_count () + 1, verbose = False, skipMerging = False):
-    global threadLog
-    global outputFiles
-    global semaphore
 
     lpcCAF = ('fnal.gov' in socket.gethostname())
     if lpcCAF:
@@ -500,40 +464,15 @@ def mergeOneDataset(dataSet, IntLumi, CondorDir, OutputDir="", optional_dict_ntu
         MakeFilesForSkimDirectory(directory, directoryOut, TotalNumber, SkimNumber, BadIndices, FilesToRemove, lpcCAF)
 
     if not skipMerging:
-        threadLog = ""
-        outputFiles = []
-        semaphore = Semaphore (nThreadsActive)
-    
-        # start threads, each of which merges some fraction of the input files
-        filesPerThread = 100 # to be adjusted if need be
-        nThreadTarget = nThreadsActive
-        nFiles = len (GoodRootFiles)
-        nThreads = int (math.ceil (float (nFiles) / float (filesPerThread)))
-        if nThreads < nThreadTarget:
-            nThreads = min (nThreadTarget, nFiles)
-            filesPerThread = int (math.ceil (float (nFiles) / float (nThreads)))
-        threads = []
-        for i in range (0, nThreads):
-            fileSubset = GoodRootFiles[(i * filesPerThread):((i + 1) * filesPerThread)]
-            if len (fileSubset):
-                threads.append (Thread (target = MergeIntermediateFile, args = (fileSubset, OutputDir, dataSet, Weight, i, verbose)))
-                threads[-1].start ()
-        for thread in threads:
-            thread.join ()
-        log += threadLog
-    
-        # merge the intermediate files produced by the threads above
-        cmd = 'mergeTFileServiceHistograms -i ' + " ".join (outputFiles) + ' -o ' + OutputDir + "/" + dataSet + '.root'
+        # merge all of the input files in a single pass, with the merging tool
+        # reading them in parallel
+        cmd = 'mergeTFileServiceHistograms -i ' + " ".join (GoodRootFiles) + ' -o ' + OutputDir + "/" + dataSet + '.root -w ' + InputWeightString + ' -j ' + str (nThreadsActive)
         if verbose:
             print "Executing: ", cmd
         try:
             log += subprocess.check_output (cmd.split (), stderr = subprocess.STDOUT)
         except subprocess.CalledProcessError as e:
             log += e.output
-    
-        # remove the intermediate files produced by the threads above
-        for outputFile in outputFiles:
-            os.unlink (outputFile)
     else:
         print '\nNot merging dataset histograms due to --skipMerging flag...\n'
 
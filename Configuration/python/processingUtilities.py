@@ -404,6 +404,30 @@ def add_channels (process,
     plotCollections = get_collections (histogramSets)
     weightCollections = get_collections (weights)
 
+    ############################################################################
+    # The channels added here share their object producers and a single cut
+    # calculator, which evaluates each distinct cut only once per event no
+    # matter how many channels use it. Each channel gets its cut decisions from
+    # the cut calculator as a product with its own instance label.
+    ############################################################################
+    channelsToAdd = []
+    for channel in channels:
+        channelName = channel.name.pythonValue ()[1:-1]
+        if not hasattr (process, channelName) and channelName not in [x.name.pythonValue ()[1:-1] for x in channelsToAdd]:
+            channelsToAdd.append (channel)
+    allCutCollections = sorted (list (set (sum ([get_collections (channel.cuts) for channel in channelsToAdd], []))))
+    cutDecisionsLabels = {}
+    for channel in channelsToAdd:
+        channelName = channel.name.pythonValue ()[1:-1]
+        label = re.sub (r"[^a-zA-Z0-9]", "", channelName)
+        while label in cutDecisionsLabels.values ():
+            label += "X"
+        cutDecisionsLabels[channelName] = label
+    objectProducers = {}
+    cutCalculator = None
+    cutCalculatorLabel = (channelsToAdd[0].name.pythonValue ()[1:-1] + "CutCalculator") if channelsToAdd else ""
+    ############################################################################
+
     for channel in channels:
         channelPath = cms.Path ()
         channelName = channel.name.pythonValue ()
@@ -573,11 +597,13 @@ def add_channels (process,
 
         ########################################################################
         # Add an OSU object producer for each collection used in a cut or
-        # histogram.
+        # histogram. The producers are shared with the other channels added
+        # here, and those for the collections used in the cuts of any of them
+        # must run before the cut calculator.
         ########################################################################
         producedCollections = copy.deepcopy (collections)
         cutCollections = get_collections (channel.cuts)
-        usedCollections = sorted (list (set (cutCollections + plotCollections + weightCollections)))
+        usedCollections = sorted (list (set (allCutCollections + plotCollections + weightCollections)))
         for collection in collectionsToProduce:
             if collection in usedCollections:
                 usedCollections.remove (collection)
@@ -591,11 +617,46 @@ def add_channels (process,
                 else:
                     inputTags = cms.VInputTag()
                 for inputTag in inputTags:
-                    eventvariableCollections = copy.deepcopy (collections)
-                    setattr (eventvariableCollections, collection, cms.InputTag ("",""))
-                    setattr (eventvariableCollections, collection,inputTag)
+                    producerKey = (collection, inputTag.value ())
+                    if producerKey not in objectProducers:
+                        eventvariableCollections = copy.deepcopy (collections)
+                        setattr (eventvariableCollections, collection, cms.InputTag ("",""))
+                        setattr (eventvariableCollections, collection,inputTag)
+                        objectProducer = getattr (collectionProducer, collection).clone()
+                        objectProducer.collections = eventvariableCollections
+                        # Set the input tag for mcparticles to that produced by the
+                        # first object producer. Needed for gen-matching to work. DO
+                        # NOT ERASE!!!
+                        if collection != "mcparticles":
+                            label = getattr (collections, "mcparticles").getProductInstanceLabel () if hasattr (collections, "mcparticles") else ""
+                            setattr (objectProducer.collections, "mcparticles", cms.InputTag ("objectProducer0", label))
+                        # Set the input tag for mets to that produced by the second
+                        # object producer. Needed for metNoMu. DO NOT ERASE!!!
+                        if collection != "mcparticles" and collection != "mets":
+                            label = getattr (collections, "mets").getProductInstanceLabel () if hasattr (collections, "mets") else ""
+                            setattr (objectProducer.collections, "mets", cms.InputTag ("objectProducer1", label))
+                        setattr (process, "objectProducer" + str (add_channels.producerIndex), objectProducer)
+                        objectProducers[producerKey] = (objectProducer, "objectProducer" + str (add_channels.producerIndex))
+                        add_channels.producerIndex += 1
+                    objectProducer, producerLabel = objectProducers[producerKey]
+                    channelPath += objectProducer
+                    newInputTags.append(cms.InputTag (producerLabel, inputTag.getProductInstanceLabel ()))
+                    if collection in cutCollections:
+                        dropCommand = "drop *_" + inputTag.getModuleLabel () + "_" + inputTag.getProductInstanceLabel () + "_"
+                        if inputTag.getProcessName ():
+                            dropCommand += inputTag.getProcessName ()
+                        else:
+                            dropCommand += "*"
+                        outputCommands.append (dropCommand)
+                    # if collection not in cutCollections:
+                    #     outputCommands.append ("keep *_" + producerLabel + "_" + inputTag.getProductInstanceLabel () + "_" + process.name_ ())
+                setattr (producedCollections, collection, newInputTags)
+            else:
+                originalInputTag = getattr (collections, collection)
+                producerKey = (collection, originalInputTag.value ())
+                if producerKey not in objectProducers:
                     objectProducer = getattr (collectionProducer, collection).clone()
-                    objectProducer.collections = eventvariableCollections
+                    objectProducer.collections = copy.deepcopy (collections)
                     # Set the input tag for mcparticles to that produced by the
                     # first object producer. Needed for gen-matching to work. DO
                     # NOT ERASE!!!
@@ -607,38 +668,12 @@ def add_channels (process,
                     if collection != "mcparticles" and collection != "mets":
                         label = getattr (collections, "mets").getProductInstanceLabel () if hasattr (collections, "mets") else ""
                         setattr (objectProducer.collections, "mets", cms.InputTag ("objectProducer1", label))
-                    channelPath += objectProducer
                     setattr (process, "objectProducer" + str (add_channels.producerIndex), objectProducer)
-                    newInputTags.append(cms.InputTag ("objectProducer" + str (add_channels.producerIndex), inputTag.getProductInstanceLabel ()))
-                    if collection in cutCollections:
-                        dropCommand = "drop *_" + inputTag.getModuleLabel () + "_" + inputTag.getProductInstanceLabel () + "_"
-                        if inputTag.getProcessName ():
-                            dropCommand += inputTag.getProcessName ()
-                        else:
-                            dropCommand += "*"
-                        outputCommands.append (dropCommand)
-                    # if collection not in cutCollections:
-                    #     outputCommands.append ("keep *_objectProducer" + str (add_channels.producerIndex) + "_" + inputTag.getProductInstanceLabel () + "_" + process.name_ ())
+                    objectProducers[producerKey] = (objectProducer, "objectProducer" + str (add_channels.producerIndex))
                     add_channels.producerIndex += 1
-                setattr (producedCollections, collection, newInputTags)
-            else:
-                objectProducer = getattr (collectionProducer, collection).clone()
-                objectProducer.collections = copy.deepcopy (collections)
-                # Set the input tag for mcparticles to that produced by the
-                # first object producer. Needed for gen-matching to work. DO
-                # NOT ERASE!!!
-                if collection != "mcparticles":
-                    label = getattr (collections, "mcparticles").getProductInstanceLabel () if hasattr (collections, "mcparticles") else ""
-                    setattr (objectProducer.collections, "mcparticles", cms.InputTag ("objectProducer0", label))
-                # Set the input tag for mets to that produced by the second
-                # object producer. Needed for metNoMu. DO NOT ERASE!!!
-                if collection != "mcparticles" and collection != "mets":
-                    label = getattr (collections, "mets").getProductInstanceLabel () if hasattr (collections, "mets") else ""
-                    setattr (objectProducer.collections, "mets", cms.InputTag ("objectProducer1", label))
+                objectProducer, producerLabel = objectProducers[producerKey]
                 channelPath += objectProducer
-                setattr (process, "objectProducer" + str (add_channels.producerIndex), objectProducer)
-                originalInputTag = getattr (collections, collection)
-                setattr (producedCollections, collection, cms.InputTag ("objectProducer" + str (add_channels.producerIndex), originalInputTag.getProductInstanceLabel ()))
+                setattr (producedCollections, collection, cms.InputTag (producerLabel, originalInputTag.getProductInstanceLabel ()))
                 if collection in cutCollections:
                     dropCommand = "drop *_" + originalInputTag.getModuleLabel () + "_" + originalInputTag.getProductInstanceLabel () + "_"
                     if originalInputTag.getProcessName ():
@@ -647,27 +682,49 @@ def add_channels (process,
                         dropCommand += "*"
                     outputCommands.append (dropCommand)
                 # if collection not in cutCollections:
-                #     outputCommands.append ("keep *_objectProducer" + str (add_channels.producerIndex) + "_" + originalInputTag.getProductInstanceLabel () + "_" + process.name_ ())
-                add_channels.producerIndex += 1
+                #     outputCommands.append ("keep *_" + producerLabel + "_" + originalInputTag.getProductInstanceLabel () + "_" + process.name_ ())
         ########################################################################
 
         ########################################################################
-        # Add a cut calculator module for this channel to the path.
+        # Add the cut calculator shared by the channels to the path, creating
+        # it along with the first channel. A channel with lazyEvaluation = True
+        # stops evaluating its cuts once the event has failed one, unless the
+        # info printer needs all of the flags, and one which also has
+        # reorderCuts = True checks its cheapest and most rejecting cuts first.
         ########################################################################
-        cutCalculator = cms.EDProducer ("CutCalculator",
-            collections = producedCollections,
-            cuts = channel
-        )
+        if cutCalculator is None:
+            printsFlags = any ([getattr (infoPrinter, x).value () for x in ["printIndividualObjectFlags", "printCumulativeObjectFlags", "printIndividualEventFlags", "printCumulativeEventFlags"]])
+            cutCalculatorChannels = cms.VPSet ()
+            for x in channelsToAdd:
+                lazy = hasattr (x, "lazyEvaluation") and x.lazyEvaluation.value () and not printsFlags
+                cutCalculatorChannels.append (cms.PSet (
+                    name = cms.string (cutDecisionsLabels[x.name.pythonValue ()[1:-1]]),
+                    cuts = x,
+                    lazy = cms.bool (lazy),
+                    reorderCuts = cms.bool (lazy and hasattr (x, "reorderCuts") and x.reorderCuts.value ())
+                ))
+            cutCalculator = cms.EDProducer ("CutCalculator",
+                collections = producedCollections,
+                channels = cutCalculatorChannels
+            )
+            setattr (process, cutCalculatorLabel, cutCalculator)
         channelPath += cutCalculator
-        setattr (process, channelName + "CutCalculator", cutCalculator)
+        cutDecisions = cms.InputTag (cutCalculatorLabel, cutDecisionsLabels[channelName])
         ########################################################################
 
         ########################################################################
-        # Add a cut flow plotting module for this channel to the path.
+        # Add a cut flow plotting module for this channel to the path. A lazy
+        # channel does not know the individual cut decisions, so its plotter
+        # only fills the event counter and the cumulative cut flow, and one
+        # which reorders its cuts only knows whether the event passes all of
+        # them, so its cut flow has a single bin for all the cuts.
         ########################################################################
+        cutCalculatorChannel = [x for x in cutCalculator.channels if x.name.value () == cutDecisionsLabels[channelName]]
         cutFlowPlotter = cms.EDAnalyzer ("CutFlowPlotter",
             collections = producedCollections,
-            cutDecisions = cms.InputTag (channelName + "CutCalculator", "cutDecisions")
+            cutDecisions = cutDecisions,
+            cumulativeOnly = cms.bool (any ([x.lazy.value () for x in cutCalculatorChannel])),
+            combineCuts = cms.bool (any ([x.reorderCuts.value () for x in cutCalculatorChannel]))
         )
         channelPath += cutFlowPlotter
         setattr (process, channelName + "CutFlowPlotter", cutFlowPlotter)
@@ -678,7 +735,7 @@ def add_channels (process,
         ########################################################################
         channelInfoPrinter = copy.deepcopy (infoPrinter)
         channelInfoPrinter.collections = producedCollections
-        channelInfoPrinter.cutDecisions = cms.InputTag (channelName + "CutCalculator", "cutDecisions")
+        channelInfoPrinter.cutDecisions = cutDecisions
         channelPath += channelInfoPrinter
         setattr (process, channelName + "InfoPrinter", channelInfoPrinter)
         ########################################################################
@@ -699,7 +756,7 @@ def add_channels (process,
                 collections = producedCollections,
                 collectionToFilter = cms.string (collection),
                 originalCollection = getattr (collections, collection),
-                cutDecisions = cms.InputTag (channelName + "CutCalculator", "cutDecisions")
+                cutDecisions = cutDecisions
             )
             channelPath += objectSelector
             setattr (process, "objectSelector" + str (add_channels.filterIndex), objectSelector)
@@ -760,16 +817,10 @@ def add_channels (process,
         # Add a plotting module for this channel to the path.
         ########################################################################
         if len (histogramSets):
-            plotter = cms.EDAnalyzer ("Plotter",
-                collections     =  filteredCollections,
-                histogramSets   =  histogramSets,
-                weights         =  weights,
-                verbose         =  cms.int32 (0)
-            )
-            channelPath += plotter
-            setattr (process, channelName + "Plotter", plotter)
-
-            # Add copies of the plotting module for any weights being fluctuated
+            # Collect the weights for any fluctuations of the weights, so that
+            # the plotting module fills a copy of each histogram with each of
+            # them.
+            variations = cms.VPSet ()
             for weight in weights:
                 # if "fluctuations" is defined in the PSet
                 for fluctuation in (weight.fluctuations if hasattr (weight, "fluctuations") else []):
@@ -778,14 +829,24 @@ def add_channels (process,
                     # now find the weight being fluctuated in the newly copied VPSet
                     for fluctuatedWeight in fluctuatedWeights:
                         if fluctuatedWeight.inputVariable == weight.inputVariable and fluctuatedWeight.inputCollections == weight.inputCollections:
-                            # now change the name of the inputVariable to the fluctuation and add a plotting module for this weights VPSet
+                            # now change the name of the inputVariable to the fluctuation and add a variation with this weights VPSet
                             fluctuatedWeight.inputVariable = fluctuation
-                            fluctuatedPlotter = copy.deepcopy(plotter)
-                            fluctuatedPlotter.weights = fluctuatedWeights
-                            channelPath += fluctuatedPlotter
-                            setattr (process, channelName + "Plotter_" + fluctuation, fluctuatedPlotter)
+                            variations.append (cms.PSet (
+                                name     =  cms.string (fluctuation),
+                                weights  =  fluctuatedWeights
+                            ))
                             break
 
+            plotter = cms.EDAnalyzer ("Plotter",
+                collections     =  filteredCollections,
+                histogramSets   =  histogramSets,
+                weights         =  weights,
+                variations      =  variations,
+                verbose         =  cms.int32 (0)
+            )
+            channelPath += plotter
+            setattr (process, channelName + "Plotter", plotter)
+
         ########################################################################
         # Add a tree-making module for this channel to the path.
         ########################################################################
@@ -383,6 +383,9 @@ def getLumiWt(dataset_file):
 def fillTableColumn(table, dataset_file, dataset, hist_name="cutFlow"):
     inputFile = TFile(dataset_file)
     cutFlow = inputFile.Get(table.channel + "/" + hist_name)
+    if not cutFlow:  # lazy channels have no selection histogram
+        print "WARNING:  no histogram", hist_name, "for channel", table.channel, "in file", dataset_file
+        return
     if cutFlow.GetNbinsX() != len(table.cutNames):
         print "ERROR:  cutFlow.GetNbinsX() = ", cutFlow.GetNbinsX(), " does not equal len(table.cutNames) = ", len(table.cutNames)
         print "Will skip channel", table.channel, " from file ", dataset_file